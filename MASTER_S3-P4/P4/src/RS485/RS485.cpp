@@ -2,322 +2,107 @@
 //  RS485.cpp  –  Master P4 (integrado en iMakie)
 // ============================================================
 #include "RS485.h"
-
-RS485Master rs485;
-
-void RS485Master::begin(uint8_t numSlaves) {
-    _numSlaves = numSlaves;
-
-    pinMode(RS485_ENABLE_PIN, OUTPUT);
-    digitalWrite(RS485_ENABLE_PIN, LOW);
-
-    Serial1.setRxBufferSize(256);   // ← ANTES del begin (fix bug anterior)
-    Serial1.begin(RS485_BAUD, SERIAL_8N1, RS485_RX_PIN, RS485_TX_PIN);
-
-    _mutex = xSemaphoreCreateMutex();
-    configASSERT(_mutex);
-
-    for (uint8_t i = 1; i <= _numSlaves; i++) {
-        snprintf(_ch[i].trackName, 8, "TRK-%02d", i);
-        _ch[i].faderTarget = 8192;
-        _ch[i].dirty       = true;
+#include <imakie_rs485_impl.h>     // RS485Master (lib/imakie_rs485)
+
+static_assert(RS485_BUS_A_SLAVES <= RS485_BUS_MAX_SLAVES &&
+              RS485_BUS_B_SLAVES <= RS485_BUS_MAX_SLAVES, "RS485_BUS_MAX_SLAVES");
+static_assert(RS485_NUM_BUSES >= 1 && RS485_NUM_BUSES <= 2, "buses A y B");
+static_assert(RS485_NUM_BUSES < 2 || RS485_B_TX_PIN >= 0, "definir pines del bus B");
+
+static const RS485BusConfig BUS_A = {
+    &Serial1, RS485_TX_PIN, RS485_RX_PIN, RS485_ENABLE_PIN, 1, RS485_BUS_A_SLAVES, 'A', "baud"
+};
+#if RS485_NUM_BUSES > 1
+static const RS485BusConfig BUS_B = {
+    &Serial2, RS485_B_TX_PIN, RS485_B_RX_PIN, RS485_B_ENABLE_PIN,
+    RS485_BUS_A_SLAVES + 1, RS485_BUS_B_SLAVES, 'B', "baudB"
+};
+#endif
+
+RS485Network rs485;
+
+// ═════════════════════════════════════════════════════════════════════
+//  RS485Network — mapa global 1..NUM_SLAVES sobre los buses
+// ═════════════════════════════════════════════════════════════════════
+// Cada bus tiene su UART, su task y su cola: los buses sondean en
+// paralelo y la tasa por strip no baja al añadir un bus.
+
+RS485Network::RS485Network()
+    : _buses{ RS485Master(BUS_A)
+#if RS485_NUM_BUSES > 1
+            , RS485Master(BUS_B)
+#endif
+      } {}
+
+RS485Master* RS485Network::_route(uint8_t& id) {
+    for (auto& bus : _buses) {
+        if (bus.owns(id)) {
+            id = id - bus.firstId() + 1;
+            return &bus;
+        }
     }
-
-    _cycleStart = millis();
-
-    log_i("[RS485] Master init | slaves:%u baud:%u", _numSlaves, RS485_BAUD);
-    // ← task ya NO se crea aquí
+    return nullptr;
 }
 
-void RS485Master::startTask() {
-    xTaskCreatePinnedToCore(
-        RS485Master::taskEntry, "RS485",
-        4096, this, 5, nullptr, 1
-    );
-    log_i("[RS485] Task iniciado.");
-}
+void RS485Network::begin()     { for (auto& bus : _buses) bus.begin(); }
+void RS485Network::startTask() { for (auto& bus : _buses) bus.startTask(); }
 
-void RS485Master::setCalibrate(uint8_t id) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].calibrate = true;
-        _ch[id].dirty     = true;
-        xSemaphoreGive(_mutex);
-    }
+void RS485Network::setTrackName(uint8_t id, const char* name) {
+    if (RS485Master* bus = _route(id)) bus->setTrackName(id, name);
 }
-
-void RS485Master::setAutoMode(uint8_t id, AutoMode mode) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].autoMode = mode;
-        _ch[id].dirty    = true;
-        xSemaphoreGive(_mutex);
-    }
+void RS485Network::setFlags(uint8_t id, uint8_t flags) {
+    if (RS485Master* bus = _route(id)) bus->setFlags(id, flags);
 }
-
-void RS485Master::taskEntry(void* param) {
-    static_cast<RS485Master*>(param)->runTask();
+void RS485Network::setFaderTarget(uint8_t id, uint16_t value14bit) {
+    if (RS485Master* bus = _route(id)) bus->setFaderTarget(id, value14bit);
 }
-
-void RS485Master::runTask() {
-    _stateTimer = micros();
-    for (;;) {
-        switch (_busState) {
-
-            case BusState::SEND:
-                _sendPacket(_currentId);
-                _rxGot    = 0;
-                _rxHeader = false;
-                _busState = BusState::WAIT_RESP;
-                _stateTimer = micros();
-                break;
-
-            case BusState::WAIT_RESP:
-                if (_readResponse()) {
-                    _handleResponse();
-                    _busState   = BusState::GAP;
-                    _stateTimer = micros();
-                } else if (micros() - _stateTimer > RS485_RESP_TIMEOUT_US) {
-                    _timeouts++;
-                    log_v("[RS485] TIMEOUT slave %d (rx bytes=%d)", _currentId, Serial1.available());  // ← añade esto
-                    if (xSemaphoreTake(_mutex, 0) == pdTRUE) {
-                        _ch[_currentId].responded = false;
-                        xSemaphoreGive(_mutex);
-                    }
-                    _busState   = BusState::GAP;
-                    _stateTimer = micros();
-                }
-                break;
-
-            case BusState::GAP:
-                if (micros() - _stateTimer >= RS485_GAP_US) {
-                    _nextSlave();
-                    _busState = BusState::SEND;
-                }
-                break;
-        }
-        taskYIELD();
-    }
+void RS485Network::setVuLevel(uint8_t id, uint8_t value) {
+    if (RS485Master* bus = _route(id)) bus->setVuLevel(id, value);
 }
-
-void RS485Master::_sendPacket(uint8_t id) {
-    MasterPacket pkt = {};
-
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(2)) == pdTRUE) {
-        pkt.header      = RS485_START_BYTE;
-        pkt.id          = id;
-        memcpy(pkt.trackName, _ch[id].trackName, 7);
-        pkt.flags       = _ch[id].flags;
-        // ── autoMode en bits 5-7 ──
-        pkt.flags = ::setAutoMode(pkt.flags, _ch[id].autoMode);
-        // ── FLAG_CALIB one-shot ──
-        if (_ch[id].calibrate) {
-            pkt.flags |= FLAG_CALIB;
-            _ch[id].calibrate = false;
-        }
-        pkt.faderTarget = _ch[id].faderTarget;
-        pkt.vuLevel     = _ch[id].vuLevel;
-        pkt.vpotValue  = _ch[id].vpotValue;   // ← NUEVO
-        extern uint8_t g_logicConnected;
-        pkt.connected   = g_logicConnected;
-        _ch[id].dirty   = false;
-        xSemaphoreGive(_mutex);
-    } else {
-        _busState   = BusState::GAP;
-        _stateTimer = micros();
-        return;
-    }
-
-    pkt.crc = rs485_crc8((const uint8_t*)&pkt, sizeof(MasterPacket) - 1);
-
-    while (Serial1.available()) Serial1.read();
-
-    digitalWrite(RS485_ENABLE_PIN, HIGH);
-    delayMicroseconds(RS485_TX_ENABLE_US);
-    Serial1.write((const uint8_t*)&pkt, sizeof(MasterPacket));
-    Serial1.flush();
-    delayMicroseconds(RS485_TX_DONE_US);
-    digitalWrite(RS485_ENABLE_PIN, LOW);
-
-    _txCount++;
+void RS485Network::setVPotValue(uint8_t id, uint8_t rawCC) {
+    if (RS485Master* bus = _route(id)) bus->setVPotValue(id, rawCC);
 }
-
-bool RS485Master::_readResponse() {
-    while (Serial1.available()) {
-        uint8_t b = (uint8_t)Serial1.read();
-        log_v("RX byte: 0x%02X", b);  // ← solo esta línea
-
-        if (!_rxHeader) {
-            if (b == RS485_RESP_BYTE) {
-                _rxBuf[0] = b;
-                _rxGot    = 1;
-                _rxHeader = true;
-            }
-        } else {
-            if (_rxGot < sizeof(SlavePacket))
-                _rxBuf[_rxGot++] = b;
-            if (_rxGot >= sizeof(SlavePacket))
-                return true;
-        }
-    }
-    return false;
+void RS485Network::setCalibrate(uint8_t id) {
+    if (RS485Master* bus = _route(id)) bus->setCalibrate(id);
 }
-
-//***************************************************************************************************
-// Procesa la respuesta del esclavo: valida CRC, actualiza estado del canal, maneja calibración, etc.
-//***************************************************************************************************
-
-void RS485Master::_handleResponse() {
-    const SlavePacket* resp = reinterpret_cast<const SlavePacket*>(_rxBuf);
-
-    uint8_t crc = rs485_crc8(_rxBuf, sizeof(SlavePacket) - 1);
-    if (crc != resp->crc) {
-        _crcErrors++;
-        log_e("[RS485] slave=%u CRC ERROR calc=0x%02X recv=0x%02X",
-              _currentId, crc, resp->crc);
-        return;
-    }
-    if (resp->id != _currentId) {
-        log_e("[RS485] ID MISMATCH esperado=%u recibido=%u",
-              _currentId, resp->id);
-        return;
-    }
-
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(2)) == pdTRUE) {
-        _ch[_currentId].faderPos          = resp->faderPos;
-        _ch[_currentId].touchState        = resp->touchState;
-        _ch[_currentId].prevButtons       = _ch[_currentId].buttons;
-        _ch[_currentId].buttons           = resp->buttons & 0x0F;
-        _ch[_currentId].encoderDelta      = resp->encoderDelta;
-        _ch[_currentId].prevEncoderButton = _ch[_currentId].encoderButton;
-        _ch[_currentId].encoderButton     = resp->encoderButton;
-        _ch[_currentId].responded         = true;
-
-        bool calibDone     = resp->buttons & SLAVE_FLAG_CALIB_DONE;
-        bool calibError    = resp->buttons & SLAVE_FLAG_CALIB_ERROR;
-        bool notCalibrated = resp->buttons & SLAVE_FLAG_NOT_CALIBRATED;
-
-        if (calibDone) {
-            _ch[_currentId].calibrating = false;
-            if (!_ch[_currentId].calibrated) {
-                _ch[_currentId].calibrated = true;
-                _ch[_currentId].dirty      = true;
-                log_i("[RS485] Slave %d calibrado OK", _currentId);
-            }
-        }
-
-        if (calibError) {
-            _ch[_currentId].calibrating  = false;
-            _ch[_currentId].calibRetries++;
-            log_w("[RS485] Slave %d ERROR calibracion (intento %d)",
-                  _currentId, _ch[_currentId].calibRetries);
-        }
-
-        if (notCalibrated && !_ch[_currentId].calibrating) {
-            _ch[_currentId].calibrated   = false;
-            _ch[_currentId].calibRetries = 0;
-        }
-
-        if (!_ch[_currentId].calibrated &&
-            !_ch[_currentId].calibrating &&
-            _ch[_currentId].calibRetries < 3) {
-            _ch[_currentId].calibrate   = true;
-            _ch[_currentId].dirty       = true;
-            _ch[_currentId].calibrating = true;
-            log_i("[RS485] Slave %d sin calibrar — disparando (intento %d)",
-                  _currentId, _ch[_currentId].calibRetries + 1);
-        }
-
-        xSemaphoreGive(_mutex);
-    }
-
-    _rxCount++;
-}
-
-
-
-
-void RS485Master::_nextSlave() {
-    _currentId++;
-    if (_currentId > _numSlaves) {
-        _currentId = 1;
-        uint32_t elapsed = millis() - _cycleStart;
-        if (elapsed < POLL_CYCLE_MS)
-            vTaskDelay(pdMS_TO_TICKS(POLL_CYCLE_MS - elapsed));
-        _cycleStart = millis();
-    }
+void RS485Network::setAutoMode(uint8_t id, AutoMode mode) {
+    if (RS485Master* bus = _route(id)) bus->setAutoMode(id, mode);
 }
 
-// --- API Core 0 ---
-
-void RS485Master::setTrackName(uint8_t id, const char* name) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        strncpy(_ch[id].trackName, name, 7);
-        _ch[id].trackName[7] = '\0';
-        _ch[id].dirty = true;
-        xSemaphoreGive(_mutex);
-    }
+bool RS485Network::hasNewSlaveData(uint8_t id) {
+    RS485Master* bus = _route(id);
+    return bus ? bus->hasNewSlaveData(id) : false;
 }
-
-void RS485Master::setFlags(uint8_t id, uint8_t flags) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].flags = flags & ~AUTOMODE_MASK;  // preservar autoMode separado
-        _ch[id].dirty = true;
-        xSemaphoreGive(_mutex);
-    }
+SlaveState RS485Network::getSlave(uint8_t id) {
+    RS485Master* bus = _route(id);
+    return bus ? bus->getSlave(id) : SlaveState{};
 }
-
-void RS485Master::setFaderTarget(uint8_t id, uint16_t value14bit) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].faderTarget = value14bit & 0x3FFF;
-        _ch[id].dirty       = true;
-        xSemaphoreGive(_mutex);
-    }
-}
-
-void RS485Master::setVuLevel(uint8_t id, uint8_t value) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].vuLevel = value;
-        xSemaphoreGive(_mutex);
-    }
+SlavePresence RS485Network::getPresence(uint8_t id) {
+    RS485Master* bus = _route(id);
+    return bus ? bus->getPresence(id) : SlavePresence::OFFLINE;
 }
 
-void RS485Master::setVPotValue(uint8_t id, uint8_t rawCC) {
-    if (id < 1 || id > _numSlaves) return;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        _ch[id].vpotValue = rawCC & 0x7F;   // 7 bits útiles
-        _ch[id].dirty     = true;
-        xSemaphoreGive(_mutex);
-    }
+void RS485Network::setEventTask(TaskHandle_t task) {
+    for (auto& bus : _buses) bus.setEventTask(task);
 }
 
-bool RS485Master::hasNewSlaveData(uint8_t id) {
-    if (id < 1 || id > _numSlaves) return false;
-    bool result = false;
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        result = _ch[id].responded;
-        _ch[id].responded = false;
-        xSemaphoreGive(_mutex);
+// Rota el bus de partida: un bus con ráfaga no retrasa los eventos del otro
+bool RS485Network::popEvent(SlaveEvent& ev) {
+    for (uint8_t n = 0; n < RS485_NUM_BUSES; n++) {
+        RS485Master& bus = _buses[_popNext];
+        _popNext = (_popNext + 1) % RS485_NUM_BUSES;
+        if (bus.popEvent(ev)) return true;
     }
-    return result;
+    return false;
 }
 
-const ChannelData& RS485Master::getChannel(uint8_t id) {
-    static ChannelData empty;
-    if (id < 1 || id > _numSlaves) return empty;
-    return _ch[id];
+void RS485Network::requestFirmware(const char* path, const char* fallback) {
+    for (auto& bus : _buses) bus.requestFirmware(path, fallback);
 }
+void RS485Network::printStats() const { for (auto& bus : _buses) bus.printStats(); }
+void RS485Network::resetStats()       { for (auto& bus : _buses) bus.resetStats(); }
+void RS485Network::writeProfile(Print& out) const { for (auto& bus : _buses) bus.writeProfile(out); }
 
-void RS485Master::printStats() const {
-    float rate = _txCount > 0 ? (float)_rxCount / _txCount * 100.0f : 0.0f;
-    log_i("[RS485] TX:%u RX:%u TO:%u CRC_ERR:%u Exito:%.1f%%",
-          _txCount, _rxCount, _timeouts, _crcErrors, rate);
+void RS485Network::profileE2E(uint8_t id, uint32_t us) {
+    if (RS485Master* bus = _route(id)) bus->profileE2E(id, us);
 }
-
-void RS485Master::resetStats() {
-    _txCount = _rxCount = _timeouts = _crcErrors = 0;
-}
\ No newline at end of file
@@ -1,96 +1,58 @@
 #pragma once
-#include <Arduino.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include "protocol.h"
 #include "../config.h"
+#include <imakie_rs485.h>
 
 
 // ============================================================
-//  RS485.h  –  Master ESP32-S3  (integrado en iMakie)
-//  Core 1: RS485 polling task (prioridad 5)
-//  Core 0: MIDI + leer respuestas de slaves
+//  RS485.h  –  Master ESP32-P4  (integrado en iMakie)
+//  Core 1: un task de polling por bus (prioridad 5), en paralelo
+//  Core 0: MIDI + leer respuestas de slaves (RS485Network, ids globales)
+//
+//  RS485Master (un bus) es lib/imakie_rs485, común con el S3; aquí
+//  solo los buses del P4 y su mapa global.
 // ============================================================
 
 
-// Base de datos por canal (acceso thread-safe desde Core 0)
-struct ChannelData {
-    // Master → Slave
-    char      trackName[8]  = {};
-    uint8_t   flags         = 0;
-    uint16_t  faderTarget   = 8192;
-    uint8_t   vuLevel       = 0;
-    uint8_t   vpotValue     = 0;
-    bool      dirty         = true;
-    bool      calibrate     = false;
-    bool      calibrating   = false;   // ← AÑADIR
-    AutoMode  autoMode      = AUTO_OFF;
-    uint8_t calibRetries = 0;
-
-
-    // Slave → Master
-    uint16_t faderPos         = 0;
-    uint8_t  touchState       = 0;
-    uint8_t  buttons          = 0;
-    uint8_t  prevButtons      = 0;
-    int8_t   encoderDelta     = 0;
-    uint8_t  encoderButton    = 0;
-    uint8_t  prevEncoderButton = 0;
-    bool     calibrated       = false;
-    bool     responded        = false;
-    
-};
-
-class RS485Master {
+// ============================================================
+//  RS485Network — mapa global de canales sobre todos los buses
+//  Misma API que un bus con ids 1..NUM_SLAVES; enruta cada id a su
+//  bus y junta las colas de eventos (cada cola sigue siendo SPSC).
+// ============================================================
+class RS485Network {
 public:
-    void begin(uint8_t numSlaves = NUM_SLAVES);
-    void startTask(); 
-    
-    // FreeRTOS task (Core 1)
-    static void taskEntry(void* param);
-    void        runTask();
+    RS485Network();
+
+    void begin();
+    void startTask();                    // un task por bus
 
-    // API Core 0 → RS485 (MIDI → slaves)
     void setTrackName  (uint8_t id, const char* name);
     void setFlags      (uint8_t id, uint8_t flags);
     void setFaderTarget(uint8_t id, uint16_t value14bit);
     void setVuLevel    (uint8_t id, uint8_t value);
-    void setVPotValue(uint8_t id, uint8_t rawCC);   // ← NUEVO
-    void setCalibrate  (uint8_t id);               // one-shot calibración
-    void setAutoMode   (uint8_t id, AutoMode mode); // modo de automatización
+    void setVPotValue  (uint8_t id, uint8_t rawCC);
+    void setCalibrate  (uint8_t id);
+    void setAutoMode   (uint8_t id, AutoMode mode);
+
+    bool          hasNewSlaveData(uint8_t id);
+    SlaveState    getSlave       (uint8_t id);
+    SlavePresence getPresence    (uint8_t id);
 
-    // API RS485 → Core 0 (slaves → MIDI)
-    bool               hasNewSlaveData(uint8_t id);
-    const ChannelData& getChannel     (uint8_t id);
+    void setEventTask(TaskHandle_t task);
+    bool popEvent    (SlaveEvent& ev);   // solo el task consumidor; rota entre buses
 
+    void requestFirmware(const char* path, const char* fallback = nullptr);   // todos los buses, en paralelo
 
     void printStats() const;
     void resetStats();
+    void profileE2E  (uint8_t id, uint32_t us);    // id global
+    void writeProfile(Print& out) const;           // un snapshot por bus
 
 private:
-    uint8_t           _numSlaves  = NUM_SLAVES;
-    uint8_t           _currentId  = 1;
-    SemaphoreHandle_t _mutex      = nullptr;
-    ChannelData       _ch[NUM_SLAVES + 1];
-
-    enum class BusState : uint8_t { SEND, WAIT_RESP, GAP };
-    BusState _busState   = BusState::SEND;
-    uint32_t _stateTimer = 0;
-    uint32_t _cycleStart = 0;
-
-    uint8_t  _rxBuf[sizeof(SlavePacket)];
-    uint8_t  _rxGot    = 0;
-    bool     _rxHeader = false;
-
-    uint32_t _txCount   = 0;
-    uint32_t _rxCount   = 0;
-    uint32_t _timeouts  = 0;
-    uint32_t _crcErrors = 0;
+    RS485Master* _route(uint8_t& id);    // id global → bus + id local
 
-    void _sendPacket   (uint8_t id);
-    bool _readResponse ();
-    void _handleResponse();
-    void _nextSlave    ();
+    RS485Master _buses[RS485_NUM_BUSES];
+    uint8_t     _popNext = 0;
 };
 
-extern RS485Master rs485;
\ No newline at end of file
+extern RS485Network rs485;
\ No newline at end of file
@@ -0,0 +1,250 @@
+// ============================================================
+//  RS485Fw.cpp  –  Firmware S2 por el bus (Master P4)
+//
+//  Fuera de la máquina de estados: bloquea el task de este bus
+//  hasta terminar. Los otros buses siguen con su propio task.
+//
+//  1. BEGIN (difusión) y QUERY hasta que cada slave ha borrado
+//  2. Rondas: bloques pendientes en difusión → QUERY uno a uno
+//     (ventanas NACK) → la unión de lo que falta es la ronda siguiente
+//  3. COMMIT → QUERY hasta VERIFIED → REBOOT; ABORT al resto
+//
+//  La imagen puede ser un .bin o un contenedor IMZ1 (tools/fwpack):
+//  se difunde tal cual y el S2 la descomprime en COMMIT.
+// ============================================================
+#include "RS485.h"
+#include <LittleFS.h>
+#include <esp_app_format.h>
+#include <esp_app_desc.h>
+#include <imakie_fwpack.h>
+
+// Espera + una vuelta de QUERY sin respuesta por slave: si el bus calla
+// más que el fallback, los S2 a velocidad negociada ya no oyen COMMIT/REBOOT
+static_assert(RS485_FW_POLL_MS + RS485_BUS_MAX_SLAVES * RS485_FW_QUERY_TIMEOUT_US / 1000 < RS485_BAUD_FALLBACK_MS,
+              "RS485_FW_POLL_MS: silencio del bus por encima de RS485_BAUD_FALLBACK_MS");
+
+void RS485Master::requestFirmware(const char* path, const char* fallback) {
+    _fwPath     = path;
+    _fwFallback = fallback;
+    _fwRequest  = true;
+}
+
+// Imagen de app para ESP32-S2; fwId = prefijo de su app_elf_sha256
+static bool _fwCheckImage(File& f, uint8_t* fwId) {
+    esp_image_header_t hdr;
+    esp_app_desc_t     desc;
+    if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) ||
+        hdr.magic != ESP_IMAGE_HEADER_MAGIC || hdr.chip_id != ESP_CHIP_ID_ESP32S2)
+        return false;
+    // esp_app_desc_t abre el primer segmento (DROM)
+    if (!f.seek(sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t)) ||
+        f.read((uint8_t*)&desc, sizeof(desc)) != sizeof(desc) ||
+        desc.magic_word != ESP_APP_DESC_MAGIC_WORD)
+        return false;
+    memcpy(fwId, desc.app_elf_sha256, FW_ID_LEN);
+    return true;
+}
+
+// .bin → FWPACK_RAW; IMZ1 → format + ids de su cabecera
+static bool _fwOpenImage(File& f, uint8_t& format, uint8_t* fwId, uint8_t* baseId) {
+    uint8_t      head[FWPACK_HEADER_LEN];
+    FwPackHeader h;
+    if (f.read(head, sizeof(head)) == sizeof(head) && fwpack_parseHeader(head, sizeof(head), h)) {
+        format = h.format;
+        memcpy(fwId,   h.fwId,   FW_ID_LEN);
+        memcpy(baseId, h.baseId, FW_ID_LEN);
+        return true;
+    }
+    format = FWPACK_RAW;
+    return f.seek(0) && _fwCheckImage(f, fwId);
+}
+
+uint32_t RS485Master::_fwUpdate(const char* path, uint32_t only) {
+    static const char* const kFormat[] = { "bin", "LZ", "delta" };
+    File f = LittleFS.open(path, "r");
+    uint8_t format, fwId[FW_ID_LEN], baseId[FW_ID_LEN] = {};
+    if (!f || !_fwOpenImage(f, format, fwId, baseId)) {
+        log_e("[RS485] Bus %c: %s no es una imagen ESP32-S2 ni IMZ1", _cfg.name, path);
+        return only;
+    }
+    const uint32_t size   = f.size();
+    const uint16_t blocks = (size + FW_BLOCK_LEN - 1) / FW_BLOCK_LEN;
+
+    uint32_t targets = 0;
+    for (uint8_t id = 1; id <= _numSlaves; id++)
+        if (_ch[id].fwCapable && _ch[id].presence.load() == SlavePresence::ONLINE)
+            targets |= (1u << id);
+    targets &= only;
+    if (!targets) {
+        log_i("[RS485] Bus %c: ningún slave con SLAVE_CAP_FW — firmware no enviado", _cfg.name);
+        return 0;
+    }
+
+    const size_t mapLen = (blocks + 7) / 8;
+    uint8_t* resend = (uint8_t*)malloc(mapLen);
+    if (!resend) return targets;
+
+    const uint16_t session = (uint16_t)esp_random() | 1;
+    uint8_t  tx[RS485_FW_MAX_LEN];
+    FwStatus st;
+    uint32_t upToDate = 0, failed = 0, complete = 0, verified = 0;
+    uint32_t sent = 0;
+    const uint32_t t0 = millis();
+    log_i("[RS485] Bus %c: firmware %s (%s, %u B, %u bloques) → slaves 0x%X, sesión %04X",
+          _cfg.name, path, kFormat[format], size, blocks, targets, session);
+
+    // ── 1. BEGIN: sin respuesta, se repite; el borrado tarda segundos ──
+    for (uint8_t n = 0; n < 3; n++)
+        _fwSend(tx, rs485_encodeFwBegin(tx, session, size, blocks, fwId, format, baseId), RS485_FW_BLOCK_GAP_US);
+
+    uint32_t erasing = targets;
+    while (erasing && millis() - t0 < RS485_FW_ERASE_MS) {
+        vTaskDelay(pdMS_TO_TICKS(RS485_FW_POLL_MS));   // QUERY durante el borrado se contestaría tarde
+        for (uint8_t id = 1; id <= _numSlaves; id++) {
+            if (!(erasing & (1u << id)) || !_fwQuery(id, session, 0, st)) continue;
+            if (st.session != session || st.state == FW_IDLE) {
+                // BEGIN perdido: se repite (el resto ya lo ignora por sesión)
+                _fwSend(tx, rs485_encodeFwBegin(tx, session, size, blocks, fwId, format, baseId), RS485_FW_BLOCK_GAP_US);
+                continue;
+            }
+            erasing &= ~(1u << id);
+            if      (st.state == FW_UP_TO_DATE) upToDate |= (1u << id);
+            else if (st.state == FW_ERROR)      failed   |= (1u << id);
+        }
+    }
+    failed  |= erasing;
+    targets &= ~(upToDate | failed);
+
+    // ── 2. Rondas: todo en la primera, solo lo que alguien no tiene después ──
+    memset(resend, 0xFF, mapLen);
+    uint8_t round = 0;
+    for (; round < RS485_FW_MAX_ROUNDS && (targets & ~complete); round++) {
+        uint32_t roundSent = 0;
+        for (uint16_t b = 0; b < blocks; b++) {
+            if (!(resend[b >> 3] & (1 << (b & 7)))) continue;
+            uint32_t off = (uint32_t)b * FW_BLOCK_LEN;
+            size_t   n   = size - off < FW_BLOCK_LEN ? size - off : FW_BLOCK_LEN;
+            uint8_t  data[FW_BLOCK_LEN];
+            if (!f.seek(off) || f.read(data, n) != n) break;
+            _fwSend(tx, rs485_encodeFwData(tx, session, b, data, n), RS485_FW_BLOCK_GAP_US);
+            roundSent++;
+        }
+        sent += roundSent;
+
+        memset(resend, 0, mapLen);
+        for (uint8_t id = 1; id <= _numSlaves; id++) {
+            uint32_t bit = 1u << id;
+            if (!(targets & bit) || (complete & bit)) continue;
+            uint16_t from  = 0;
+            uint8_t  tries = 0;
+            while (from < blocks) {
+                if (!_fwQuery(id, session, from, st)) {
+                    if (++tries >= 3) break;       // la próxima ronda se vuelve a preguntar
+                    continue;
+                }
+                tries = 0;
+                if (st.session != session || st.state == FW_IDLE || st.state == FW_ERROR) {
+                    failed  |= bit;                // reiniciado a mitad o error de escritura
+                    targets &= ~bit;
+                    break;
+                }
+                if (st.state != FW_RECEIVING) { complete |= bit; break; }
+                for (uint16_t i = 0; i < st.nbytes * 8u; i++) {
+                    uint16_t b = st.base + i;
+                    if (b < blocks && (st.bitmap[i >> 3] & (1 << (i & 7))))
+                        resend[b >> 3] |= 1 << (b & 7);
+                }
+                if (st.nbytes == 0) break;
+                from = st.base + FW_NACK_BYTES * 8;
+            }
+        }
+        log_i("[RS485] Bus %c: ronda %u — %u bloques, completos 0x%X de 0x%X",
+              _cfg.name, round + 1, roundSent, complete, targets);
+    }
+
+    // ── 3. COMMIT (IMZ1: descompresión; esp_ota_end verifica la imagen) → REBOOT ──
+    if (complete) {
+        for (uint8_t n = 0; n < 3; n++)
+            _fwSend(tx, rs485_encodeFwCmd(tx, FW_OP_COMMIT, session), RS485_FW_BLOCK_GAP_US);
+        uint32_t tc = millis();
+        uint32_t checking = complete;
+        while (checking && millis() - tc < RS485_FW_VERIFY_MS) {
+            vTaskDelay(pdMS_TO_TICKS(RS485_FW_POLL_MS));
+            for (uint8_t id = 1; id <= _numSlaves; id++) {
+                if (!(checking & (1u << id)) || !_fwQuery(id, session, 0, st)) continue;
+                if (st.state == FW_COMPLETE) {
+                    // Contesta antes de verificar → COMMIT perdido: se repite
+                    _fwSend(tx, rs485_encodeFwCmd(tx, FW_OP_COMMIT, session), RS485_FW_BLOCK_GAP_US);
+                    continue;
+                }
+                checking &= ~(1u << id);
+                if (st.session == session && st.state == FW_VERIFIED) verified |= (1u << id);
+            }
+        }
+    }
+    failed |= targets & ~verified;
+    if (failed)
+        _fwSend(tx, rs485_encodeFwCmd(tx, FW_OP_ABORT, session), RS485_FW_BLOCK_GAP_US);
+    if (verified)
+        for (uint8_t n = 0; n < 3; n++)
+            _fwSend(tx, rs485_encodeFwCmd(tx, FW_OP_REBOOT, session), RS485_FW_BLOCK_GAP_US);
+
+    free(resend);
+    f.close();
+    uint32_t ms = millis() - t0;
+    log_i("[RS485] Bus %c: firmware en %u ms (%u rondas, %u bloques enviados, %.1f kB/s) "
+          "OK:0x%X al día:0x%X fallo:0x%X",
+          _cfg.name, ms, round, sent, ms ? size / (float)ms : 0.0f, verified, upToDate, failed);
+
+    // Los slaves que reinician vuelven solos: presencia + re-anuncio de velocidad
+    _bcastPending = true;
+    for (uint8_t id = 1; id <= _numSlaves; id++) _ch[id].dirty = DF_ALL;
+    return failed;
+}
+
+// QUERY a un slave: estado + ventana NACK desde 'from'
+bool RS485Master::_fwQuery(uint8_t id, uint16_t session, uint16_t from, FwStatus& st) {
+    uint8_t tx[RS485_FW_MAX_LEN];
+    _transmit(tx, rs485_encodeFwQuery(tx, session, id, from));
+
+    uint8_t  rx[RS485_FW_STATUS_MAX_LEN];
+    size_t   got   = 0;
+    uint32_t limit = RS485_FW_QUERY_TIMEOUT_US + _txBusyUs;
+    uint32_t t0    = micros();
+    _armTimer(limit);
+    while (micros() - t0 < limit) {
+        while (_uart.available()) {
+            uint8_t b = (uint8_t)_uart.read();
+            if (got == 0 && b != RS485_FW_RESP_BYTE) continue;
+            rx[got++] = b;
+            size_t need = rs485_frameLength(rx, got);
+            if (need == 0) { got = 0; continue; }
+            if (got < need) continue;
+
+            got = 0;
+            if (rs485_checkFrame(rx, need) != Rs485Status::OK || rx[2] != id) continue;
+            st.state   = rx[3];
+            st.session = rs485_get16(&rx[4]);
+            st.missing = rs485_get16(&rx[6]);
+            st.base    = rs485_get16(&rx[8]);
+            st.nbytes  = need - FW_STATUS_HEADER_LEN - 2;
+            memcpy(st.bitmap, &rx[FW_STATUS_HEADER_LEN], st.nbytes);
+            delayMicroseconds(RS485_GAP_US);
+            return true;
+        }
+        _waitEvent();
+    }
+    return false;
+}
+
+// Difusión sin respuesta: fin de TX + margen para que el S2 la procese
+void RS485Master::_fwSend(const uint8_t* buf, size_t len, uint32_t gapUs) {
+    _transmit(buf, len);
+    _sleepUs(_txBusyUs + gapUs);
+}
+
+void RS485Master::_sleepUs(uint32_t us) {
+    uint32_t t0 = micros();
+    _armTimer(us);
+    while (micros() - t0 < us) _waitEvent();
+}
@@ -1,6 +1,8 @@
 // include/config.h — P4 versión mínima
 #pragma once
 #include <Arduino.h>
+#include "imakie_midi.h"
+#include "imakie_fixedstr.h"
 
 // ====================================================================
 // CONFIGURACIÓN AUTOMÁTICA SEGÚN DISPOSITIVO
@@ -8,7 +10,7 @@
 #if defined(DEVICE_P4_MASTER)
     #define DEVICE_FAMILY       0x14
     #define VERSION_REPLY_CMD   0x14
-    #define NUM_SLAVES          9
+    #define NUM_SLAVES          (RS485_BUS_A_SLAVES + RS485_BUS_B_SLAVES)
 
 #elif defined(DEVICE_S3_EXTENDER)
     #define DEVICE_FAMILY       0x15
@@ -21,12 +23,36 @@
 
 
 
-// --- RS485 pines P4 ---
+// --- RS485 pines P4 (bus A, UART1) ---
 #define RS485_TX_PIN      52
 #define RS485_RX_PIN      51
 #define RS485_ENABLE_PIN  50
 #define RS485_BAUD       500000
 
+// --- Buses RS485 (un RS485Master + task por bus, en paralelo) ---
+// Cada bus usa ids 1..N en el cable (firmware S2 sin cambios); RS485Network
+// los une en el mapa global 1..NUM_SLAVES: bus A primero, luego bus B.
+// Límite real: A + B <= MCU_CHANNELS (9, un solo puerto Mackie). El
+// segundo bus reparte esos 9 strips en dos cables para ~doblar la tasa
+// por strip; no añade strips (ver "Canales MCU").
+#define RS485_NUM_BUSES         1   // 2 = bus B en UART2 (definir sus pines)
+#define RS485_BUS_MAX_SLAVES   12   // slaves por bus (tamaño de tablas, < 32)
+#define RS485_BUS_A_SLAVES     (RS485_NUM_BUSES > 1 ? 5 : 9)
+#define RS485_BUS_B_SLAVES     (RS485_NUM_BUSES > 1 ? 4 : 0)
+#define RS485_B_TX_PIN         -1   // según PCB
+#define RS485_B_RX_PIN         -1
+#define RS485_B_ENABLE_PIN     -1
+
+// --- Canales MCU ---
+// Un puerto Mackie = 8 strips + fader master (pitch bend canal 9, sin
+// botones ni VPot). Los arrays por canal se dimensionan con MCU_CHANNELS;
+// el strip 9 hace de master. Más de 9 strips pediría un puerto extender
+// por bloque de 8 (USB-MIDI multi-cable), y USBMIDI solo expone el cable 0.
+#define MCU_STRIPS      8
+#define MCU_CHANNELS    (MCU_STRIPS + 1)
+static_assert(NUM_SLAVES <= MCU_CHANNELS,
+              "NUM_SLAVES > 9: los strips 10+ no tienen canal MCU (hace falta un puerto extender por bloque de 8)");
+
 // ── I2C ──────────────────────────────────────────────────
 // NeoTrellis — I2C_NUM_0
 #define TRELLIS_SDA_PIN  33
@@ -41,6 +67,108 @@
 #define RS485_GAP_US          300
 #define POLL_CYCLE_MS         20
 
+// --- Transceptor RS485 ---
+// 1 = UART_MODE_RS485_HALF_DUPLEX: el RTS del UART (RS485_ENABLE_PIN) conmuta DE
+//     por hardware y write() vuelve al instante. Si el modo falla → GPIO.
+// 0 = DE por GPIO + delays + flush() bloqueante (RS485_TX_ENABLE_US / _DONE_US)
+#define RS485_HW_HALF_DUPLEX        1
+
+// --- Modo event-driven RS485 ---
+// 1 = task bloqueado en eventos (UART onReceive + esp_timer para timeout/GAP)
+// 0 = polling clásico (taskYIELD + Serial1.available())
+#define RS485_EVENT_DRIVEN        1
+#define RS485_RX_TIMEOUT_SYMBOLS  2     // UART RX timeout (símbolos) → despierta con paquete parcial
+#define RS485_EVT_WAIT_MAX_MS     POLL_CYCLE_MS   // red de seguridad si se pierde un evento
+
+// --- Paquetes delta (solo a slaves con SLAVE_CAP_DELTA) ---
+#define RS485_DELTA_PACKETS         1   // 0 = siempre MasterPacket completo
+#define RS485_DELTA_REFRESH_CYCLES  50  // refresco completo cada N envíos (~1s) por si el slave reinicia
+#define RS485_BCAST_GAP_US          50  // tras broadcast (sin respuesta): solo separación de tramas
+
+// --- Scheduler adaptativo (touch / encoder / fader en movimiento) ---
+// Slot extra para un slave activo tras cada poll del barrido y en el hueco
+// hasta POLL_CYCLE_MS. Un slave inactivo espera como mucho 2·N transacciones.
+#define RS485_ADAPTIVE_POLL         1   // 0 = round-robin estricto
+#define RS485_ACTIVE_HOLD_MS      250   // slave sigue activo tras el último movimiento
+#define RS485_MOTION_THRESHOLD     16   // Δ faderPos (ADC) que cuenta como movimiento
+
+// --- Presencia de slaves (ONLINE / SUSPECT / OFFLINE) ---
+// Un timeout → SUSPECT; RS485_OFFLINE_MISSES seguidos → OFFLINE: sale del barrido
+// y solo se re-sondea con backoff exponencial. El ciclo depende de los slaves vivos.
+#define RS485_OFFLINE_MISSES        3   // timeouts seguidos → OFFLINE
+#define RS485_BACKOFF_MIN_MS      100   // primer re-sondeo de un slave OFFLINE
+#define RS485_BACKOFF_MAX_MS     2000   // techo (×2 por re-sondeo fallido)
+
+// --- Timeout de respuesta adaptativo por slave ---
+// Percentil de la latencia observada (fin de TX → respuesta completa) + margen,
+// acotado a [RS485_RESP_TIMEOUT_MIN_US, RS485_RESP_TIMEOUT_US]. Tras un timeout
+// corto el siguiente poll a ese slave usa el fijo: un retraso puntual no es una baja.
+#define RS485_ADAPTIVE_TIMEOUT      1   // 0 = siempre RS485_RESP_TIMEOUT_US
+#define RS485_RESP_TIMEOUT_MIN_US 300
+#define RS485_LAT_PERCENTILE      990   // ‰ (p99)
+#define RS485_LAT_MARGIN_US       150
+#define RS485_LAT_MIN_SAMPLES      64   // respuestas antes de usar el aprendido
+#define RS485_LAT_BUCKET_US        25   // histograma: 64 × 25 µs; lo que no cabe → fijo
+#define RS485_LAT_BUCKETS          64
+#define RS485_LAT_WINDOW          512   // muestras antes de dividir el histograma por 2
+
+// --- Group poll TDMA ---
+// Al inicio de cada barrido, una trama 0xAE para todos los slaves con
+// SLAVE_CAP_GROUP; cada uno responde en su ranura (orden de id). El resto
+// (OFFLINE, firmware antiguo) sigue con poll individual en el mismo barrido.
+// test_bus_sim: sin choques mientras el jitter de despertar entre S2 no pase
+// de GUARD_US + 1 carácter; comprobar en el bus con el sniffer (RS485.md 7.16).
+#define RS485_GROUP_POLL            1   // 0 = siempre poll individual
+#define RS485_GROUP_GUARD_US       40   // guarda por ranura: jitter de despertar entre slaves
+#define RS485_GROUP_LEAD_US       300   // fin de TX → primera respuesta (RX timeout + task S2)
+
+// --- Firmware S2 por el bus (RS485Fw.cpp) ---
+// Con 'u' en la consola serie (nunca al arrancar), RS485_FW_PATH se difunde a
+// los slaves ONLINE con SLAVE_CAP_FW; los que ya la ejecutan contestan
+// UP_TO_DATE y no se tocan.
+// Ambas rutas admiten .bin o IMZ1 (tools/fwpack, lo deja `pio run -t fwdeploy`
+// en S2). Si existe el delta va primero y RS485_FW_PATH queda para los slaves
+// que no ejecutan su base.
+#define RS485_FW_UPDATE             1   // lib/imakie_rs485: requestFirmware() + RS485Fw.cpp
+#define RS485_TASK_STACK         6144   // task de cada bus (RS485Fw abre LittleFS)
+#define RS485_FW_PATH      "/s2_firmware.bin"
+#define RS485_FW_DELTA_PATH "/s2_firmware.imd"
+#define RS485_FW_BLOCK_GAP_US    1500   // tras cada bloque: escritura en flash del S2
+#define RS485_FW_ERASE_MS       15000   // BEGIN → RECEIVING (borrado de la partición)
+#define RS485_FW_QUERY_TIMEOUT_US 3000  // QUERY → estado + bitmap NACK
+#define RS485_FW_MAX_ROUNDS         8   // rondas de reenvío antes de abortar
+#define RS485_FW_VERIFY_MS      15000   // COMMIT → VERIFIED (IMZ1: descompresión + SHA-256)
+#define RS485_FW_POLL_MS          200   // entre vueltas de QUERY (borrado, verificación): el S2 sordo mientras
+                                        // borra/descomprime; el bus callado > RS485_BAUD_FALLBACK_MS devuelve
+                                        // a la base a los S2 que ya contestaron
+
+// --- Cola de eventos slave → MIDI (flancos detectados en el task RS485) ---
+#define RS485_EVENT_QUEUE_LEN      64   // potencia de 2; llena → evento descartado (EVQ_DROP)
+
+// --- Negociación de velocidad RS485 (RS485_BAUD = velocidad base de arranque) ---
+// Al arrancar el task el master sube a 1/2/4 Mbaud mientras todos los slaves
+// respondan sin errores; la elegida se guarda en NVS ("rs485"/"baud").
+#define RS485_BAUD_NEGOTIATE        1   // 0 = fijo a RS485_BAUD
+#define RS485_BAUD_MAX_CODE         3   // tope: 1=1M 2=2M 3=4M (limitar según transceptor)
+#define RS485_BAUD_PROBE_POLLS     20   // polls por slave y velocidad; un CRC/timeout la descarta
+#define RS485_BAUD_SWITCH_MS       20   // margen para que los slaves reconfiguren su UART
+#define RS485_BAUD_FALLBACK_MS    300   // = S2: silencio tras el que un slave vuelve a la base
+#define RS485_BAUD_ANNOUNCE_MS   1000   // re-anuncio a velocidad base (slave reiniciado)
+
+// --- Cola USB-MIDI TX (lib/imakie_midi, imakie_miditx.h) ---
+#define MIDI_TX_QUEUE_LEN         128   // paquetes de 4 bytes por frame (SysEx LCD ≈ 22)
+#define MIDI_TX_SYSEX_WAIT_MS      20   // SysEx que no cabe, desde un task que no es el MIDI
+
+// --- Parser USB-MIDI RX (lib/imakie_midi) ---
+#define MIDI_SYSEX_CHUNK          16    // bytes de SysEx por llamada; el LCD se procesa a trozos
+#define MIDI_SYSEX_MAX            64    // SysEx no-LCD completos (el mayor, meters 0x72: 13 B)
+#define MIDI_RX_PACKETS_PER_LOOP  16    // paquetes USB-MIDI por vuelta del task MIDI (= 64 B)
+
+// --- Textos de Logic sin heap (lib/imakie_midi, FixedString) ---
+typedef FixedString<7>  TrackName;      // celda de 7 caracteres del LCD Mackie (MCU_LCD_CELL_W)
+typedef FixedString<2>  AssignText;     // display de asignación (SysEx 0x11)
+typedef FixedString<23> TimecodeText;   // 10 dígitos + hasta 10 puntos, relleno a 13
+
 
 // ── Dimensiones display ──────────────────────────────────────────
 #define P4_W    480
@@ -72,9 +200,6 @@
 #define COL_AUTO_WRITE  0xAA0000
 #define COL_AUTO_OFF    0x333333
 
-// --- Slaves ---
-#define NUM_SLAVES  9
-
 
 // --- Enums ---
 enum class ConnectionState {
@@ -91,22 +216,23 @@ extern volatile ConnectionState logicConnectionState;
 extern uint8_t g_logicConnected;
 
 // --- Variables de display ---
-extern String trackNames[9];
+extern TrackName trackNames[MCU_CHANNELS];
+extern TrackName lcdValues[8];      // fila inferior del LCD Mackie (valor del VPot)
 extern bool recStates[8], soloStates[8], muteStates[8], selectStates[8];
 extern uint8_t vpotValues[8];
-extern float vuLevels[9];
-extern bool vuClipState[9];
-extern unsigned long vuLastUpdateTime[9];
-extern float vuPeakLevels[9];
-extern unsigned long vuPeakLastUpdateTime[9];
-extern float faderPositions[9];
+extern float vuLevels[MCU_CHANNELS];
+extern bool vuClipState[MCU_CHANNELS];
+extern unsigned long vuLastUpdateTime[MCU_CHANNELS];
+extern float vuPeakLevels[MCU_CHANNELS];
+extern unsigned long vuPeakLastUpdateTime[MCU_CHANNELS];
+extern float faderPositions[MCU_CHANNELS];
 extern bool needsTOTALRedraw;
 extern bool needsMainAreaRedraw;
 extern bool needsTimecodeRedraw;
 extern bool needsButtonsRedraw;
 extern bool needsVUMetersRedraw;
 extern bool needsHeaderRedraw;
-extern String assignmentString;
+extern AssignText assignmentString;
 extern bool btnStatePG1[32];
 extern bool btnStatePG2[32];
 extern bool btnFlashPG1[32];
@@ -165,17 +291,25 @@ static const uint8_t BTN_COLOR_IDX[32] = {
 };
 
 // --- Notas MIDI ---
-static const byte MIDI_NOTES_PG1[32] = {
-    0x28,0x2A,0x2C,0x29,0x2B,0x2D,0x32,0x33,
-    0x4A,0x4B,0x4D,0x4E,0x4C,0x4F,0x57,0x35,
-    0x00,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
-    0x51,0x50,0x46,0x47,0x48,0x49,0x53,0x00
-};
+// Mapa declarativo tecla → nota MCU por página (0x00 = tecla sin nota).
+// MCU_NOTES (tecla → nota y nota → tecla) se genera de aquí en compilación
+enum McuPage : uint8_t { MCU_PG1, MCU_PG2, MCU_PAGES };
 
-static const byte MIDI_NOTES_PG2[32] = {
-    0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,
-    0x3E,0x3F,0x40,0x41,0x42,0x43,0x44,0x45,
-    0x64,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
-    0x4C,0x50,0x46,0x47,0x48,0x49,0x52,0x00
+static constexpr byte MCU_BUTTON_NOTES[MCU_PAGES][32] = {
+    {   // PG1
+        0x28,0x2A,0x2C,0x29,0x2B,0x2D,0x32,0x33,
+        0x4A,0x4B,0x4D,0x4E,0x4C,0x4F,0x57,0x35,
+        0x00,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
+        0x51,0x50,0x46,0x47,0x48,0x49,0x53,0x00
+    },
+    {   // PG2
+        0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,
+        0x3E,0x3F,0x40,0x41,0x42,0x43,0x44,0x45,
+        0x64,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
+        0x4C,0x50,0x46,0x47,0x48,0x49,0x52,0x00
+    },
 };
 
+inline constexpr auto MCU_NOTES = mcuNoteMap(MCU_BUTTON_NOTES);
+static_assert(MCU_NOTES.unique, "nota MCU repetida en una página");
+
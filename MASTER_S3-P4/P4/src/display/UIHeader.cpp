@@ -10,8 +10,8 @@ static lv_obj_t* s_timecode = NULL;
 static lv_obj_t* s_tc_ghost = NULL;
 static lv_obj_t* s_mode_lbl = NULL;
 
-extern String formatBeatString();
-extern String formatTimecodeString();
+extern TimecodeText formatBeatString();
+extern TimecodeText formatTimecodeString();
 extern char timeCodeChars_clean[13];
 
 static bool hasDigit(const char* s) {
@@ -109,9 +109,9 @@ void uiHeaderUpdate() {
     if (!s_timecode || !s_tc_ghost) return;
     if (!hasDigit(timeCodeChars_clean)) return;
 
-    String displayText = (currentTimecodeMode == MODE_BEATS)
-                         ? formatBeatString()
-                         : formatTimecodeString();
+    TimecodeText displayText = (currentTimecodeMode == MODE_BEATS)
+                               ? formatBeatString()
+                               : formatTimecodeString();
     lv_label_set_text(s_timecode, displayText.c_str());
     lv_label_set_text(s_tc_ghost,
                       (currentTimecodeMode == MODE_BEATS)
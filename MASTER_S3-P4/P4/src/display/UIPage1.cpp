@@ -62,14 +62,14 @@ static void btn_event_cb(lv_event_t* e) {
             // TODO: cambio a PG2 cuando esté implementada
             return;
         }
-        if (MIDI_NOTES_PG1[idx] != 0x00) {
-            uint8_t msg[3] = { 0x90, MIDI_NOTES_PG1[idx], 0x7F };
+        if (MCU_NOTES.note[MCU_PG1][idx] != 0x00) {
+            uint8_t msg[3] = { 0x90, MCU_NOTES.note[MCU_PG1][idx], 0x7F };
             sendMIDIBytes(msg, 3);
         }
     } else if (code == LV_EVENT_RELEASED) {
         if (idx == 31) return;
-        if (MIDI_NOTES_PG1[idx] != 0x00) {
-            uint8_t msg[3] = { 0x90, MIDI_NOTES_PG1[idx], 0x00 };
+        if (MCU_NOTES.note[MCU_PG1][idx] != 0x00) {
+            uint8_t msg[3] = { 0x90, MCU_NOTES.note[MCU_PG1][idx], 0x00 };
             sendMIDIBytes(msg, 3);
         }
     }
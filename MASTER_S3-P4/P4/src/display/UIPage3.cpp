@@ -222,11 +222,15 @@ void uiPage3Update() {
             int pos = (int)(vpotValues[i] & 0x0F);
             int pan = ((pos - 6) * 100) / 6;
             lv_arc_set_value(s_arc[i], pan);
-            char pan_txt[5];
-            if (pos == 6)      snprintf(pan_txt, sizeof(pan_txt), "C");
-            else if (pos > 6)  snprintf(pan_txt, sizeof(pan_txt), "R%d", pos - 6);
-            else               snprintf(pan_txt, sizeof(pan_txt), "L%d", 6 - pos);
-            lv_label_set_text(s_arc_lbl[i], pan_txt);
+            if (!lcdValues[i].empty()) {
+                lv_label_set_text(s_arc_lbl[i], lcdValues[i].c_str());   // valor que muestra Logic
+            } else {
+                char pan_txt[5];
+                if (pos == 6)      snprintf(pan_txt, sizeof(pan_txt), "C");
+                else if (pos > 6)  snprintf(pan_txt, sizeof(pan_txt), "R%d", pos - 6);
+                else               snprintf(pan_txt, sizeof(pan_txt), "L%d", 6 - pos);
+                lv_label_set_text(s_arc_lbl[i], pan_txt);
+            }
         }
         needsButtonsRedraw = false;
     }
@@ -65,8 +65,8 @@ static const lv_color_t AUTOMODE_COLORS[] = {
 static const uint8_t AUTOMODE_NOTES[] = { 0x4A, 0x4D, 0x4E, 0x4B }; // READ TOUCH LATCH WRITE
 
 extern void sendMIDIBytes(const byte* data, size_t len);
-extern String formatBeatString();
-extern String formatTimecodeString();
+extern TimecodeText formatBeatString();
+extern TimecodeText formatTimecodeString();
 extern uint8_t g_channelAutoMode[8];
 
 
@@ -248,11 +248,15 @@ void uiPage3BUpdate() {
             int pos = (int)(vpotValues[i] & 0x0F);
             int pan = ((pos - 6) * 100) / 6;
             lv_arc_set_value(s_arc[i], pan);
-            char pan_txt[5];
-            if (pos == 6)      snprintf(pan_txt, sizeof(pan_txt), "C");
-            else if (pos > 6)  snprintf(pan_txt, sizeof(pan_txt), "R%d", pos - 6);
-            else               snprintf(pan_txt, sizeof(pan_txt), "L%d", 6 - pos);
-            lv_label_set_text(s_arc_lbl[i], pan_txt);
+            if (!lcdValues[i].empty()) {
+                lv_label_set_text(s_arc_lbl[i], lcdValues[i].c_str());   // valor que muestra Logic
+            } else {
+                char pan_txt[5];
+                if (pos == 6)      snprintf(pan_txt, sizeof(pan_txt), "C");
+                else if (pos > 6)  snprintf(pan_txt, sizeof(pan_txt), "R%d", pos - 6);
+                else               snprintf(pan_txt, sizeof(pan_txt), "L%d", 6 - pos);
+                lv_label_set_text(s_arc_lbl[i], pan_txt);
+            }
             int fval = (int)(faderPositions[i] * 16383.0f);
             lv_slider_set_value(s_fader[i], fval, LV_ANIM_OFF);
         }
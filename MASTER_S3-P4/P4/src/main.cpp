@@ -23,21 +23,23 @@ volatile ConnectionState logicConnectionState = ConnectionState::DISCONNECTED;
 uint8_t g_logicConnected = 0;
 uint8_t vpotValues[8] = {};
 
-String trackNames[9];
+TrackName trackNames[MCU_CHANNELS];
+TrackName lcdValues[8];
 bool recStates[8]    = {}, soloStates[8] = {};
 bool muteStates[8]   = {}, selectStates[8] = {};
-float vuLevels[9]    = {};
-bool vuClipState[9]  = {};
-unsigned long vuLastUpdateTime[9]     = {};
-float vuPeakLevels[9]                 = {};
-unsigned long vuPeakLastUpdateTime[9] = {};
-float faderPositions[9]               = {};
+float vuLevels[MCU_CHANNELS]    = {};
+bool vuClipState[MCU_CHANNELS]  = {};
+unsigned long vuLastUpdateTime[MCU_CHANNELS]     = {};
+float vuPeakLevels[MCU_CHANNELS]                 = {};
+unsigned long vuPeakLastUpdateTime[MCU_CHANNELS] = {};
+float faderPositions[MCU_CHANNELS]               = {};
 bool needsTOTALRedraw    = false;
 bool needsMainAreaRedraw = false;
 bool needsHeaderRedraw   = false;
 bool needsTimecodeRedraw = true;
 bool needsButtonsRedraw  = true;
-bool needsVUMetersRedraw = true;String assignmentString  = "--";
+bool needsVUMetersRedraw = true;
+AssignText assignmentString = "--";
 bool btnStatePG1[32] = {}, btnStatePG2[32] = {};
 bool btnFlashPG1[32] = {}, btnFlashPG2[32] = {};
 char timeCodeChars_clean[13] = {};
@@ -61,60 +63,75 @@ volatile bool g_switchToPage1 = false;
 
 void updateLeds() {}
 
-static void processSlaveResponse(uint8_t slaveId) {
-    const ChannelData& ch = rs485.getChannel(slaveId);
-    uint8_t midiCh = slaveId - 1;
-
-    if (ch.touchState) {
-        uint16_t pb  = ch.faderPos;
-        byte msg[3]  = { (byte)(0xE0 | midiCh),
-                         (byte)(pb & 0x7F),
-                         (byte)(pb >> 7) };
-        sendMIDIBytes(msg, 3);
-    }
-
-    uint8_t changed = ch.buttons ^ ch.prevButtons;
-    if (changed) {
-        const uint8_t noteBase[4] = { 0, 8, 16, 24 };
-        for (uint8_t bit = 0; bit < 4; bit++) {
-            if (changed & (1 << bit)) {
-                bool isOn    = (ch.buttons & (1 << bit)) != 0;
-                uint8_t note = noteBase[bit] + midiCh;
-                uint8_t vel  = isOn ? 127 : 0;
-                byte msg[3]  = { (byte)(isOn ? 0x90 : 0x80), note, vel };
-                sendMIDIBytes(msg, 3);
-            }
+static void processSlaveEvent(const SlaveEvent& ev) {
+    uint8_t midiCh = ev.id - 1;          // 0..7 strips, 8 = master (static_assert en config.h)
+    const bool master = midiCh >= MCU_STRIPS;
+
+    switch (ev.type) {
+        case SlaveEvtType::FADER: {
+            uint16_t pb  = (uint16_t)ev.value;
+            byte msg[3]  = { (byte)(0xE0 | midiCh),
+                             (byte)(pb & 0x7F),
+                             (byte)(pb >> 7) };
+            sendMIDIBytes(msg, 3);
+            break;
         }
-    }
+        case SlaveEvtType::BUTTON: {
+            if (master) break;           // notas 0..31 = 4 filas × 8 strips; el master no tiene
+            const uint8_t noteBase[4] = { 0, 8, 16, 24 };
+            uint8_t note = noteBase[ev.arg] + midiCh;
+            uint8_t vel  = ev.on ? 127 : 0;
+            byte msg[3]  = { (byte)(ev.on ? 0x90 : 0x80), note, vel };
+            sendMIDIBytes(msg, 3);
+            break;
+        }
+        case SlaveEvtType::ENCODER: {
+            if (master) break;           // CC 16..23: VPots de los 8 strips
+            uint8_t cc  = 16 + midiCh;
+            uint8_t val = (ev.value > 0) ? 65 : 63;
+            byte msg[3] = { (byte)(0xB0 | midiCh), cc, val };
+            sendMIDIBytes(msg, 3);
+            break;
+        }
+        case SlaveEvtType::TOUCH:
+            break;   // sin mensaje MCU por ahora
 
-    if (ch.encoderDelta != 0) {
-        uint8_t cc  = 16 + midiCh;
-        uint8_t val = (ch.encoderDelta > 0) ? 65 : 63;
-        byte msg[3] = { (byte)(0xB0 | midiCh), cc, val };
-        sendMIDIBytes(msg, 3);
+        // --- Presencia: touch/botones ya llegan soltados como eventos normales ---
+        case SlaveEvtType::PRESENCE:
+            if (!ev.on) log_w("[MIDI] Strip %d OFFLINE — canal %d sin control físico", ev.id, midiCh + 1);
+            break;
     }
 }
 
 void taskCore0(void* pvParameters) {
     log_e("MIDI task en Core %d", xPortGetCoreID());
     for (;;) {
-        uint8_t rx_buf[64];
-        uint32_t count = tud_midi_stream_read(rx_buf, sizeof(rx_buf));
-        if (count > 0) {
-            for (uint32_t i = 0; i < count; i++)
-                processMidiByte(rx_buf[i]);
-        }
-
-        if (logicConnectionState == ConnectionState::CONNECTED) {
-            for (uint8_t id = 1; id <= NUM_SLAVES; id++) {
-                if (rs485.hasNewSlaveData(id))
-                    processSlaveResponse(id);
+        // Paquetes USB-MIDI enteros: el CIN ya delimita cada mensaje
+        uint8_t pkt[4];
+        for (uint8_t n = 0; n < MIDI_RX_PACKETS_PER_LOOP && tud_midi_packet_read(pkt); n++)
+            processMidiPacket(pkt);
+
+        // Eventos RS485: se drenan siempre; sin Logic se descartan
+        SlaveEvent ev;
+        SlaveEvent faders[8];          // perfil fader → MIDI: medido tras el flush
+        uint8_t    nFaders = 0;
+        while (rs485.popEvent(ev)) {
+            if (logicConnectionState == ConnectionState::CONNECTED) {
+                processSlaveEvent(ev);
+                if (ev.type == SlaveEvtType::FADER && nFaders < 8) faders[nFaders++] = ev;
             }
         }
 
         tickCalibracion();
         // checkMidiTimeout();
-        vTaskDelay(1);
+        // Todo lo encolado en esta vuelta (y por UI/Transporte) sale en un único flush
+        MidiTx::flush();
+        const uint32_t now = micros();
+        for (uint8_t i = 0; i < nFaders; i++)
+            rs485.profileE2E(faders[i].id, now - faders[i].t);
+
+        // Despierta con evento RS485; USB MIDI se sigue sondeando cada 1 ms
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1));
     }
 }
 
@@ -248,18 +265,45 @@ void setup() {
     log_i("   MIDI OK");
 
     // 8. RS485
-    log_i("7. RS485.begin(%d)...", NUM_SLAVES);
-    rs485.begin(NUM_SLAVES);
-    log_i("   RS485 OK — TX:%d RX:%d EN:%d", 
+    log_i("7. RS485.begin(%d slaves, %d buses)...", NUM_SLAVES, RS485_NUM_BUSES);
+    rs485.begin();
+    log_i("   RS485 OK — bus A TX:%d RX:%d EN:%d",
           RS485_TX_PIN, RS485_RX_PIN, RS485_ENABLE_PIN);
 
     // 9. Crear tareas
     log_i("8. Creando tareas...");
     xTaskCreatePinnedToCore(taskCore0, "MIDI", 4096, NULL, 2, &taskCore0Handle, 0);
     xTaskCreatePinnedToCore(taskCore1, "UI", 16384, NULL, 1, &taskCore1Handle, 1);
+    rs485.setEventTask(taskCore0Handle);
+    rs485.startTask();   // un task de polling por bus
     log_i("   Tareas creadas");
 
     log_i("=== P4 Master ACTIVO. Slaves: %d ===", NUM_SLAVES);
 }
 
-void loop() { vTaskDelay(portMAX_DELAY); }
\ No newline at end of file
+// Firmware S2 por el bus: solo a petición ('u'), nunca al arrancar. El
+// borrado bloquea cada bus varios segundos y al boot los slaves aún no
+// están ONLINE (solo se actualizan los ONLINE con SLAVE_CAP_FW).
+static void requestSlaveFirmware() {
+    const char* full  = LittleFS.exists(RS485_FW_PATH)       ? RS485_FW_PATH       : nullptr;
+    const char* delta = LittleFS.exists(RS485_FW_DELTA_PATH) ? RS485_FW_DELTA_PATH : nullptr;
+    if (!delta && !full) {
+        log_w("[FW] Ni %s ni %s en LittleFS", RS485_FW_DELTA_PATH, RS485_FW_PATH);
+        return;
+    }
+    log_i("[FW] Firmware S2 en %s%s%s → actualización por el bus",
+          delta ? delta : full, delta && full ? ", completa en " : "", delta && full ? full : "");
+    rs485.requestFirmware(delta ? delta : full, delta ? full : nullptr);
+}
+
+// Consola por Serial: 'p' informe, 'P' snapshot binario (tools/rs485prof), 'r' reset,
+// 'u' firmware S2 por el bus
+void loop() {
+    switch (Serial.read()) {
+        case 'p': rs485.printStats(); MidiTx::printStats(); break;
+        case 'P': rs485.writeProfile(Serial); break;
+        case 'r': rs485.resetStats(); log_i("[PROF] Estadísticas a cero"); break;
+        case 'u': requestSlaveFirmware(); break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+}
\ No newline at end of file
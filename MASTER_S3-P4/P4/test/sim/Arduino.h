@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include "sim.h"
+#include "freertos/FreeRTOS.h"
+#include "sim_rs485.h"
+
+// ============================================================
+//  Arduino.h (host)  –  lo que usa src/RS485 sobre el reloj de
+//  sim.h. HardwareSerial escribe y lee en una sim::Line; el
+//  RS485Slave del S2 (test del S2) la usa igual, desde el lado
+//  que aquí se llama master.
+// ============================================================
+
+typedef uint8_t byte;
+
+// Solo para declaraciones (extern String ... de config.h del S2)
+class String : public std::string {
+public:
+    using std::string::string;
+};
+
+#define LOW    0
+#define HIGH   1
+#define OUTPUT 1
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+
+inline uint32_t micros() { return (uint32_t)sim::now(); }
+inline uint32_t millis() { return (uint32_t)(sim::now() / 1000); }
+inline void delayMicroseconds(uint32_t us) { sim::busy(us); }
+inline uint32_t esp_random() { return sim::rng()(); }
+
+// Eventos y tasks nunca corren a la vez (sim.h)
+#define IRAM_ATTR
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#define log_e(fmt, ...) sim::log(1, fmt, ##__VA_ARGS__)
+#define log_w(fmt, ...) sim::log(2, fmt, ##__VA_ARGS__)
+#define log_i(fmt, ...) sim::log(3, fmt, ##__VA_ARGS__)
+#define log_d(fmt, ...) sim::log(4, fmt, ##__VA_ARGS__)
+#define log_v(fmt, ...) sim::log(5, fmt, ##__VA_ARGS__)
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* buf, size_t len) = 0;
+    size_t write(uint8_t c) { return write(&c, 1); }
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char    buf[256];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        write((const uint8_t*)buf, strlen(buf));
+        return n;
+    }
+};
+
+// USB CDC: consola, se descarta
+class HWCDC : public Print {
+public:
+    size_t write(const uint8_t*, size_t len) override { return len; }
+};
+inline HWCDC Serial;
+
+#define SERIAL_8N1 0x800001c
+enum SerialMode { UART_MODE_UART = 0, UART_MODE_RS485_HALF_DUPLEX = 1 };
+
+// UART en modo RS485 half-duplex: write() vuelve al instante, flush()
+// espera al último bit; el master no oye su propia trama
+class HardwareSerial : public Print {
+public:
+    sim::Line line;
+
+    void setRxBufferSize(size_t) {}
+    void setTxBufferSize(size_t) {}
+    void begin(uint32_t baud, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {
+        line.baseBaud = line.masterBaud = baud;
+        _begun = true;
+    }
+    void end() { _begun = false; }
+    explicit operator bool() const { return _begun; }
+    bool setPins(int8_t, int8_t, int8_t, int8_t) { return true; }
+    bool setMode(SerialMode) { return true; }
+    bool setRxFIFOFull(uint8_t n) { line.fifoFull = n; return true; }
+    bool setRxTimeout(uint8_t symbols) { line.rxTimeoutSym = symbols; return true; }
+    void onReceive(std::function<void()> cb, bool onlyOnTimeout = false) {
+        line.onRx          = cb;
+        line.onlyOnTimeout = onlyOnTimeout;
+    }
+    void updateBaudRate(uint32_t baud) { line.masterBaud = baud; }
+
+    int    available() { return line.available(); }
+    int    read()      { return line.read(); }
+    void   flush()     { sim::block(line.masterFreeAt); }
+    using Print::write;
+    size_t write(const uint8_t* buf, size_t len) override { return line.masterWrite(buf, len); }
+
+private:
+    bool _begun = false;
+};
+
+inline HardwareSerial Serial1, Serial2;
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// ============================================================
+//  LittleFS.h (host)  –  ficheros en memoria, solo lectura desde
+//  src (RS485Fw abre la imagen S2). El test los crea con
+//  LittleFS.files["/ruta"] = bytes.
+// ============================================================
+
+class File {
+public:
+    File() = default;
+    explicit File(const std::vector<uint8_t>* data) : _data(data) {}
+
+    explicit operator bool() const { return _data != nullptr; }
+    size_t size() const { return _data ? _data->size() : 0; }
+
+    bool seek(uint32_t pos) {
+        if (!_data || pos > _data->size()) return false;
+        _pos = pos;
+        return true;
+    }
+    size_t read(uint8_t* buf, size_t n) {
+        if (!_data) return 0;
+        if (n > _data->size() - _pos) n = _data->size() - _pos;
+        memcpy(buf, _data->data() + _pos, n);
+        _pos += n;
+        return n;
+    }
+    void close() { _data = nullptr; }
+
+private:
+    const std::vector<uint8_t>* _data = nullptr;
+    size_t _pos = 0;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool = false) { return true; }
+    bool exists(const char* path) const { return files.count(path) != 0; }
+    File open(const char* path, const char* = "r") {
+        auto it = files.find(path);
+        return it == files.end() ? File() : File(&it->second);
+    }
+
+    std::map<std::string, std::vector<uint8_t>> files;
+};
+
+inline LittleFSFS LittleFS;
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <string>
+
+// ============================================================
+//  Preferences.h (host)  –  NVS en memoria, compartido por todas
+//  las instancias (como la flash). store().clear() = flash borrada.
+// ============================================================
+
+class Preferences {
+public:
+    bool begin(const char* ns, bool = false) { _ns = ns; return true; }
+    void end() {}
+
+    uint8_t getUChar(const char* key, uint8_t def = 0) {
+        auto it = store().find(_ns + "/" + key);
+        return it == store().end() ? def : it->second;
+    }
+    size_t putUChar(const char* key, uint8_t value) {
+        store()[_ns + "/" + key] = value;
+        return 1;
+    }
+
+    static std::map<std::string, uint8_t>& store() {
+        static std::map<std::string, uint8_t> s;
+        return s;
+    }
+
+private:
+    std::string _ns;
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  USBMIDI.h (host)  –  salida USB-MIDI de MIDIProcessor: cuenta
+//  los paquetes escritos y guarda el último. Sin heap.
+// ============================================================
+
+typedef struct {
+    uint8_t header;
+    uint8_t byte1;
+    uint8_t byte2;
+    uint8_t byte3;
+} midiEventPacket_t;
+
+class USBMIDI {
+public:
+    void begin() {}
+    bool writePacket(midiEventPacket_t* p) {
+        last = *p;
+        written++;
+        return true;
+    }
+
+    midiEventPacket_t last    = {};
+    uint32_t          written = 0;
+};
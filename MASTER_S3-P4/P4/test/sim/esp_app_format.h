@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  esp_app_format.h (host)  –  cabecera de imagen de app (IDF)
+// ============================================================
+
+#define ESP_IMAGE_HEADER_MAGIC 0xE9
+#define ESP_CHIP_ID_ESP32S2    0x0002
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;
+    uint8_t  segment_count;
+    uint8_t  spi_mode;
+    uint8_t  spi_speed_size;
+    uint32_t entry_addr;
+    uint8_t  wp_pin;
+    uint8_t  spi_pin_drv[3];
+    uint16_t chip_id;
+    uint8_t  min_chip_rev;
+    uint16_t min_chip_rev_full;
+    uint16_t max_chip_rev_full;
+    uint8_t  reserved[4];
+    uint8_t  hash_appended;
+} esp_image_header_t;
+
+typedef struct {
+    uint32_t load_addr;
+    uint32_t data_len;
+} esp_image_segment_header_t;
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <memory>
+#include <vector>
+#include "sim.h"
+
+// ============================================================
+//  esp_timer.h (host)  –  one-shot sobre el reloj de sim.h.
+//  stop() invalida el disparo pendiente (generación).
+// ============================================================
+
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_ERR_INVALID_STATE  0x103
+#define ESP_ERROR_CHECK(x) do { if ((x) != ESP_OK) abort(); } while (0)
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t       callback;
+    void*                arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char*          name;
+    bool                 skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+    esp_timer_cb_t cb;
+    void*          arg;
+    uint32_t       gen   = 0;
+    bool           armed = false;
+};
+typedef esp_timer* esp_timer_handle_t;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    static std::vector<std::unique_ptr<esp_timer>> timers;
+    timers.emplace_back(new esp_timer{args->callback, args->arg});
+    *out = timers.back().get();
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t us) {
+    const uint32_t gen = ++t->gen;
+    t->armed = true;
+    sim::at(sim::now() + us, [t, gen]() {
+        if (!t->armed || t->gen != gen) return;
+        t->armed = false;
+        t->cb(t->arg);
+    });
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (!t->armed) return ESP_ERR_INVALID_STATE;
+    t->armed = false;
+    t->gen++;
+    return ESP_OK;
+}
+
+inline int64_t esp_timer_get_time() { return (int64_t)sim::now(); }
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include "../sim.h"
+
+// ============================================================
+//  FreeRTOS.h (host)  –  notificaciones y retardos de task sobre
+//  el reloj de sim.h. Tick de 1 ms.
+// ============================================================
+
+typedef sim::Task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+typedef uint32_t   TickType_t;
+typedef int        BaseType_t;
+typedef unsigned   UBaseType_t;
+
+#define pdFALSE               0
+#define pdTRUE                1
+#define pdPASS                1
+#define portMAX_DELAY         0xFFFFFFFFu
+#define configMAX_PRIORITIES  25
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(ms))
+
+enum eNotifyAction { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite };
+
+inline BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    sim::notify(task, action == eSetBits ? value : 0);
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    sim::notify(task, 0, true);
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyWait(uint32_t, uint32_t clearOnExit, uint32_t* value, TickType_t ticks) {
+    return sim::waitNotify((uint64_t)ticks * 1000, clearOnExit, value) ? pdTRUE : pdFALSE;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    return sim::takeNotify(clear, (uint64_t)ticks * 1000);
+}
+
+inline void vTaskDelay(TickType_t ticks) { sim::sleep((uint64_t)ticks * 1000); }
+
+// Sin otro task listo el bucle de polling gira: espera activa, y
+// cada vuelta cuenta como un despertar del task
+inline void taskYIELD() {
+    if (sim::Task* t = sim::state().current) t->wakeups++;
+    sim::busy(sim::state().yieldUs);
+}
+
+// Secciones críticas: un solo hilo corre a la vez
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux)  ((void)(mux))
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return sim::state().current; }
+
+// El task no arranca aquí: lo corre sim::run()
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t,
+                                          void* arg, UBaseType_t prio, TaskHandle_t* handle, BaseType_t) {
+    TaskHandle_t t = sim::createTask(fn, name, arg, prio);
+    if (handle) *handle = t;
+    return pdPASS;
+}
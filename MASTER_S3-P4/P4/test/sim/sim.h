@@ -0,0 +1,304 @@
+#pragma once
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// ============================================================
+//  sim.h  –  reloj virtual para correr src/RS485 en host
+//
+//  Varios tasks (runTask() de cada bus, el responder del S2...)
+//  corren de verdad, cada uno en su hilo, pero de uno en uno: el
+//  planificador les pasa el turno como un núcleo con prioridades.
+//  Cada llamada que en el ESP32 bloquea (xTaskNotifyWait,
+//  vTaskDelay, flush) devuelve el turno hasta su evento o plazo;
+//  delayMicroseconds / taskYIELD son espera activa y cuentan como
+//  CPU del task. Un evento que notifica a un task bloqueado lo
+//  despierta wakeUs después (ISR → task corriendo otra vez).
+//
+//  Eventos (esp_timer, UART onReceive, acciones del test) corren
+//  en el hilo del test, nunca a la vez que un task. reset() y
+//  stop() terminan los tasks (Stop desde su llamada bloqueante).
+//
+//  Los fakes de Arduino.h / FreeRTOS.h / esp_timer.h /
+//  Preferences.h de este directorio solo llaman a esto.
+// ============================================================
+
+namespace sim {
+
+struct Stop {};                                  // fin de la simulación
+
+struct Task {
+    void      (*fn)(void*) = nullptr;
+    void*       arg        = nullptr;
+    char        name[16]   = "";                 // copia, como FreeRTOS
+    unsigned    prio       = 0;
+    uint32_t    bits       = 0;                  // valor de notificación
+    bool        notified   = false;
+
+    // Medida: vueltas de una espera bloqueante y µs de espera activa
+    uint32_t    wakeups    = 0;
+    uint64_t    busyUs     = 0;
+
+    // Planificador
+    uint64_t    wakeAt     = 0;                  // listo desde este instante
+    bool        onNotify   = false;              // bloqueado esperando notificación
+    bool        started = false, go = false, done = false;
+    std::thread             thread;
+    std::condition_variable cv;
+};
+
+struct State {
+    uint64_t now     = 0;
+    uint32_t wakeUs  = 5;                        // evento → task corriendo otra vez
+    uint32_t yieldUs = 1;                        // taskYIELD sin otro task listo
+    std::multimap<uint64_t, std::function<void()>> events;   // mismo instante: orden de alta
+    std::vector<std::unique_ptr<Task>>             tasks;
+    Task*        current  = nullptr;             // nullptr = hilo del test
+    bool         stopping = false;
+    std::mutex               m;
+    std::condition_variable  turn;               // el task devuelve el turno
+    std::mt19937 rng;
+    int          logLevel = 0;                   // IMAKIE_SIM_LOG=1..5 (e..v)
+    std::function<void(uint64_t)> onSleep;       // vTaskDelay(us) de un task (p.ej. relleno del barrido)
+
+    ~State();
+};
+
+inline State& state() {
+    static State s;
+    return s;
+}
+
+inline uint64_t now() { return state().now; }
+inline std::mt19937& rng() { return state().rng; }
+
+// Uniforme en [0, n]
+inline uint32_t jitter(uint32_t n) {
+    return n ? std::uniform_int_distribution<uint32_t>(0, n)(rng()) : 0;
+}
+
+inline void at(uint64_t t, std::function<void()> fn) {
+    state().events.emplace(t, std::move(fn));
+}
+
+// Acción periódica del test (p.ej. el task MIDI drenando eventos)
+inline void every(uint64_t first, uint32_t periodUs, std::function<void()> fn) {
+    at(first, [first, periodUs, fn]() {
+        fn();
+        every(first + periodUs, periodUs, fn);
+    });
+}
+
+// ─── Turnos ───────────────────────────────────────────────────
+
+inline void _entry(Task* t) {
+    State& s = state();
+    try {
+        if (!s.stopping) t->fn(t->arg);
+    } catch (const Stop&) {
+    }
+    std::lock_guard<std::mutex> lk(s.m);
+    t->done = true;
+    t->go   = false;
+    s.turn.notify_one();
+}
+
+// Hilo del test: da el turno a 't' hasta que se bloquee o termine
+inline void _resume(Task* t) {
+    State& s = state();
+    std::unique_lock<std::mutex> lk(s.m);
+    s.current = t;
+    t->go     = true;
+    if (!t->started) {
+        t->started = true;
+        t->thread  = std::thread(_entry, t);
+    } else {
+        t->cv.notify_one();
+    }
+    s.turn.wait(lk, [t]() { return !t->go; });
+    s.current = nullptr;
+}
+
+// El listo de más prioridad; a igualdad, el que lleva más esperando
+inline Task* _ready() {
+    State& s = state();
+    Task*  best = nullptr;
+    for (auto& t : s.tasks) {
+        if (t->done || t->wakeAt > s.now) continue;
+        if (!best || t->prio > best->prio || (t->prio == best->prio && t->wakeAt < best->wakeAt))
+            best = t.get();
+    }
+    return best;
+}
+
+// Hilo del test: eventos y tasks hasta 'until'
+inline void runUntil(uint64_t until) {
+    State& s = state();
+    for (;;) {
+        auto it = s.events.begin();
+        if (it != s.events.end() && it->first <= s.now) {
+            auto fn = std::move(it->second);
+            s.events.erase(it);
+            fn();
+            continue;
+        }
+        if (Task* t = _ready()) {
+            _resume(t);
+            continue;
+        }
+        uint64_t next = it != s.events.end() ? it->first : UINT64_MAX;
+        for (auto& t : s.tasks)
+            if (!t->done && t->wakeAt < next) next = t->wakeAt;
+        if (next > until) {
+            if (until > s.now) s.now = until;
+            return;
+        }
+        s.now = next;
+    }
+}
+
+// Desde un task: devuelve el turno hasta 'until' (o notificación).
+// Desde el hilo del test: corre la simulación hasta 'until'.
+inline void block(uint64_t until, bool onNotify = false) {
+    State& s = state();
+    Task*  t = s.current;
+    if (!t) {
+        if (until > s.now) runUntil(until);
+        return;
+    }
+    std::unique_lock<std::mutex> lk(s.m);
+    t->wakeAt   = until;
+    t->onNotify = onNotify;
+    t->go       = false;
+    s.turn.notify_one();
+    t->cv.wait(lk, [t]() { return t->go; });
+    t->onNotify = false;
+    if (s.stopping) throw Stop{};
+}
+
+// Espera activa (delayMicroseconds, taskYIELD en bucle): CPU del task
+inline void busy(uint32_t us) {
+    State& s = state();
+    if (s.current) s.current->busyUs += us;
+    block(s.now + us);
+}
+
+// ─── Notificaciones ───────────────────────────────────────────
+
+// increment: xTaskNotifyGive (cuenta); si no, OR de bits
+inline void notify(Task* t, uint32_t bits, bool increment = false) {
+    if (!t) return;
+    if (increment) t->bits++;
+    else t->bits |= bits;
+    t->notified = true;
+    const uint64_t wake = state().now + state().wakeUs;
+    if (t->onNotify && t->wakeAt > wake) t->wakeAt = wake;
+}
+
+// xTaskNotifyWait: notificación pendiente → al instante; si no, hasta
+// notificación + wakeUs o 'maxUs'
+inline bool waitNotify(uint64_t maxUs, uint32_t clearOnExit, uint32_t* value) {
+    State& s = state();
+    Task*  t = s.current;
+    if (!t->notified) {
+        block(s.now + maxUs, true);
+        t->wakeups++;
+    }
+    if (!t->notified) return false;
+    if (value) *value = t->bits;
+    t->bits    &= ~clearOnExit;
+    t->notified = false;
+    return true;
+}
+
+// ulTaskNotifyTake: devuelve la cuenta (0 = plazo cumplido)
+inline uint32_t takeNotify(bool clear, uint64_t maxUs) {
+    State& s = state();
+    Task*  t = s.current;
+    if (!t->bits) {
+        block(s.now + maxUs, true);
+        t->wakeups++;
+    }
+    const uint32_t v = t->bits;
+    if (clear) t->bits = 0;
+    else if (v) t->bits--;
+    t->notified = t->bits != 0;
+    return v;
+}
+
+// vTaskDelay
+inline void sleep(uint64_t us) {
+    State& s = state();
+    if (s.onSleep) s.onSleep(us);
+    block(s.now + us);
+    if (s.current) s.current->wakeups++;
+}
+
+// ─── Vida de la simulación ────────────────────────────────────
+
+// El task arranca en el siguiente run(), listo desde ya
+inline Task* createTask(void (*fn)(void*), const char* name, void* arg, unsigned prio = 0) {
+    State& s = state();
+    s.tasks.emplace_back(new Task);
+    Task* t   = s.tasks.back().get();
+    t->fn     = fn;
+    t->arg    = arg;
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->prio   = prio;
+    t->wakeAt = s.now;
+    return t;
+}
+
+// Corre tasks y eventos 'us' de reloj; los tasks siguen vivos
+inline void run(uint64_t us) { runUntil(state().now + us); }
+
+// Termina todos los tasks (antes de destruir lo que usan)
+inline void stop() {
+    State& s = state();
+    s.stopping = true;
+    for (auto& t : s.tasks)
+        if (t->started && !t->done) _resume(t.get());
+    for (auto& t : s.tasks)
+        if (t->thread.joinable()) t->thread.join();
+    s.tasks.clear();
+    s.stopping = false;
+}
+
+inline State::~State() { stop(); }
+
+// Reloj en 1 s (millis() lejos de 0), sin eventos ni tasks
+inline void reset(uint32_t seed = 1) {
+    stop();
+    State& s = state();
+    s.now     = 1000000;
+    s.wakeUs  = 5;
+    s.yieldUs = 1;
+    s.events.clear();
+    s.onSleep = nullptr;
+    s.current = nullptr;
+    s.rng.seed(seed);
+    const char* lv = getenv("IMAKIE_SIM_LOG");
+    s.logLevel = lv ? atoi(lv) : 0;
+}
+
+inline void log(int level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+inline void log(int level, const char* fmt, ...) {
+    if (level > state().logLevel) return;
+    va_list ap;
+    va_start(ap, fmt);
+    printf("%10.3f ms  %-6s ", state().now / 1000.0, state().current ? state().current->name : "");
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+}
+
+}  // namespace sim
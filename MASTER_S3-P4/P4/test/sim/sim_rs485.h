@@ -0,0 +1,427 @@
+#pragma once
+#include <math.h>
+#include <deque>
+#include <imakie_protocol.h>
+#include "sim.h"
+
+// ============================================================
+//  sim_rs485.h  –  cable RS485 y S2 simulados
+//
+//  Line: un bus half-duplex. Cada trama (master o slave) ocupa
+//  [start, end) a 10 bits por byte; dos que se solapan llegan
+//  como basura a todos. El master lo ve por su HardwareSerial
+//  falso (Arduino.h): bytes con su instante de llegada y
+//  onReceive() con FIFO lleno / RX timeout como el UART.
+//
+//  S2: lo que el master ve de un S2_V1 (RS485Slave): respuesta
+//  al fin de trama + RX timeout + despertar del task responder
+//  (+ jitter), ranura de grupo desde el instante de parseo,
+//  cambio de velocidad y vuelta a la base tras
+//  fallbackMs sin tramas válidas. Por encima de maxCode el
+//  enlace no aguanta: badRate de tramas perdidas/respuestas rotas.
+//  dropRate / lateUs / noiseRate: hipos del propio S2 en el poll
+//  individual (sin respuesta, tarde, con CRC roto); broken / replyId:
+//  enlace roto o id mal configurado en todas.
+//  rx: el MasterPacket que aplicaría el S2 (completo, delta o grupo).
+//  Firmware (SLAVE_CAP_FW): BEGIN / DATA / QUERY / COMMIT / REBOOT
+//  como BusOta, sordo mientras borra y verifica; fwLossRate pierde
+//  tramas 0xAF y rompe respuestas de estado (bus con pérdidas).
+// ============================================================
+
+namespace sim {
+
+class S2;
+
+struct Frame {
+    uint64_t  start;
+    uint64_t  end;
+    const S2* src;                 // nullptr = master
+    uint32_t  baud;
+    uint8_t   header;              // primer byte (tipo de trama)
+    bool      group    = false;    // respuesta en ranura de grupo
+    bool      collided = false;    // solapada con otra trama
+    bool      garbled  = false;    // el master la oyó a otra velocidad
+    bool      corrupt  = false;    // error de línea (CRC mal)
+};
+
+inline uint32_t charUs(uint32_t baud, size_t chars) {
+    return (uint32_t)ceil(chars * 10e6 / baud);
+}
+
+class Line {
+public:
+    // ── Lado master (HardwareSerial) ──
+    uint32_t baseBaud     = 0;     // begin(): velocidad base (RS485_BAUD)
+    uint32_t masterBaud   = 0;
+    uint64_t masterFreeAt = 0;     // fin de la última trama del master
+    uint8_t  fifoFull     = 120;
+    uint8_t  rxTimeoutSym = 10;
+    bool     onlyOnTimeout = false;  // onReceive(cb, true): sin evento de FIFO lleno
+    std::function<void()> onRx;
+
+    std::vector<S2*>   slaves;
+    std::vector<Frame> frames;
+    uint32_t           collisions = 0;
+
+    void attach(S2& s) { slaves.push_back(&s); }
+
+    inline size_t masterWrite(const uint8_t* buf, size_t len);
+    inline void   slaveWrite(const S2& s, const uint8_t* buf, size_t len, uint64_t start,
+                             uint32_t baud, bool group, bool corrupt);
+
+    int available() const {
+        int n = 0;
+        for (const RxByte& b : _rx) {
+            if (b.t > now()) break;
+            n++;
+        }
+        return n;
+    }
+
+    int read() {
+        if (_rx.empty() || _rx.front().t > now()) return -1;
+        RxByte b = _rx.front();
+        _rx.pop_front();
+        const Frame& f = frames[b.frame];
+        if (f.collided || f.garbled) return (uint8_t)rng()();
+        return b.b;
+    }
+
+    // Respuestas de 's' que empiezan en [from, to)
+    struct Replies {
+        uint32_t sent = 0, clean = 0, collided = 0;
+    };
+    Replies replies(const S2* s, uint64_t from, uint64_t to) const {
+        Replies r;
+        for (const Frame& f : frames) {
+            if (f.src != s || f.start < from || f.start >= to) continue;
+            r.sent++;
+            if (f.collided) r.collided++;
+            else if (!f.garbled && !f.corrupt) r.clean++;
+        }
+        return r;
+    }
+
+    // Tramas del master con cabecera 'header' que empiezan en [from, to)
+    uint32_t sent(uint8_t header, uint64_t from, uint64_t to) const {
+        uint32_t n = 0;
+        for (const Frame& f : frames)
+            if (!f.src && f.header == header && f.start >= from && f.start < to) n++;
+        return n;
+    }
+
+    // Latencia de las respuestas individuales limpias de 's' en [from, to):
+    // fin de la trama del master anterior → fin de la respuesta
+    std::vector<uint32_t> latencies(const S2* s, uint64_t from, uint64_t to) const {
+        std::vector<uint32_t> out;
+        uint64_t polled = 0;
+        for (const Frame& f : frames) {
+            if (!f.src) polled = f.end;
+            else if (f.src == s && !f.group && f.start >= from && f.start < to &&
+                     !f.collided && !f.garbled && !f.corrupt)
+                out.push_back((uint32_t)(f.end - polled));
+        }
+        return out;
+    }
+
+    // Primera trama del master que empieza en o después de 't' (0 = ninguna)
+    uint64_t nextMasterFrame(uint64_t t) const {
+        for (const Frame& f : frames)
+            if (!f.src && f.start >= t) return f.start;
+        return 0;
+    }
+
+    // Barrido medio en [from, to): broadcast → fin de la última trama
+    // antes del siguiente broadcast (sin el relleno hasta POLL_CYCLE_MS)
+    double sweepUs(uint64_t from, uint64_t to) const {
+        uint64_t sum = 0, start = 0, last = 0;
+        uint32_t n = 0;
+        for (const Frame& f : frames) {
+            if (f.start < from || f.start >= to) continue;
+            if (!f.src && f.header == RS485_BCAST_BYTE) {
+                if (start) { sum += last - start; n++; }
+                start = f.start;
+            }
+            if (f.end > last) last = f.end;
+        }
+        return n ? (double)sum / n : 0;
+    }
+
+    // Fracción de [from, to) con el cable ocupado
+    double busy(uint64_t from, uint64_t to) const {
+        uint64_t us = 0;
+        for (const Frame& f : frames) {
+            uint64_t a = f.start > from ? f.start : from;
+            uint64_t b = f.end < to ? f.end : to;
+            if (b > a) us += b - a;
+        }
+        return (double)us / (to - from);
+    }
+
+private:
+    struct RxByte {
+        uint64_t t;
+        uint8_t  b;
+        uint32_t frame;
+    };
+    std::deque<RxByte> _rx;        // por instante de llegada
+
+    uint32_t _add(const Frame& f) {
+        Frame n = f;
+        size_t first = frames.size() > 64 ? frames.size() - 64 : 0;
+        for (size_t i = first; i < frames.size(); i++) {
+            Frame& o = frames[i];
+            if (o.start < n.end && n.start < o.end) {
+                if (!o.collided || !n.collided) collisions++;
+                o.collided = n.collided = true;
+            }
+        }
+        frames.push_back(n);
+        return (uint32_t)frames.size() - 1;
+    }
+};
+
+class S2 {
+public:
+    explicit S2(uint8_t localId) : id(localId) {}
+
+    uint8_t  id;
+    bool     online     = true;
+    uint8_t  caps       = SLAVE_CAP_DELTA | SLAVE_CAP_BCAST | SLAVE_CAP_BAUD | SLAVE_CAP_GROUP;
+    uint8_t  maxCode    = RS485_BAUD_CODES - 1;   // velocidad más alta que el enlace aguanta
+    float    badRate    = 0.3f;
+    uint32_t wakeUs     = 40;      // RX timeout → respuesta en el FIFO (task responder)
+    uint32_t jitterUs   = 20;      // + uniforme [0, jitterUs]
+    uint32_t fallbackMs = 300;     // RS485_BAUD_FALLBACK_MS del S2
+    bool     touched    = false;   // touch + fader en movimiento
+    float    dropRate   = 0;       // polls individuales sin respuesta
+    uint32_t lateUs     = 0;       // retraso extra de las próximas 'latePolls' respuestas
+    uint32_t latePolls  = 0;
+    std::vector<uint64_t> missed;  // fin de cada poll no contestado (dropRate)
+    float    noiseRate  = 0;       // polls individuales contestados con CRC roto...
+    uint32_t noiseLateUs = 0;      // ...y este retraso extra
+    bool     broken     = false;   // todas las respuestas individuales con CRC roto
+    bool     calibSending = false; // SLAVE_FLAG_CALIB_SENDING: faderPos alterna min/max
+    uint8_t  replyId    = 0;       // != 0: contesta con este id (S2 mal configurado)
+
+    // Firmware por el bus
+    float    fwLossRate = 0;       // cada trama 0xAF: perdida para este S2 / estado con CRC roto
+    uint32_t fwEraseMs  = 800;     // BEGIN → RECEIVING
+    uint32_t fwVerifyMs = 300;     // COMMIT → VERIFIED
+    uint8_t  fwState    = FW_IDLE;
+    uint16_t fwSession  = 0;
+    uint16_t fwBlocks   = 0, fwMissing = 0;
+    uint32_t fwData     = 0;       // DATA en el cable (antes de perderse)
+    uint32_t fwRounds   = 0;       // pasadas de DATA (el bloque vuelve hacia atrás)
+    uint64_t fwRebootAt = 0;       // REBOOT con la imagen verificada
+
+    uint8_t  baudCode   = 0;
+    uint64_t lastValid  = 0;
+    MasterPacket rx     = {};      // estado aplicado (polls individuales y de grupo)
+    uint32_t polls = 0, groupPolls = 0, fallbacks = 0, lineErrors = 0;
+
+    uint32_t baud(uint32_t base) const { return rs485_baudRate(baudCode, base); }
+
+    void onFrame(Line& line, const uint8_t* buf, size_t len, const Frame& f) {
+        if (baudCode && f.start > lastValid + (uint64_t)fallbackMs * 1000) {
+            baudCode = 0;
+            fallbacks++;
+        }
+        if (f.start < _fwBusyUntil) return;                      // borrando / verificando
+        if (buf[0] == RS485_FW_BYTE && len > 5 && buf[2] == FW_OP_DATA) _fwCountData(buf);
+        const uint32_t myBaud = baud(line.baseBaud);
+        if (!online || f.collided || f.baud != myBaud) return;   // basura para este S2
+        if (_lineError()) return;
+        if (rs485_checkFrame(buf, len) != Rs485Status::OK) return;
+        lastValid = f.end;
+
+        // Referencia: RX timeout (2 símbolos) + despertar del task
+        const uint64_t parseAt = f.end + charUs(myBaud, 2) + wakeUs + jitter(jitterUs);
+        switch (buf[0]) {
+            case RS485_BAUD_BYTE:
+                if ((caps & SLAVE_CAP_BAUD) && buf[1] == RS485_BROADCAST_ID &&
+                    buf[2] != baudCode && buf[2] < RS485_BAUD_CODES)
+                    baudCode = buf[2];
+                break;
+            case RS485_GROUP_BYTE: {
+                uint8_t slot;
+                const uint8_t* rec = (caps & SLAVE_CAP_GROUP) ? rs485_groupFind(buf, id, slot) : nullptr;
+                if (!rec) break;
+                rs485_applyRecord(rec, rx);
+                groupPolls++;
+                _reply(line, parseAt + (uint64_t)slot * rs485_get16(&buf[3]), true);
+                break;
+            }
+            case RS485_FW_BYTE:
+                if ((caps & SLAVE_CAP_FW) && !_chance(fwLossRate)) _fw(line, buf, len, parseAt);
+                break;
+            case RS485_DELTA_BYTE:
+                if (!(caps & SLAVE_CAP_DELTA)) break;
+                // fallthrough
+            case RS485_START_BYTE:
+                if (buf[1] != id) break;
+                rs485_applyMaster(buf, rx);
+                polls++;
+                if (broken) {
+                    _reply(line, parseAt, false, true);
+                    break;
+                }
+                // Hipos aislados: tras uno, el poll siguiente sale bien
+                // (el master nunca ve RS485_OFFLINE_MISSES seguidos)
+                if (!_hiccup && _chance(dropRate)) {
+                    missed.push_back(f.end);
+                    _hiccup = true;
+                    break;
+                }
+                if (!_hiccup && _chance(noiseRate)) {
+                    _reply(line, parseAt + noiseLateUs, false, true);
+                    _hiccup = true;
+                    break;
+                }
+                _hiccup = false;
+                if (latePolls) {
+                    latePolls--;
+                    _reply(line, parseAt + lateUs, false);
+                    break;
+                }
+                _reply(line, parseAt, false);
+                break;
+        }
+    }
+
+private:
+    bool _calibMax = false;
+    bool _hiccup   = false;        // el último poll fue un hipo (dropRate / noiseRate)
+    std::vector<uint8_t> _fwPending;   // bit = bloque pendiente
+    uint64_t _fwBusyUntil = 0;
+    int32_t  _fwLastBlock = -1;
+
+    void _fwCountData(const uint8_t* buf) {
+        const int32_t block = rs485_get16(&buf[FW_HEADER_LEN]);
+        if (block <= _fwLastBlock || !fwData) fwRounds++;
+        _fwLastBlock = block;
+        fwData++;
+    }
+
+    // Sordo 'ms' desde el parseo; sin fallback de velocidad al volver
+    void _fwBusy(uint64_t parseAt, uint32_t ms) {
+        _fwBusyUntil = parseAt + (uint64_t)ms * 1000;
+        lastValid    = _fwBusyUntil;
+    }
+
+    void _fw(Line& line, const uint8_t* buf, size_t len, uint64_t parseAt) {
+        const uint8_t  op      = buf[2];
+        const uint16_t session = rs485_get16(&buf[3]);
+        const uint8_t* body    = &buf[FW_HEADER_LEN];
+        if (op == FW_OP_BEGIN) {
+            if (session == fwSession && fwState != FW_IDLE) return;
+            fwSession = session;
+            fwBlocks  = fwMissing = rs485_get16(&body[4]);
+            _fwPending.assign((fwBlocks + 7) / 8, 0xFF);
+            fwState   = FW_RECEIVING;
+            _fwBusy(parseAt, fwEraseMs);
+            return;
+        }
+        if (op == FW_OP_QUERY) {
+            if (body[0] != id) return;
+            const bool mine = session == fwSession && fwState != FW_IDLE;
+            uint8_t  win[FW_NACK_BYTES];
+            uint16_t base = 0;
+            size_t   n    = (mine && fwState == FW_RECEIVING)
+                          ? rs485_fwNackWindow(_fwPending.data(), fwBlocks, rs485_get16(&body[1]), base, win) : 0;
+            uint8_t  out[RS485_FW_STATUS_MAX_LEN];
+            size_t   k = rs485_encodeFwStatus(out, id, mine ? fwState : FW_IDLE, fwSession,
+                                              (mine && fwState == FW_RECEIVING) ? fwMissing : 0, base, win, n);
+            const bool corrupt = _chance(fwLossRate);
+            if (corrupt) out[3] ^= 0x10;
+            line.slaveWrite(*this, out, k, parseAt, baud(line.baseBaud), false, corrupt);
+            return;
+        }
+        if (session != fwSession) return;
+        switch (op) {
+            case FW_OP_DATA: {
+                const uint16_t b = rs485_get16(body);
+                if (fwState != FW_RECEIVING || b >= fwBlocks || !(_fwPending[b >> 3] & (1 << (b & 7)))) break;
+                _fwPending[b >> 3] &= ~(1 << (b & 7));
+                if (--fwMissing == 0) fwState = FW_COMPLETE;
+                break;
+            }
+            case FW_OP_COMMIT:
+                if (fwState != FW_COMPLETE) break;
+                fwState = FW_VERIFIED;
+                _fwBusy(parseAt, fwVerifyMs);
+                break;
+            case FW_OP_REBOOT:
+                if (fwState == FW_VERIFIED && !fwRebootAt) fwRebootAt = parseAt;
+                break;
+            case FW_OP_ABORT:
+                if (fwState == FW_RECEIVING || fwState == FW_COMPLETE) fwState = FW_IDLE;
+                break;
+        }
+    }
+
+    static bool _chance(float p) {
+        return p > 0 && std::uniform_real_distribution<float>(0, 1)(rng()) < p;
+    }
+
+    bool _lineError() {
+        if (baudCode <= maxCode || !_chance(badRate)) return false;
+        lineErrors++;
+        return true;
+    }
+
+    void _reply(Line& line, uint64_t at, bool group, bool broken = false) {
+        SlavePacket p = {};
+        p.id            = replyId ? replyId : id;
+        p.buttons       = SLAVE_FLAG_CALIB_DONE;
+        p.touchState    = touched ? 1 : 0;
+        p.faderPos      = touched ? (uint16_t)((at / 10) * 7 % 4096) : 2000;
+        if (calibSending) {
+            p.buttons |= SLAVE_FLAG_CALIB_SENDING;
+            p.faderPos = (_calibMax = !_calibMax) ? 3900 : 150;
+            if (!_calibMax) p.buttons |= SLAVE_FLAG_CALIB_IS_MIN;   // como RS485Handler del S2
+        }
+        p.encoderButton = caps;
+        uint8_t buf[sizeof(SlavePacket)];
+        rs485_encodeSlave(buf, p);
+        const bool corrupt = broken || _lineError();
+        if (corrupt) buf[3] ^= 0x10;
+        line.slaveWrite(*this, buf, sizeof(buf), at, baud(line.baseBaud), group, corrupt);
+    }
+};
+
+// ─── Line: envío y recepción ──────────────────────────────────
+
+size_t Line::masterWrite(const uint8_t* buf, size_t len) {
+    const uint64_t start = masterFreeAt > now() ? masterFreeAt : now();
+    const uint32_t idx   = _add(Frame{start, start + charUs(masterBaud, len), nullptr, masterBaud, buf[0]});
+    masterFreeAt = frames[idx].end;
+    const Frame f = frames[idx];      // slaveWrite puede realojar 'frames'
+    for (S2* s : slaves) s->onFrame(*this, buf, len, f);
+    return len;
+}
+
+// Bytes al RX del master (half-duplex: si se solapa con su propia
+// trama tampoco los oye bien) y eventos onReceive del UART
+void Line::slaveWrite(const S2& s, const uint8_t* buf, size_t len, uint64_t start,
+                      uint32_t baud, bool group, bool corrupt) {
+    Frame f{start, start + charUs(baud, len), &s, baud, buf[0]};
+    f.group   = group;
+    f.garbled = baud != masterBaud;
+    f.corrupt = corrupt;
+    const uint32_t idx = _add(f);
+
+    for (size_t k = 0; k < len; k++) {
+        RxByte b{start + charUs(baud, k + 1), buf[k], idx};
+        auto   it = _rx.end();
+        while (it != _rx.begin() && (it - 1)->t > b.t) --it;
+        _rx.insert(it, b);
+    }
+    auto wake = [this]() {
+        if (onRx) onRx();
+    };
+    if (len >= fifoFull && !onlyOnTimeout) at(start + charUs(baud, fifoFull), wake);
+    at(frames[idx].end + charUs(masterBaud, rxTimeoutSym), wake);
+}
+
+}  // namespace sim
@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <Arduino.h>
+#include <Preferences.h>
+
+// ============================================================
+//  bus_cpu.h  –  mismo escenario para los dos modos de espera
+//  (test_bus_cpu.cpp: RS485_EVENT_DRIVEN 1, bus_polling.cpp: 0)
+//
+//  Un bus con 9 S2 (touch + fader en movimiento), calentamiento
+//  y ventana de medida. Del task RS485: vueltas de espera
+//  (sim::Task::wakeups) y µs de espera activa (busyUs).
+// ============================================================
+
+struct CpuResult {
+    uint64_t windowUs = 0;
+    uint32_t wakeups  = 0;      // vueltas de xTaskNotifyWait / taskYIELD en la ventana
+    uint64_t busyUs   = 0;      // espera activa (taskYIELD, delayMicroseconds)
+    uint32_t replies  = 0;      // respuestas limpias de los 9 S2
+    uint32_t baud     = 0;
+};
+
+static constexpr uint8_t  CPU_SLAVES    = 9;
+static constexpr uint64_t CPU_WARMUP_US = 1000000;   // negociación de velocidad + latencias aprendidas
+static constexpr uint64_t CPU_WINDOW_US = 500000;
+
+CpuResult runEventDriven(uint32_t seed);
+CpuResult runPolling(uint32_t seed);
+
+template <class Master>
+CpuResult busCpuRun(uint32_t seed) {
+    sim::reset(seed);
+    Preferences::store().clear();
+    CpuResult r;
+    {
+        HardwareSerial uart;
+        std::vector<std::unique_ptr<sim::S2>> s2;
+        for (uint8_t id = 1; id <= CPU_SLAVES; id++) {
+            s2.emplace_back(new sim::S2(id));
+            s2.back()->touched = true;
+            uart.line.attach(*s2.back());
+        }
+        RS485BusConfig cfg = { &uart, -1, -1, -1, 1, CPU_SLAVES, 'A', "baud" };
+        Master master(cfg);
+        master.begin();
+        master.startTask();
+        sim::Task* task = sim::state().tasks.back().get();
+
+        uint32_t wake0 = 0;
+        uint64_t busy0 = 0;
+        const uint64_t t0 = sim::now() + CPU_WARMUP_US;
+        sim::at(t0, [&]() {
+            wake0 = task->wakeups;
+            busy0 = task->busyUs;
+        });
+        sim::every(sim::now() + 1000, 1000, [&]() {   // task MIDI
+            SlaveEvent ev;
+            while (master.popEvent(ev)) {}
+        });
+        sim::run(CPU_WARMUP_US + CPU_WINDOW_US);
+
+        r.windowUs = CPU_WINDOW_US;
+        r.wakeups  = task->wakeups - wake0;
+        r.busyUs   = task->busyUs - busy0;
+        for (auto& s : s2) r.replies += uart.line.replies(s.get(), t0, t0 + CPU_WINDOW_US).clean;
+        r.baud = uart.line.masterBaud;
+        sim::stop();
+    }
+    return r;
+}
@@ -0,0 +1,31 @@
+// ============================================================
+//  bus_polling.cpp  –  src/RS485 con RS485_EVENT_DRIVEN 0
+//  (taskYIELD + available()), la referencia de test_bus_cpu.
+//  Clases y global renombradas: conviven con las del modo
+//  event-driven de test_bus_cpu.cpp en el mismo ejecutable.
+// ============================================================
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#define DEVICE_P4_MASTER
+#include "config.h"
+#undef  RS485_EVENT_DRIVEN
+#define RS485_EVENT_DRIVEN  0
+
+#define RS485Master   RS485MasterPolling
+#define RS485Network  RS485NetworkPolling
+#define rs485         rs485Polling
+#include "../../src/RS485/RS485.cpp"
+
+void RS485Master::requestFirmware(const char*, const char*) {}
+uint32_t RS485Master::_fwUpdate(const char*, uint32_t) { return 0; }
+bool RS485Master::_fwQuery(uint8_t, uint16_t, uint16_t, FwStatus&) { return false; }
+void RS485Master::_fwSend(const uint8_t*, size_t, uint32_t) {}
+void RS485Master::_sleepUs(uint32_t) {}
+
+#include "bus_cpu.h"
+
+CpuResult runPolling(uint32_t seed) { return busCpuRun<RS485Master>(seed); }
@@ -0,0 +1,65 @@
+// ============================================================
+//  test_bus_cpu.cpp  –  CPU del task RS485: eventos frente a polling
+//  pio test -e native -f test_bus_cpu
+//
+//  src/RS485 dos veces en el mismo reloj virtual: aquí tal cual
+//  (RS485_EVENT_DRIVEN 1: onReceive + esp_timer despiertan al task)
+//  y en bus_polling.cpp con RS485_EVENT_DRIVEN 0 (taskYIELD en
+//  bucle leyendo available()). Mismo bus, mismos S2, misma semilla:
+//  la tasa de respuestas no cambia, las vueltas y la CPU sí.
+// ============================================================
+#include <unity.h>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#define DEVICE_P4_MASTER
+#include "../../src/RS485/RS485.cpp"
+#include "bus_cpu.h"
+
+uint8_t g_logicConnected = 1;
+
+void RS485Master::requestFirmware(const char*, const char*) {}
+uint32_t RS485Master::_fwUpdate(const char*, uint32_t) { return 0; }
+bool RS485Master::_fwQuery(uint8_t, uint16_t, uint16_t, FwStatus&) { return false; }
+void RS485Master::_fwSend(const uint8_t*, size_t, uint32_t) {}
+void RS485Master::_sleepUs(uint32_t) {}
+
+CpuResult runEventDriven(uint32_t seed) { return busCpuRun<RS485Master>(seed); }
+
+void setUp() {}
+void tearDown() {}
+
+static void report(const char* mode, const CpuResult& r) {
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-8s %7u vueltas (%.2f por respuesta)  CPU en espera activa %5.1f %%  %u resp/s a %u baud",
+             mode, (unsigned)r.wakeups, (double)r.wakeups / (r.replies ? r.replies : 1),
+             100.0 * r.busyUs / r.windowUs, (unsigned)(r.replies * 1e6 / r.windowUs), (unsigned)r.baud);
+    TEST_MESSAGE(msg);
+}
+
+// Event-driven: un puñado de vueltas por transacción (RX, timer del
+// GAP, red de seguridad) y casi nada de espera activa. Polling: el
+// task gira entero en taskYIELD. La tasa de respuestas es la misma.
+static void test_event_driven_vs_polling_cpu() {
+    const CpuResult ev   = runEventDriven(11);
+    const CpuResult poll = runPolling(11);
+    report("eventos", ev);
+    report("polling", poll);
+
+    TEST_ASSERT_EQUAL_UINT32(poll.baud, ev.baud);
+    TEST_ASSERT_UINT32_WITHIN(poll.replies / 20, poll.replies, ev.replies);
+
+    TEST_ASSERT_LESS_OR_EQUAL(4 * ev.replies, ev.wakeups);
+    TEST_ASSERT_LESS_THAN(ev.windowUs / 100, ev.busyUs);       // < 1 % de CPU
+    TEST_ASSERT_GREATER_THAN(ev.windowUs * 9 / 10, poll.busyUs);
+    TEST_ASSERT_GREATER_THAN(50 * ev.wakeups, poll.wakeups);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_event_driven_vs_polling_cpu);
+    return UNITY_END();
+}
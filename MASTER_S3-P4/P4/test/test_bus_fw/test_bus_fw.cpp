@@ -0,0 +1,145 @@
+// ============================================================
+//  test_bus_fw.cpp  –  firmware S2 por el bus (RS485Fw.cpp) en host
+//  pio test -e native -f test_bus_fw
+//
+//  src/RS485/RS485.cpp + RS485Fw.cpp tal cual sobre test/sim: la
+//  imagen sale de un LittleFS en memoria y los S2 simulados la
+//  reciben como BusOta (borrado y verificación sordos). Con
+//  fwLossRate cada S2 pierde tramas 0xAF por su cuenta: las rondas
+//  de difusión + ventanas NACK tienen que converger igual. Se
+//  informa el caudal (imagen / tiempo hasta REBOOT) y los bloques
+//  reenviados.
+// ============================================================
+#include <unity.h>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#define DEVICE_P4_MASTER
+#include "../../src/RS485/RS485.cpp"
+#include "../../src/RS485/RS485Fw.cpp"
+
+uint8_t g_logicConnected = 1;
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint8_t  FW_SLAVES   = 8;
+static constexpr uint32_t IMAGE_SIZE  = 160 * 1024;      // 854 bloques: dos ventanas NACK
+static constexpr uint64_t FW_LIMIT_US = 120000000;
+
+// .bin de app ESP32-S2: cabecera, primer segmento con esp_app_desc_t y relleno
+static std::vector<uint8_t> s2Image(uint32_t size, uint32_t seed) {
+    std::vector<uint8_t> img(size);
+    std::mt19937 rng(seed);
+    for (auto& b : img) b = (uint8_t)rng();
+
+    esp_image_header_t hdr = {};
+    hdr.magic   = ESP_IMAGE_HEADER_MAGIC;
+    hdr.chip_id = ESP_CHIP_ID_ESP32S2;
+    esp_app_desc_t desc = {};
+    desc.magic_word = ESP_APP_DESC_MAGIC_WORD;
+    for (uint8_t i = 0; i < sizeof(desc.app_elf_sha256); i++) desc.app_elf_sha256[i] = (uint8_t)(seed + i);
+    memcpy(&img[0], &hdr, sizeof(hdr));
+    memcpy(&img[sizeof(hdr) + sizeof(esp_image_segment_header_t)], &desc, sizeof(desc));
+    return img;
+}
+
+struct FwRun {
+    uint32_t blocks   = 0;
+    uint32_t sent     = 0;    // DATA en el cable
+    uint32_t rounds   = 0;
+    uint32_t verified = 0;    // S2 con REBOOT tras VERIFIED
+    double   secs     = 0;    // petición → último REBOOT
+    double   kBps     = 0;
+};
+
+static FwRun distribute(float loss, uint32_t seed) {
+    sim::reset(seed);
+    Preferences::store().clear();
+    LittleFS.files.clear();
+    LittleFS.files[RS485_FW_PATH] = s2Image(IMAGE_SIZE, seed);
+
+    HardwareSerial uart;
+    std::vector<std::unique_ptr<sim::S2>> s2;
+    for (uint8_t id = 1; id <= FW_SLAVES; id++) {
+        s2.emplace_back(new sim::S2(id));
+        s2.back()->caps      |= SLAVE_CAP_FW;
+        s2.back()->fwLossRate = loss;
+        uart.line.attach(*s2.back());
+    }
+    RS485BusConfig cfg = { &uart, -1, -1, -1, 1, FW_SLAVES, 'A', "baud" };
+    RS485Master master(cfg);
+    master.begin();
+    master.startTask();
+    sim::every(sim::now() + 1000, 1000, [&master]() {
+        SlaveEvent ev;
+        while (master.popEvent(ev)) {}
+    });
+    sim::run(1000000);                           // presencia, SLAVE_CAP_FW, velocidad
+
+    const uint64_t t0 = sim::now();
+    master.requestFirmware(RS485_FW_PATH);
+    FwRun r;
+    uint64_t last = 0;
+    while (sim::now() - t0 < FW_LIMIT_US) {
+        sim::run(100000);
+        r.verified = 0;
+        for (auto& s : s2)
+            if (s->fwRebootAt) {
+                r.verified++;
+                if (s->fwRebootAt > last) last = s->fwRebootAt;
+            }
+        if (r.verified == FW_SLAVES) break;
+    }
+    sim::stop();
+
+    r.blocks = (IMAGE_SIZE + FW_BLOCK_LEN - 1) / FW_BLOCK_LEN;
+    r.sent   = s2[0]->fwData;
+    r.rounds = s2[0]->fwRounds;
+    r.secs   = last ? (last - t0) / 1e6 : 0;
+    r.kBps   = r.secs ? IMAGE_SIZE / 1024.0 / r.secs : 0;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "pérdida %4.1f %%: %u/%u S2 en %5.2f s (%5.1f kB/s), %u rondas, %u bloques enviados de %u (+%.0f %%)",
+             loss * 100, (unsigned)r.verified, (unsigned)FW_SLAVES, r.secs, r.kBps, (unsigned)r.rounds,
+             (unsigned)r.sent, (unsigned)r.blocks, 100.0 * (r.sent - r.blocks) / r.blocks);
+    TEST_MESSAGE(msg);
+    return r;
+}
+
+// Bus limpio: una ronda, cada bloque una vez
+static void test_fw_clean_bus_single_round() {
+    const FwRun r = distribute(0, 1);
+    TEST_ASSERT_EQUAL_UINT32(FW_SLAVES, r.verified);
+    TEST_ASSERT_EQUAL_UINT32(1, r.rounds);
+    TEST_ASSERT_EQUAL_UINT32(r.blocks, r.sent);
+}
+
+// Cada S2 pierde tramas 0xAF (DATA, QUERY, COMMIT) y respuestas de
+// estado por su cuenta: todos verifican dentro de RS485_FW_MAX_ROUNDS.
+// Se reenvía la unión de lo que falta, no una copia por S2
+static void test_fw_lossy_bus_converges() {
+    const FwRun clean = distribute(0, 2);
+    for (float loss : { 0.01f, 0.05f, 0.10f }) {
+        const FwRun r = distribute(loss, 3);
+        TEST_ASSERT_EQUAL_UINT32(FW_SLAVES, r.verified);
+        TEST_ASSERT_GREATER_THAN(1, r.rounds);
+        TEST_ASSERT_LESS_OR_EQUAL(RS485_FW_MAX_ROUNDS, r.rounds);
+        // Ronda 2 ≈ 1 − (1 − p)^8 de la imagen; el resto, despreciable
+        const double union2 = 1 - pow(1 - loss, FW_SLAVES);
+        TEST_ASSERT_LESS_THAN(r.blocks * (1 + 1.5 * union2 + 0.02), r.sent);
+        TEST_ASSERT_GREATER_THAN(clean.kBps / (1 + 2 * union2 + 0.05), r.kBps);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fw_clean_bus_single_round);
+    RUN_TEST(test_fw_lossy_bus_converges);
+    int rc = UNITY_END();
+    sim::stop();
+    return rc;
+}
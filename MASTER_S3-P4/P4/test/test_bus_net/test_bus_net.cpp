@@ -0,0 +1,171 @@
+// ============================================================
+//  test_bus_net.cpp  –  RS485Network con RS485_NUM_BUSES = 2
+//  pio test -e native -f test_bus_net
+//
+//  config.h tal cual salvo el número de buses y los pines del bus B
+//  (según PCB): el reparto A/B por defecto tiene que compilar y
+//  caber en MCU_CHANNELS. Los dos tasks (RS485A en Serial1,
+//  RS485B en Serial2) corren a la vez sobre el mismo reloj de
+//  test/sim; el test hace de task MIDI drenando rs485.popEvent().
+// ============================================================
+#include <unity.h>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#define DEVICE_P4_MASTER
+#include "config.h"
+#undef  RS485_NUM_BUSES
+#define RS485_NUM_BUSES     2
+#undef  RS485_B_TX_PIN
+#undef  RS485_B_RX_PIN
+#undef  RS485_B_ENABLE_PIN
+#define RS485_B_TX_PIN      47
+#define RS485_B_RX_PIN      46
+#define RS485_B_ENABLE_PIN  45
+
+static_assert(NUM_SLAVES <= MCU_CHANNELS, "reparto por defecto con 2 buses");
+static_assert(RS485_BUS_A_SLAVES + RS485_BUS_B_SLAVES == MCU_CHANNELS, "los 9 canales MCU");
+
+#include "../../src/RS485/RS485.cpp"
+
+uint8_t g_logicConnected = 1;
+
+// RS485Fw.cpp (LittleFS, imagen S2) queda fuera: nunca se pide firmware
+void RS485Master::requestFirmware(const char*, const char*) {}
+uint32_t RS485Master::_fwUpdate(const char*, uint32_t) { return 0; }
+bool RS485Master::_fwQuery(uint8_t, uint16_t, uint16_t, FwStatus&) { return false; }
+void RS485Master::_fwSend(const uint8_t*, size_t, uint32_t) {}
+void RS485Master::_sleepUs(uint32_t) {}
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint64_t WARMUP_US = 1000000;   // negociación de velocidad + latencias aprendidas
+static constexpr uint64_t WINDOW_US = 2000000;
+
+// S2 en los dos cables (ids locales 1..N en cada uno) y task MIDI
+// drenando la red cada ms; eventos FADER por id global desde t0
+struct Net {
+    std::vector<std::unique_ptr<sim::S2>> s2;      // por id global - 1
+    std::unique_ptr<RS485Network>          net;
+    uint32_t fader[NUM_SLAVES + 1] = {};
+    uint32_t badIds = 0;
+    uint64_t t0 = 0, t1 = 0;
+
+    explicit Net(uint32_t seed, bool touched) {
+        sim::reset(seed);
+        Preferences::store().clear();
+        Serial1.line = sim::Line();
+        Serial2.line = sim::Line();
+        for (uint8_t gid = 1; gid <= NUM_SLAVES; gid++) {
+            const bool busA = gid <= RS485_BUS_A_SLAVES;
+            s2.emplace_back(new sim::S2(busA ? gid : gid - RS485_BUS_A_SLAVES));
+            s2.back()->touched = touched;
+            (busA ? Serial1 : Serial2).line.attach(*s2.back());
+        }
+        net.reset(new RS485Network);
+        net->begin();
+        net->startTask();
+    }
+    ~Net() { sim::stop(); }
+
+    void run() {
+        t0 = sim::now() + WARMUP_US;
+        t1 = t0 + WINDOW_US;
+        sim::every(sim::now() + 1000, 1000, [this]() {
+            SlaveEvent ev;
+            while (net->popEvent(ev)) {
+                if (ev.id < 1 || ev.id > NUM_SLAVES) badIds++;
+                else if (ev.type == SlaveEvtType::FADER && sim::now() >= t0) fader[ev.id]++;
+            }
+        });
+        sim::run(WARMUP_US + WINDOW_US);
+    }
+
+    const sim::Line& line(uint8_t gid) const { return (gid <= RS485_BUS_A_SLAVES ? Serial1 : Serial2).line; }
+    double hz(uint8_t gid) const {
+        return line(gid).replies(s2[gid - 1].get(), t0, t1).clean / ((t1 - t0) / 1e6);
+    }
+};
+
+// Reparto por defecto: 5 + 4 = los 9 canales MCU, ids globales seguidos
+static void test_default_split_fills_mcu_channels() {
+    TEST_ASSERT_EQUAL_UINT8(5, RS485_BUS_A_SLAVES);
+    TEST_ASSERT_EQUAL_UINT8(4, RS485_BUS_B_SLAVES);
+    TEST_ASSERT_EQUAL_UINT8(MCU_CHANNELS, NUM_SLAVES);
+}
+
+// Los dos tasks arrancan, negocian por separado y todos los ids
+// globales quedan ONLINE; el bus B ve 1..4 en su cable
+static void test_both_buses_polled_concurrently() {
+    Net n(3, false);
+    n.run();
+    const uint32_t baud = rs485_baudRate(RS485_BAUD_MAX_CODE, RS485_BAUD);
+    TEST_ASSERT_EQUAL_UINT32(baud, Serial1.line.masterBaud);
+    TEST_ASSERT_EQUAL_UINT32(baud, Serial2.line.masterBaud);
+    TEST_ASSERT_EQUAL_UINT32(2, sim::state().tasks.size());
+    for (uint8_t gid = 1; gid <= NUM_SLAVES; gid++) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "id global %u", gid);
+        TEST_ASSERT_TRUE_MESSAGE(n.net->getPresence(gid) == SlavePresence::ONLINE, msg);
+        TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1000.0 / POLL_CYCLE_MS * 0.98, n.hz(gid), msg);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, n.badIds);
+}
+
+// Tasa agregada sobre un reloj compartido frente a los mismos 9 strips
+// en un solo bus (RS485Master suelto en Serial1)
+static void test_two_buses_aggregate_rate() {
+    double one = 0, oneMin = 1e9;
+    {
+        sim::reset(5);
+        Preferences::store().clear();
+        Serial1.line = sim::Line();
+        std::vector<std::unique_ptr<sim::S2>> s2;
+        for (uint8_t id = 1; id <= NUM_SLAVES; id++) {
+            s2.emplace_back(new sim::S2(id));
+            s2.back()->touched = true;
+            Serial1.line.attach(*s2.back());
+        }
+        RS485BusConfig cfg = { &Serial1, -1, -1, -1, 1, NUM_SLAVES, 'A', "baud" };
+        RS485Master bus(cfg);
+        bus.begin();
+        bus.startTask();
+        sim::run(WARMUP_US + WINDOW_US);
+        for (auto& s : s2) {
+            const double hz = Serial1.line.replies(s.get(), sim::now() - WINDOW_US, sim::now()).clean /
+                              (WINDOW_US / 1e6);
+            one += hz;
+            if (hz < oneMin) oneMin = hz;
+        }
+        sim::stop();
+    }
+
+    Net n(5, true);
+    n.run();
+    double two = 0, twoMin = 1e9, events = 0;
+    for (uint8_t gid = 1; gid <= NUM_SLAVES; gid++) {
+        two += n.hz(gid);
+        if (n.hz(gid) < twoMin) twoMin = n.hz(gid);
+        events += n.fader[gid] / (WINDOW_US / 1e6);
+    }
+    char msg[160];
+    snprintf(msg, sizeof(msg), "1 x 9: %.0f resp/s (min %.0f Hz)  2 buses 5+4: %.0f resp/s (min %.0f Hz), FADER %.0f/s",
+             one, oneMin, two, twoMin, events);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, n.badIds);
+    TEST_ASSERT_GREATER_OR_EQUAL(1.8 * one, two);
+    TEST_ASSERT_GREATER_OR_EQUAL(1.6 * oneMin, twoMin);
+    TEST_ASSERT_GREATER_OR_EQUAL(0.99 * two, events);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_split_fills_mcu_channels);
+    RUN_TEST(test_both_buses_polled_concurrently);
+    RUN_TEST(test_two_buses_aggregate_rate);
+    return UNITY_END();
+}
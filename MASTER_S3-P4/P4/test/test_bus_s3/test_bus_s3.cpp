@@ -0,0 +1,191 @@
+// ============================================================
+//  test_bus_s3.cpp  –  lib/imakie_rs485 con el config.h y la glue
+//  del S3
+//  pio test -e native -f test_bus_s3
+//
+//  S3/src/RS485/RS485.cpp tal cual (un bus en Serial1, nombre 'S')
+//  sobre test/sim, con NUM_SLAVES subido a 4. Cubre lo que solo usa
+//  el S3 del master compartido: secuencia de desconexión (por polls
+//  y por broadcast), lostMask del LED, rango calibrado min/max y
+//  setFaderTarget escalado (RS485_FADER_MAP_CALIBRATED), suavizado
+//  de faderPos (RS485_FADER_EMA_PCT).
+// ============================================================
+#include <unity.h>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#define DEVICE_S3_EXTENDER
+#include "../../../S3/iMakie-ESP32_S3_EXTENDER/src/config.h"
+#undef  NUM_SLAVES
+#define NUM_SLAVES  4
+#include "../../../S3/iMakie-ESP32_S3_EXTENDER/src/RS485/RS485.cpp"
+
+uint8_t g_logicConnected = 1;
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint64_t WARMUP_US = 1000000;   // negociación de velocidad + primer barrido
+static constexpr uint8_t  CAPS_NO_BCAST = SLAVE_CAP_DELTA | SLAVE_CAP_BAUD | SLAVE_CAP_GROUP;
+
+// Un RS485Master nuevo por test sobre la BUS de la glue (rs485 es global)
+struct S3Bus {
+    std::vector<std::unique_ptr<sim::S2>> s2;
+    std::unique_ptr<RS485Master>          master;
+    uint32_t badIds = 0;
+
+    explicit S3Bus(uint32_t seed, uint8_t caps = SLAVE_CAP_DELTA | SLAVE_CAP_BCAST |
+                                                 SLAVE_CAP_BAUD | SLAVE_CAP_GROUP) {
+        sim::reset(seed);
+        Preferences::store().clear();
+        Serial1.line = sim::Line();
+        g_logicConnected = 1;
+        for (uint8_t id = 1; id <= NUM_SLAVES; id++) {
+            s2.emplace_back(new sim::S2(id));
+            s2.back()->caps = caps;
+            Serial1.line.attach(*s2.back());
+        }
+        master.reset(new RS485Master(BUS));
+        master->begin();
+        master->startTask();
+        sim::every(sim::now() + 1000, 1000, [this]() {
+            SlaveEvent ev;
+            while (master->popEvent(ev))
+                if (ev.id < 1 || ev.id > NUM_SLAVES) badIds++;
+        });
+    }
+    ~S3Bus() { sim::stop(); }
+
+    // GoOffline: tiempo hasta isDisconnectComplete() y 'connected' que
+    // tenía cada S2 en ese instante (bit id)
+    uint64_t disconnect(uint32_t& stillConnected) {
+        g_logicConnected = 0;
+        master->beginDisconnectSequence();
+        TEST_ASSERT_FALSE(master->isDisconnectComplete());
+        const uint64_t t0 = sim::now();
+        uint64_t done = 0;
+        sim::every(t0 + 50, 50, [&]() {
+            if (done || !master->isDisconnectComplete()) return;
+            done = sim::now();
+            stillConnected = 0;
+            for (auto& s : s2)
+                if (s->rx.connected) stillConnected |= 1u << s->id;
+        });
+        sim::run(200000);
+        return done ? done - t0 : UINT64_MAX;
+    }
+};
+
+// La glue: Serial1, ids 1..NUM_SLAVES, nombre 'S'; todos ONLINE
+static void test_glue_single_bus() {
+    TEST_ASSERT_TRUE(BUS.uart == &Serial1);
+    TEST_ASSERT_EQUAL_UINT8(1, BUS.firstId);
+    TEST_ASSERT_EQUAL_UINT8(NUM_SLAVES, BUS.numSlaves);
+    TEST_ASSERT_EQUAL_UINT8('S', BUS.name);
+
+    S3Bus bus(1);
+    sim::run(WARMUP_US);
+    for (uint8_t id = 1; id <= NUM_SLAVES; id++)
+        TEST_ASSERT_TRUE(bus.master->getPresence(id) == SlavePresence::ONLINE);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.master->lostMask());
+    TEST_ASSERT_EQUAL_UINT32(0, bus.badIds);
+}
+
+// La petición la recoge _nextSlave(): si el task duerme el resto de
+// POLL_CYCLE_MS, la secuencia empieza al despertar
+static constexpr uint64_t DISCONNECT_MAX_US = (POLL_CYCLE_MS + 2) * 1000;
+
+// Slaves sin SLAVE_CAP_BCAST: la secuencia sondea 1..N seguidos y
+// termina cuando el último ya tiene connected = 0
+static void test_disconnect_by_polls() {
+    S3Bus bus(2, CAPS_NO_BCAST);
+    sim::run(WARMUP_US);
+    for (auto& s : bus.s2) TEST_ASSERT_EQUAL_UINT8(1, s->rx.connected);
+
+    uint32_t still = ~0u;
+    const uint64_t us = bus.disconnect(still);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "desconexión por polls: %u us", (unsigned)us);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, still);
+    TEST_ASSERT_LESS_THAN(DISCONNECT_MAX_US, us);
+}
+
+// Todos con broadcast: basta la trama id 0, sin esperar a los polls
+static void test_disconnect_by_broadcast() {
+    S3Bus bus(3);
+    sim::run(WARMUP_US);
+    const uint64_t t0 = sim::now();
+    uint32_t still = 0;
+    const uint64_t us = bus.disconnect(still);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "desconexión por broadcast: %u us", (unsigned)us);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(DISCONNECT_MAX_US, us);
+    // Termina con la trama id 0: ningún poll individual entre petición y fin
+    TEST_ASSERT_EQUAL_UINT32(0, Serial1.line.sent(RS485_START_BYTE, t0, t0 + us) +
+                                Serial1.line.sent(RS485_DELTA_BYTE, t0, t0 + us));
+}
+
+// Un S2 OFFLINE prende su bit (LED rojo); al volver se apaga
+static void test_lost_mask_follows_presence() {
+    S3Bus bus(4);
+    sim::run(WARMUP_US);
+    bus.s2[2]->online = false;
+    sim::run(500000);
+    TEST_ASSERT_TRUE(bus.master->getPresence(3) == SlavePresence::OFFLINE);
+    TEST_ASSERT_EQUAL_UINT32(1u << 3, bus.master->lostMask());
+
+    bus.s2[2]->online = true;
+    sim::run(3000000);                                 // > RS485_BACKOFF_MAX_MS
+    TEST_ASSERT_TRUE(bus.master->getPresence(3) == SlavePresence::ONLINE);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.master->lostMask());
+}
+
+// Rango enviado con CALIB_SENDING → calibratedMin/Max; setFaderTarget
+// lleva 0..LOGIC_PITCHBEND_MAX a ese rango (sin calibrar: 0..27000)
+static void test_calibrated_range_maps_fader_target() {
+    S3Bus bus(5);
+    bus.s2[0]->calibSending = true;                   // alterna 150 / 3900
+    sim::run(WARMUP_US);
+    bus.s2[0]->calibSending = false;
+    const SlaveState st = bus.master->getSlave(1);
+    TEST_ASSERT_EQUAL_UINT16(150,  st.calibratedMin);
+    TEST_ASSERT_EQUAL_UINT16(3900, st.calibratedMax);
+
+    const uint16_t in[3]  = { 0, LOGIC_PITCHBEND_MAX / 2, LOGIC_PITCHBEND_MAX };
+    const uint16_t cal[3] = { 150, 150 + (LOGIC_PITCHBEND_MAX / 2) * 3750 / LOGIC_PITCHBEND_MAX, 3900 };
+    const uint16_t raw[3] = { 0, (LOGIC_PITCHBEND_MAX / 2) * 27000 / LOGIC_PITCHBEND_MAX, 27000 };
+    for (uint8_t k = 0; k < 3; k++) {
+        bus.master->setFaderTarget(1, in[k]);
+        bus.master->setFaderTarget(2, in[k]);
+        sim::run(100000);
+        TEST_ASSERT_EQUAL_UINT16(cal[k], bus.s2[0]->rx.faderTarget);
+        TEST_ASSERT_EQUAL_UINT16(raw[k], bus.s2[1]->rx.faderTarget);
+    }
+}
+
+// faderPos suavizado: S2 quieto en 2000 → converge sin llegar a
+// saltos (el EMA entero se para a < 100 / RS485_FADER_EMA_PCT del valor)
+static void test_fader_ema_converges() {
+    S3Bus bus(6);
+    sim::run(WARMUP_US);
+    const uint16_t pos = bus.master->getSlave(1).faderPos;
+    TEST_ASSERT_LESS_OR_EQUAL(2000, pos);
+    TEST_ASSERT_GREATER_OR_EQUAL(2000 - 100 / RS485_FADER_EMA_PCT, pos);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_glue_single_bus);
+    RUN_TEST(test_disconnect_by_polls);
+    RUN_TEST(test_disconnect_by_broadcast);
+    RUN_TEST(test_lost_mask_follows_presence);
+    RUN_TEST(test_calibrated_range_maps_fader_target);
+    RUN_TEST(test_fader_ema_converges);
+    return UNITY_END();
+}
@@ -0,0 +1,716 @@
+// ============================================================
+//  test_bus_sim.cpp  –  scheduler RS485 del P4 en host
+//  pio test -e native -f test_bus_sim
+//
+//  src/RS485/RS485.cpp tal cual, sobre los fakes de test/sim:
+//  reloj virtual, UART half-duplex con cable simulado y S2 que
+//  contestan como RS485Slave. runTask() corre de verdad (un
+//  task por bus, negociación de velocidad incluida); el test hace
+//  de task MIDI drenando la cola de eventos.
+//
+//  Aquí cada bus corre solo (no comparten UART, task ni cola, solo
+//  g_logicConnected): la suma de buses = la tasa agregada de
+//  RS485Network. Los dos a la vez en un reloj: test_bus_net.
+// ============================================================
+#include <unity.h>
+#include <algorithm>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+
+#define DEVICE_P4_MASTER
+#include "../../src/RS485/RS485.cpp"
+
+uint8_t g_logicConnected = 1;
+
+// RS485Fw.cpp (LittleFS, imagen S2) queda fuera: nunca se pide firmware
+void RS485Master::requestFirmware(const char*, const char*) {}
+uint32_t RS485Master::_fwUpdate(const char*, uint32_t) { return 0; }
+bool RS485Master::_fwQuery(uint8_t, uint16_t, uint16_t, FwStatus&) { return false; }
+void RS485Master::_fwSend(const uint8_t*, size_t, uint32_t) {}
+void RS485Master::_sleepUs(uint32_t) {}
+
+void setUp() {}
+void tearDown() {}
+
+// ─── Un bus simulado ──────────────────────────────────────────
+
+static constexpr uint64_t WARMUP_US = 1000000;   // negociación de velocidad + latencias aprendidas
+static constexpr uint64_t WINDOW_US = 2000000;
+
+struct ProfileSink : Print {
+    std::vector<uint8_t> bytes;
+    size_t write(const uint8_t* buf, size_t len) override {
+        bytes.insert(bytes.end(), buf, buf + len);
+        return len;
+    }
+};
+
+struct SimBus {
+    HardwareSerial                       uart;
+    std::vector<std::unique_ptr<sim::S2>> s2;
+    std::unique_ptr<RS485Master>          master;
+    sim::Task*                            task = nullptr;
+    uint32_t fader[RS485_BUS_MAX_SLAVES * 2 + 1] = {};   // eventos FADER por id global
+    uint32_t otherIds = 0;                               // eventos con id de otro bus
+    uint64_t t0 = 0, t1 = 0;
+
+    // keepNvs: la flash conserva lo que dejó el bus anterior (reinicio)
+    SimBus(char name, uint8_t firstId, uint8_t slaves, uint32_t seed, bool keepNvs = false) {
+        sim::reset(seed);
+        if (!keepNvs) Preferences::store().clear();
+        for (uint8_t id = 1; id <= slaves; id++) {
+            s2.emplace_back(new sim::S2(id));
+            uart.line.attach(*s2.back());
+        }
+        RS485BusConfig cfg = { &uart, -1, -1, -1, firstId, slaves, name, "baud" };
+        master.reset(new RS485Master(cfg));
+        master->begin();
+        master->startTask();
+        task = sim::state().tasks.back().get();
+    }
+    ~SimBus() { sim::stop(); }
+
+    // Task MIDI: drena la cola cada ms; contadores y profiler desde t0
+    void run(uint64_t warmupUs = WARMUP_US, uint64_t windowUs = WINDOW_US) {
+        t0 = sim::now() + warmupUs;
+        t1 = t0 + windowUs;
+        sim::at(t0, [this]() { master->resetStats(); });
+        sim::every(sim::now() + 1000, 1000, [this]() {
+            SlaveEvent ev;
+            while (master->popEvent(ev)) {
+                if (!master->owns(ev.id)) otherIds++;
+                if (ev.type == SlaveEvtType::FADER && sim::now() >= t0) fader[ev.id]++;
+            }
+        });
+        sim::run(warmupUs + windowUs);
+    }
+
+    uint32_t clean(uint8_t id) const { return uart.line.replies(s2[id - 1].get(), t0, t1).clean; }
+
+    // Respuestas limpias / s de un slave en [from, to)
+    double hz(uint8_t id, uint64_t from, uint64_t to) const {
+        return uart.line.replies(s2[id - 1].get(), from, to).clean / ((to - from) / 1e6);
+    }
+
+    // Contadores del profiler (snapshot IMPF): polls, timeouts, crc, id
+    uint32_t counter(uint8_t id, uint8_t which) const {
+        ProfileSink out;
+        master->writeProfile(out);
+        return rs485_get32(&out.bytes[PROF_HEADER_LEN + (id - 1) * PROF_COUNTERS_LEN + which * 4]);
+    }
+};
+
+struct Rate {
+    double   total    = 0;   // respuestas limpias / s, todos los buses
+    double   minStrip = 1e9; // la tira peor servida
+    double   events   = 0;   // eventos FADER / s que llegan al task MIDI
+    double   busy     = 0;   // ocupación media del cable
+    uint32_t errors   = 0;   // timeouts + CRC + id en el profiler
+    uint32_t baud     = 0;   // del último bus
+};
+
+static constexpr uint8_t CAPS_ALL  = SLAVE_CAP_DELTA | SLAVE_CAP_BCAST | SLAVE_CAP_BAUD | SLAVE_CAP_GROUP;
+static constexpr uint8_t CAPS_BASE = SLAVE_CAP_DELTA | SLAVE_CAP_BCAST;   // sin baud ni grupo: 500 k, poll individual
+
+// 'strips' repartidos en 'buses' iguales; touched = todos moviendo el fader
+static Rate measure(uint8_t strips, uint8_t buses, bool touched, uint8_t caps = CAPS_ALL,
+                    uint32_t seed = 1) {
+    Rate r;
+    const uint8_t per = strips / buses;
+    for (uint8_t b = 0; b < buses; b++) {
+        SimBus bus((char)('A' + b), (uint8_t)(1 + b * per), per, seed + b);
+        for (auto& s : bus.s2) {
+            s->touched = touched;
+            s->caps    = caps;
+        }
+        bus.run();
+        const double secs = (bus.t1 - bus.t0) / 1e6;
+        for (uint8_t id = 1; id <= per; id++) {
+            const double hz = bus.clean(id) / secs;
+            r.total += hz;
+            if (hz < r.minStrip) r.minStrip = hz;
+            r.events += bus.fader[bus.master->firstId() + id - 1] / secs;
+            for (uint8_t c = 1; c < 4; c++) r.errors += bus.counter(id, c);
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, bus.otherIds);
+        r.busy += bus.uart.line.busy(bus.t0, bus.t1) / buses;
+        r.baud  = bus.uart.line.masterBaud;
+    }
+    return r;
+}
+
+static void report(const char* name, const Rate& r) {
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-16s %7.0f resp/s  min %6.1f Hz/tira  FADER %7.0f/s  cable %3.0f %%  baud %u  err %u",
+             name, r.total, r.minStrip, r.events, r.busy * 100, (unsigned)r.baud, (unsigned)r.errors);
+    TEST_MESSAGE(msg);
+}
+
+// ─── Multi-bus ────────────────────────────────────────────────
+
+// Bus B: ids 1..4 en el cable, 5..8 hacia MIDI; la cola de cada bus
+// solo lleva sus ids globales
+static void test_bus_b_local_wire_ids_global_events() {
+    SimBus bus('B', 5, 4, 7);
+    bus.s2[1]->touched = true;                         // local 2 = global 6
+    bus.run(WARMUP_US, 500000);
+    for (uint8_t id = 1; id <= 4; id++) {
+        TEST_ASSERT_GREATER_THAN(0, bus.s2[id - 1]->polls + bus.s2[id - 1]->groupPolls);
+        TEST_ASSERT_TRUE(bus.master->getPresence(id) == SlavePresence::ONLINE);
+    }
+    TEST_ASSERT_GREATER_THAN(0, bus.fader[6]);
+    for (uint8_t gid = 0; gid < sizeof(bus.fader) / sizeof(bus.fader[0]); gid++)
+        if (gid != 6) TEST_ASSERT_EQUAL_UINT32(0, bus.fader[gid]);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.otherIds);
+}
+
+// Reposo: cada tira a POLL_CYCLE_MS (50 Hz) con uno o dos buses
+static void test_idle_every_strip_at_cycle_rate() {
+    const uint8_t configs[][2] = { {8, 1}, {8, 2}, {12, 1}, {12, 2} };
+    for (auto& c : configs) {
+        Rate r = measure(c[0], c[1], false);
+        char name[24];
+        snprintf(name, sizeof(name), "reposo %u x %u", c[1], c[0] / c[1]);
+        report(name, r);
+        TEST_ASSERT_EQUAL_UINT32(0, r.errors);
+        TEST_ASSERT_GREATER_OR_EQUAL(1000.0 / POLL_CYCLE_MS * 0.98, r.minStrip);
+    }
+}
+
+// Todas las tiras tocadas: los slots extra llenan el ciclo, la tasa la
+// marca el bus → dos buses dan ~el doble y cada evento llega a MIDI
+static void test_two_buses_double_aggregate_rate() {
+    for (uint8_t caps : { CAPS_ALL, CAPS_BASE }) {
+        const char* tag = caps == CAPS_ALL ? "negociado" : "500 k";
+        Rate one = measure(8, 1, true, caps);
+        Rate two = measure(8, 2, true, caps);
+        char name[24];
+        snprintf(name, sizeof(name), "%s 1 x 8", tag);
+        report(name, one);
+        snprintf(name, sizeof(name), "%s 2 x 4", tag);
+        report(name, two);
+        TEST_ASSERT_EQUAL_UINT32(0, one.errors);
+        TEST_ASSERT_EQUAL_UINT32(0, two.errors);
+        TEST_ASSERT_GREATER_OR_EQUAL(1.8 * one.total, two.total);
+        TEST_ASSERT_GREATER_OR_EQUAL(1.8 * one.minStrip, two.minStrip);
+        TEST_ASSERT_GREATER_OR_EQUAL(0.99 * one.total, one.events);
+        TEST_ASSERT_GREATER_OR_EQUAL(0.99 * two.total, two.events);
+    }
+}
+
+// ─── Group poll TDMA ──────────────────────────────────────────
+// 9 S2 en reposo; jitter = despertar del task responder de cada S2
+// (uniforme 0..J, independiente por slave y trama). Dos ranuras
+// seguidas solo chocan si la diferencia de despertar supera
+// RS485_GROUP_GUARD_US + el carácter de conmutación.
+
+static constexpr uint8_t CAPS_NO_GROUP = CAPS_ALL & ~SLAVE_CAP_GROUP;
+
+struct Speed {
+    const char* name;
+    uint8_t     caps;      // sin SLAVE_CAP_BAUD → se queda en la base
+    uint8_t     maxCode;   // más arriba el enlace falla → la negociación se para aquí
+};
+static const Speed SPEEDS[] = {
+    { "500 k", CAPS_ALL & ~SLAVE_CAP_BAUD, 0 },
+    { "2 M",   CAPS_ALL,                   2 },
+    { "4 M",   CAPS_ALL,                   3 },
+};
+
+struct GroupRun {
+    double   sweepUs     = 0;
+    uint32_t collisions  = 0;   // toda la simulación, negociación incluida
+    uint32_t errors      = 0;   // profiler, ventana de medida
+    uint32_t groupPolls  = 0;
+    uint32_t baud        = 0;
+};
+
+static GroupRun runGroup(const Speed& sp, uint8_t caps, uint32_t jitterUs, uint32_t seed = 3) {
+    SimBus bus('A', 1, 9, seed);
+    for (auto& s : bus.s2) {
+        s->caps     = caps;
+        s->maxCode  = sp.maxCode;
+        s->jitterUs = jitterUs;
+    }
+    bus.run();
+    GroupRun g;
+    g.sweepUs    = bus.uart.line.sweepUs(bus.t0, bus.t1);
+    g.collisions = bus.uart.line.collisions;
+    g.baud       = bus.uart.line.masterBaud;
+    for (uint8_t id = 1; id <= 9; id++) {
+        for (uint8_t c = 1; c < 4; c++) g.errors += bus.counter(id, c);
+        g.groupPolls += bus.s2[id - 1]->groupPolls;
+    }
+    return g;
+}
+
+static void test_group_slots_no_collision_up_to_guard() {
+    for (const Speed& sp : SPEEDS) {
+        for (uint32_t j : { 0u, 20u, (uint32_t)RS485_GROUP_GUARD_US }) {
+            for (uint32_t seed = 1; seed <= 3; seed++) {
+                GroupRun g = runGroup(sp, sp.caps, j, seed);
+                char msg[96];
+                snprintf(msg, sizeof(msg), "%s jitter %u us seed %u: baud %u, %u choques, %u errores",
+                         sp.name, (unsigned)j, (unsigned)seed, (unsigned)g.baud,
+                         (unsigned)g.collisions, (unsigned)g.errors);
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(rs485_baudRate(sp.maxCode, RS485_BAUD), g.baud, msg);
+                TEST_ASSERT_GREATER_THAN_MESSAGE(0, g.groupPolls, msg);
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, g.collisions, msg);
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, g.errors, msg);
+            }
+        }
+    }
+}
+
+// El margen es la guarda: con jitter muy por encima las ranuras chocan
+// (y el bus sigue: timeouts → SUSPECT, nada se cuelga)
+static void test_group_collides_beyond_guard() {
+    char msg[96];
+    for (uint32_t j : { 2u * RS485_GROUP_GUARD_US, 3u * RS485_GROUP_GUARD_US }) {
+        GroupRun g = runGroup(SPEEDS[2], CAPS_ALL, j);
+        snprintf(msg, sizeof(msg), "4 M jitter %3u us: %u choques, %u errores",
+                 (unsigned)j, (unsigned)g.collisions, (unsigned)g.errors);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_GREATER_THAN(0, g.collisions);
+    }
+}
+
+// Barrido en reposo (broadcast → última respuesta), grupo frente a poll individual
+static void test_group_sweep_shorter_than_individual() {
+    for (const Speed& sp : SPEEDS) {
+        GroupRun ind = runGroup(sp, sp.caps & ~SLAVE_CAP_GROUP, 20);
+        GroupRun grp = runGroup(sp, sp.caps, 20);
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%-5s barrido individual %5.0f us, grupo %5.0f us (-%2.0f %%)",
+                 sp.name, ind.sweepUs, grp.sweepUs, 100.0 * (1 - grp.sweepUs / ind.sweepUs));
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL_UINT32(0, ind.groupPolls);
+        TEST_ASSERT_EQUAL_UINT32(0, ind.errors + grp.errors);
+        TEST_ASSERT_LESS_THAN(ind.sweepUs * 0.7, grp.sweepUs);
+    }
+}
+
+// ─── Negociación de velocidad ─────────────────────────────────
+// maxCode = la velocidad más alta que el cable aguanta; por encima
+// cada S2 pierde/rompe badRate de las tramas
+
+static constexpr uint64_t NEGOTIATED_US = 800000;    // arranque + barrido limpio hasta 4 M
+static constexpr uint64_t RESWEPT_US    = 2500000;   // códigos que fallan: silencio de vuelta + repetición
+
+static uint8_t storedCode() {
+    Preferences prefs;
+    prefs.begin("rs485", true);
+    uint8_t code = prefs.getUChar("baud", 0);
+    prefs.end();
+    return code;
+}
+
+// Se queda en la más alta que pasa limpia, la guarda y los S2 la siguen
+static void test_baud_negotiates_highest_clean_code() {
+    for (uint8_t maxCode = 0; maxCode <= RS485_BAUD_MAX_CODE; maxCode++) {
+        SimBus bus('A', 1, 8, 11 + maxCode);
+        for (auto& s : bus.s2) s->maxCode = maxCode;
+        bus.run(RESWEPT_US, 500000);
+        char msg[64];
+        snprintf(msg, sizeof(msg), "maxCode %u: baud %u", maxCode, (unsigned)bus.uart.line.masterBaud);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(rs485_baudRate(maxCode, RS485_BAUD), bus.uart.line.masterBaud, msg);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(maxCode, storedCode(), msg);
+        for (uint8_t id = 1; id <= 8; id++) {
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(maxCode, bus.s2[id - 1]->baudCode, msg);
+            for (uint8_t c = 1; c < 4; c++) TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, bus.counter(id, c), msg);
+        }
+    }
+}
+
+// Un solo S2 sin SLAVE_CAP_BAUD (firmware antiguo) deja todo el bus en la base
+static void test_baud_fixed_if_any_slave_lacks_cap() {
+    SimBus bus('A', 1, 8, 5);
+    bus.s2[4]->caps &= ~SLAVE_CAP_BAUD;
+    bus.run(WARMUP_US, 500000);
+    TEST_ASSERT_EQUAL_UINT32(RS485_BAUD, bus.uart.line.masterBaud);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.uart.line.sent(RS485_BAUD_BYTE, 0, bus.t1));
+    for (auto& s : bus.s2) TEST_ASSERT_EQUAL_UINT8(0, s->baudCode);
+}
+
+// Reinicio con la velocidad en NVS: una sola prueba en vez del barrido;
+// si ya no pasa (cable cambiado) se barre otra vez y se guarda la nueva
+static void test_baud_stored_code_reused_or_reswept() {
+    uint32_t sweepFrames;
+    {
+        SimBus bus('A', 1, 8, 21);
+        bus.run(NEGOTIATED_US, 0);
+        sweepFrames = bus.uart.line.sent(RS485_BAUD_BYTE, 0, bus.t1);
+        TEST_ASSERT_EQUAL_UINT8(RS485_BAUD_MAX_CODE, storedCode());
+        TEST_ASSERT_EQUAL_UINT32(RS485_BAUD_MAX_CODE, sweepFrames);   // una orden por código
+    }
+    {
+        SimBus bus('A', 1, 8, 22, true);
+        bus.run(NEGOTIATED_US, 0);
+        TEST_ASSERT_EQUAL_UINT32(1, bus.uart.line.sent(RS485_BAUD_BYTE, 0, bus.t1));
+        TEST_ASSERT_EQUAL_UINT32(rs485_baudRate(RS485_BAUD_MAX_CODE, RS485_BAUD), bus.uart.line.masterBaud);
+    }
+    {
+        SimBus bus('A', 1, 8, 23, true);
+        for (auto& s : bus.s2) s->maxCode = 1;
+        bus.run(RESWEPT_US, 500000);
+        TEST_ASSERT_EQUAL_UINT32(rs485_baudRate(1, RS485_BAUD), bus.uart.line.masterBaud);
+        TEST_ASSERT_EQUAL_UINT8(1, storedCode());
+        for (uint8_t id = 1; id <= 8; id++)
+            for (uint8_t c = 1; c < 4; c++) TEST_ASSERT_EQUAL_UINT32(0, bus.counter(id, c));
+    }
+}
+
+// Master reiniciado con los S2 aún a 4 M: su silencio inicial los
+// devuelve a la base y la negociación empieza limpia
+static void test_baud_master_restart_slaves_fall_back() {
+    SimBus bus('A', 1, 8, 31);
+    for (auto& s : bus.s2) {
+        s->baudCode  = RS485_BAUD_MAX_CODE;
+        s->lastValid = sim::now();
+    }
+    bus.run(WARMUP_US, 500000);
+    TEST_ASSERT_EQUAL_UINT32(rs485_baudRate(RS485_BAUD_MAX_CODE, RS485_BAUD), bus.uart.line.masterBaud);
+    for (uint8_t id = 1; id <= 8; id++) {
+        TEST_ASSERT_EQUAL_UINT32(1, bus.s2[id - 1]->fallbacks);
+        TEST_ASSERT_EQUAL_UINT8(RS485_BAUD_MAX_CODE, bus.s2[id - 1]->baudCode);
+        for (uint8_t c = 1; c < 4; c++) TEST_ASSERT_EQUAL_UINT32(0, bus.counter(id, c));
+    }
+}
+
+// S2 reiniciado a mitad (arranca a la base): deja de contestar hasta el
+// siguiente re-anuncio (RS485_BAUD_ANNOUNCE_MS) y vuelve solo
+static void test_baud_slave_restart_recovered_by_announce() {
+    SimBus bus('A', 1, 8, 41);
+    sim::S2& s = *bus.s2[2];
+    uint64_t reboot = 0;
+    sim::at(sim::now() + WARMUP_US + 300000, [&]() {
+        reboot     = sim::now();
+        s.baudCode = 0;
+    });
+    bus.run(WARMUP_US, 3000000);
+    const uint64_t back = reboot + RS485_BAUD_ANNOUNCE_MS * 1000ULL + 100000;
+    const uint32_t lost = bus.uart.line.replies(&s, reboot, reboot + 100000).clean;
+    const uint32_t after = bus.uart.line.replies(&s, back, bus.t1).clean;
+    char msg[80];
+    snprintf(msg, sizeof(msg), "tras el reinicio: %u respuestas en 100 ms, %.0f Hz desde +%u ms",
+             (unsigned)lost, after / ((bus.t1 - back) / 1e6), (unsigned)(RS485_BAUD_ANNOUNCE_MS + 100));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+    TEST_ASSERT_EQUAL_UINT8(RS485_BAUD_MAX_CODE, s.baudCode);
+    TEST_ASSERT_GREATER_OR_EQUAL(1000.0 / POLL_CYCLE_MS * 0.98 * (bus.t1 - back) / 1e6, (double)after);
+    TEST_ASSERT_TRUE(bus.master->getPresence(3) == SlavePresence::ONLINE);
+}
+
+// ─── Scheduler adaptativo ─────────────────────────────────────
+
+static constexpr double CYCLE_HZ = 1000.0 / POLL_CYCLE_MS;
+
+// La tira tocada se lleva el tiempo que el bus tenía ocioso; las
+// demás siguen a POLL_CYCLE_MS, con y sin group poll
+static void test_adaptive_touched_strip_polled_faster() {
+    for (uint8_t caps : { CAPS_ALL, CAPS_BASE }) {
+        SimBus bus('A', 1, 8, 51);
+        for (auto& s : bus.s2) s->caps = caps;
+        bus.s2[3]->touched = true;
+        bus.run();
+        double idleMin = 1e9;
+        for (uint8_t id = 1; id <= 8; id++)
+            if (id != 4 && bus.hz(id, bus.t0, bus.t1) < idleMin) idleMin = bus.hz(id, bus.t0, bus.t1);
+        const double touched = bus.hz(4, bus.t0, bus.t1);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "%s: tocada %.0f Hz, resto min %.1f Hz",
+                 caps == CAPS_ALL ? "negociado" : "500 k", touched, idleMin);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_GREATER_OR_EQUAL(CYCLE_HZ * 0.98, idleMin);
+        TEST_ASSERT_GREATER_OR_EQUAL(10 * idleMin, touched);
+        TEST_ASSERT_EQUAL_UINT32(0, bus.otherIds);
+    }
+}
+
+// Todas tocadas menos una: los slots extra van de uno en uno entre
+// polls del barrido → la parada no se queda sin su turno
+static void test_adaptive_idle_strip_not_starved() {
+    for (uint8_t caps : { CAPS_ALL, CAPS_BASE }) {
+        SimBus bus('A', 1, 8, 61);
+        for (auto& s : bus.s2) {
+            s->caps    = caps;
+            s->touched = true;
+        }
+        bus.s2[7]->touched = false;
+        bus.run();
+        const double idle = bus.hz(8, bus.t0, bus.t1);
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%s: parada %.1f Hz", caps == CAPS_ALL ? "negociado" : "500 k", idle);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_GREATER_OR_EQUAL(CYCLE_HZ * 0.98, idle);
+        for (uint8_t id = 1; id <= 7; id++)
+            TEST_ASSERT_GREATER_THAN(2 * idle, bus.hz(id, bus.t0, bus.t1));
+    }
+}
+
+// Al soltar el fader sigue activa RS485_ACTIVE_HOLD_MS y vuelve al ritmo del barrido
+static void test_adaptive_active_slot_ends_after_hold() {
+    SimBus bus('A', 1, 8, 71);
+    bus.s2[0]->touched = true;
+    const uint64_t release = sim::now() + WARMUP_US + 500000;
+    sim::at(release, [&]() { bus.s2[0]->touched = false; });
+    bus.run(WARMUP_US, 1500000);
+    const uint64_t hold  = RS485_ACTIVE_HOLD_MS * 1000ULL;
+    const double   held  = bus.hz(1, release + 20000, release + hold - 20000);
+    const double   after = bus.hz(1, release + hold + 50000, bus.t1);
+    char msg[80];
+    snprintf(msg, sizeof(msg), "tocada %.0f Hz, hold %.0f Hz, después %.1f Hz",
+             bus.hz(1, bus.t0, release), held, after);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(10 * CYCLE_HZ, held);
+    TEST_ASSERT_FLOAT_WITHIN(CYCLE_HZ * 0.1, CYCLE_HZ, after);
+}
+
+// Con SLAVE_FLAG_CALIB_SENDING faderPos lleva min/max de calibración:
+// el salto entre respuestas no es movimiento y no gana slots extra
+static void test_adaptive_calibration_not_activity() {
+    SimBus bus('A', 1, 8, 73);
+    bus.s2[2]->calibSending = true;
+    bus.run();
+    const double calib = bus.hz(3, bus.t0, bus.t1);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "enviando calibración %.1f Hz", calib);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_FLOAT_WITHIN(CYCLE_HZ * 0.1, CYCLE_HZ, calib);
+}
+
+// ─── Timeout adaptativo ───────────────────────────────────────
+// Poll individual (sin grupo) para que cada respuesta pase por WAIT_RESP
+
+// Timeout que el master debería haber aprendido con estas latencias
+// (LatencyEstimator: percentil por cubos de RS485_LAT_BUCKET_US)
+static uint32_t expectedTimeout(std::vector<uint32_t> lat) {
+    std::sort(lat.begin(), lat.end());
+    uint32_t p = lat[lat.size() * RS485_LAT_PERCENTILE / 1000] + RS485_LAT_MARGIN_US;
+    if (p < RS485_RESP_TIMEOUT_MIN_US) p = RS485_RESP_TIMEOUT_MIN_US;
+    return p;
+}
+
+// En reposo (50 Hz) un slave tarda RS485_LAT_MIN_SAMPLES barridos en aprender
+static constexpr uint64_t LEARNED_US = 3000000;
+
+// Un poll sin respuesta cuesta ~p99 + margen en vez de RS485_RESP_TIMEOUT_US
+static void test_adaptive_timeout_miss_costs_learned() {
+    for (const Speed& sp : SPEEDS) {
+        SimBus bus('A', 1, 8, 81);
+        for (auto& s : bus.s2) {
+            s->caps    = sp.caps & ~SLAVE_CAP_GROUP;
+            s->maxCode = sp.maxCode;
+        }
+        // En reposo y a mitad de barrido: tras el fallo va el poll del
+        // id 6, no el relleno hasta POLL_CYCLE_MS. Fallos solo tras la
+        // negociación (un timeout en la prueba descarta la velocidad)
+        sim::S2& s = *bus.s2[4];
+        sim::at(sim::now() + LEARNED_US, [&]() { s.dropRate = 0.1f; });
+        bus.run(LEARNED_US, 3000000);
+
+        std::vector<uint32_t> cost;
+        for (uint64_t end : s.missed) {
+            const uint64_t next = bus.uart.line.nextMasterFrame(end);
+            if (end >= bus.t0 && next) cost.push_back((uint32_t)(next - end - RS485_GAP_US));
+        }
+        std::sort(cost.begin(), cost.end());
+        const uint32_t expect = expectedTimeout(bus.uart.line.latencies(&s, bus.t0, bus.t1));
+        const uint32_t median = cost[cost.size() / 2];
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%-5s %u fallos: coste mediano %u us (p99 + margen %u us, fijo %u us)",
+                 sp.name, (unsigned)cost.size(), (unsigned)median, (unsigned)expect,
+                 (unsigned)RS485_RESP_TIMEOUT_US);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(rs485_baudRate(sp.maxCode, RS485_BAUD), bus.uart.line.masterBaud, msg);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(8, cost.size(), msg);
+        TEST_ASSERT_UINT32_WITHIN_MESSAGE(RS485_LAT_BUCKET_US + 20, expect, median, msg);
+        TEST_ASSERT_TRUE_MESSAGE(bus.master->getPresence(5) != SlavePresence::OFFLINE, msg);
+    }
+}
+
+// Respuestas con CRC roto y algo más tardías que las buenas: no
+// enseñan latencia, el aprendido sale solo de las limpias (si
+// entraran, el p99 sería el de las rotas y el fallo costaría más)
+static void test_adaptive_timeout_ignores_bad_replies() {
+    for (const Speed& sp : SPEEDS) {
+        SimBus bus('A', 1, 8, 85);
+        for (auto& s : bus.s2) {
+            s->caps    = sp.caps & ~SLAVE_CAP_GROUP;
+            s->maxCode = sp.maxCode;
+        }
+        sim::S2& s = *bus.s2[4];
+        // Tras la negociación: un CRC en la prueba descarta la velocidad
+        sim::at(sim::now() + 1500000, [&]() {
+            s.noiseRate   = 0.1f;
+            s.noiseLateUs = 100;
+        });
+        sim::at(sim::now() + LEARNED_US, [&]() { s.dropRate = 0.1f; });
+        bus.run(LEARNED_US, 4000000);
+
+        std::vector<uint32_t> cost;
+        for (uint64_t end : s.missed) {
+            const uint64_t next = bus.uart.line.nextMasterFrame(end);
+            if (end >= bus.t0 && next) cost.push_back((uint32_t)(next - end - RS485_GAP_US));
+        }
+        std::sort(cost.begin(), cost.end());
+        const uint32_t expect = expectedTimeout(bus.uart.line.latencies(&s, bus.t0, bus.t1));
+        const uint32_t median = cost[cost.size() / 2];
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%-5s %u fallos, %u CRC: coste mediano %u us (p99 limpias + margen %u us)",
+                 sp.name, (unsigned)cost.size(), (unsigned)bus.counter(5, 2), (unsigned)median,
+                 (unsigned)expect);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(rs485_baudRate(sp.maxCode, RS485_BAUD), bus.uart.line.masterBaud, msg);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(8, cost.size(), msg);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(4, bus.counter(5, 2), msg);
+        TEST_ASSERT_UINT32_WITHIN_MESSAGE(RS485_LAT_BUCKET_US + 20, expect, median, msg);
+    }
+}
+
+// Respuesta tardía tras un timeout corto: el siguiente poll espera el
+// fijo, la recoge y el slave no pasa por SUSPECT/OFFLINE
+static void test_adaptive_timeout_late_reply_uses_fixed() {
+    SimBus bus('A', 1, 8, 91);
+    for (auto& s : bus.s2) s->caps = CAPS_NO_GROUP & ~SLAVE_CAP_BAUD;
+    sim::S2& s = *bus.s2[2];
+    uint64_t late = 0;
+    sim::at(sim::now() + LEARNED_US + 500000, [&]() {
+        late        = sim::now();
+        s.lateUs    = RS485_RESP_TIMEOUT_US / 2;
+        s.latePolls = 2;
+    });
+    bus.run(LEARNED_US, 1500000);
+    const sim::Line::Replies r = bus.uart.line.replies(&s, late, bus.t1);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "timeouts %u, respuestas %u (%u limpias)",
+             (unsigned)bus.counter(3, 1), (unsigned)r.sent, (unsigned)r.clean);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, s.latePolls);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.counter(3, 1));          // solo el primero, con el aprendido
+    TEST_ASSERT_TRUE(bus.master->getPresence(3) == SlavePresence::ONLINE);
+    TEST_ASSERT_GREATER_OR_EQUAL(CYCLE_HZ * 0.9, bus.hz(3, late, bus.t1));
+}
+
+// ─── Presencia ────────────────────────────────────────────────
+
+// CRC roto o trama de otro id: cuenta como fallo (SUSPECT → OFFLINE
+// con backoff) igual que un timeout; el resto no se entera
+static void test_presence_invalid_replies_are_misses() {
+    SimBus bus('A', 1, 8, 101);
+    for (auto& s : bus.s2) s->caps = CAPS_BASE;
+    bus.s2[2]->broken  = true;
+    bus.s2[5]->replyId = 7;          // mal configurado: contesta como el 7
+    bus.run();
+    char msg[96];
+    snprintf(msg, sizeof(msg), "id 3: %u polls, %u CRC  id 6: %u polls, %u id ajeno",
+             (unsigned)bus.counter(3, 0), (unsigned)bus.counter(3, 2),
+             (unsigned)bus.counter(6, 0), (unsigned)bus.counter(6, 3));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(bus.master->getPresence(3) == SlavePresence::OFFLINE);
+    TEST_ASSERT_TRUE(bus.master->getPresence(6) == SlavePresence::OFFLINE);
+    // En la ventana solo re-sondeos con backoff, no uno por barrido
+    const uint32_t sweeps = (uint32_t)(WINDOW_US / 1000 / POLL_CYCLE_MS);
+    for (uint8_t id : { 3, 6 }) {
+        TEST_ASSERT_GREATER_THAN(0, bus.counter(id, 0));
+        TEST_ASSERT_LESS_THAN(sweeps / 10, bus.counter(id, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(bus.counter(3, 0), bus.counter(3, 2));
+    TEST_ASSERT_EQUAL_UINT32(bus.counter(6, 0), bus.counter(6, 3));
+    for (uint8_t id : { 1, 2, 4, 5, 7, 8 }) {
+        TEST_ASSERT_TRUE(bus.master->getPresence(id) == SlavePresence::ONLINE);
+        TEST_ASSERT_GREATER_OR_EQUAL(CYCLE_HZ * 0.98, bus.hz(id, bus.t0, bus.t1));
+    }
+}
+
+// Tiempo de bus de cada barrido: del broadcast que lo abre al relleno
+// hasta POLL_CYCLE_MS (vTaskDelay) o al broadcast siguiente
+struct SweepTime {
+    double   meanMs = 0, worstMs = 0;
+    uint32_t sweeps = 0;
+    double   liveMinHz = 1e9;
+};
+
+// Backoff de los muertos ya en RS485_BACKOFF_MAX_MS (100 + 200 + ... + 1600 ms)
+static constexpr uint64_t SETTLED_US = 4000000;
+
+static SweepTime sweepTime(uint8_t slaves, uint8_t dead, uint32_t seed) {
+    SimBus bus('A', 1, slaves, seed);
+    for (auto& s : bus.s2) s->caps = CAPS_BASE;
+    for (uint8_t i = 0; i < dead; i++) bus.s2[slaves - 1 - i]->online = false;
+    std::vector<uint64_t> pads;
+    sim::state().onSleep = [&pads](uint64_t) { pads.push_back(sim::now()); };
+    bus.run(SETTLED_US, 4000000);
+
+    std::vector<uint64_t> starts;
+    for (const sim::Frame& f : bus.uart.line.frames)
+        if (!f.src && f.header == RS485_BCAST_BYTE && f.start >= bus.t0 && f.start < bus.t1)
+            starts.push_back(f.start);
+    SweepTime r;
+    for (size_t k = 0; k + 1 < starts.size(); k++) {
+        uint64_t end = starts[k + 1];
+        auto it = std::lower_bound(pads.begin(), pads.end(), starts[k]);
+        if (it != pads.end() && *it < end) end = *it;
+        const double ms = (end - starts[k]) / 1000.0;
+        r.meanMs += ms;
+        if (ms > r.worstMs) r.worstMs = ms;
+        r.sweeps++;
+    }
+    r.meanMs /= r.sweeps;
+    for (uint8_t id = 1; id <= slaves - dead; id++) {
+        const double hz = bus.hz(id, bus.t0, bus.t1);
+        if (hz < r.liveMinHz) r.liveMinHz = hz;
+    }
+    return r;
+}
+
+// 9 slaves a 500 k, poll individual (docs/RS485.md §7.13): los muertos
+// salen del barrido (OFFLINE) y como mucho uno por barrido se re-sondea
+// → la media escala con los vivos y el peor barrido suma un solo timeout
+static void test_presence_dead_slaves_cycle_time() {
+    const SweepTime all = sweepTime(9, 0, 111);
+    const double perSlave = all.meanMs / 9, worstPerSlave = all.worstMs / 9;
+    for (uint8_t dead : { 0, 1, 3, 5, 9 }) {
+        const SweepTime r = dead ? sweepTime(9, dead, 111 + dead) : all;
+        const uint8_t live = 9 - dead;
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%u muertos: %.1f / %.1f ms (media / peor, %u barridos), vivos min %.1f Hz",
+                 dead, r.meanMs, r.worstMs, (unsigned)r.sweeps, live ? r.liveMinHz : 0.0);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(150, r.sweeps, msg);
+        // En régimen un muerto cuesta un timeout cada RS485_BACKOFF_MAX_MS
+        // (~5 ms / 100 barridos): menos de 0.1 ms por barrido y muerto
+        TEST_ASSERT_TRUE_MESSAGE(r.meanMs <= live * perSlave + 0.1 * dead + 0.3, msg);
+        TEST_ASSERT_TRUE_MESSAGE(r.worstMs <= (live + 1) * worstPerSlave + RS485_RESP_TIMEOUT_US / 1000.0, msg);
+        if (live) TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(CYCLE_HZ * 0.98, r.liveMinHz, msg);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bus_b_local_wire_ids_global_events);
+    RUN_TEST(test_idle_every_strip_at_cycle_rate);
+    RUN_TEST(test_two_buses_double_aggregate_rate);
+    RUN_TEST(test_group_slots_no_collision_up_to_guard);
+    RUN_TEST(test_group_collides_beyond_guard);
+    RUN_TEST(test_group_sweep_shorter_than_individual);
+    RUN_TEST(test_baud_negotiates_highest_clean_code);
+    RUN_TEST(test_baud_fixed_if_any_slave_lacks_cap);
+    RUN_TEST(test_baud_stored_code_reused_or_reswept);
+    RUN_TEST(test_baud_master_restart_slaves_fall_back);
+    RUN_TEST(test_baud_slave_restart_recovered_by_announce);
+    RUN_TEST(test_adaptive_touched_strip_polled_faster);
+    RUN_TEST(test_adaptive_idle_strip_not_starved);
+    RUN_TEST(test_adaptive_active_slot_ends_after_hold);
+    RUN_TEST(test_adaptive_calibration_not_activity);
+    RUN_TEST(test_adaptive_timeout_miss_costs_learned);
+    RUN_TEST(test_adaptive_timeout_ignores_bad_replies);
+    RUN_TEST(test_adaptive_timeout_late_reply_uses_fixed);
+    RUN_TEST(test_presence_invalid_replies_are_misses);
+    RUN_TEST(test_presence_dead_slaves_cycle_time);
+    return UNITY_END();
+}
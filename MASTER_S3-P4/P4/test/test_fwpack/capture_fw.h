@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  capture_fw.h  –  captura del sniffer (imakie_sniff.h, lo que
+//  guarda `rs485sniff -w`) de una actualización delta de un S2
+//
+//  Bus a 4 M, S2 id 3, sesión 5C31. Delante, el log de arranque
+//  del nodo sniffer por el mismo USB (el lector resincroniza).
+//  BEGIN ×3 (IMZ1 delta, fw_sample.h v1 → v2, tools/fwpack) →
+//  QUERY: RECEIVING → DATA 0 y 1, el 1 con un bit cambiado en el
+//  cable → QUERY: NACK del bloque 1 → DATA 1 otra vez → QUERY:
+//  COMPLETE → COMMIT ×3 → QUERY: VERIFIED → REBOOT ×3.
+//  Tramas de más de 120 B en dos lecturas (FIFO lleno).
+//
+//  Generada con los encoders de imakie_protocol.h y la salida de
+//  fwpack: no hay captura en hardware de una actualización por el
+//  bus. Si se registra una, sustituye a esta con el mismo test.
+// ============================================================
+
+// 982 B de flujo USB
+static const uint8_t CAPTURE_FW[] = {
+    0x45, 0x53, 0x50, 0x2D, 0x52, 0x4F, 0x4D, 0x3A, 0x65, 0x73, 0x70, 0x33, 0x32, 0x73, 0x32, 0x2D,
+    0x72, 0x63, 0x34, 0x2D, 0x32, 0x30, 0x31, 0x39, 0x31, 0x30, 0x32, 0x35, 0x0D, 0x0A, 0x42, 0x75,
+    0x69, 0x6C, 0x64, 0x3A, 0x4F, 0x63, 0x74, 0x20, 0x32, 0x35, 0x20, 0x32, 0x30, 0x31, 0x39, 0x0D,
+    0x0A, 0x5B, 0x53, 0x4E, 0x49, 0x46, 0x46, 0x5D, 0x20, 0x34, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30,
+    0x20, 0x62, 0x61, 0x75, 0x64, 0x0D, 0x0A, 0xA5, 0x48, 0x08, 0x40, 0x42, 0x0F, 0x00, 0x01, 0x00,
+    0x09, 0x3D, 0x00, 0x02, 0x10, 0x00, 0xA0, 0xA5, 0x44, 0x1E, 0x8C, 0x42, 0x0F, 0x00, 0xAF, 0x1E,
+    0x01, 0x31, 0x5C, 0x47, 0x01, 0x00, 0x00, 0x02, 0x00, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x02, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x4C, 0x07, 0x7A, 0xA5, 0x44, 0x1E,
+    0xB4, 0x48, 0x0F, 0x00, 0xAF, 0x1E, 0x01, 0x31, 0x5C, 0x47, 0x01, 0x00, 0x00, 0x02, 0x00, 0x22,
+    0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x02, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+    0x4C, 0x07, 0xE1, 0xA5, 0x44, 0x1E, 0xDC, 0x4E, 0x0F, 0x00, 0xAF, 0x1E, 0x01, 0x31, 0x5C, 0x47,
+    0x01, 0x00, 0x00, 0x02, 0x00, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x02, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x4C, 0x07, 0xDA, 0xA5, 0x44, 0x0A, 0x52, 0x6F, 0x15, 0x00,
+    0xAF, 0x0A, 0x03, 0x31, 0x5C, 0x03, 0x00, 0x00, 0x5D, 0x96, 0x4E, 0xA5, 0x44, 0x0D, 0xAF, 0x6F,
+    0x15, 0x00, 0xBC, 0x0D, 0x03, 0x01, 0x31, 0x5C, 0x02, 0x00, 0x00, 0x00, 0x03, 0xFC, 0x5D, 0x72,
+    0xA5, 0x44, 0x78, 0xD2, 0x72, 0x15, 0x00, 0xAF, 0xC9, 0x02, 0x31, 0x5C, 0x00, 0x00, 0x49, 0x4D,
+    0x5A, 0x31, 0x02, 0x0C, 0x00, 0x00, 0xF0, 0x20, 0x00, 0x00, 0x60, 0x54, 0xF0, 0x79, 0x22, 0x23,
+    0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0xFF, 0x6D,
+    0x00, 0xCB, 0x22, 0x10, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C,
+    0x3D, 0x3E, 0x3F, 0x40, 0x41, 0xFF, 0xBD, 0x0D, 0x00, 0x0F, 0xC2, 0xDD, 0x63, 0x67, 0xC3, 0xB6,
+    0x30, 0x2C, 0xC9, 0x07, 0xD2, 0xA7, 0x52, 0x1A, 0x16, 0x2F, 0xFF, 0xE5, 0x16, 0x20, 0x27, 0x8F,
+    0x0A, 0x0D, 0xD3, 0xA3, 0x5D, 0x38, 0xBF, 0x49, 0x11, 0xE0, 0x9E, 0x7F, 0x9D, 0xA7, 0x8E, 0x13,
+    0xCE, 0x6B, 0x5C, 0x80, 0x96, 0x8C, 0x06, 0x0D, 0xBF, 0x1D, 0x3B, 0xD8, 0x28, 0x0E, 0xA1, 0xC5,
+    0xA5, 0x44, 0x51, 0xD2, 0x72, 0x15, 0x00, 0x60, 0x65, 0xC7, 0x89, 0x47, 0x9D, 0x4D, 0x67, 0xFF,
+    0xB5, 0x18, 0x00, 0x7F, 0xC3, 0x27, 0x79, 0x4D, 0x26, 0xC3, 0x3B, 0x3F, 0x7E, 0xCD, 0x21, 0xAA,
+    0xA8, 0xDA, 0x98, 0x68, 0xBA, 0x97, 0xBC, 0xD8, 0xC2, 0x11, 0xCC, 0x97, 0x3A, 0x5B, 0xD2, 0x5C,
+    0x71, 0x88, 0x07, 0x13, 0xE5, 0x90, 0xD0, 0xB1, 0x92, 0x03, 0x50, 0x1C, 0x06, 0xC4, 0x93, 0x7E,
+    0x62, 0x52, 0x33, 0x4A, 0x59, 0x84, 0xC3, 0x69, 0x74, 0x74, 0x0C, 0xE4, 0xF8, 0x6C, 0x73, 0x19,
+    0xB9, 0x12, 0x84, 0x74, 0x26, 0xAA, 0xA9, 0x4E, 0x9E, 0xA5, 0x44, 0x78, 0x17, 0x7A, 0x15, 0x00,
+    0xAF, 0x90, 0x02, 0x31, 0x5C, 0x01, 0x00, 0xF4, 0x40, 0xF1, 0x5C, 0x62, 0x28, 0xF4, 0x14, 0x75,
+    0xEC, 0xD1, 0x1F, 0x44, 0x99, 0x7A, 0x3A, 0x09, 0xF1, 0x57, 0x87, 0x3D, 0x46, 0xDF, 0x23, 0x0A,
+    0x4A, 0x0A, 0x99, 0xB2, 0x68, 0x9F, 0x01, 0xF6, 0xCA, 0x63, 0xDF, 0x00, 0x41, 0x01, 0x7C, 0x01,
+    0x7E, 0xC2, 0x21, 0x04, 0x23, 0x37, 0x09, 0x3D, 0xD3, 0x13, 0xE3, 0xA0, 0x5F, 0xCD, 0x65, 0x90,
+    0xA6, 0x64, 0xC3, 0x80, 0x50, 0x47, 0xD3, 0xEB, 0x6B, 0x8A, 0x19, 0xA2, 0xD0, 0xEE, 0x07, 0xE1,
+    0x9C, 0x35, 0x01, 0x13, 0x66, 0x8E, 0x93, 0xCF, 0x61, 0xD0, 0xDB, 0x12, 0x8E, 0x73, 0xC2, 0x6A,
+    0xE0, 0x40, 0xA3, 0x78, 0x06, 0xB6, 0xBD, 0x72, 0xE1, 0x32, 0x60, 0x4F, 0xED, 0x59, 0x42, 0xC2,
+    0x5C, 0x7D, 0xD5, 0x30, 0xBF, 0x5C, 0x49, 0x46, 0x54, 0xA5, 0x44, 0x18, 0x17, 0x7A, 0x15, 0x00,
+    0x85, 0x53, 0xEB, 0x6E, 0x4C, 0x60, 0x04, 0x5D, 0x94, 0x83, 0xF0, 0x66, 0x5F, 0x06, 0x64, 0x7D,
+    0x2B, 0x4B, 0xC1, 0xD4, 0xCF, 0xBC, 0x48, 0x88, 0xFF, 0xA5, 0x44, 0x0A, 0x0D, 0x80, 0x15, 0x00,
+    0xAF, 0x0A, 0x03, 0x31, 0x5C, 0x03, 0x00, 0x00, 0x5D, 0x96, 0xFE, 0xA5, 0x44, 0x0D, 0x6A, 0x80,
+    0x15, 0x00, 0xBC, 0x0D, 0x03, 0x01, 0x31, 0x5C, 0x01, 0x00, 0x01, 0x00, 0x01, 0x5C, 0xA4, 0x2A,
+    0xA5, 0x44, 0x78, 0xFF, 0x82, 0x15, 0x00, 0xAF, 0x90, 0x02, 0x31, 0x5C, 0x01, 0x00, 0xF4, 0x40,
+    0xF1, 0x5C, 0x62, 0x28, 0xF4, 0x14, 0x75, 0xEC, 0xD1, 0x1F, 0x44, 0x99, 0x7A, 0x3A, 0x09, 0xF1,
+    0x57, 0x87, 0x3D, 0x46, 0xDF, 0x23, 0x0A, 0x4A, 0x0A, 0x99, 0xB2, 0x68, 0x9F, 0x01, 0xF6, 0xC2,
+    0x63, 0xDF, 0x00, 0x41, 0x01, 0x7C, 0x01, 0x7E, 0xC2, 0x21, 0x04, 0x23, 0x37, 0x09, 0x3D, 0xD3,
+    0x13, 0xE3, 0xA0, 0x5F, 0xCD, 0x65, 0x90, 0xA6, 0x64, 0xC3, 0x80, 0x50, 0x47, 0xD3, 0xEB, 0x6B,
+    0x8A, 0x19, 0xA2, 0xD0, 0xEE, 0x07, 0xE1, 0x9C, 0x35, 0x01, 0x13, 0x66, 0x8E, 0x93, 0xCF, 0x61,
+    0xD0, 0xDB, 0x12, 0x8E, 0x73, 0xC2, 0x6A, 0xE0, 0x40, 0xA3, 0x78, 0x06, 0xB6, 0xBD, 0x72, 0xE1,
+    0x32, 0x60, 0x4F, 0xED, 0x59, 0x42, 0xC2, 0x5C, 0x7D, 0xD5, 0x30, 0xBF, 0x5C, 0x49, 0x46, 0x9D,
+    0xA5, 0x44, 0x18, 0xFF, 0x82, 0x15, 0x00, 0x85, 0x53, 0xEB, 0x6E, 0x4C, 0x60, 0x04, 0x5D, 0x94,
+    0x83, 0xF0, 0x66, 0x5F, 0x06, 0x64, 0x7D, 0x2B, 0x4B, 0xC1, 0xD4, 0xCF, 0xBC, 0x48, 0x88, 0xF4,
+    0xA5, 0x44, 0x0A, 0xF5, 0x88, 0x15, 0x00, 0xAF, 0x0A, 0x03, 0x31, 0x5C, 0x03, 0x00, 0x00, 0x5D,
+    0x96, 0xC7, 0xA5, 0x44, 0x0C, 0x50, 0x89, 0x15, 0x00, 0xBC, 0x0C, 0x03, 0x02, 0x31, 0x5C, 0x00,
+    0x00, 0x00, 0x00, 0x5B, 0xA6, 0x1B, 0xA5, 0x44, 0x07, 0x8E, 0x8A, 0x15, 0x00, 0xAF, 0x07, 0x04,
+    0x31, 0x5C, 0xA1, 0x7E, 0xBF, 0xA5, 0x44, 0x07, 0x7C, 0x90, 0x15, 0x00, 0xAF, 0x07, 0x04, 0x31,
+    0x5C, 0xA1, 0x7E, 0xEC, 0xA5, 0x44, 0x07, 0x6A, 0x96, 0x15, 0x00, 0xAF, 0x07, 0x04, 0x31, 0x5C,
+    0xA1, 0x7E, 0x2E, 0xA5, 0x44, 0x0A, 0x80, 0x3D, 0x1D, 0x00, 0xAF, 0x0A, 0x03, 0x31, 0x5C, 0x03,
+    0x00, 0x00, 0x5D, 0x96, 0x82, 0xA5, 0x44, 0x0C, 0xDB, 0x3D, 0x1D, 0x00, 0xBC, 0x0C, 0x03, 0x03,
+    0x31, 0x5C, 0x00, 0x00, 0x00, 0x00, 0x3A, 0x1E, 0xF7, 0xA5, 0x44, 0x07, 0x19, 0x3F, 0x1D, 0x00,
+    0xAF, 0x07, 0x05, 0x31, 0x5C, 0x91, 0x49, 0x95, 0xA5, 0x44, 0x07, 0x07, 0x45, 0x1D, 0x00, 0xAF,
+    0x07, 0x05, 0x31, 0x5C, 0x91, 0x49, 0xB6, 0xA5, 0x44, 0x07, 0xF5, 0x4A, 0x1D, 0x00, 0xAF, 0x07,
+    0x05, 0x31, 0x5C, 0x91, 0x49, 0xB8,
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// ============================================================
+//  fw_sample.h  –  imágenes de app S2 de juguete para test_fwpack
+//
+//  8 KB con la forma de un .bin ESP32-S2: cabecera (0xE9, chip 2),
+//  esp_app_desc_t con app_elf_sha256 = f(version) y un cuerpo
+//  pseudoaleatorio con repeticiones (tablas de punteros, cadenas).
+//  v2 = v1 con un parche de 16 B, 40 B insertados (todo lo de
+//  detrás se desplaza) y 200 B nuevos al final: lo que cambia
+//  entre dos builds. capture_fw.h lleva el delta v1 → v2.
+// ============================================================
+
+static constexpr size_t SAMPLE_SIZE    = 8192;
+static constexpr size_t SAMPLE_DESC_AT = 24 + 8;            // cabecera + segmento
+static constexpr size_t SAMPLE_SHA_AT  = SAMPLE_DESC_AT + 144;
+
+static uint32_t sampleRand(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+static std::vector<uint8_t> sampleImage(uint8_t version) {
+    std::vector<uint8_t> img;
+    uint32_t s = 0x1234567;
+    while (img.size() < SAMPLE_SIZE) {
+        const uint32_t r = sampleRand(s);
+        switch (r & 3) {
+            case 0:                               // tabla de punteros 0x4008xxxx
+                for (int i = 0; i < 8; i++) {
+                    const uint32_t p = 0x40080000 + (sampleRand(s) & 0xFFFC);
+                    for (int k = 0; k < 4; k++) img.push_back((uint8_t)(p >> (8 * k)));
+                }
+                break;
+            case 1: {                             // cadena repetida
+                static const char* const words[] = { "RS485", "fader", "motor", "calib", "touch" };
+                const char* w = words[(r >> 2) % 5];
+                img.insert(img.end(), w, w + strlen(w) + 1);
+                break;
+            }
+            default:                              // "código"
+                for (int i = 0; i < 12; i++) img.push_back((uint8_t)sampleRand(s));
+                break;
+        }
+    }
+    img.resize(SAMPLE_SIZE);
+
+    if (version >= 2) {
+        for (size_t i = 0; i < 16; i++) img[2000 + i] ^= 0x5A;
+        std::vector<uint8_t> ins(40);
+        for (auto& b : ins) b = (uint8_t)sampleRand(s);
+        img.insert(img.begin() + 5000, ins.begin(), ins.end());
+        for (int i = 0; i < 200; i++) img.push_back((uint8_t)sampleRand(s));
+    }
+
+    memset(img.data(), 0, SAMPLE_DESC_AT + 256);
+    img[0]  = 0xE9;                               // ESP_IMAGE_HEADER_MAGIC
+    img[12] = 0x02;                               // chip_id = ESP32-S2
+    const uint32_t magic = 0xABCD5432;            // ESP_APP_DESC_MAGIC_WORD
+    memcpy(&img[SAMPLE_DESC_AT], &magic, 4);
+    for (int i = 0; i < 32; i++) img[SAMPLE_SHA_AT + i] = (uint8_t)(version * 0x11 + i);
+    return img;
+}
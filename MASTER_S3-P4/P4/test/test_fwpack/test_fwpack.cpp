@@ -0,0 +1,200 @@
+// ============================================================
+//  test_fwpack.cpp  –  decoder IMZ1 (imakie_fwpack.h) en host
+//  pio test -e native -f test_fwpack
+//
+//  Parte de una captura del sniffer (capture_fw.h): registros →
+//  tramas 0xAF / 0xBC con su CRC → bloques DATA por número (la
+//  copia rota en el cable se descarta, vale el reenvío) → imagen
+//  IMZ1 → FwUnpack contra la base, en trozos de FW_BLOCK_LEN como
+//  en el S2. La salida tiene que ser v2 byte a byte.
+// ============================================================
+#include <unity.h>
+#include <map>
+#include <vector>
+#include <imakie_sniff.h>
+#include <imakie_fwpack.h>
+#include "fw_sample.h"
+#include "capture_fw.h"
+
+void setUp() {}
+void tearDown() {}
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Decoded {
+    uint32_t records = 0, hello = 0, skipped = 0;
+    uint32_t baud = 0;                         // HELLO: versión, baud, rxTimeout, ring KB
+    uint32_t frames = 0, badCrc = 0;
+    uint32_t ops[FW_OP_ABORT + 1] = {};
+    std::vector<uint8_t> states;               // estado de cada respuesta 0xBC
+    std::vector<uint16_t> nack;                // bloques pedidos en cada respuesta
+    Bytes    begin;                            // cuerpo del primer BEGIN
+    std::map<uint16_t, Bytes> blocks;          // primera copia buena de cada bloque
+    uint32_t duplicates = 0;
+};
+
+// Flujo USB → registros → bytes del bus → tramas
+static Decoded decodeCapture(const uint8_t* cap, size_t n) {
+    Decoded d;
+    SniffReader rd;
+    Bytes bus;
+    for (size_t i = 0; i < n; i++) {
+        if (!rd.push(cap[i])) continue;
+        d.records++;
+        if (rd.type == SNIFF_HELLO) { d.hello++; d.baud = rs485_get32(rd.payload() + 1); }
+        if (rd.type == SNIFF_DATA) bus.insert(bus.end(), rd.payload(), rd.payload() + rd.len);
+    }
+    d.skipped = rd.skipped;
+
+    size_t i = 0;
+    while (i < bus.size()) {
+        const size_t avail = bus.size() - i;
+        const size_t need  = rs485_frameLength(&bus[i], avail);
+        if (need == 0) { i++; continue; }
+        if (need > avail) break;
+        if (rs485_checkFrame(&bus[i], need) != Rs485Status::OK) {
+            d.badCrc++;
+            i += need;                         // longitud coherente: trama entera fuera
+            continue;
+        }
+        const uint8_t* f = &bus[i];
+        d.frames++;
+        if (f[0] == RS485_FW_BYTE && f[2] <= FW_OP_ABORT) {
+            d.ops[f[2]]++;
+            const uint8_t* body = &f[FW_HEADER_LEN];
+            const size_t   len  = need - FW_HEADER_LEN - 2;
+            if (f[2] == FW_OP_BEGIN && d.begin.empty()) d.begin.assign(body, body + len);
+            if (f[2] == FW_OP_DATA) {
+                const uint16_t b = rs485_get16(body);
+                if (d.blocks.count(b)) d.duplicates++;
+                else d.blocks[b].assign(body + 2, body + len);
+            }
+        } else if (f[0] == RS485_FW_RESP_BYTE) {
+            d.states.push_back(f[3]);
+            const uint16_t base = rs485_get16(&f[8]);
+            for (size_t k = 0; k < (need - FW_STATUS_HEADER_LEN - 2) * 8; k++)
+                if (f[FW_STATUS_HEADER_LEN + k / 8] & (1 << (k & 7))) d.nack.push_back(base + k);
+        }
+        i += need;
+    }
+    return d;
+}
+
+struct Sink {
+    Bytes out;
+    static bool write(void* ctx, const uint8_t* src, size_t n) {
+        Bytes& o = static_cast<Sink*>(ctx)->out;
+        o.insert(o.end(), src, src + n);
+        return true;
+    }
+    const Bytes* base = nullptr;
+    static bool read(void* ctx, uint32_t off, uint8_t* dst, size_t n) {
+        const Bytes* b = static_cast<Sink*>(ctx)->base;
+        if (off + n > b->size()) return false;
+        memcpy(dst, b->data() + off, n);
+        return true;
+    }
+};
+
+static FwUnpackStatus unpack(const Bytes& imz, const Bytes& base, Bytes& out) {
+    FwPackHeader h;
+    if (!fwpack_parseHeader(imz.data(), imz.size(), h)) return FwUnpackStatus::BAD_DATA;
+    std::vector<uint8_t> window(1u << h.windowBits);
+    Sink sink;
+    sink.base = &base;
+    FwUnpack un;
+    un.begin(h, window.data(), Sink::write, &sink, Sink::read, base.size());
+    FwUnpackStatus st = FwUnpackStatus::OK;
+    for (size_t off = FWPACK_HEADER_LEN; off < imz.size() && st == FwUnpackStatus::OK; off += FW_BLOCK_LEN) {
+        const size_t k = imz.size() - off < FW_BLOCK_LEN ? imz.size() - off : FW_BLOCK_LEN;
+        st = un.push(&imz[off], k);
+    }
+    if (st == FwUnpackStatus::OK) st = un.finish();
+    out = sink.out;
+    return st;
+}
+
+// Registros y tramas: el log de arranque se salta, la copia rota del
+// bloque 1 no pasa el CRC y la conversación es la del comentario de
+// capture_fw.h
+static void test_capture_frames() {
+    const Decoded d = decodeCapture(CAPTURE_FW, sizeof(CAPTURE_FW));
+    TEST_ASSERT_EQUAL_UINT32(1, d.hello);
+    TEST_ASSERT_EQUAL_UINT32(4000000, d.baud);
+    TEST_ASSERT_GREATER_THAN(0, d.skipped);
+    TEST_ASSERT_EQUAL_UINT32(1, d.badCrc);
+    TEST_ASSERT_EQUAL_UINT32(3, d.ops[FW_OP_BEGIN]);
+    TEST_ASSERT_EQUAL_UINT32(2, d.ops[FW_OP_DATA]);           // bloque 0 + reenvío del 1
+    TEST_ASSERT_EQUAL_UINT32(4, d.ops[FW_OP_QUERY]);
+    TEST_ASSERT_EQUAL_UINT32(3, d.ops[FW_OP_COMMIT]);
+    TEST_ASSERT_EQUAL_UINT32(3, d.ops[FW_OP_REBOOT]);
+    TEST_ASSERT_EQUAL_UINT32(0, d.duplicates);
+
+    const uint8_t states[] = { FW_RECEIVING, FW_RECEIVING, FW_COMPLETE, FW_VERIFIED };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(states), d.states.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(states, d.states.data(), sizeof(states));
+    // 1.ª respuesta: todo pendiente (0, 1); 2.ª: solo el bloque roto
+    TEST_ASSERT_EQUAL_UINT32(3, d.nack.size());
+    TEST_ASSERT_EQUAL_UINT16(1, d.nack.back());
+}
+
+// Bloques → IMZ1 → v2 contra la base v1, como COMMIT en el S2
+static void test_capture_unpacks_to_v2() {
+    const Decoded d = decodeCapture(CAPTURE_FW, sizeof(CAPTURE_FW));
+    TEST_ASSERT_EQUAL_UINT32(FW_BEGIN_PACK_LEN, d.begin.size());
+    const uint32_t size   = rs485_get32(&d.begin[0]);
+    const uint16_t blocks = rs485_get16(&d.begin[4]);
+    TEST_ASSERT_EQUAL_UINT8(FWPACK_DELTA, d.begin[14]);
+    TEST_ASSERT_EQUAL_UINT32(blocks, d.blocks.size());
+
+    Bytes imz;
+    for (uint16_t b = 0; b < blocks; b++) imz.insert(imz.end(), d.blocks.at(b).begin(), d.blocks.at(b).end());
+    TEST_ASSERT_EQUAL_UINT32(size, imz.size());
+
+    FwPackHeader h;
+    TEST_ASSERT_TRUE(fwpack_parseHeader(imz.data(), imz.size(), h));
+    TEST_ASSERT_EQUAL_UINT8(FWPACK_DELTA, h.format);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&d.begin[6], h.fwId, FW_ID_LEN);       // BEGIN = cabecera
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&d.begin[15], h.baseId, FW_ID_LEN);
+
+    const Bytes v1 = sampleImage(1), v2 = sampleImage(2);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&v1[SAMPLE_SHA_AT], h.baseId, FW_ID_LEN);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&v2[SAMPLE_SHA_AT], h.fwId, FW_ID_LEN);
+
+    Bytes out;
+    TEST_ASSERT_EQUAL_INT((int)FwUnpackStatus::DONE, (int)unpack(imz, v1, out));
+    TEST_ASSERT_EQUAL_UINT32(h.outSize, out.size());
+    TEST_ASSERT_EQUAL_UINT32(h.outCrc, fwpack_crc32(0, out.data(), out.size()));
+    TEST_ASSERT_EQUAL_UINT32(v2.size(), out.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(v2.data(), out.data(), v2.size());
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "IMZ1 delta %u B en %u bloques → %u B (%.1f %% de la imagen)",
+             (unsigned)size, (unsigned)blocks, (unsigned)out.size(), 100.0 * size / out.size());
+    TEST_MESSAGE(msg);
+}
+
+// La copia rota del bloque 1 (la que se habría escrito sin CRC) o una
+// base que no es la del delta: el S2 no llega a VERIFIED
+static void test_capture_rejects_bad_block_or_base() {
+    const Decoded d = decodeCapture(CAPTURE_FW, sizeof(CAPTURE_FW));
+    Bytes imz;
+    for (auto& b : d.blocks) imz.insert(imz.end(), b.second.begin(), b.second.end());
+
+    Bytes out;
+    Bytes other = sampleImage(1);
+    other[4000] ^= 0x01;
+    TEST_ASSERT_TRUE(unpack(imz, other, out) != FwUnpackStatus::DONE);
+
+    Bytes flipped = imz;
+    flipped[FW_BLOCK_LEN + 40 - FW_HEADER_LEN - 2] ^= 0x08;      // el bit que cambió el cable
+    TEST_ASSERT_TRUE(unpack(flipped, sampleImage(1), out) != FwUnpackStatus::DONE);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_frames);
+    RUN_TEST(test_capture_unpacks_to_v2);
+    RUN_TEST(test_capture_rejects_bad_block_or_base);
+    return UNITY_END();
+}
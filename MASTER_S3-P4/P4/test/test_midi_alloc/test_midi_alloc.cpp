@@ -0,0 +1,206 @@
+// ============================================================
+//  test_midi_alloc.cpp  –  el camino LCD / asignación / timecode
+//  de MIDIProcessor no toca el heap
+//  pio test -e native -f test_midi_alloc
+//
+//  src/midi/MIDIProcessor.cpp y src/RS485 tal cual sobre test/sim;
+//  las globales de main.cpp se definen aquí. operator new / delete
+//  globales cuentan reservas. Un flujo de Logic en paquetes USB-MIDI
+//  (nombres y valores del LCD 0x12, asignación 0x11, dígitos de
+//  timecode CC 64-73, VU y faders de relleno) pasa una vez para
+//  calentar y luego N veces contando: processMidiPacket(), lcdApply()
+//  → trackNames / lcdValues / rs485.setTrackName(), y los
+//  formatTimecodeString() / formatBeatString() del redibujado de
+//  cabecera. Tiene que salir 0.
+// ============================================================
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <imakie_protocol.h>
+#include <imakie_profiler.h>
+#include <LatencyEstimator.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+#include <freertos/FreeRTOS.h>
+
+// ─── Contador de reservas ────────────────────────────────────
+// new → malloc y delete → free: GCC no ve el emparejamiento al inlinear
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static size_t s_allocs = 0;
+
+void* operator new(size_t n) {
+    s_allocs++;
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { s_allocs++; return malloc(n ? n : 1); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { s_allocs++; return malloc(n ? n : 1); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+// En el firmware, portENTER_CRITICAL (imakie_miditx.h, ESP_PLATFORM)
+struct MidiTxSpinlock {
+    void lock() {}
+    void unlock() {}
+};
+
+// config.h trae estado estático del UI; los log_* con size_t son de
+// 32 bits en el ESP32
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wformat"
+#define DEVICE_P4_MASTER
+#include "../../src/RS485/RS485.cpp"
+#include "../../src/RS485/RS485Fw.cpp"
+#include "../../src/midi/MIDIProcessor.cpp"
+
+// Globales de main.cpp que usa MIDIProcessor
+USBMIDI MIDI;
+volatile ConnectionState logicConnectionState = ConnectionState::CONNECTED;
+uint8_t g_logicConnected = 1;
+uint8_t vpotValues[8] = {};
+TrackName trackNames[MCU_CHANNELS];
+TrackName lcdValues[8];
+bool recStates[8]    = {}, soloStates[8] = {};
+bool muteStates[8]   = {}, selectStates[8] = {};
+float vuLevels[MCU_CHANNELS]    = {};
+bool vuClipState[MCU_CHANNELS]  = {};
+unsigned long vuLastUpdateTime[MCU_CHANNELS]     = {};
+float vuPeakLevels[MCU_CHANNELS]                 = {};
+unsigned long vuPeakLastUpdateTime[MCU_CHANNELS] = {};
+float faderPositions[MCU_CHANNELS]               = {};
+bool needsTOTALRedraw    = false;
+bool needsMainAreaRedraw = false;
+bool needsHeaderRedraw   = false;
+bool needsTimecodeRedraw = true;
+bool needsButtonsRedraw  = true;
+bool needsVUMetersRedraw = true;
+AssignText assignmentString = "--";
+bool btnStatePG1[32] = {}, btnStatePG2[32] = {};
+bool btnFlashPG1[32] = {}, btnFlashPG2[32] = {};
+char timeCodeChars_clean[13] = {};
+char beatsChars_clean[13]    = {};
+DisplayMode currentTimecodeMode = MODE_BEATS;
+volatile bool g_switchToPage3   = false;
+volatile bool g_switchToOffline = false;
+
+void setUp() {}
+void tearDown() {}
+
+// ─── Flujo de Logic en paquetes USB-MIDI ─────────────────────
+typedef std::vector<midiEventPacket_t> Stream;
+
+static void addMsg(Stream& s, uint8_t status, uint8_t d1, uint8_t d2) {
+    s.push_back({ (uint8_t)(status >> 4), status, d1, d2 });
+}
+
+static void addSysEx(Stream& s, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> msg = { 0xF0, 0x00, 0x00, 0x66, 0x14 };
+    msg.insert(msg.end(), body.begin(), body.end());
+    msg.push_back(0xF7);
+    for (size_t pos = 0; pos < msg.size();) {
+        midiEventPacket_t p;
+        pos = midiPackSysEx(msg.data(), msg.size(), pos, p);
+        s.push_back(p);
+    }
+}
+
+static void addLcd(Stream& s, uint8_t offset, const char* text) {
+    std::vector<uint8_t> body = { 0x12, offset };
+    body.insert(body.end(), text, text + strlen(text));
+    addSysEx(s, body);
+}
+
+// Una vuelta: carga de banco (fila 0 entera), el usuario gira un VPot
+// (Logic reescribe el valor de esa tira), asignación y timecode que
+// corren, y el banco siguiente. Cada vuelta cambia algo en cada celda.
+static Stream logicStream() {
+    static const char* BANKS[2] = {
+        "Kick   Snare  OH L/R Bass DIGtr RhyGtr Ld Keys   Lead Vx",
+        "Pad    StringsBrass  Perc   FX Rev FX Dly Sub    Bus Drm",
+    };
+    static const char* ASSIGN[2] = { "PN", "EQ" };
+    Stream s;
+    for (int bank = 0; bank < 2; bank++) {
+        addLcd(s, 0x00, BANKS[bank]);
+        addSysEx(s, { 0x11, (uint8_t)ASSIGN[bank][0], (uint8_t)ASSIGN[bank][1] });
+        for (int step = 0; step < 40; step++) {
+            const uint8_t strip = step % 8;
+            char value[8];
+            snprintf(value, sizeof(value), "%+5d  ", (step * 7 + bank * 3) % 64 - 32);
+            addLcd(s, 0x38 + strip * MCU_LCD_CELL_W, value);
+            addMsg(s, 0xB0, 0x30 + strip, 0x41);                     // VPot
+            addMsg(s, 0xB0, 64 + step % 10, (0x30 + (step + bank) % 10) | (step & 1) << 6);
+            addMsg(s, 0xD0, (uint8_t)(strip << 4 | step % 12), 0);   // VU
+            addMsg(s, 0xE0 | strip, 0, (uint8_t)(step * 3));         // fader
+        }
+        addLcd(s, 0x00, BANKS[bank]);                               // reescritura igual
+    }
+    return s;
+}
+
+static uint32_t replay(const Stream& s, uint32_t rounds) {
+    uint32_t msgs = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (const midiEventPacket_t& p : s) processMidiPacket(&p.header);
+        // Redibujado de cabecera en el task de UI
+        TimecodeText tc = formatTimecodeString();
+        TimecodeText bt = formatBeatString();
+        TEST_ASSERT_FALSE(tc.empty() || bt.empty());
+        MidiTx::flush();
+        msgs += s.size();
+    }
+    return msgs;
+}
+
+// El contador cuenta (std::string largo → reserva)
+static void test_counter_sees_heap() {
+    const size_t before = s_allocs;
+    std::string big(64, 'x');
+    TEST_ASSERT_GREATER_THAN(before, s_allocs);
+}
+
+// Camino estacionario: 0 reservas
+static void test_lcd_assign_timecode_heap_free() {
+    sim::reset(1);
+    rs485.begin();
+    const Stream s = logicStream();
+    replay(s, 1);                                   // arranque: estado inicial
+    TEST_ASSERT_EQUAL_STRING("Bus Drm", trackNames[7].c_str());
+    TEST_ASSERT_EQUAL_STRING("EQ", assignmentString.c_str());
+    TEST_ASSERT_FALSE(lcdValues[7].empty());
+
+    const size_t   before = s_allocs;
+    const uint32_t msgs   = replay(s, 500);
+    const size_t   allocs = s_allocs - before;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%u paquetes USB-MIDI, %u cambios de banco: %u reservas",
+             (unsigned)msgs, 500u * 2, (unsigned)allocs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, allocs);
+}
+
+// Todos los dígitos con punto: 20 caracteres, caben en TimecodeText
+// (el char[14] de antes se desbordaba)
+static void test_timecode_all_dots_fits() {
+    for (int i = 0; i < 10; i++) timeCodeChars_clean[i] = (char)('0' + i) | (char)0x80;
+    const size_t before = s_allocs;
+    TimecodeText tc = formatTimecodeString();
+    TEST_ASSERT_EQUAL_UINT32(0, s_allocs - before);
+    TEST_ASSERT_EQUAL_STRING("0:1:2:3:4:5:6:7:8:9:", tc.c_str());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_sees_heap);
+    RUN_TEST(test_lcd_assign_timecode_heap_free);
+    RUN_TEST(test_timecode_all_dots_fits);
+    int rc = UNITY_END();
+    sim::stop();
+    return rc;
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  lcd_capture.h  –  flujo MIDI de Logic (bytes en crudo, el formato
+//  de IMAKIE_MIDI_CAPTURE de test_midi_parser) con el tráfico del
+//  LCD Mackie de una sesión corta
+//
+//  Carga del proyecto (fila 0 y fila 1 enteras), barrido de pan en la
+//  tira 3 (Logic reescribe los 56 caracteres de la fila 1 en cada
+//  paso), filas reenviadas iguales, renombrar una pista, cambio de
+//  banco en un solo 0x12 de 112 caracteres, un mensaje que cruza de la
+//  fila 0 a la 1 y un carácter suelto. Entre medias, channel pressure
+//  (VU) y algún F8 de reloj dentro del SysEx.
+//
+//  Sintética, con los textos y el orden que manda Logic: no hay una
+//  captura de placa guardada. LCD_CAPTURE_CELLS[i] es el número de
+//  celdas que cambian con el 0x12 número i.
+// ============================================================
+
+// 2028 B, 32 mensajes 0x12, 54 celdas cambiadas
+static const uint8_t LCD_CAPTURE[] = {
+    0xD0, 0x00, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x00, 0x4B, 0x69, 0x63, 0x6B, 0x20, 0x20, 0x20,
+    0x53, 0x6E, 0x61, 0x72, 0x65, 0x20, 0x20, 0x4F, 0x48, 0x20, 0x4C, 0x2F, 0x52, 0x20, 0x42, 0x61,
+    0x73, 0x73, 0x20, 0x44, 0x49, 0x47, 0x74, 0x72, 0x20, 0x52, 0x68, 0x79, 0x47, 0x74, 0x72, 0x20,
+    0x4C, 0x64, 0x20, 0x4B, 0x65, 0x79, 0x73, 0x20, 0x20, 0x20, 0x4C, 0x65, 0x61, 0x64, 0x20, 0x56,
+    0x78, 0xF7, 0xD0, 0x11, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0xF7, 0xD0, 0x22, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x33, 0x30, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x33, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x32,
+    0x37, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x44, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12,
+    0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0xF8, 0x20,
+    0x20, 0x2D, 0x32, 0x34, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x55, 0xF0, 0x00, 0x00,
+    0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x2D, 0x32, 0x31, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x66, 0xF0,
+    0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x31, 0x38, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0,
+    0x77, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x31, 0x35, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0xF7, 0xD0, 0x08, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x31, 0x32, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0xF7, 0xD0, 0x19, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x20, 0x2D, 0x39, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x2A, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x2D,
+    0x36, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x3B, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12,
+    0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x2D, 0x33, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x40, 0xF0, 0x00, 0x00, 0x66,
+    0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x2B, 0x30, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x51, 0xF0, 0x00,
+    0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x33, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x62,
+    0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x20, 0x2B, 0x36, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0xF7, 0xD0, 0x73, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x39, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0xF7, 0xD0, 0x04, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x31, 0x32, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x15, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x31, 0x35,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x26, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B,
+    0x31, 0x38, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x37, 0xF0, 0x00, 0x00, 0x66, 0x14,
+    0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0xF8,
+    0x20, 0x20, 0x2B, 0x32, 0x31, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x48, 0xF0, 0x00,
+    0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x2B, 0x32, 0x34, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x59,
+    0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x32, 0x37, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7,
+    0xD0, 0x6A, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x32, 0x37, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0xF7, 0xD0, 0x7B, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20, 0x43, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x32, 0x37, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43,
+    0x20, 0x20, 0x20, 0xF7, 0xD0, 0x00, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x38, 0x20, 0x20, 0x20,
+    0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x2B, 0x32, 0x37,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x11, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x00,
+    0x4B, 0x69, 0x63, 0x6B, 0x20, 0x20, 0x20, 0x53, 0x6E, 0x61, 0x72, 0x65, 0x20, 0x20, 0x4F, 0x48,
+    0x20, 0x4C, 0x2F, 0x52, 0x20, 0x42, 0x61, 0x73, 0x73, 0x20, 0x44, 0x49, 0x47, 0x74, 0x72, 0x20,
+    0x52, 0x68, 0x79, 0x47, 0x74, 0x72, 0x20, 0x4C, 0x64, 0x20, 0x4B, 0x65, 0x79, 0x73, 0x20, 0x20,
+    0x20, 0x4C, 0x65, 0x61, 0x64, 0x20, 0x56, 0x78, 0xF7, 0xD0, 0x22, 0xF0, 0x00, 0x00, 0x66, 0x14,
+    0x12, 0x00, 0x4B, 0x69, 0x63, 0x6B, 0x20, 0x20, 0x20, 0x53, 0x6E, 0x61, 0x72, 0x65, 0x20, 0x20,
+    0x4F, 0x48, 0x20, 0x4C, 0x2F, 0x52, 0x20, 0x42, 0x61, 0x73, 0x73, 0x20, 0x44, 0x49, 0x47, 0x74,
+    0x72, 0x20, 0x52, 0x68, 0x79, 0x47, 0x74, 0x72, 0x20, 0x4C, 0x64, 0x20, 0x4B, 0x65, 0x79, 0x73,
+    0x20, 0x20, 0x20, 0x4C, 0x65, 0x61, 0x64, 0x20, 0x56, 0x78, 0xF7, 0xD0, 0x33, 0xF0, 0x00, 0x00,
+    0x66, 0x14, 0x12, 0x00, 0x4B, 0x69, 0x63, 0x6B, 0x20, 0x20, 0x20, 0x53, 0x6E, 0x61, 0x72, 0x65,
+    0x20, 0x20, 0x4F, 0x48, 0x20, 0x4C, 0x2F, 0x52, 0x20, 0x42, 0x61, 0x73, 0x73, 0x20, 0x44, 0x49,
+    0x47, 0x74, 0x72, 0x20, 0x52, 0x68, 0x79, 0x47, 0x74, 0x72, 0x20, 0x4C, 0x64, 0x20, 0x4B, 0x65,
+    0x79, 0x73, 0x20, 0x20, 0x20, 0x4C, 0x65, 0x61, 0x64, 0x20, 0x56, 0x78, 0xF7, 0xD0, 0x44, 0xF0,
+    0x00, 0x00, 0x66, 0x14, 0x12, 0x23, 0x53, 0x6F, 0x6C, 0x6F, 0x20, 0x47, 0x74, 0xF7, 0xD0, 0x55,
+    0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x00, 0x50, 0x61, 0x64, 0x20, 0x20, 0x20, 0x20, 0x53, 0x74,
+    0x72, 0x69, 0x6E, 0x67, 0xF8, 0x73, 0x42, 0x72, 0x61, 0x73, 0x73, 0x20, 0x20, 0x50, 0x65, 0x72,
+    0x63, 0x20, 0x20, 0x20, 0x46, 0x58, 0x20, 0x52, 0x65, 0x76, 0x20, 0x46, 0x58, 0x20, 0x44, 0x6C,
+    0x79, 0x20, 0x53, 0x75, 0x62, 0x20, 0x20, 0x20, 0x20, 0x42, 0x75, 0x73, 0x20, 0x44, 0x72, 0x6D,
+    0x20, 0x20, 0x2D, 0x33, 0x20, 0x20, 0x20, 0x20, 0x20, 0x2B, 0x31, 0x32, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x4C, 0x32, 0x30, 0x20, 0x20, 0x20, 0x20, 0x52, 0x38,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0x20, 0x20, 0x2D, 0x36, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x43, 0x20, 0x20, 0x20, 0xF7, 0xD0, 0x66, 0xF0, 0x00, 0x00, 0x66, 0x14,
+    0x12, 0x31, 0x42, 0x75, 0x73, 0x20, 0x56, 0x6F, 0x63, 0x20, 0x20, 0x2D, 0x34, 0x20, 0x20, 0x20,
+    0xF7, 0xD0, 0x77, 0xF0, 0x00, 0x00, 0x66, 0x14, 0x12, 0x11, 0x58, 0xF7,
+};
+
+static const uint8_t LCD_CAPTURE_CELLS[] = {
+    8, 8, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 1, 14, 2, 1,
+};
@@ -0,0 +1,133 @@
+// ============================================================
+//  test_midi_lcd.cpp  –  lib/imakie_midi (McuLcd) con un flujo del
+//  LCD Mackie
+//  pio test -e native -f test_midi_lcd
+//
+//  lcd_capture.h pasa por MidiParser<MIDI_SYSEX_CHUNK> y llega a
+//  McuLcd como en onMidiSysEx() (P4/S3): cabecera en el primer trozo,
+//  begin() + feed() por trozo, takeDirty(partial) tras cada uno. Por
+//  cada 0x12 se cuentan las celdas que salen (= trackNames / lcdValues
+//  / rs485.setTrackName que se hacen) y se comparan con las que
+//  cambian de verdad; aparte, las que el mensaje reescribe.
+// ============================================================
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include <imakie_midi.h>
+#include <imakie_lcd.h>
+#include "lcd_capture.h"
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint8_t CHUNK = 16;      // MIDI_SYSEX_CHUNK (config.h P4/S3)
+
+struct Replay {
+    McuLcd               lcd;
+    std::vector<uint8_t> cells;            // celdas aplicadas por 0x12
+    uint32_t             touched = 0;      // celdas reescritas (sin bits de cambio)
+    uint32_t             applies = 0;      // llamadas con máscara ≠ 0
+
+    // Estado de onMidiSysEx()
+    uint8_t head[6];
+    uint8_t headLen = 0;
+    bool    isLcd   = false;
+    uint8_t first = 0, pos = 0;            // rango del mensaje para 'touched'
+
+    void apply(bool partial) {
+        const uint16_t mask = lcd.takeDirty(partial);
+        if (mask) applies++;
+        cells.back() += __builtin_popcount(mask);
+    }
+
+    static void onSysEx(void* ctx, const uint8_t* data, uint8_t n, uint8_t flags) {
+        Replay& r = *static_cast<Replay*>(ctx);
+        if (flags & MIDI_SYSEX_START) { r.headLen = 0; r.isLcd = false; }
+        if (r.isLcd) {
+            r.lcd.feed(data, n);
+            r.pos += n;
+        } else {
+            uint8_t k = 0;
+            while (k < n && r.headLen < sizeof(r.head)) r.head[r.headLen++] = data[k++];
+            if ((flags & MIDI_SYSEX_START) && r.headLen == sizeof(r.head) &&
+                r.head[3] == 0x14 && r.head[4] == 0x12) {
+                r.isLcd = true;
+                r.cells.push_back(0);
+                r.first = r.pos = r.head[5];
+                r.lcd.begin(r.head[5]);
+                r.lcd.feed(data + k, n - k);
+                r.pos += n - k;
+            }
+        }
+        const bool last = flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT);
+        if (!r.isLcd) return;
+        r.apply(!last);
+        if (last && r.pos > r.first)
+            r.touched += (r.pos - 1) / MCU_LCD_CELL_W - r.first / MCU_LCD_CELL_W + 1;
+    }
+};
+
+static void onMsg(void*, uint8_t, uint8_t, uint8_t) {}
+
+static Replay& replay() {
+    static Replay r;
+    static bool   done = false;
+    if (!done) {
+        MidiParser<CHUNK> p(onMsg, Replay::onSysEx, nullptr, &r);
+        p.push(LCD_CAPTURE, sizeof(LCD_CAPTURE));
+        done = true;
+    }
+    return r;
+}
+
+// Celdas por mensaje = las que cambian (ni más: filas reenviadas iguales,
+// celda partida entre trozos; ni menos: mensaje que cruza de fila)
+static void test_cells_per_message() {
+    const Replay& r = replay();
+    TEST_ASSERT_EQUAL_UINT32(sizeof(LCD_CAPTURE_CELLS), r.cells.size());
+    for (size_t i = 0; i < r.cells.size(); i++) {
+        char msg[48];
+        snprintf(msg, sizeof(msg), "0x12 número %u", (unsigned)i);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(LCD_CAPTURE_CELLS[i], r.cells[i], msg);
+    }
+}
+
+// Total frente a reescribir todo lo que llega
+static void test_dirty_total_vs_rewrites() {
+    const Replay& r = replay();
+    uint32_t expected = 0, got = 0;
+    for (uint8_t c : LCD_CAPTURE_CELLS) expected += c;
+    for (uint8_t c : r.cells) got += c;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u mensajes 0x12: %u celdas reescritas, %u aplicadas (%u llamadas con cambios)",
+             (unsigned)r.cells.size(), (unsigned)r.touched, (unsigned)got, (unsigned)r.applies);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(expected, got);
+    TEST_ASSERT_LESS_THAN(r.touched / 4, got);
+}
+
+// Texto final: banco 2, pista 8 renombrada por el mensaje que cruza
+// filas, carácter suelto en la tira 3
+static void test_final_text() {
+    const Replay& r = replay();
+    char cell[MCU_LCD_CELL_W + 1];
+    r.lcd.cell(0, 0, cell);
+    TEST_ASSERT_EQUAL_STRING("Pad", cell);
+    r.lcd.cell(0, 2, cell);
+    TEST_ASSERT_EQUAL_STRING("BraXs", cell);
+    r.lcd.cell(0, 7, cell);
+    TEST_ASSERT_EQUAL_STRING("Bus Voc", cell);
+    r.lcd.cell(1, 0, cell);
+    TEST_ASSERT_EQUAL_STRING("  -4", cell);
+    r.lcd.cell(1, 3, cell);
+    TEST_ASSERT_EQUAL_STRING("  L20", cell);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cells_per_message);
+    RUN_TEST(test_dirty_total_vs_rewrites);
+    RUN_TEST(test_final_text);
+    return UNITY_END();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  notes_legacy.h  –  arrays y bucles de processNote() anteriores a
+//  McuNoteMap, copiados tal cual (P4 y S3 difieren en la tecla 16
+//  de PG1: 0x00 en el P4, 0x64 en el S3)
+// ============================================================
+
+static const uint8_t LEGACY_P4_PG1[32] = {
+    0x28,0x2A,0x2C,0x29,0x2B,0x2D,0x32,0x33,
+    0x4A,0x4B,0x4D,0x4E,0x4C,0x4F,0x57,0x35,
+    0x00,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
+    0x51,0x50,0x46,0x47,0x48,0x49,0x53,0x00
+};
+
+static const uint8_t LEGACY_S3_PG1[32] = {
+    0x28, 0x2A, 0x2C, 0x29, 0x2B, 0x2D, 0x32, 0x33,
+    0x4A, 0x4B, 0x4D, 0x4E, 0x4C, 0x4F, 0x57, 0x35,
+    0x64, 0x65, 0x66, 0x54, 0x30, 0x31, 0x2E, 0x2F,
+    0x51, 0x50, 0x46, 0x47, 0x48, 0x49, 0x53, 0x00
+};
+
+// Igual en los dos
+static const uint8_t LEGACY_PG2[32] = {
+    0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,
+    0x3E,0x3F,0x40,0x41,0x42,0x43,0x44,0x45,
+    0x64,0x65,0x66,0x54,0x30,0x31,0x2E,0x2F,
+    0x4C,0x50,0x46,0x47,0x48,0x49,0x52,0x00
+};
+
+// Teclas que tocaba el bucle viejo para 'note' (bit k = btnState*[k])
+static inline uint32_t legacyKeys(const uint8_t (&notes)[32], uint8_t note) {
+    uint32_t mask = 0;
+    for (int key = 0; key < 32; key++)
+        if (notes[key] != 0x00 && notes[key] == note) mask |= 1u << key;
+    return mask;
+}
+
+// Lo mismo con la tabla: una tecla o ninguna
+static inline uint32_t tableKeys(uint8_t key) {
+    return key == 0xFF ? 0 : 1u << key;        // MCU_NO_KEY
+}
+
+// config.h del S3 en su propia unidad (notes_s3.cpp): mismos nombres
+uint8_t s3KeyOf(uint8_t page, uint8_t note);
+uint8_t s3NoteOf(uint8_t page, uint8_t key);
@@ -0,0 +1,14 @@
+// config.h del S3 extender en su propio namespace: MCU_NOTES es una
+// variable inline y, con el mismo nombre que la del P4, el enlazador
+// se quedaría con una sola
+#include <Arduino.h>
+#include <imakie_midi.h>
+#include <imakie_fixedstr.h>
+
+namespace s3 {
+#define DEVICE_S3_EXTENDER
+#include "../../../S3/iMakie-ESP32_S3_EXTENDER/src/config.h"
+}  // namespace s3
+
+uint8_t s3KeyOf(uint8_t page, uint8_t note) { return s3::MCU_NOTES.keyOf(page, note); }
+uint8_t s3NoteOf(uint8_t page, uint8_t key) { return s3::MCU_NOTES.note[page][key]; }
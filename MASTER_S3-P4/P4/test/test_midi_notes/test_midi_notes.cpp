@@ -0,0 +1,80 @@
+// ============================================================
+//  test_midi_notes.cpp  –  MCU_NOTES (config.h P4 y S3) frente a
+//  los arrays y bucles que sustituye
+//  pio test -e native -f test_midi_notes
+//
+//  processNote(): para cada una de las 128 notas y cada página, la
+//  tecla que da keyOf() es exactamente el conjunto de teclas que
+//  tocaba el bucle sobre MIDI_NOTES_PG1/PG2 (notes_legacy.h).
+//  UIPage1: note[página][tecla] es el byte del array viejo.
+// ============================================================
+#include <unity.h>
+#include <stdio.h>
+
+#pragma GCC diagnostic ignored "-Wunused-variable"     // estado estático de config.h
+#define DEVICE_P4_MASTER
+#include "../../src/config.h"
+#include "notes_legacy.h"
+
+void setUp() {}
+void tearDown() {}
+
+typedef uint8_t (*KeyOf)(uint8_t page, uint8_t note);
+
+static uint8_t p4KeyOf(uint8_t page, uint8_t note) { return MCU_NOTES.keyOf(page, note); }
+
+// Diferencias en las 128 notas de una página (mensaje con la primera)
+static int compareKeys(const char* board, const char* page, uint8_t p,
+                       const uint8_t (&legacy)[32], KeyOf keyOf) {
+    int diffs = 0;
+    for (int n = 0; n < 128; n++) {
+        const uint32_t want = legacyKeys(legacy, n);
+        const uint32_t got  = tableKeys(keyOf(p, n));
+        if (want != got && diffs++ == 0) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "%s %s nota 0x%02X: bucle 0x%08X, tabla 0x%08X",
+                     board, page, n, (unsigned)want, (unsigned)got);
+            TEST_MESSAGE(msg);
+        }
+    }
+    return diffs;
+}
+
+static void test_p4_note_to_key_matches_loops() {
+    TEST_ASSERT_EQUAL_INT(0, compareKeys("P4", "PG1", MCU_PG1, LEGACY_P4_PG1, p4KeyOf));
+    TEST_ASSERT_EQUAL_INT(0, compareKeys("P4", "PG2", MCU_PG2, LEGACY_PG2, p4KeyOf));
+}
+
+static void test_s3_note_to_key_matches_loops() {
+    TEST_ASSERT_EQUAL_INT(0, compareKeys("S3", "PG1", 0, LEGACY_S3_PG1, s3KeyOf));
+    TEST_ASSERT_EQUAL_INT(0, compareKeys("S3", "PG2", 1, LEGACY_PG2, s3KeyOf));
+}
+
+// Dirección tecla → nota (UIPage1 envía note[PG1][idx] si no es 0x00)
+static void test_key_to_note_matches_arrays() {
+    for (uint8_t k = 0; k < 32; k++) {
+        TEST_ASSERT_EQUAL_HEX8(LEGACY_P4_PG1[k], MCU_NOTES.note[MCU_PG1][k]);
+        TEST_ASSERT_EQUAL_HEX8(LEGACY_PG2[k],    MCU_NOTES.note[MCU_PG2][k]);
+        TEST_ASSERT_EQUAL_HEX8(LEGACY_S3_PG1[k], s3NoteOf(0, k));
+        TEST_ASSERT_EQUAL_HEX8(LEGACY_PG2[k],    s3NoteOf(1, k));
+    }
+}
+
+// Nota 0x00 (tecla vacía) y notas fuera de 7 bits: el bucle viejo nunca
+// las casaba; keyOf enmascara a 7 bits
+static void test_unmapped_notes() {
+    TEST_ASSERT_EQUAL_HEX8(MCU_NO_KEY, MCU_NOTES.keyOf(MCU_PG1, 0x00));
+    TEST_ASSERT_EQUAL_HEX8(MCU_NO_KEY, MCU_NOTES.keyOf(MCU_PG2, 0x00));
+    TEST_ASSERT_EQUAL_HEX8(MCU_NO_KEY, s3KeyOf(0, 0x00));
+    for (int n = 0; n < 128; n++)
+        TEST_ASSERT_EQUAL_HEX8(MCU_NOTES.keyOf(MCU_PG1, n), MCU_NOTES.keyOf(MCU_PG1, n | 0x80));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_p4_note_to_key_matches_loops);
+    RUN_TEST(test_s3_note_to_key_matches_loops);
+    RUN_TEST(test_key_to_note_matches_arrays);
+    RUN_TEST(test_unmapped_notes);
+    return UNITY_END();
+}
@@ -0,0 +1,505 @@
+// ============================================================
+//  test_midi_parser.cpp  –  lib/imakie_midi (MidiParser) en host
+//  pio test -e native -f test_midi_parser
+//
+//  Casos límite: running status entre trozos, realtime dentro de
+//  SysEx, EOX justo tras un trozo lleno (callback con n = 0),
+//  CIN que no cuadra con el status.
+//  Fuzz: flujo de bytes contra un modelo de referencia (MIDI 1.0
+//  byte a byte, SysEx entero) y paquetes USB-MIDI aleatorios.
+//  Benchmark: bytes/s con tráfico de una sesión de Logic (MCU) o
+//  con una captura en crudo: IMAKIE_MIDI_CAPTURE=<fichero>.
+// ============================================================
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <imakie_midi.h>
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint8_t CHUNK = 16;      // MIDI_SYSEX_CHUNK (config.h P4/S3)
+typedef MidiParser<CHUNK> Parser;
+
+// ─── Registro de callbacks ────────────────────────────────────
+// msgs: mensajes y SysEx completos en orden (SysEx = trozos unidos);
+// rt: realtime aparte (el parser los entrega antes que el trozo de
+// SysEx que los rodea). Las reglas de los trozos se comprueban al vuelo.
+
+struct Ev {
+    uint8_t kind;                  // 'M' mensaje, 'S' SysEx
+    uint8_t status, d1, d2;        // 'S': status = MIDI_SYSEX_END / MIDI_SYSEX_ABORT
+    std::vector<uint8_t> data;
+    bool operator==(const Ev& o) const {
+        return kind == o.kind && status == o.status && d1 == o.d1 && d2 == o.d2 && data == o.data;
+    }
+};
+
+struct Log {
+    std::vector<Ev>      msgs;
+    std::vector<uint8_t> rt;
+    std::vector<uint8_t> chunkLens, chunkFlags;   // trozos tal cual
+    std::vector<uint8_t> sx;                       // SysEx en curso
+    bool     inSx  = false;
+    uint32_t fails = 0;                            // trozos que rompen las reglas
+
+    static void onMsg(void* ctx, uint8_t status, uint8_t d1, uint8_t d2) {
+        Log& l = *(Log*)ctx;
+        const uint8_t e = MIDI_STATUS_TABLE.t[status & 0x7F];
+        const uint8_t k = e & MIDI_KIND_MASK;
+        if (status < 0x80 || (k != MIDI_KIND_CHANNEL && k != MIDI_KIND_COMMON) ||
+            d1 > 0x7F || d2 > 0x7F || ((e & MIDI_LEN_MASK) < 2 && d2) ||
+            ((e & MIDI_LEN_MASK) < 1 && d1))
+            l.fails++;
+        l.msgs.push_back(Ev{'M', status, d1, d2, {}});
+    }
+
+    static void onSysEx(void* ctx, const uint8_t* data, uint8_t n, uint8_t flags) {
+        Log& l = *(Log*)ctx;
+        const bool last = flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT);
+        if (n > CHUNK)                                   l.fails++;
+        if ((flags & MIDI_SYSEX_START) == l.inSx)        l.fails++;   // START solo al empezar
+        if (!last && n != CHUNK)                         l.fails++;   // intermedios llenos
+        if ((flags & MIDI_SYSEX_END) && (flags & MIDI_SYSEX_ABORT)) l.fails++;
+        for (uint8_t i = 0; i < n; i++) if (data[i] > 0x7F) l.fails++;
+        l.chunkLens.push_back(n);
+        l.chunkFlags.push_back(flags);
+        l.sx.insert(l.sx.end(), data, data + n);
+        l.inSx = !last;
+        if (!last) return;
+        l.msgs.push_back(Ev{'S', (uint8_t)(flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT)), 0, 0, l.sx});
+        l.sx.clear();
+    }
+
+    static void onRt(void* ctx, uint8_t status) {
+        Log& l = *(Log*)ctx;
+        if (status < 0xF8) l.fails++;
+        l.rt.push_back(status);
+    }
+};
+
+struct Harness {
+    Log    log;
+    Parser p{Log::onMsg, Log::onSysEx, Log::onRt, &log};
+};
+
+// ─── Modelo de referencia: MIDI 1.0 byte a byte ───────────────
+// Independiente de MIDI_STATUS_TABLE; SysEx en un vector sin límite
+
+static int refDataLen(uint8_t s) {
+    if (s < 0xF0) return ((s & 0xF0) == 0xC0 || (s & 0xF0) == 0xD0) ? 1 : 2;
+    if (s == 0xF2) return 2;
+    if (s == 0xF1 || s == 0xF3) return 1;
+    return 0;
+}
+
+struct RefParser {
+    std::vector<Ev>      msgs;
+    std::vector<uint8_t> rt, sx;
+    bool    inSx = false, running = false;
+    uint8_t status = 0, got = 0, data[2] = {};
+    uint32_t stray = 0;
+
+    void endSx(uint8_t how) { msgs.push_back(Ev{'S', how, 0, 0, sx}); sx.clear(); inSx = false; }
+
+    void push(uint8_t b) {
+        if (b >= 0xF8) { rt.push_back(b); return; }
+        if (b == 0xF0) { if (inSx) endSx(MIDI_SYSEX_ABORT); inSx = true; status = 0; return; }
+        if (b == 0xF7) { if (inSx) endSx(MIDI_SYSEX_END); status = 0; return; }
+        if (b >= 0x80) {
+            if (inSx) endSx(MIDI_SYSEX_ABORT);
+            running = b < 0xF0;
+            got = 0;
+            if (refDataLen(b)) { status = b; return; }
+            status = 0;
+            msgs.push_back(Ev{'M', b, 0, 0, {}});
+            return;
+        }
+        if (inSx)   { sx.push_back(b); return; }
+        if (!status) { stray++; return; }
+        data[got++] = b;
+        if (got < refDataLen(status)) return;
+        got = 0;
+        msgs.push_back(Ev{'M', status, data[0], (uint8_t)(refDataLen(status) > 1 ? data[1] : 0), {}});
+        if (!running) status = 0;
+    }
+};
+
+static void assertSameEvents(const std::vector<Ev>& want, const std::vector<Ev>& got, const char* what) {
+    char msg[128];
+    if (want.size() != got.size()) {
+        snprintf(msg, sizeof(msg), "%s: %u eventos, esperados %u", what,
+                 (unsigned)got.size(), (unsigned)want.size());
+        TEST_FAIL_MESSAGE(msg);
+    }
+    for (size_t i = 0; i < want.size(); i++) {
+        if (want[i] == got[i]) continue;
+        snprintf(msg, sizeof(msg), "%s: evento %u difiere (%c %02X %02X %02X / %c %02X %02X %02X)", what,
+                 (unsigned)i, want[i].kind, want[i].status, want[i].d1, want[i].d2,
+                 got[i].kind, got[i].status, got[i].d1, got[i].d2);
+        TEST_FAIL_MESSAGE(msg);
+    }
+}
+
+// ─── Sesión MCU: flujo de bytes y los mismos mensajes en USB-MIDI ──
+
+struct Session {
+    std::vector<uint8_t> bytes;     // con running status, como un puerto DIN
+    std::vector<uint8_t> packets;   // 4 bytes por paquete, sin running status
+    uint8_t last = 0;               // status de canal vigente en bytes
+
+    void packet(uint8_t cin, uint8_t a, uint8_t b = 0, uint8_t c = 0) {
+        packets.push_back(cin);
+        packets.push_back(a);
+        packets.push_back(b);
+        packets.push_back(c);
+    }
+
+    void msg(uint8_t status, uint8_t d1, uint8_t d2 = 0) {
+        const int n = refDataLen(status);
+        if (status != last || status >= 0xF0) bytes.push_back(status);
+        bytes.push_back(d1);
+        if (n > 1) bytes.push_back(d2);
+        last = status < 0xF0 ? status : 0;
+        if (status < 0xF0) packet(status >> 4, status, d1, n > 1 ? d2 : 0);
+        else               packet(n == 2 ? MIDI_CIN_COMMON_3 : MIDI_CIN_COMMON_2, status, d1, n > 1 ? d2 : 0);
+    }
+
+    void realtime(uint8_t s) {
+        bytes.push_back(s);
+        packet(MIDI_CIN_BYTE, s);
+    }
+
+    // SysEx completo (F0 ... F7); rtAt ≥ 0: un F8 tras ese byte de datos
+    void sysex(const std::vector<uint8_t>& body, int rtAt = -1) {
+        std::vector<uint8_t> all;
+        all.push_back(0xF0);
+        all.insert(all.end(), body.begin(), body.end());
+        all.push_back(0xF7);
+        for (size_t i = 0; i < all.size(); i++) {
+            bytes.push_back(all[i]);
+            if (rtAt >= 0 && (int)i == rtAt + 1) bytes.push_back(0xF8);
+        }
+        last = 0;
+        for (size_t i = 0; i < all.size(); i += 3) {
+            const size_t n = all.size() - i < 3 ? all.size() - i : 3;
+            const uint8_t cin = i + 3 >= all.size() ? (uint8_t)(MIDI_CIN_SYSEX + n) : (uint8_t)MIDI_CIN_SYSEX;
+            packet(cin, all[i], n > 1 ? all[i + 1] : 0, n > 2 ? all[i + 2] : 0);
+            if (rtAt >= 0 && (size_t)rtAt + 1 >= i && (size_t)rtAt + 1 < i + 3) packet(MIDI_CIN_BYTE, 0xF8);
+        }
+    }
+};
+
+static std::vector<uint8_t> lcdWrite(uint8_t offset, const char* text) {
+    std::vector<uint8_t> v = {0x00, 0x00, 0x66, 0x14, 0x12, offset};
+    while (*text) v.push_back((uint8_t)*text++ & 0x7F);
+    return v;
+}
+
+// Reproducción típica: meters (D0, running status), timecode (B0 40-49),
+// LEDs (90), faders en automatización (E0-E7), LCD por celdas y por filas
+// enteras (barrido de parámetro), MIDI clock
+static Session logicSession(int frames) {
+    static const char* names[] = {"Kick   ", "Snare  ", "OH L   ", "Bass   ",
+                                  "GUITAR ", "Keys   ", "Vox    ", "FX Bus "};
+    Session s;
+    for (int f = 0; f < frames; f++) {
+        for (uint8_t strip = 0; strip < 8; strip++)
+            s.msg(0xD0, (uint8_t)(strip << 4 | ((f + strip * 3) % 14)));
+        for (uint8_t d = 0; d < 10; d++)
+            s.msg(0xB0, 0x40 + d, 0x30 + ((f / (d + 1)) % 10));
+        if (f % 2 == 0)
+            for (uint8_t ch = 0; ch < 8; ch++) {
+                const uint16_t v = (uint16_t)((f * 37 + ch * 911) & 0x3FFF);
+                s.msg(0xE0 | ch, v & 0x7F, v >> 7);
+            }
+        if (f % 6 == 0) s.msg(0x90, 0x5E, (f / 6) & 1 ? 0x7F : 0x00);   // PLAY
+        if (f % 4 == 0) s.realtime(0xF8);
+        if (f % 25 == 0) s.sysex(lcdWrite((uint8_t)((f / 25 % 8) * 7), names[f / 25 % 8]));
+        if (f % 50 == 0) {
+            char row[57];
+            for (int i = 0; i < 56; i++) row[i] = "  -12.4 "[i % 8];
+            row[56] = '\0';
+            s.sysex(lcdWrite(0x38, row), f % 100 == 0 ? 20 : -1);
+        }
+        if (f % 100 == 0) s.sysex({0x00, 0x00, 0x66, 0x14, 0x72, 0x01, 0x02, 0x03});
+    }
+    return s;
+}
+
+static void pushPackets(Parser& p, const std::vector<uint8_t>& pk) {
+    for (size_t i = 0; i + 4 <= pk.size(); i += 4) p.pushPacket(&pk[i]);
+}
+
+// ─── Casos límite ─────────────────────────────────────────────
+
+// El status de canal sigue vigente entre llamadas a push(); system
+// common lo anula y los datos sueltos cuentan como stray
+static void test_running_status_across_chunks() {
+    const uint8_t stream[] = {0x90, 0x3C, 0x7F, 0x3D, 0x7F, 0x3E, 0x40,
+                              0xF3, 0x05, 0x3F, 0x10,
+                              0xD0, 0x12, 0x34};
+    for (size_t cut = 1; cut < sizeof(stream); cut++) {
+        Harness h;
+        h.p.push(stream, cut);
+        h.p.push(stream + cut, sizeof(stream) - cut);
+        TEST_ASSERT_EQUAL(6, h.log.msgs.size());
+        TEST_ASSERT_EQUAL_UINT8(0x90, h.log.msgs[2].status);
+        TEST_ASSERT_EQUAL_UINT8(0x3E, h.log.msgs[2].d1);
+        TEST_ASSERT_EQUAL_UINT8(0x40, h.log.msgs[2].d2);
+        TEST_ASSERT_EQUAL_UINT8(0xF3, h.log.msgs[3].status);
+        TEST_ASSERT_EQUAL_UINT8(0x34, h.log.msgs[5].d1);
+        TEST_ASSERT_EQUAL_UINT32(2, h.p.strayBytes());
+        TEST_ASSERT_EQUAL_UINT32(0, h.log.fails);
+    }
+}
+
+// Realtime en cualquier punto de un SysEx: callback inmediato, el SysEx
+// sigue entero; igual por paquetes (CIN 0xF entre CIN 0x4)
+static void test_realtime_inside_sysex() {
+    const std::vector<uint8_t> body = lcdWrite(0x00, "GUITAR Bass   Keys   ");
+    for (int at = 0; at < (int)body.size(); at++) {
+        Session s;
+        s.sysex(body, at);
+        Harness hb, hp;
+        hb.p.push(s.bytes.data(), s.bytes.size());
+        pushPackets(hp.p, s.packets);
+        for (Harness* h : {&hb, &hp}) {
+            TEST_ASSERT_EQUAL(1, h->log.msgs.size());
+            TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_END, h->log.msgs[0].status);
+            TEST_ASSERT_TRUE(h->log.msgs[0].data == body);
+            TEST_ASSERT_EQUAL(1, h->log.rt.size());
+            TEST_ASSERT_EQUAL_UINT8(0xF8, h->log.rt[0]);
+            TEST_ASSERT_EQUAL_UINT32(0, h->log.fails);
+        }
+    }
+}
+
+// SysEx de CHUNK y 2·CHUNK bytes: F7 llega con el buffer recién vaciado
+// → último callback con n = 0 y MIDI_SYSEX_END (el consumidor lo acepta)
+static void test_eox_right_after_full_chunk() {
+    for (int chunks = 1; chunks <= 2; chunks++) {
+        std::vector<uint8_t> body;
+        for (int i = 0; i < chunks * CHUNK; i++) body.push_back((uint8_t)i);
+        Session s;
+        s.sysex(body);
+        Harness hb, hp;
+        hb.p.push(s.bytes.data(), s.bytes.size());
+        pushPackets(hp.p, s.packets);
+        for (Harness* h : {&hb, &hp}) {
+            TEST_ASSERT_EQUAL(chunks + 1, h->log.chunkLens.size());
+            TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_START, h->log.chunkFlags[0]);
+            TEST_ASSERT_EQUAL_UINT8(CHUNK, h->log.chunkLens[chunks - 1]);
+            TEST_ASSERT_EQUAL_UINT8(0, h->log.chunkLens[chunks]);
+            TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_END, h->log.chunkFlags[chunks]);
+            TEST_ASSERT_TRUE(h->log.msgs[0].data == body);
+            TEST_ASSERT_EQUAL_UINT32(0, h->log.fails);
+        }
+    }
+    // Sin SysEx abierto, F7 no genera callback
+    Harness h;
+    const uint8_t eox[] = {0xF7, 0xF7};
+    h.p.push(eox, sizeof(eox));
+    TEST_ASSERT_EQUAL(0, h.log.chunkLens.size());
+}
+
+// CIN y status (o datos) incoherentes: paquete descartado y contado,
+// sin tocar un SysEx en curso
+static void test_cin_status_mismatch() {
+    static const uint8_t bad[][4] = {
+        {0x09, 0x80, 0x3C, 0x00},   // CIN note on, status note off
+        {0x0E, 0x90, 0x3C, 0x7F},   // CIN pitch bend, status note on
+        {0x09, 0x3C, 0x7F, 0x00},   // CIN canal, byte de datos como status
+        {0x09, 0x90, 0xBC, 0x7F},   // dato con bit 7
+        {0x0C, 0xC0, 0x85, 0x00},   // program change, dato con bit 7
+        {0x02, 0xF2, 0x01, 0x02},   // CIN 2 con song position (3 bytes)
+        {0x03, 0xF1, 0x01, 0x02},   // CIN 3 con MTC (2 bytes)
+        {0x02, 0xF0, 0x00, 0x00},   // CIN common con SysEx start
+        {0x02, 0xF7, 0x00, 0x00},   // CIN common con EOX
+        {0x03, 0xF8, 0x00, 0x00},   // CIN common con realtime
+        {0x02, 0xF6, 0x00, 0x00},   // tune request va por CIN 5
+        {0x02, 0x40, 0x00, 0x00},   // CIN common sin status
+    };
+    Harness h;
+    const uint8_t open[4] = {MIDI_CIN_SYSEX, 0xF0, 0x00, 0x00};
+    h.p.pushPacket(open);
+    for (const auto& pk : bad) h.p.pushPacket(pk);
+    TEST_ASSERT_EQUAL(0, h.log.msgs.size());
+    TEST_ASSERT_EQUAL_UINT32(sizeof(bad) / sizeof(bad[0]), h.p.strayBytes());
+
+    const uint8_t close[4] = {MIDI_CIN_SYSEX_END2, 0x66, 0xF7, 0x00};
+    h.p.pushPacket(close);
+    TEST_ASSERT_EQUAL(1, h.log.msgs.size());
+    TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_END, h.log.msgs[0].status);
+    TEST_ASSERT_EQUAL(3, h.log.msgs[0].data.size());
+
+    // Los válidos equivalentes sí pasan (F6 por CIN 5 = common de 1 byte)
+    static const uint8_t good[][4] = {
+        {0x08, 0x80, 0x3C, 0x00}, {0x0C, 0xC0, 0x05, 0x00}, {0x02, 0xF1, 0x01, 0x00},
+        {0x03, 0xF2, 0x01, 0x02}, {0x05, 0xF6, 0x00, 0x00},
+    };
+    for (const auto& pk : good) h.p.pushPacket(pk);
+    TEST_ASSERT_EQUAL(6, h.log.msgs.size());
+    TEST_ASSERT_EQUAL_UINT8(0xF6, h.log.msgs[5].status);
+    TEST_ASSERT_EQUAL_UINT32(0, h.log.fails);
+}
+
+// Otro status dentro de un SysEx lo cierra con ABORT y se procesa
+static void test_status_aborts_sysex() {
+    const uint8_t stream[] = {0xF0, 0x00, 0x00, 0x66, 0x90, 0x3C, 0x7F, 0xF0, 0x01, 0xF0, 0x02, 0xF7};
+    Harness h;
+    h.p.push(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL(4, h.log.msgs.size());
+    TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_ABORT, h.log.msgs[0].status);
+    TEST_ASSERT_EQUAL('M', h.log.msgs[1].kind);
+    TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_ABORT, h.log.msgs[2].status);
+    TEST_ASSERT_EQUAL_UINT8(MIDI_SYSEX_END, h.log.msgs[3].status);
+    TEST_ASSERT_EQUAL_UINT32(0, h.log.fails);
+}
+
+// ─── Fuzz ─────────────────────────────────────────────────────
+
+// Bytes al azar con peso hacia lo que rompe estados: status de canal,
+// common, F0/F7 y realtime entre datos. Trozos de push() al azar.
+static uint8_t fuzzByte() {
+    const int r = rand() % 100;
+    if (r < 55) return rand() & 0x7F;
+    if (r < 75) return 0x80 | (rand() & 0x6F);          // canal 0x80-0xEF
+    if (r < 82) return 0xF1 + rand() % 6;               // common F1-F6
+    if (r < 88) return 0xF0;
+    if (r < 93) return 0xF7;
+    return 0xF8 + rand() % 8;                           // realtime, incluidos F9/FD
+}
+
+static void test_fuzz_bytes_vs_reference() {
+    static constexpr int RUNS = 400, LEN = 3000;
+    for (int run = 1; run <= RUNS; run++) {
+        srand(run);
+        std::vector<uint8_t> in(LEN);
+        for (auto& b : in) b = fuzzByte();
+        // SysEx largos de vez en cuando: varios trozos seguidos
+        if (run % 4 == 0) in.insert(in.begin() + rand() % LEN, 200, 0x41);
+
+        Harness h;
+        RefParser ref;
+        for (size_t i = 0; i < in.size();) {
+            size_t n = 1 + rand() % 40;
+            if (n > in.size() - i) n = in.size() - i;
+            h.p.push(&in[i], n);
+            i += n;
+        }
+        for (uint8_t b : in) ref.push(b);
+        const uint8_t eox = 0xF7;                        // cierra lo que quede abierto
+        h.p.push(eox);
+        ref.push(eox);
+
+        char what[32];
+        snprintf(what, sizeof(what), "run %d", run);
+        assertSameEvents(ref.msgs, h.log.msgs, what);
+        TEST_ASSERT_TRUE_MESSAGE(ref.rt == h.log.rt, what);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(ref.stray, h.p.strayBytes(), what);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, h.log.fails, what);
+    }
+}
+
+// Paquetes completamente aleatorios: nada fuera de rango llega a los
+// callbacks y los trozos de SysEx siguen las reglas
+static void test_fuzz_random_packets() {
+    srand(0x1D1);
+    Harness h;
+    for (int i = 0; i < 300000; i++) {
+        uint8_t pk[4];
+        for (auto& b : pk) b = rand() & 0xFF;
+        if (i % 3 == 0) pk[0] = MIDI_CIN_SYSEX + rand() % 4;   // más SysEx
+        h.p.pushPacket(pk);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, h.log.fails);
+    TEST_ASSERT_GREATER_THAN(0, h.log.msgs.size());
+}
+
+// La misma sesión por paquetes (sin running status) y por bytes (con
+// running status) da los mismos eventos que el modelo de referencia
+static void test_session_packets_match_bytes() {
+    Session s = logicSession(400);
+    Harness hb, hp;
+    RefParser ref;
+    hb.p.push(s.bytes.data(), s.bytes.size());
+    pushPackets(hp.p, s.packets);
+    for (uint8_t b : s.bytes) ref.push(b);
+    assertSameEvents(ref.msgs, hb.log.msgs, "bytes");
+    assertSameEvents(ref.msgs, hp.log.msgs, "paquetes");
+    TEST_ASSERT_TRUE(ref.rt == hb.log.rt);
+    TEST_ASSERT_TRUE(ref.rt == hp.log.rt);
+    TEST_ASSERT_EQUAL_UINT32(0, hb.p.strayBytes() + hp.p.strayBytes());
+}
+
+// ─── Benchmark ────────────────────────────────────────────────
+// Callbacks mínimos (como un consumidor que solo copia): mide el parser
+
+static uint32_t sink;
+static void benchMsg(void*, uint8_t s, uint8_t a, uint8_t b) { sink += s + a + b; }
+static void benchSx(void*, const uint8_t* d, uint8_t n, uint8_t f) { sink += n + f + (n ? d[0] : 0); }
+static void benchRt(void*, uint8_t s) { sink += s; }
+
+template <typename Fn>
+static double bytesPerSecond(size_t bytes, Fn run) {
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    int reps = 0;
+    double secs = 0;
+    do {                                                 // ≥ 0.2 s por medida
+        run();
+        reps++;
+        secs = std::chrono::duration<double>(clock::now() - t0).count();
+    } while (secs < 0.2);
+    return (double)bytes * reps / secs;
+}
+
+static void report(const char* what, size_t bytes, double bps) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: %u B/pasada, %.1f MB/s (%.0fx USB full-speed MIDI)",
+             what, (unsigned)bytes, bps / 1e6, bps * 8 / 12e6);
+    TEST_MESSAGE(msg);
+}
+
+static void test_benchmark_logic_session() {
+    Session s = logicSession(2000);
+    Parser p(benchMsg, benchSx, benchRt);
+
+    const double bytesBps = bytesPerSecond(s.bytes.size(), [&] { p.push(s.bytes.data(), s.bytes.size()); });
+    report("push() sesión Logic", s.bytes.size(), bytesBps);
+    // Paquetes: se cuentan los bytes MIDI que llevan (el flujo equivalente)
+    const double pktBps = bytesPerSecond(s.bytes.size(), [&] { pushPackets(p, s.packets); });
+    report("pushPacket() sesión Logic", s.bytes.size(), pktBps);
+
+    // Un DIN a 31250 baud son 3125 B/s: cualquier cifra por debajo de
+    // 1 MB/s en host indicaría un problema serio en el parser
+    TEST_ASSERT_TRUE(bytesBps > 1e6);
+    TEST_ASSERT_TRUE(pktBps > 1e6);
+
+    const char* path = getenv("IMAKIE_MIDI_CAPTURE");   // flujo en crudo (p. ej. volcado de MIDI Monitor)
+    if (!path) return;
+    FILE* f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+    std::vector<uint8_t> cap;
+    for (int c; (c = fgetc(f)) != EOF;) cap.push_back((uint8_t)c);
+    fclose(f);
+    TEST_ASSERT_TRUE(cap.size() > 0);
+    report(path, cap.size(), bytesPerSecond(cap.size(), [&] { p.push(cap.data(), cap.size()); }));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_running_status_across_chunks);
+    RUN_TEST(test_realtime_inside_sysex);
+    RUN_TEST(test_eox_right_after_full_chunk);
+    RUN_TEST(test_cin_status_mismatch);
+    RUN_TEST(test_status_aborts_sysex);
+    RUN_TEST(test_fuzz_bytes_vs_reference);
+    RUN_TEST(test_fuzz_random_packets);
+    RUN_TEST(test_session_packets_match_bytes);
+    RUN_TEST(test_benchmark_logic_session);
+    return UNITY_END();
+}
@@ -0,0 +1,279 @@
+// ============================================================
+//  test_midi_tx.cpp  –  lib/imakie_midi (MidiTxQueue) en host
+//  pio test -e native -f test_midi_tx
+//
+//  Orden: un PB solo se fusiona con el anterior del mismo canal
+//  si nada del canal (ni un paquete sin canal) va entre medias.
+//  SysEx: entero y seguido, también más largo que la cola.
+//  Ráfaga: un hilo por canal (fader ride + notas de touch), uno
+//  con SysEx y el consumidor vaciando cada "frame": paquetes
+//  emitidos frente a recibidos, flujo por canal intacto salvo PB
+//  superados, último PB de cada canal siempre entregado.
+// ============================================================
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <imakie_miditx.h>
+
+void setUp() {}
+void tearDown() {}
+
+struct Pkt {
+    uint8_t header, byte1, byte2, byte3;
+    bool operator==(const Pkt& o) const {
+        return header == o.header && byte1 == o.byte1 && byte2 == o.byte2 && byte3 == o.byte3;
+    }
+};
+
+static constexpr uint16_t LEN = 128;                  // MIDI_TX_QUEUE_LEN (config.h P4/S3)
+typedef MidiTxQueue<Pkt, LEN, std::mutex> Queue;
+
+static Pkt pb(uint8_t ch, uint16_t v)  { return Pkt{ 0x0E, (uint8_t)(0xE0 | ch), (uint8_t)(v & 0x7F), (uint8_t)(v >> 7) }; }
+static Pkt note(uint8_t ch, uint8_t n) { return Pkt{ 0x09, (uint8_t)(0x90 | ch), n, 0x7F }; }
+
+struct Usb {
+    std::vector<Pkt> out;
+    void operator()(const Pkt& p) { out.push_back(p); }
+};
+
+static std::vector<uint8_t> sysex(size_t len, uint8_t seed) {
+    std::vector<uint8_t> s(len);
+    s[0] = 0xF0;
+    for (size_t i = 1; i + 1 < len; i++) s[i] = (uint8_t)((i * 7 + seed) & 0x7F);
+    s[len - 1] = 0xF7;
+    return s;
+}
+
+// Bytes de los paquetes SysEx (CIN 0x4-0x7) a partir de out[from]
+static std::vector<uint8_t> unpackSysEx(const std::vector<Pkt>& out, size_t from, size_t& end) {
+    std::vector<uint8_t> b;
+    for (end = from; end < out.size(); end++) {
+        const uint8_t cin = out[end].header & 0x0F;
+        if (cin < MIDI_CIN_SYSEX || cin > MIDI_CIN_SYSEX_END3) break;
+        const uint8_t n = cin == MIDI_CIN_SYSEX ? 3 : cin - MIDI_CIN_SYSEX;
+        const uint8_t* p = &out[end].byte1;
+        b.insert(b.end(), p, p + n);
+        if (cin != MIDI_CIN_SYSEX) { end++; break; }
+    }
+    return b;
+}
+
+// ─── Orden ────────────────────────────────────────────────────
+
+static void test_pitchbend_coalesced_only_when_last_of_channel() {
+    Queue q;
+    Usb   usb;
+
+    q.push(pb(0, 100));
+    q.push(pb(0, 200));                              // superado → en su sitio
+    q.flush(usb);
+    TEST_ASSERT_EQUAL_UINT32(1, usb.out.size());
+    TEST_ASSERT_TRUE(usb.out[0] == pb(0, 200));
+
+    usb.out.clear();
+    q.push(pb(0, 100));
+    q.push(note(0, 0x68));                           // touch del mismo canal
+    q.push(pb(0, 300));
+    q.flush(usb);
+    TEST_ASSERT_EQUAL_UINT32(3, usb.out.size());
+    TEST_ASSERT_TRUE(usb.out[0] == pb(0, 100));
+    TEST_ASSERT_TRUE(usb.out[1] == note(0, 0x68));
+    TEST_ASSERT_TRUE(usb.out[2] == pb(0, 300));
+
+    usb.out.clear();
+    q.push(pb(0, 100));
+    q.push(pb(1, 500));                              // otro canal: no cierra la ventana
+    q.push(pb(0, 400));
+    q.flush(usb);
+    TEST_ASSERT_EQUAL_UINT32(2, usb.out.size());
+    TEST_ASSERT_TRUE(usb.out[0] == pb(0, 400));
+    TEST_ASSERT_TRUE(usb.out[1] == pb(1, 500));
+
+    usb.out.clear();
+    const std::vector<uint8_t> sx = sysex(8, 1);
+    q.push(pb(0, 100));
+    TEST_ASSERT_TRUE(q.pushSysEx(sx.data(), sx.size(), false, usb));   // sin canal: barrera
+    q.push(pb(0, 500));
+    q.flush(usb);
+    TEST_ASSERT_EQUAL_UINT32(1 + midiSysExPackets(sx.size()) + 1, usb.out.size());
+    TEST_ASSERT_TRUE(usb.out.back() == pb(0, 500));
+
+    // La ventana no pasa de un flush al siguiente
+    usb.out.clear();
+    q.push(pb(2, 1));
+    q.flush(usb);
+    q.push(pb(2, 2));
+    q.flush(usb);
+    TEST_ASSERT_EQUAL_UINT32(2, usb.out.size());
+    TEST_ASSERT_EQUAL_UINT32(2, q.stats().coalesced);
+}
+
+// ─── SysEx ────────────────────────────────────────────────────
+
+static void test_sysex_packing_all_lengths() {
+    for (size_t len = 2; len <= 40; len++) {
+        Queue q;
+        Usb   usb;
+        const std::vector<uint8_t> sx = sysex(len, (uint8_t)len);
+        TEST_ASSERT_TRUE(q.pushSysEx(sx.data(), sx.size(), false, usb));
+        q.flush(usb);
+        size_t end;
+        TEST_ASSERT_EQUAL_UINT32(midiSysExPackets(len), usb.out.size());
+        TEST_ASSERT_TRUE(unpackSysEx(usb.out, 0, end) == sx);
+        TEST_ASSERT_EQUAL_UINT32(usb.out.size(), end);
+    }
+}
+
+// Más largo que la cola: el consumidor vacía lo pendiente y lo escribe
+// directo detrás; otro task no encola nada y reintenta
+static void test_sysex_longer_than_queue_never_truncated() {
+    Queue q;
+    Usb   usb;
+    const std::vector<uint8_t> sx = sysex(1000, 3);    // 334 paquetes > LEN
+    q.push(note(0, 1));
+    q.push(pb(0, 77));
+
+    TEST_ASSERT_FALSE(q.pushSysEx(sx.data(), sx.size(), false, usb));
+    TEST_ASSERT_EQUAL_UINT32(0, usb.out.size());
+
+    TEST_ASSERT_TRUE(q.pushSysEx(sx.data(), sx.size(), true, usb));
+    q.push(pb(0, 78));                                 // después del SysEx, no fusionado con el 77
+    q.flush(usb);
+    size_t end;
+    TEST_ASSERT_EQUAL_UINT32(2 + midiSysExPackets(sx.size()) + 1, usb.out.size());
+    TEST_ASSERT_TRUE(usb.out[0] == note(0, 1));
+    TEST_ASSERT_TRUE(usb.out[1] == pb(0, 77));
+    TEST_ASSERT_TRUE(unpackSysEx(usb.out, 2, end) == sx);
+    TEST_ASSERT_TRUE(usb.out[end] == pb(0, 78));
+    TEST_ASSERT_EQUAL_UINT32(midiSysExPackets(sx.size()), q.stats().direct);
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().dropped);
+}
+
+// Cola casi llena: un SysEx corto no entra a medias
+static void test_sysex_all_or_nothing_when_nearly_full() {
+    Queue q;
+    Usb   usb;
+    for (uint16_t i = 0; i < LEN - 2; i++) q.push(note(i % 16, i & 0x7F));
+    const std::vector<uint8_t> sx = sysex(20, 5);
+    TEST_ASSERT_FALSE(q.pushSysEx(sx.data(), sx.size(), false, usb));
+    TEST_ASSERT_EQUAL_UINT32(LEN - 2, q.flush(usb));
+    usb.out.clear();
+    TEST_ASSERT_TRUE(q.pushSysEx(sx.data(), sx.size(), false, usb));   // reintento tras el flush
+    q.flush(usb);
+    size_t end;
+    TEST_ASSERT_TRUE(unpackSysEx(usb.out, 0, end) == sx);
+}
+
+// ─── Ráfaga ───────────────────────────────────────────────────
+
+static void test_burst_packets_emitted_vs_received() {
+    static constexpr int      CHANNELS = 8;
+    static constexpr int      RIDE     = 4000;    // PB por canal
+    static constexpr int      SYSEX    = 200;
+    Queue q;
+    Usb   usb;
+    std::vector<Pkt>          sent[CHANNELS];
+    std::atomic<int>          running{CHANNELS + 1};
+    std::atomic<uint32_t>     sysexRetries{0}, fullRetries{0};
+
+    std::vector<std::thread> producers;
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        producers.emplace_back([&, ch]() {
+            for (int i = 0; i < RIDE; i++) {
+                if (i % 500 == 0) {                    // touch on/off entre tramos del ride
+                    const Pkt t = note(ch, 0x68 + ch);
+                    sent[ch].push_back(t);
+                    while (!q.push(t)) fullRetries++;
+                }
+                const Pkt p = pb(ch, (uint16_t)(i * 3 + ch));
+                sent[ch].push_back(p);
+                while (!q.push(p)) fullRetries++;
+                if (i % 16 == 0) std::this_thread::yield();
+            }
+            running--;
+        });
+    }
+    producers.emplace_back([&]() {
+        for (int i = 0; i < SYSEX; i++) {
+            const std::vector<uint8_t> sx = sysex(12 + (i % 5) * 11, (uint8_t)i);
+            while (!q.pushSysEx(sx.data(), sx.size(), false, usb)) {
+                sysexRetries++;
+                std::this_thread::yield();
+            }
+        }
+        running--;
+    });
+
+    uint32_t frames = 0;
+    while (running > 0) {
+        q.flush(usb);
+        frames++;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    for (auto& t : producers) t.join();
+    q.flush(usb);
+
+    // Reparto por canal y SysEx enteros, nunca intercalados
+    std::vector<Pkt> got[CHANNELS];
+    uint32_t sysexOk = 0, sysexBad = 0;
+    for (size_t i = 0; i < usb.out.size();) {
+        const uint8_t cin = usb.out[i].header & 0x0F;
+        if (cin >= MIDI_CIN_SYSEX && cin <= MIDI_CIN_SYSEX_END3) {
+            size_t end;
+            const std::vector<uint8_t> b = unpackSysEx(usb.out, i, end);
+            if (b.size() >= 2 && b.front() == 0xF0 && b.back() == 0xF7) sysexOk++;
+            else sysexBad++;
+            i = end;
+            continue;
+        }
+        got[usb.out[i].byte1 & 0x0F].push_back(usb.out[i]);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(SYSEX, sysexOk);
+    TEST_ASSERT_EQUAL_UINT32(0, sysexBad);
+
+    // Lo recibido = lo enviado menos PB seguidos de otro PB del canal
+    uint32_t pushed = 0, received = 0;
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        const std::vector<Pkt>& s = sent[ch];
+        const std::vector<Pkt>& g = got[ch];
+        size_t k = 0;
+        for (size_t i = 0; i < s.size() && k < g.size(); i++) {
+            if (s[i] == g[k]) { k++; continue; }
+            char msg[64];
+            snprintf(msg, sizeof(msg), "canal %d, paquete %u", ch, (unsigned)i);
+            TEST_ASSERT_TRUE_MESSAGE((s[i].header & 0x0F) == MIDI_CIN_PITCHBEND, msg);
+            TEST_ASSERT_TRUE_MESSAGE(i + 1 < s.size() && (s[i + 1].header & 0x0F) == MIDI_CIN_PITCHBEND, msg);
+        }
+        TEST_ASSERT_EQUAL_UINT32(g.size(), k);
+        TEST_ASSERT_TRUE(g.back() == s.back());
+        pushed   += s.size();
+        received += g.size();
+    }
+
+    const uint32_t sxPkts = usb.out.size() - received;
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%u frames: canal %u enviados → %u recibidos (%.0f %% fusionados), SysEx %u paquetes, "
+             "%u reintentos; paquetes USB %u (%.1f/frame)",
+             (unsigned)frames, (unsigned)pushed, (unsigned)received, 100.0 * (pushed - received) / pushed,
+             (unsigned)sxPkts, (unsigned)sysexRetries.load(), (unsigned)usb.out.size(),
+             (double)usb.out.size() / frames);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(q.stats().sent, usb.out.size());
+    TEST_ASSERT_EQUAL_UINT32(pushed - received, q.stats().coalesced);
+    TEST_ASSERT_EQUAL_UINT32(fullRetries.load(), q.stats().dropped);   // cola llena: rechazado y repetido
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pitchbend_coalesced_only_when_last_of_channel);
+    RUN_TEST(test_sysex_packing_all_lengths);
+    RUN_TEST(test_sysex_longer_than_queue_never_truncated);
+    RUN_TEST(test_sysex_all_or_nothing_when_nearly_full);
+    RUN_TEST(test_burst_packets_emitted_vs_received);
+    return UNITY_END();
+}
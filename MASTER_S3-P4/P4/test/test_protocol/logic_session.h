@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include <imakie_protocol.h>
+
+// ============================================================
+//  logic_session.h  –  sesión de referencia para el benchmark de
+//  bytes en el cable (test_protocol)
+//
+//  12 s de Logic con 9 canales MCU, como lo ve RS485Master tras
+//  MIDIProcessor: solo los set*() que marcan dirty (nombre,
+//  flags, V-Pot). Fader y VU viajan en cada paquete sea cual sea
+//  su valor, así que su tráfico no cambia el tamaño del delta.
+//  Orden: carga del proyecto, play, pan con el encoder, mute /
+//  solo / select, renombrar pista, cambio de banco, escritura de
+//  automatización, rec armado parpadeando, stop.
+// ============================================================
+
+enum SessionKind : uint8_t { EV_NAME, EV_FLAGS, EV_VPOT };
+
+struct SessionEvent {
+    uint16_t    ms;        // desde el inicio
+    uint8_t     ch;        // canal MCU 1..9
+    SessionKind kind;
+    uint8_t     value;     // flags / vpot (en ráfaga: +1 por repetición, flags alterna 0)
+    uint8_t     count;     // repeticiones (1 = suelto)
+    uint8_t     everyMs;   // separación entre repeticiones
+    const char* name;      // EV_NAME
+};
+
+static constexpr uint16_t SESSION_MS = 12000;
+
+static constexpr uint8_t AUTO_R = AUTO_READ << AUTOMODE_SHIFT;
+static constexpr uint8_t AUTO_T = AUTO_TOUCH << AUTOMODE_SHIFT;
+
+static const SessionEvent LOGIC_SESSION[] = {
+    // Carga: nombres, automatización y V-Pots de todo el banco
+    {    0, 1, EV_NAME,  0, 1, 0, "Kick   " },
+    {    0, 2, EV_NAME,  0, 1, 0, "Snare  " },
+    {    0, 3, EV_NAME,  0, 1, 0, "OH L/R " },
+    {    0, 4, EV_NAME,  0, 1, 0, "Bass DI" },
+    {    0, 5, EV_NAME,  0, 1, 0, "Gtr Rhy" },
+    {    0, 6, EV_NAME,  0, 1, 0, "Gtr Ld " },
+    {    0, 7, EV_NAME,  0, 1, 0, "Keys   " },
+    {    0, 8, EV_NAME,  0, 1, 0, "Lead Vx" },
+    {    0, 9, EV_NAME,  0, 1, 0, "BGV    " },
+    {   10, 1, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    {   10, 4, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    {   10, 8, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    {   20, 1, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 2, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 3, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 4, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 5, EV_VPOT,  0x43, 1, 0, nullptr },
+    {   20, 6, EV_VPOT,  0x49, 1, 0, nullptr },
+    {   20, 7, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 8, EV_VPOT,  0x46, 1, 0, nullptr },
+    {   20, 9, EV_VPOT,  0x46, 1, 0, nullptr },
+    {  500, 1, EV_FLAGS, FLAG_SELECT | AUTO_R, 1, 0, nullptr },
+    // Pan de la guitarra rítmica con el encoder
+    { 2000, 5, EV_VPOT,  0x40, 20, 30, nullptr },
+    { 3500, 5, EV_FLAGS, FLAG_MUTE, 1, 0, nullptr },
+    { 3600, 2, EV_FLAGS, FLAG_SOLO, 1, 0, nullptr },
+    { 4000, 1, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    { 4000, 4, EV_FLAGS, FLAG_SELECT | AUTO_R, 1, 0, nullptr },
+    { 4400, 2, EV_FLAGS, 0, 1, 0, nullptr },
+    { 5000, 6, EV_NAME,  0, 1, 0, "Solo Gt" },
+    // Cambio de banco: todo el estado de los 9 canales cambia
+    { 6000, 1, EV_NAME,  0, 1, 0, "Pad    " },
+    { 6000, 2, EV_NAME,  0, 1, 0, "Strings" },
+    { 6000, 3, EV_NAME,  0, 1, 0, "Brass  " },
+    { 6000, 4, EV_NAME,  0, 1, 0, "Perc   " },
+    { 6000, 5, EV_NAME,  0, 1, 0, "FX Rev " },
+    { 6000, 6, EV_NAME,  0, 1, 0, "FX Dly " },
+    { 6000, 7, EV_NAME,  0, 1, 0, "Sub    " },
+    { 6000, 8, EV_NAME,  0, 1, 0, "Bus Drm" },
+    { 6000, 9, EV_NAME,  0, 1, 0, "Bus Voc" },
+    { 6010, 1, EV_FLAGS, 0, 1, 0, nullptr },
+    { 6010, 2, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    { 6010, 3, EV_FLAGS, 0, 1, 0, nullptr },
+    { 6010, 4, EV_FLAGS, FLAG_MUTE, 1, 0, nullptr },
+    { 6010, 5, EV_FLAGS, 0, 1, 0, nullptr },
+    { 6010, 6, EV_FLAGS, 0, 1, 0, nullptr },
+    { 6010, 7, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    { 6010, 8, EV_FLAGS, FLAG_SELECT, 1, 0, nullptr },
+    { 6010, 9, EV_FLAGS, 0, 1, 0, nullptr },
+    { 6020, 1, EV_VPOT,  0x41, 1, 0, nullptr },
+    { 6020, 2, EV_VPOT,  0x4B, 1, 0, nullptr },
+    { 6020, 3, EV_VPOT,  0x46, 1, 0, nullptr },
+    { 6020, 4, EV_VPOT,  0x44, 1, 0, nullptr },
+    { 6020, 5, EV_VPOT,  0x46, 1, 0, nullptr },
+    { 6020, 6, EV_VPOT,  0x46, 1, 0, nullptr },
+    { 6020, 7, EV_VPOT,  0x48, 1, 0, nullptr },
+    { 6020, 8, EV_VPOT,  0x46, 1, 0, nullptr },
+    { 6020, 9, EV_VPOT,  0x46, 1, 0, nullptr },
+    // Escritura de automatización en el bus de voces
+    { 7000, 9, EV_FLAGS, AUTO_T, 1, 0, nullptr },
+    { 8000, 1, EV_VPOT,  0x41, 30, 20, nullptr },
+    // Rec armado: Logic hace parpadear el LED (flags alterna)
+    { 9500, 3, EV_FLAGS, FLAG_REC, 8, 250, nullptr },
+    {11500, 9, EV_FLAGS, AUTO_R, 1, 0, nullptr },
+    {11500, 8, EV_FLAGS, 0, 1, 0, nullptr },
+};
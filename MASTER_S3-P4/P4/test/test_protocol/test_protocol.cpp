@@ -0,0 +1,644 @@
+// ============================================================
+//  test_protocol.cpp  –  lib/imakie_protocol en host
+//  pio test -e native -f test_protocol
+//
+//  - Bytes de referencia: tramas fijadas a mano (CRC calculado
+//    aparte); cualquier cambio de layout o de CRC rompe aquí
+//    antes que en el bus con firmware ya desplegado.
+//  - Ida y vuelta: encode → checkFrame → apply/decode.
+//  - Fuzz: bytes aleatorios y tramas válidas mutadas; checkFrame
+//    nunca acepta lo que apply/groupFind no puedan recorrer.
+//  - Bytes en el cable por barrido con la sesión de referencia
+//    (logic_session.h): 16 B fijos, delta y group poll.
+//  - Micro-benchmark de CRC: bit a bit, nibble y tabla 256 (las
+//    tres RS485_CRC_IMPL) por tamaño de trama.
+// ============================================================
+#include <unity.h>
+#include <chrono>
+#include <stdlib.h>
+#include <imakie_protocol.h>
+#include "logic_session.h"
+
+void setUp() {}
+void tearDown() {}
+
+// xorshift32: fuzz reproducible
+static uint32_t s_rng = 0x1234567u;
+static uint32_t rnd() {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static MasterPacket samplePacket(uint8_t id) {
+    MasterPacket p = {};
+    p.id = id;
+    memcpy(p.trackName, "GUITAR ", 7);
+    p.flags       = FLAG_MUTE | FLAG_SELECT | (AUTO_READ << AUTOMODE_SHIFT);
+    p.faderTarget = 0x1234;
+    p.vuLevel     = 100;
+    p.vpotValue   = 0x46;
+    p.connected   = 1;
+    return p;
+}
+
+static MasterPacket randomPacket(uint8_t id) {
+    MasterPacket p = {};
+    p.header = RS485_START_BYTE;
+    p.id     = id;
+    for (auto& c : p.trackName) c = (char)(' ' + rnd() % 95);
+    p.flags       = (uint8_t)rnd() & ~FLAG_CALIB;
+    p.faderTarget = (uint16_t)(rnd() & 0x3FFF);
+    p.vuLevel     = (uint8_t)(rnd() & 0x7F);
+    p.vpotValue   = (uint8_t)(rnd() & 0x7F);
+    p.connected   = (uint8_t)(rnd() & 1);
+    return p;
+}
+
+// ─── CRC ──────────────────────────────────────────────────────
+
+static void test_crc_check_values() {
+    const uint8_t s[] = { '1','2','3','4','5','6','7','8','9' };
+    TEST_ASSERT_EQUAL_HEX8(0xF4, rs485_crc8(s, sizeof(s)));
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, rs485_crc16(s, sizeof(s)));
+}
+
+// La implementación elegida (RS485_CRC_IMPL) contra el paso bit a bit,
+// por trozos y de una vez
+static void test_crc_matches_bitwise() {
+    uint8_t buf[256];
+    for (int n = 0; n < 2000; n++) {
+        const size_t len = rnd() % sizeof(buf);
+        for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)rnd();
+        uint8_t  c8  = 0;
+        uint16_t c16 = RS485_CRC16_INIT;
+        for (size_t i = 0; i < len; i++) {
+            c8  = rs485_crc8Step(c8, buf[i]);
+            c16 = rs485_crc16Step(c16, buf[i]);
+        }
+        TEST_ASSERT_EQUAL_HEX8(c8, rs485_crc8(buf, len));
+        TEST_ASSERT_EQUAL_HEX16(c16, rs485_crc16(buf, len));
+        const size_t cut = len ? rnd() % len : 0;
+        TEST_ASSERT_EQUAL_HEX8(c8, rs485_crc8(buf + cut, len - cut, rs485_crc8(buf, cut)));
+    }
+}
+
+// Micro-benchmark: las tres RS485_CRC_IMPL en el mismo binario (pasos
+// con tabla explícita), ns por byte con tramas de 9 B (SlavePacket),
+// 16 B (MasterPacket) y 256 B (bloque de firmware). Mejor de 5 pasadas.
+static constexpr Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  8, 256> BENCH_T8{};
+static constexpr Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  4, 16>  BENCH_N8{};
+static constexpr Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 8, 256> BENCH_T16{};
+static constexpr Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 4, 16>  BENCH_N16{};
+
+static volatile uint32_t s_crcSink;
+
+template <typename Step>
+static double crcNsPerByte(const uint8_t* buf, size_t total, size_t frame, Step step) {
+    double best = 1e9;
+    for (int pass = 0; pass < 5; pass++) {
+        const auto t0  = std::chrono::steady_clock::now();
+        uint32_t   acc = 0;
+        for (int rep = 0; rep < 64; rep++)
+            for (size_t off = 0; off + frame <= total; off += frame)
+                acc += step(buf + off, frame);
+        const auto t1 = std::chrono::steady_clock::now();
+        s_crcSink = acc;
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        const double per = ns / (64.0 * (total / frame) * frame);
+        if (per < best) best = per;
+    }
+    return best;
+}
+
+static void test_crc_benchmark() {
+    static uint8_t buf[16 * 1024];
+    for (auto& b : buf) b = (uint8_t)rnd();
+    static const size_t FRAMES[] = { 9, 16, 256 };
+
+    TEST_MESSAGE("CRC ns/byte        bit a bit   nibble   tabla 256");
+    for (size_t frame : FRAMES) {
+        const double b8 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint8_t c = 0;
+            for (size_t i = 0; i < n; i++) c = rs485_crc8Step(c, p[i]);
+            return (uint32_t)c;
+        });
+        const double n8 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint8_t c = 0;
+            for (size_t i = 0; i < n; i++) c = rs485_crc8Step(BENCH_N8, c, p[i]);
+            return (uint32_t)c;
+        });
+        const double t8 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint8_t c = 0;
+            for (size_t i = 0; i < n; i++) c = rs485_crc8Step(BENCH_T8, c, p[i]);
+            return (uint32_t)c;
+        });
+        const double b16 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint16_t c = RS485_CRC16_INIT;
+            for (size_t i = 0; i < n; i++) c = rs485_crc16Step(c, p[i]);
+            return (uint32_t)c;
+        });
+        const double n16 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint16_t c = RS485_CRC16_INIT;
+            for (size_t i = 0; i < n; i++) c = rs485_crc16Step(BENCH_N16, c, p[i]);
+            return (uint32_t)c;
+        });
+        const double t16 = crcNsPerByte(buf, sizeof(buf), frame, [](const uint8_t* p, size_t n) {
+            uint16_t c = RS485_CRC16_INIT;
+            for (size_t i = 0; i < n; i++) c = rs485_crc16Step(BENCH_T16, c, p[i]);
+            return (uint32_t)c;
+        });
+        char msg[96];
+        snprintf(msg, sizeof(msg), "CRC8  %3u B       %8.2f  %8.2f  %8.2f", (unsigned)frame, b8, n8, t8);
+        TEST_MESSAGE(msg);
+        snprintf(msg, sizeof(msg), "CRC16 %3u B       %8.2f  %8.2f  %8.2f", (unsigned)frame, b16, n16, t16);
+        TEST_MESSAGE(msg);
+
+        // La tabla 256 (defecto) gana con holgura al bucle bit a bit; la
+        // nibble queda entre las dos
+        TEST_ASSERT_LESS_THAN(b8 / 2, t8);
+        TEST_ASSERT_LESS_THAN(b16 / 2, t16);
+        TEST_ASSERT_LESS_THAN(b8, n8);
+        TEST_ASSERT_LESS_THAN(b16, n16);
+    }
+}
+
+// ─── Bytes de referencia ──────────────────────────────────────
+
+static void test_golden_master() {
+    static const uint8_t ref[] = { 0xAA, 0x03, 0x47, 0x55, 0x49, 0x54, 0x41, 0x52,
+                                   0x20, 0x2C, 0x34, 0x12, 0x64, 0x46, 0x01, 0xAB };
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    TEST_ASSERT_EQUAL(sizeof(ref), rs485_encodeMaster(buf, samplePacket(3)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, buf, sizeof(ref));
+    TEST_ASSERT_TRUE(rs485_checkFrame(ref, sizeof(ref)) == Rs485Status::OK);
+}
+
+static void test_golden_slave() {
+    static const uint8_t ref[] = { 0xBB, 0x05, 0x39, 0x30, 0x01, 0x05, 0xFD, 0xC1, 0x16 };
+    SlavePacket p = {};
+    p.id            = 5;
+    p.faderPos      = 12345;
+    p.touchState    = 1;
+    p.buttons       = FLAG_REC | FLAG_MUTE;
+    p.encoderDelta  = -3;
+    p.encoderButton = SLAVE_ENC_BUTTON | SLAVE_CAP_DELTA | SLAVE_CAP_BCAST;
+    uint8_t buf[sizeof(SlavePacket)];
+    TEST_ASSERT_EQUAL(sizeof(ref), rs485_encodeSlave(buf, p));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, buf, sizeof(ref));
+}
+
+static void test_golden_delta() {
+    static const uint8_t full[] = { 0xAB, 0x03, 0x23, 0x34, 0x12, 0x64, 0x47, 0x55,
+                                    0x49, 0x54, 0x41, 0x52, 0x20, 0x2C, 0xC8 };
+    static const uint8_t bare[] = { 0xAB, 0x07, 0x20, 0xFF, 0x3F, 0x00, 0x15 };
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    TEST_ASSERT_EQUAL(sizeof(full), rs485_encodeDelta(buf, samplePacket(3), DF_NAME | DF_FLAGS));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(full, buf, sizeof(full));
+
+    MasterPacket p = {};
+    p.id = 7; p.faderTarget = 0x3FFF;
+    TEST_ASSERT_EQUAL(sizeof(bare), rs485_encodeDelta(buf, p, 0));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bare, buf, sizeof(bare));
+}
+
+static void test_golden_broadcast_baud() {
+    static const uint8_t bcast[] = { 0xAC, 0x00, 0x2A, 0x01, 0x3C };
+    static const uint8_t baud[]  = { 0xAD, 0x00, 0x02, 0xD7 };
+    uint8_t buf[8];
+    TEST_ASSERT_EQUAL(sizeof(bcast), rs485_encodeBroadcast(buf, 42, BCAST_CONNECTED));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bcast, buf, sizeof(bcast));
+    TEST_ASSERT_EQUAL(sizeof(baud), rs485_encodeBaud(buf, 2));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(baud, buf, sizeof(baud));
+}
+
+static void test_golden_group() {
+    static const uint8_t ref[] = { 0xAE, 0x13, 0x02, 0xC8, 0x00,
+                                   0x01, 0x20, 0x00, 0x01, 0x0A,
+                                   0x04, 0x2C, 0x00, 0x20, 0x00, 0x41, 0x01,
+                                   0x61, 0xCA };
+    MasterPacket a = {}, b = {};
+    a.id = 1; a.faderTarget = 0x0100; a.vuLevel = 10;
+    b.id = 4; b.faderTarget = 0x2000; b.vpotValue = 0x41; b.connected = 1;
+    uint8_t buf[RS485_GROUP_MAX_LEN];
+    size_t n = rs485_groupBegin(buf, 200);
+    n = rs485_groupAdd(buf, n, a, 0);
+    n = rs485_groupAdd(buf, n, b, DF_VPOT | DF_CONNECTED);
+    n = rs485_groupEnd(buf, n);
+    TEST_ASSERT_EQUAL(sizeof(ref), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, buf, sizeof(ref));
+}
+
+static void test_golden_fw_query() {
+    static const uint8_t ref[] = { 0xAF, 0x0A, 0x03, 0x34, 0x12, 0x05, 0x10, 0x00, 0x1F, 0xC8 };
+    uint8_t buf[RS485_FW_MAX_LEN];
+    TEST_ASSERT_EQUAL(sizeof(ref), rs485_encodeFwQuery(buf, 0x1234, 5, 0x0010));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, buf, sizeof(ref));
+    TEST_ASSERT_TRUE(rs485_checkFrame(ref, sizeof(ref)) == Rs485Status::OK);
+}
+
+// ─── Ida y vuelta ─────────────────────────────────────────────
+
+static void test_roundtrip_master_and_slave() {
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    for (int n = 0; n < 500; n++) {
+        const MasterPacket p = randomPacket(1 + rnd() % 17);
+        const size_t len = rs485_encodeMaster(buf, p);
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+        MasterPacket acc = {};
+        rs485_applyMaster(buf, acc);
+        TEST_ASSERT_EQUAL_MEMORY(&p, &acc, sizeof(MasterPacket) - 1);
+
+        SlavePacket s = {}, out = {};
+        s.id = p.id; s.faderPos = (uint16_t)rnd(); s.touchState = rnd() & 1;
+        s.buttons = (uint8_t)rnd(); s.encoderDelta = (int8_t)rnd(); s.encoderButton = (uint8_t)rnd();
+        const size_t sl = rs485_encodeSlave(buf, s);
+        TEST_ASSERT_TRUE(rs485_decodeSlave(buf, sl, out) == Rs485Status::OK);
+        TEST_ASSERT_EQUAL_MEMORY(&s.id, &out.id, sizeof(SlavePacket) - 2);
+    }
+}
+
+// Cada subconjunto de campos: el delta solo toca lo que lleva y la
+// longitud codificada coincide con rs485_deltaLength
+static void test_roundtrip_delta_all_field_sets() {
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    for (uint8_t fields = 0; fields <= DF_ALL; fields++) {
+        const MasterPacket prev = randomPacket(9);
+        MasterPacket cur        = randomPacket(9);
+        const size_t len = rs485_encodeDelta(buf, cur, fields);
+        TEST_ASSERT_EQUAL(rs485_deltaLength(buf[2]), len);
+        TEST_ASSERT_EQUAL(rs485_frameLength(buf, len), len);
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+
+        MasterPacket acc = prev;
+        rs485_applyMaster(buf, acc);
+        TEST_ASSERT_EQUAL_UINT16(cur.faderTarget, acc.faderTarget);
+        TEST_ASSERT_EQUAL_UINT8(cur.vuLevel, acc.vuLevel);
+        TEST_ASSERT_EQUAL_MEMORY((fields & DF_NAME) ? cur.trackName : prev.trackName, acc.trackName, 7);
+        TEST_ASSERT_EQUAL_UINT8((fields & DF_FLAGS) ? cur.flags : prev.flags, acc.flags);
+        TEST_ASSERT_EQUAL_UINT8((fields & DF_VPOT) ? cur.vpotValue : prev.vpotValue, acc.vpotValue);
+        TEST_ASSERT_EQUAL_UINT8((fields & DF_CONNECTED) ? cur.connected : prev.connected, acc.connected);
+    }
+}
+
+// FLAG_CALIB es one-shot: fuerza DF_FLAGS y, ausente, se borra del acumulado
+static void test_delta_calib_one_shot() {
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    MasterPacket p = samplePacket(2);
+    p.flags |= FLAG_CALIB;
+    rs485_encodeDelta(buf, p, 0);
+    TEST_ASSERT_TRUE(buf[2] & DF_FLAGS);
+    MasterPacket acc = {};
+    rs485_applyMaster(buf, acc);
+    TEST_ASSERT_TRUE(acc.flags & FLAG_CALIB);
+
+    p.flags &= ~FLAG_CALIB;
+    rs485_encodeDelta(buf, p, 0);
+    rs485_applyMaster(buf, acc);
+    TEST_ASSERT_FALSE(acc.flags & FLAG_CALIB);
+    TEST_ASSERT_EQUAL_UINT8(samplePacket(2).flags, acc.flags);
+}
+
+static void test_roundtrip_group_find() {
+    uint8_t buf[RS485_GROUP_MAX_LEN];
+    for (int n = 0; n < 300; n++) {
+        // ids crecientes con huecos, hasta RS485_GROUP_MAX_SLAVES
+        MasterPacket pk[RS485_GROUP_MAX_SLAVES];
+        uint8_t fields[RS485_GROUP_MAX_SLAVES];
+        uint8_t count = 0, id = 0;
+        const uint8_t want = 1 + rnd() % RS485_GROUP_MAX_SLAVES;
+        size_t len = rs485_groupBegin(buf, (uint16_t)rnd());
+        while (count < want) {
+            id += 1 + rnd() % 2;
+            pk[count]     = randomPacket(id);
+            fields[count] = rnd() & DF_ALL;
+            len = rs485_groupAdd(buf, len, pk[count], fields[count]);
+            count++;
+        }
+        len = rs485_groupEnd(buf, len);
+        TEST_ASSERT_TRUE(len <= RS485_GROUP_MAX_LEN);
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+
+        for (uint8_t r = 0; r < count; r++) {
+            uint8_t slot = 0xFF;
+            const uint8_t* rec = rs485_groupFind(buf, pk[r].id, slot);
+            TEST_ASSERT_NOT_NULL(rec);
+            TEST_ASSERT_EQUAL_UINT8(r, slot);
+            MasterPacket acc = {};
+            rs485_applyRecord(rec, acc);
+            TEST_ASSERT_EQUAL_UINT8(pk[r].id, acc.id);
+            TEST_ASSERT_EQUAL_UINT16(pk[r].faderTarget, acc.faderTarget);
+            if (fields[r] & DF_NAME) TEST_ASSERT_EQUAL_MEMORY(pk[r].trackName, acc.trackName, 7);
+        }
+        uint8_t slot;
+        TEST_ASSERT_NULL(rs485_groupFind(buf, id + 1, slot));
+    }
+}
+
+static void test_fw_nack_window() {
+    uint8_t missing[64] = {};
+    uint8_t out[FW_NACK_BYTES];
+    uint16_t base;
+    TEST_ASSERT_EQUAL(0, rs485_fwNackWindow(missing, 500, 0, base, out));
+
+    missing[10 >> 3] |= 1 << (10 & 7);
+    missing[300 >> 3] |= 1 << (300 & 7);
+    size_t n = rs485_fwNackWindow(missing, 500, 0, base, out);
+    TEST_ASSERT_EQUAL(10, base);
+    TEST_ASSERT_EQUAL((290 >> 3) + 1, n);
+    TEST_ASSERT_TRUE(out[0] & 1);
+    TEST_ASSERT_TRUE(out[290 >> 3] & (1 << (290 & 7)));
+
+    n = rs485_fwNackWindow(missing, 500, 11, base, out);
+    TEST_ASSERT_EQUAL(300, base);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(0, rs485_fwNackWindow(missing, 500, 301, base, out));
+
+    uint8_t frame[RS485_FW_STATUS_MAX_LEN];
+    n = rs485_fwNackWindow(missing, 500, 0, base, out);
+    const size_t len = rs485_encodeFwStatus(frame, 4, FW_RECEIVING, 0x55AA, 2, base, out, n);
+    TEST_ASSERT_TRUE(rs485_checkFrame(frame, len) == Rs485Status::OK);
+    TEST_ASSERT_EQUAL_UINT16(10, rs485_get16(&frame[8]));
+}
+
+// ─── checkFrame ───────────────────────────────────────────────
+
+// Trama válida → cualquier bit cambiado deja de ser OK; cortada = INCOMPLETE;
+// con un byte de más = BAD_LENGTH
+static void test_check_bit_flips_and_lengths() {
+    uint8_t frames[6][RS485_GROUP_MAX_LEN];
+    size_t  lens[6];
+    lens[0] = rs485_encodeMaster(frames[0], samplePacket(3));
+    lens[1] = rs485_encodeDelta(frames[1], samplePacket(3), DF_ALL);
+    lens[2] = rs485_encodeBroadcast(frames[2], 1, 0);
+    lens[3] = rs485_encodeBaud(frames[3], 3);
+    size_t g = rs485_groupBegin(frames[4], 100);
+    g = rs485_groupAdd(frames[4], g, samplePacket(1), DF_ALL);
+    g = rs485_groupAdd(frames[4], g, samplePacket(2), 0);
+    lens[4] = rs485_groupEnd(frames[4], g);
+    lens[5] = rs485_encodeFwCmd(frames[5], FW_OP_COMMIT, 7);
+
+    for (int f = 0; f < 6; f++) {
+        uint8_t* buf = frames[f];
+        const size_t len = lens[f];
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+        for (size_t i = 0; i < len; i++) {
+            for (uint8_t b = 0; b < 8; b++) {
+                buf[i] ^= 1 << b;
+                TEST_ASSERT_FALSE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+                buf[i] ^= 1 << b;
+            }
+        }
+        for (size_t cut = 1; cut < len; cut++) {
+            const Rs485Status st = rs485_checkFrame(buf, cut);
+            TEST_ASSERT_TRUE(st == Rs485Status::INCOMPLETE);
+        }
+        buf[len] = 0;
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len + 1) == Rs485Status::BAD_LENGTH);
+    }
+}
+
+static void test_check_rejects_unknown_header_and_version() {
+    uint8_t buf[RS485_MAX_FRAME_LEN];
+    for (int h = 0; h < 256; h++) {
+        buf[0] = (uint8_t)h;
+        const bool known = h == RS485_START_BYTE || h == RS485_RESP_BYTE || h == RS485_BCAST_BYTE ||
+                           h == RS485_DELTA_BYTE || h == RS485_BAUD_BYTE || h == RS485_GROUP_BYTE ||
+                           h == RS485_FW_BYTE   || h == RS485_FW_RESP_BYTE;
+        TEST_ASSERT_EQUAL(known, rs485_checkFrame(buf, 1) != Rs485Status::BAD_HEADER);
+        TEST_ASSERT_EQUAL(known, rs485_frameLength(buf, 1) != 0);
+    }
+    const size_t len = rs485_encodeDelta(buf, samplePacket(1), DF_NAME);
+    buf[2] = (uint8_t)((2 << DELTA_VERSION_SHIFT) | (buf[2] & DELTA_FIELD_MASK));
+    buf[len - 1] = rs485_crc8(buf, len - 1);
+    TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::BAD_VERSION);
+    TEST_ASSERT_EQUAL(0, rs485_frameLength(buf, 3));
+}
+
+// Registro de grupo con longitud que no cuadra con len: CRC correcto
+// pero BAD_LENGTH (groupFind no revalida)
+static void test_check_group_record_overrun() {
+    uint8_t buf[RS485_GROUP_MAX_LEN];
+    size_t n = rs485_groupBegin(buf, 100);
+    n = rs485_groupAdd(buf, n, samplePacket(1), 0);
+    n = rs485_groupAdd(buf, n, samplePacket(2), 0);
+    buf[2] = 3;                                   // count de más
+    n = rs485_groupEnd(buf, n);
+    TEST_ASSERT_TRUE(rs485_checkFrame(buf, n) == Rs485Status::BAD_LENGTH);
+
+    n = rs485_groupBegin(buf, 100);
+    n = rs485_groupAdd(buf, n, samplePacket(1), 0);
+    buf[GROUP_HEADER_LEN + 1] |= DF_NAME;         // registro dice 7 B más de los que hay
+    n = rs485_groupEnd(buf, n);
+    TEST_ASSERT_TRUE(rs485_checkFrame(buf, n) == Rs485Status::BAD_LENGTH);
+}
+
+// ─── Fuzz ─────────────────────────────────────────────────────
+
+// Lo que checkFrame acepta se puede aplicar/recorrer sin salirse de len.
+// El buffer va relleno con 0xEE tras len: una lectura fuera se notaría
+// como registro/longitud incoherente.
+static void fuzzAccepted(const uint8_t* buf, size_t len) {
+    TEST_ASSERT_EQUAL(len, rs485_frameLength(buf, len));
+    MasterPacket acc = {};
+    switch (buf[0]) {
+        case RS485_START_BYTE:
+        case RS485_DELTA_BYTE:
+            rs485_applyMaster(buf, acc);
+            TEST_ASSERT_EQUAL_UINT8(buf[1], acc.id);
+            break;
+        case RS485_GROUP_BYTE: {
+            size_t i = GROUP_HEADER_LEN;
+            for (uint8_t r = 0; r < buf[2]; r++) {
+                uint8_t slot = 0xFF;
+                const uint8_t* rec = rs485_groupFind(buf, buf[i], slot);
+                TEST_ASSERT_NOT_NULL(rec);
+                TEST_ASSERT_TRUE(rec >= buf + GROUP_HEADER_LEN && rec + rs485_deltaLength(rec[1]) - 2 <= buf + len - 2);
+                rs485_applyRecord(rec, acc);
+                i += rs485_deltaLength(buf[i + 1]) - 2;
+            }
+            TEST_ASSERT_EQUAL(len - 2, i);
+            break;
+        }
+        default: break;
+    }
+}
+
+static void test_fuzz_random_bytes() {
+    uint8_t buf[RS485_RX_MAX_LEN + 16];
+    static const uint8_t headers[] = { RS485_START_BYTE, RS485_RESP_BYTE, RS485_BCAST_BYTE,
+                                       RS485_DELTA_BYTE, RS485_BAUD_BYTE, RS485_GROUP_BYTE,
+                                       RS485_FW_BYTE, RS485_FW_RESP_BYTE };
+    uint32_t accepted = 0;
+    for (int n = 0; n < 200000; n++) {
+        memset(buf, 0xEE, sizeof(buf));
+        const size_t len = rnd() % (RS485_RX_MAX_LEN + 1);
+        for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)rnd();
+        if (len && (rnd() & 1)) buf[0] = headers[rnd() % sizeof(headers)];
+        // Bytes 1-2 coherentes a veces: si no, casi todo muere en la longitud
+        if (len > 2 && rs485_isLongFrame(buf[0]) && (rnd() & 1)) buf[1] = (uint8_t)len;
+        if (len > 2 && buf[0] == RS485_DELTA_BYTE)
+            buf[2] = (uint8_t)((DELTA_VERSION << DELTA_VERSION_SHIFT) | (buf[2] & DELTA_FIELD_MASK));
+        const Rs485Status st = rs485_checkFrame(buf, len);
+        if (st == Rs485Status::OK) { fuzzAccepted(buf, len); accepted++; }
+        // Longitud provisional: nunca 0 para un header conocido con pocos bytes
+        if (len && len < 3 && st != Rs485Status::BAD_HEADER)
+            TEST_ASSERT_TRUE(rs485_frameLength(buf, len) > 0 || st == Rs485Status::BAD_LENGTH);
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%u tramas aleatorias aceptadas (CRC casual)", (unsigned)accepted);
+    TEST_MESSAGE(msg);
+}
+
+// Tramas válidas con 1-4 bytes cambiados y el CRC recalculado: solo
+// la estructura protege → groupFind/apply siguen dentro de la trama
+static void test_fuzz_mutated_valid_frames() {
+    uint8_t buf[RS485_GROUP_MAX_LEN + 16];
+    uint32_t accepted = 0;
+    for (int n = 0; n < 50000; n++) {
+        memset(buf, 0xEE, sizeof(buf));
+        size_t len;
+        switch (rnd() % 3) {
+            case 0:  len = rs485_encodeDelta(buf, randomPacket(1 + rnd() % 17), rnd() & DF_ALL); break;
+            case 1:  len = rs485_encodeMaster(buf, randomPacket(1 + rnd() % 17)); break;
+            default: {
+                len = rs485_groupBegin(buf, 100);
+                const uint8_t cnt = 1 + rnd() % 8;
+                for (uint8_t r = 0; r < cnt; r++)
+                    len = rs485_groupAdd(buf, len, randomPacket(r + 1), rnd() & DF_ALL);
+                len = rs485_groupEnd(buf, len);
+            }
+        }
+        const int muts = 1 + rnd() % 4;
+        for (int m = 0; m < muts; m++) buf[1 + rnd() % (len - 1)] = (uint8_t)rnd();
+        if (rs485_isLongFrame(buf[0])) {
+            buf[1] = (uint8_t)len;
+            rs485_put16(&buf[len - 2], rs485_crc16(buf, len - 2));
+        } else {
+            buf[len - 1] = rs485_crc8(buf, len - 1);
+        }
+        if (rs485_checkFrame(buf, len) == Rs485Status::OK) { fuzzAccepted(buf, len); accepted++; }
+    }
+    TEST_ASSERT_GREATER_THAN(0, accepted);
+}
+
+// ─── Bytes en el cable ────────────────────────────────────────
+// Sesión de referencia barrida como RS485Master::_buildPacket: dirty
+// por set*(), fader + VU siempre, refresco completo cada
+// RS485_DELTA_REFRESH_CYCLES envíos. Por barrido: tramas del master
+// + una respuesta de 9 B por slave (+ broadcast con delta / grupo).
+
+static constexpr uint8_t  BENCH_SLAVES   = 9;
+static constexpr uint16_t BENCH_CYCLE_MS = 20;    // POLL_CYCLE_MS del P4
+static constexpr uint8_t  BENCH_REFRESH  = 50;    // RS485_DELTA_REFRESH_CYCLES
+
+struct WireBytes {
+    uint32_t sum = 0, max = 0, cycles = 0;
+    void add(uint32_t n) {
+        sum += n;
+        if (n > max) max = n;
+        cycles++;
+    }
+    double avg() const { return cycles ? (double)sum / cycles : 0; }
+};
+
+// Eventos de la sesión con instante en [from, to) → estado y dirty
+static void sessionApply(uint32_t from, uint32_t to, MasterPacket* ch, uint8_t* dirty) {
+    for (const SessionEvent& e : LOGIC_SESSION) {
+        for (uint8_t k = 0; k < e.count; k++) {
+            const uint32_t t = e.ms + (uint32_t)k * e.everyMs;
+            if (t < from || t >= to) continue;
+            MasterPacket& p = ch[e.ch];
+            switch (e.kind) {
+                case EV_NAME:  memcpy(p.trackName, e.name, 7);   dirty[e.ch] |= DF_NAME;  break;
+                case EV_FLAGS: p.flags = (k & 1) ? 0 : e.value;  dirty[e.ch] |= DF_FLAGS; break;
+                case EV_VPOT:  p.vpotValue = e.value + k;        dirty[e.ch] |= DF_VPOT;  break;
+            }
+        }
+    }
+}
+
+static void test_bytes_per_cycle_logic_session() {
+    MasterPacket ch[BENCH_SLAVES + 1] = {};
+    uint8_t      dirty[BENCH_SLAVES + 1], refresh[BENCH_SLAVES + 1] = {};
+    for (uint8_t id = 1; id <= BENCH_SLAVES; id++) {
+        ch[id].id        = id;
+        ch[id].connected = 1;
+        dirty[id]        = DF_ALL;                  // arranque: todo pendiente
+    }
+
+    const uint32_t reply = BENCH_SLAVES * sizeof(SlavePacket);
+    WireBytes full, delta, group;
+    uint8_t   buf[RS485_GROUP_MAX_LEN];
+    for (uint32_t t = 0; t < SESSION_MS; t += BENCH_CYCLE_MS) {
+        sessionApply(t, t + BENCH_CYCLE_MS, ch, dirty);
+
+        uint32_t nFull = 0, nDelta = sizeof(BroadcastPacket);
+        size_t   len   = rs485_groupBegin(buf, 100);
+        for (uint8_t id = 1; id <= BENCH_SLAVES; id++) {
+            MasterPacket& p = ch[id];
+            p.faderTarget   = (uint16_t)((t * 7 + id * 1000) & 0x3FFF);   // automatización en curso
+            p.vuLevel       = (uint8_t)((t / BENCH_CYCLE_MS + id) & 0x7F);
+
+            uint8_t fields = dirty[id];
+            dirty[id]      = 0;
+            if (++refresh[id] >= BENCH_REFRESH) {
+                refresh[id] = 0;
+                fields      = DF_ALL;
+            }
+            uint8_t frame[RS485_MAX_FRAME_LEN];
+            nFull  += rs485_encodeMaster(frame, p);
+            nDelta += rs485_encodeDelta(frame, p, fields);
+            len     = rs485_groupAdd(buf, len, p, fields);
+        }
+        len = rs485_groupEnd(buf, len);
+        TEST_ASSERT_TRUE(rs485_checkFrame(buf, len) == Rs485Status::OK);
+
+        full.add(nFull + reply);
+        delta.add(nDelta + reply);
+        group.add(sizeof(BroadcastPacket) + len + reply);
+    }
+
+    // 10 bits por byte: µs a 500 k = 20 × bytes
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "B/barrido (9 slaves, %u barridos): 16 B %.1f (máx %u)  delta %.1f (máx %u)  grupo %.1f (máx %u)",
+             (unsigned)full.cycles, full.avg(), (unsigned)full.max, delta.avg(), (unsigned)delta.max,
+             group.avg(), (unsigned)group.max);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "cable a 500 k: 16 B %.0f us  delta %.0f us  grupo %.0f us (máx %u us)",
+             full.avg() * 20, delta.avg() * 20, group.avg() * 20, (unsigned)group.max * 20);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL_UINT32(SESSION_MS / BENCH_CYCLE_MS, full.cycles);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_SLAVES * (sizeof(MasterPacket) + sizeof(SlavePacket)), full.max);
+    TEST_ASSERT_TRUE(delta.avg() < 0.75 * full.avg());
+    TEST_ASSERT_TRUE(group.avg() < delta.avg());
+    TEST_ASSERT_LESS_THAN(BENCH_CYCLE_MS * 1000, group.max * 20);   // cabe en el barrido a 500 k
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_values);
+    RUN_TEST(test_crc_matches_bitwise);
+    RUN_TEST(test_crc_benchmark);
+    RUN_TEST(test_golden_master);
+    RUN_TEST(test_golden_slave);
+    RUN_TEST(test_golden_delta);
+    RUN_TEST(test_golden_broadcast_baud);
+    RUN_TEST(test_golden_group);
+    RUN_TEST(test_golden_fw_query);
+    RUN_TEST(test_roundtrip_master_and_slave);
+    RUN_TEST(test_roundtrip_delta_all_field_sets);
+    RUN_TEST(test_delta_calib_one_shot);
+    RUN_TEST(test_roundtrip_group_find);
+    RUN_TEST(test_fw_nack_window);
+    RUN_TEST(test_check_bit_flips_and_lengths);
+    RUN_TEST(test_check_rejects_unknown_header_and_version);
+    RUN_TEST(test_check_group_record_overrun);
+    RUN_TEST(test_fuzz_random_bytes);
+    RUN_TEST(test_fuzz_mutated_valid_frames);
+    RUN_TEST(test_bytes_per_cycle_logic_session);
+    return UNITY_END();
+}
@@ -0,0 +1,325 @@
+// ============================================================
+//  test_rt.cpp  –  lib/imakie_rt en host
+//  pio test -e native -f test_rt
+//
+//  Seqlock y SpscRing con hilos reales (escritor/productor contra
+//  lectores/consumidor a toda velocidad): ningún snapshot a medias,
+//  ningún evento reordenado ni perdido sin contar. Latencia del
+//  escritor (task MIDI) frente al mutex con timeout de antes.
+//  LatencyEstimator: percentiles, desbordamiento y ventana.
+// ============================================================
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Seqlock.h>
+#include <SpscRing.h>
+#include <LatencyEstimator.h>
+
+void setUp() {}
+void tearDown() {}
+
+// ─── Seqlock ──────────────────────────────────────────────────
+
+// Más grande que una palabra: una copia a medias mezcla valores
+struct Snapshot {
+    uint32_t v[16];
+};
+
+static constexpr uint32_t WRITES  = 2000000;
+static constexpr int      READERS = 3;
+
+static void test_seqlock_no_torn_reads() {
+    Seqlock<Snapshot> lock;
+    std::atomic<bool>     done{false};
+    std::atomic<uint32_t> torn{0}, reads{0}, backwards{0};
+
+    Snapshot init;                              // estado inicial coherente (n = 0)
+    for (uint32_t i = 0; i < 16; i++) init.v[i] = i;
+    lock.write(init);
+
+    auto reader = [&]() {
+        uint32_t last = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            Snapshot s;
+            lock.read(s);
+            for (uint32_t i = 1; i < 16; i++)
+                if (s.v[i] != s.v[0] + i) { torn++; break; }
+            if (s.v[0] < last) backwards++;     // un solo escritor: nunca retrocede
+            last = s.v[0];
+            reads++;
+        }
+    };
+
+    std::thread rd[READERS];
+    for (auto& t : rd) t = std::thread(reader);
+    for (uint32_t n = 1; n <= WRITES; n++) {
+        Snapshot& s = lock.beginWrite();
+        for (uint32_t i = 0; i < 16; i++) s.v[i] = n + i;
+        lock.endWrite();
+    }
+    done = true;
+    for (auto& t : rd) t.join();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%u escrituras, %u lecturas concurrentes",
+             (unsigned)WRITES, (unsigned)reads.load());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+    TEST_ASSERT_GREATER_THAN(0, reads.load());
+    TEST_ASSERT_EQUAL_UINT32(2 * (WRITES + 1), lock.version());
+    TEST_ASSERT_EQUAL_UINT32(WRITES, lock.read().v[0]);
+}
+
+static void test_seqlock_write_helpers() {
+    Seqlock<Snapshot> lock;
+    Snapshot s = {};
+    s.v[3] = 7;
+    lock.write(s);
+    TEST_ASSERT_EQUAL_UINT32(2, lock.version());
+    TEST_ASSERT_EQUAL_UINT32(7, lock.data().v[3]);
+    TEST_ASSERT_EQUAL_UINT32(7, lock.read().v[3]);
+}
+
+// ─── Seqlock frente al mutex de antes ─────────────────────────
+// Antes: set*() tomaba _mutex con timeout de 5 ms (si vencía, el
+// cambio se perdía) y el task RS485 lo retenía mientras armaba el
+// paquete. Aquí el lector retiene/lee LAT_HOLD_US y descansa
+// LAT_GAP_US, como un ciclo del bus; se mide cada escritura.
+
+typedef std::chrono::steady_clock Clock;
+
+static constexpr uint32_t LAT_HOLD_US = 10;
+static constexpr uint32_t LAT_GAP_US  = 40;
+static constexpr int      LAT_RUN_MS  = 300;
+
+struct WriteLat {
+    uint32_t p50, p99, p999, max;   // ns
+    uint32_t writes, waits, drops;
+};
+
+static void spinUs(uint32_t us) {
+    const Clock::time_point end = Clock::now() + std::chrono::microseconds(us);
+    while (Clock::now() < end) {}
+}
+
+// write(n) devuelve false si el cambio se perdió (timeout); waits lo
+// cuenta el propio write cuando encontró el lock tomado
+template <typename Write, typename Read>
+static WriteLat measureWriter(Write write, Read readCycle, const uint32_t& waits) {
+    std::atomic<bool> done{false};
+    std::thread bus([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            readCycle();
+            spinUs(LAT_GAP_US);
+        }
+    });
+
+    std::vector<uint32_t> ns;
+    ns.reserve(1 << 20);
+    WriteLat r = {};
+    const Clock::time_point end = Clock::now() + std::chrono::milliseconds(LAT_RUN_MS);
+    for (uint32_t n = 1; Clock::now() < end; n++) {
+        const Clock::time_point t0 = Clock::now();
+        if (!write(n)) r.drops++;
+        ns.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+        spinUs(2);                              // MIDI entre mensajes
+    }
+    done = true;
+    bus.join();
+
+    std::sort(ns.begin(), ns.end());
+    r.writes = ns.size();
+    r.p50    = ns[ns.size() / 2];
+    r.p99    = ns[ns.size() * 99 / 100];
+    r.p999   = ns[ns.size() * 999 / 1000];
+    r.max    = ns.back();
+    r.waits  = waits;
+    return r;
+}
+
+static void reportLat(const char* mode, const WriteLat& r) {
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-7s %6u escrituras  p50 %5u ns  p99 %6u ns  p99.9 %7u ns  max %8u ns  esperas %u  perdidas %u",
+             mode, (unsigned)r.writes, (unsigned)r.p50, (unsigned)r.p99, (unsigned)r.p999,
+             (unsigned)r.max, (unsigned)r.waits, (unsigned)r.drops);
+    TEST_MESSAGE(msg);
+}
+
+// El escritor del seqlock nunca espera: su latencia no depende de lo
+// que haga el bus. Con el mutex cada set*() paga el lock y, si el bus
+// lo retiene, espera. El máximo de ambos lo marca el planificador
+// del host (se informa, no se compara).
+static void test_seqlock_writer_latency_vs_mutex() {
+    Seqlock<Snapshot> lock;
+    uint32_t          noWaits = 0;
+    const WriteLat seq = measureWriter(
+        [&](uint32_t n) {
+            Snapshot& s = lock.beginWrite();
+            for (uint32_t i = 0; i < 16; i++) s.v[i] = n + i;
+            lock.endWrite();
+            return true;
+        },
+        [&]() {
+            Snapshot s;
+            lock.read(s);
+            spinUs(LAT_HOLD_US);
+        },
+        noWaits);
+
+    std::timed_mutex mutex;
+    Snapshot         shared = {};
+    uint32_t         waits  = 0;
+    const WriteLat mtx = measureWriter(
+        [&](uint32_t n) {
+            if (!mutex.try_lock()) {
+                waits++;
+                if (!mutex.try_lock_for(std::chrono::milliseconds(5))) return false;
+            }
+            for (uint32_t i = 0; i < 16; i++) shared.v[i] = n + i;
+            mutex.unlock();
+            return true;
+        },
+        [&]() {
+            if (!mutex.try_lock_for(std::chrono::milliseconds(2))) return;
+            Snapshot s = shared;
+            (void)s;
+            spinUs(LAT_HOLD_US);                // armando el paquete con el lock
+            mutex.unlock();
+        },
+        waits);
+
+    reportLat("seqlock", seq);
+    reportLat("mutex", mtx);
+    TEST_ASSERT_EQUAL_UINT32(0, seq.drops);
+    TEST_ASSERT_LESS_THAN(mtx.p50, seq.p50);
+    TEST_ASSERT_LESS_THAN(mtx.p99, seq.p99);
+}
+
+// ─── SpscRing ─────────────────────────────────────────────────
+// Cola vacía/llena → yield: con un solo núcleo el otro hilo avanza
+
+struct Event {
+    uint32_t seq;
+    uint32_t check;     // ~seq: un slot copiado a medias no cuadra
+};
+
+static constexpr uint32_t EVENTS = 1000000;
+
+// Productor que reintenta: todo llega, en orden
+static void test_spsc_order_no_loss() {
+    SpscRing<Event, 64> q;
+    std::atomic<uint32_t> bad{0};
+    std::thread consumer([&]() {
+        uint32_t expect = 0;
+        Event e;
+        while (expect < EVENTS) {
+            if (!q.pop(e)) { std::this_thread::yield(); continue; }
+            if (e.seq != expect || e.check != ~e.seq) bad++;
+            expect = e.seq + 1;
+        }
+    });
+    for (uint32_t n = 0; n < EVENTS; n++)
+        while (!q.push(Event{n, ~n})) std::this_thread::yield();
+    consumer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, bad.load());
+    TEST_ASSERT_EQUAL_UINT32(0, q.size());
+}
+
+// Productor que descarta con la cola llena (como _pushEvents): el
+// consumidor ve una secuencia creciente y los huecos = los descartes
+static void test_spsc_drops_are_counted() {
+    SpscRing<Event, 16> q;
+    std::atomic<bool>     done{false};
+    std::atomic<uint32_t> bad{0}, gaps{0}, got{0};
+    std::thread consumer([&]() {
+        uint32_t next = 0;
+        Event e;
+        for (;;) {
+            if (!q.pop(e)) {
+                if (done.load(std::memory_order_acquire) && !q.size()) break;
+                std::this_thread::yield();
+                continue;
+            }
+            if (e.seq < next || e.check != ~e.seq) bad++;
+            gaps += e.seq - next;
+            next  = e.seq + 1;
+            got++;
+        }
+        gaps += EVENTS - next;                   // descartes tras el último recibido
+    });
+    uint32_t drops = 0;
+    for (uint32_t n = 0; n < EVENTS; n++)
+        if (!q.push(Event{n, ~n})) drops++;
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, bad.load());
+    TEST_ASSERT_EQUAL_UINT32(drops, gaps.load());
+    TEST_ASSERT_EQUAL_UINT32(EVENTS, got.load() + drops);
+}
+
+static void test_spsc_capacity() {
+    SpscRing<uint8_t, 4> q;
+    for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(q.push(i));
+    TEST_ASSERT_FALSE(q.push(9));
+    TEST_ASSERT_EQUAL(4, q.size());
+    uint8_t v;
+    for (uint8_t i = 0; i < 4; i++) { TEST_ASSERT_TRUE(q.pop(v)); TEST_ASSERT_EQUAL_UINT8(i, v); }
+    TEST_ASSERT_FALSE(q.pop(v));
+}
+
+// ─── LatencyEstimator ─────────────────────────────────────────
+
+typedef LatencyEstimator<25, 64, 512> Lat;   // RS485_LAT_BUCKET_US / BUCKETS / WINDOW
+
+static void test_latency_percentile() {
+    Lat lat;
+    TEST_ASSERT_EQUAL_UINT32(Lat::OUT_OF_RANGE, lat.percentileUs(990));
+    for (int i = 0; i < 99; i++) lat.add(110);   // cubeta 4 → borde 125
+    lat.add(480);                                // cubeta 19 → borde 500
+    TEST_ASSERT_EQUAL_UINT32(125, lat.percentileUs(500));
+    TEST_ASSERT_EQUAL_UINT32(125, lat.percentileUs(990));
+    TEST_ASSERT_EQUAL_UINT32(500, lat.percentileUs(1000));
+    TEST_ASSERT_EQUAL(100, lat.samples());
+}
+
+static void test_latency_out_of_range() {
+    Lat lat;
+    for (int i = 0; i < 50; i++) lat.add(100);
+    for (int i = 0; i < 50; i++) lat.add(100000);   // última cubeta
+    TEST_ASSERT_EQUAL_UINT32(125, lat.percentileUs(500));
+    TEST_ASSERT_EQUAL_UINT32(Lat::OUT_OF_RANGE, lat.percentileUs(990));
+}
+
+// Al llenar la ventana los contadores se dividen: lo reciente domina
+static void test_latency_window_forgets() {
+    Lat lat;
+    for (int i = 0; i < 2000; i++) lat.add(400);
+    TEST_ASSERT_EQUAL_UINT32(425, lat.percentileUs(990));
+    for (int i = 0; i < 2000; i++) lat.add(60);
+    TEST_ASSERT_EQUAL_UINT32(75, lat.percentileUs(990));
+    TEST_ASSERT_EQUAL(4000, lat.samples());
+
+    lat.reset();
+    TEST_ASSERT_EQUAL(0, lat.samples());
+    TEST_ASSERT_EQUAL_UINT32(Lat::OUT_OF_RANGE, lat.percentileUs(500));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_seqlock_no_torn_reads);
+    RUN_TEST(test_seqlock_write_helpers);
+    RUN_TEST(test_seqlock_writer_latency_vs_mutex);
+    RUN_TEST(test_spsc_order_no_loss);
+    RUN_TEST(test_spsc_drops_are_counted);
+    RUN_TEST(test_spsc_capacity);
+    RUN_TEST(test_latency_percentile);
+    RUN_TEST(test_latency_out_of_range);
+    RUN_TEST(test_latency_window_forgets);
+    return UNITY_END();
+}
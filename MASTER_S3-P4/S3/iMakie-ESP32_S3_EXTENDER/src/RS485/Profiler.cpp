@@ -1,3 +0,0 @@
-#include "Profiler.h"
-
-RS485Profiler rs485prof;
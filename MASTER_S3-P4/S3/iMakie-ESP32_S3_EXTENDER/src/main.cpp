@@ -16,7 +16,7 @@ USBMIDI MIDI;
 // ====================================================================
 // --- Boot LED (2026-05-16 19:50) ---
 // ====================================================================
-extern Adafruit_NeoPixel pixels;  // Definido en RS485.cpp
+Adafruit_NeoPixel pixels(NEOPIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 static uint32_t bootLEDTime = 0;  // Timestamp cuando encender LED verde
 
 // ====================================================================
@@ -62,8 +62,8 @@ bool btnFlashPG1[32]  = {false};
 bool btnFlashPG2[32]  = {false};
 
 // --- Track info ---
-String trackNames[8];
-String assignmentString = "--";
+TrackName trackNames[8];
+AssignText assignmentString = "--";
 uint8_t vpotValues[8]   = {0};
 
 // --- Handles de tareas ---
@@ -75,53 +75,59 @@ TaskHandle_t taskCore1Handle = nullptr;
 // ====================================================================
 static uint16_t lastSentPb[9] = {0};  // Track último PitchBend enviado por slave
 
-static void processSlaveResponse(uint8_t slaveId) {
-    const ChannelData& ch = rs485.getChannel(slaveId);
-    uint8_t midiCh = slaveId - 1;
+static void processSlaveEvent(const SlaveEvent& ev) {
+    uint8_t midiCh = ev.id - 1;
 
-    // --- Fader → Pitch Bend ---
-    // NO ENVIAR si slave está en calibración (CALIB_SENDING activo) — valores raw no son válidos para Logic
-    if (ch.touchState && !(ch.buttons & SLAVE_FLAG_CALIB_SENDING)) {
-        uint16_t pb  = ((uint32_t)ch.faderPos * LOGIC_PITCHBEND_MAX / 27000) & 0x3FFF;
+    switch (ev.type) {
+        // --- Fader → Pitch Bend ---
+        // El task RS485 ya descarta CALIB_SENDING (valores raw no válidos para Logic)
+        case SlaveEvtType::FADER: {
+            uint16_t pb = ((uint32_t)(uint16_t)ev.value * LOGIC_PITCHBEND_MAX / 27000) & 0x3FFF;
 
-        // Send-only-on-change: filtrar repeticiones idénticas (reduce tráfico 850→~100 msgs/s)
-        if (pb != lastSentPb[slaveId]) {
-            byte msg[3]  = { (byte)(0xE0 | midiCh), (byte)(pb & 0x7F), (byte)(pb >> 7) };
+            // Send-only-on-change: filtrar repeticiones idénticas (reduce tráfico 850→~100 msgs/s)
+            if (pb != lastSentPb[ev.id]) {
+                byte msg[3] = { (byte)(0xE0 | midiCh), (byte)(pb & 0x7F), (byte)(pb >> 7) };
+                sendMIDIBytes(msg, 3);
+                lastSentPb[ev.id] = pb;
+            }
+            break;
+        }
+
+        // --- Botones → Note On/Off ---
+        case SlaveEvtType::BUTTON: {
+            const uint8_t noteBase[4] = { 0, 8, 16, 24 };
+            uint8_t note = noteBase[ev.arg] + midiCh;
+            uint8_t vel  = ev.on ? 127 : 0;
+            byte msg[3]  = { (byte)(ev.on ? 0x90 : 0x80), note, vel };
             sendMIDIBytes(msg, 3);
-            lastSentPb[slaveId] = pb;
+            break;
         }
-    }
 
-    // --- Botones → Note On/Off ---
-    uint8_t changed = ch.buttons ^ ch.prevButtons;
-    if (changed) {
-        const uint8_t noteBase[4] = { 0, 8, 16, 24 };
-        for (uint8_t bit = 0; bit < 4; bit++) {
-            if (changed & (1 << bit)) {
-                bool    isOn = (ch.buttons & (1 << bit)) != 0;
-                uint8_t note = noteBase[bit] + midiCh;
-                uint8_t vel  = isOn ? 127 : 0;
-                byte msg[3]  = { (byte)(isOn ? 0x90 : 0x80), note, vel };
-                sendMIDIBytes(msg, 3);
+        // --- Encoder → CC ---
+        case SlaveEvtType::ENCODER: {
+            uint8_t cc = 16 + midiCh;
+            uint8_t val;
+
+            if (ev.value > 0) {
+                // CW: valores 1-62
+                val = constrain((uint8_t)ev.value, 1, 62);
+            } else {
+                // CCW: valores 64-127 (64 + ticks)
+                val = 64 + constrain((uint8_t)(-ev.value), 1, 64);
             }
-        }
-    }
 
-    // --- Encoder → CC ---
-    if (ch.encoderDelta != 0) {
-        uint8_t cc  = 16 + midiCh;
-        uint8_t val;
-
-        if (ch.encoderDelta > 0) {
-            // CW: valores 1-62
-            val = constrain((uint8_t)ch.encoderDelta, 1, 62);
-        } else {
-            // CCW: valores 64-127 (64 + ticks)
-            val = 64 + constrain((uint8_t)(-ch.encoderDelta), 1, 64);
+            byte msg[3] = { (byte)(0xB0 | midiCh), cc, val };
+            sendMIDIBytes(msg, 3);
+            break;
         }
 
-        byte msg[3] = { (byte)(0xB0 | midiCh), cc, val };
-        sendMIDIBytes(msg, 3);
+        case SlaveEvtType::TOUCH:
+            break;   // sin mensaje MCU por ahora
+
+        // --- Presencia: touch/botones ya llegan soltados como eventos normales ---
+        case SlaveEvtType::PRESENCE:
+            if (!ev.on) log_w("[MIDI] Strip %d OFFLINE — canal %d sin control físico", ev.id, midiCh + 1);
+            break;
     }
 }
 
@@ -131,6 +137,7 @@ static void processSlaveResponse(uint8_t slaveId) {
 void taskCore0(void* pvParameters) {
     log_e("MIDI task arrancando en Core %d", xPortGetCoreID());
     static unsigned long lastStatusLog = 0;  // ← MOVER AQUÍ
+    bool ledLost = false;                     // último estado pintado del LED de presencia
 
     for (;;) {
         // ── Apagar LED verde después de 200ms (2026-05-16 21:30) ──
@@ -138,19 +145,30 @@ void taskCore0(void* pvParameters) {
             pixels.setPixelColor(0, pixels.Color(0, 0, 0));  // Apagar
             pixels.show();
             bootLEDTime = 0;  // Reset
+            ledLost = false;
         }
 
-        uint8_t rx_buf[64];
-        uint32_t count = tud_midi_stream_read(rx_buf, sizeof(rx_buf));
-        if (count > 0) {
-            for (uint32_t i = 0; i < count; i++)
-                processMidiByte(rx_buf[i]);
+        // LED rojo mientras falte un strip (lo publica el task RS485)
+        const bool lost = rs485.lostMask() != 0;
+        if (bootLEDTime == 0 && lost != ledLost) {
+            pixels.setPixelColor(0, lost ? pixels.Color(255, 0, 0) : pixels.Color(0, 0, 0));
+            pixels.show();
+            ledLost = lost;
         }
 
-        if (logicConnectionState == ConnectionState::CONNECTED) {
-            for (uint8_t id = 1; id <= NUM_SLAVES; id++) {
-                if (rs485.hasNewSlaveData(id))
-                    processSlaveResponse(id);
+        // Paquetes USB-MIDI enteros: el CIN ya delimita cada mensaje
+        uint8_t pkt[4];
+        for (uint8_t n = 0; n < MIDI_RX_PACKETS_PER_LOOP && tud_midi_packet_read(pkt); n++)
+            processMidiPacket(pkt);
+
+        // Eventos RS485: se drenan siempre; sin Logic se descartan
+        SlaveEvent ev;
+        SlaveEvent faders[8];          // perfil fader → MIDI: medido tras el flush
+        uint8_t    nFaders = 0;
+        while (rs485.popEvent(ev)) {
+            if (logicConnectionState == ConnectionState::CONNECTED) {
+                processSlaveEvent(ev);
+                if (ev.type == SlaveEvtType::FADER && nFaders < 8) faders[nFaders++] = ev;
             }
         }
 
@@ -176,7 +194,14 @@ void taskCore0(void* pvParameters) {
             log_v("[STATUS] %s | g_logicConnected=%d", stateStr, g_logicConnected);
         }
         
-        vTaskDelay(1);
+        // Todo lo encolado en esta vuelta (y por UI/Transporte) sale en un único flush
+        MidiTx::flush();
+        const uint32_t now = micros();
+        for (uint8_t i = 0; i < nFaders; i++)
+            rs485.profileE2E(faders[i].id, now - faders[i].t);
+
+        // Despierta con evento RS485; USB MIDI se sigue sondeando cada 1 ms
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1));
     }
 }
 
@@ -209,9 +234,13 @@ void setup() {
     Transporte::begin();
     log_i("   Transporte OK");
 
-    // 3. RS485
+    // 3. RS485 (+ LED de estado: azul hasta que arrancan las tareas)
+    pixels.begin();
+    pixels.setBrightness(NEOPIXEL_BRIGHTNESS);
+    pixels.setPixelColor(0, pixels.Color(0, 0, 255));
+    pixels.show();
     log_i("3. rs485.begin(%d)...", NUM_SLAVES);
-    rs485.begin(NUM_SLAVES);
+    rs485.begin();
     log_i("   RS485 OK. Slaves: %d", NUM_SLAVES);
 
     // 4. MIDI (sin delay largo)
@@ -227,6 +256,7 @@ void setup() {
     log_i("5. Creando tareas...");
     xTaskCreatePinnedToCore(taskCore0, "MIDI", 4096, NULL, 2, &taskCore0Handle, 0);
     xTaskCreatePinnedToCore(taskCore1, "TRANSP", 4096, NULL, 1, &taskCore1Handle, 1);
+    rs485.setEventTask(taskCore0Handle);
     rs485.startTask();
     log_i("   Tareas creadas");
 
@@ -238,4 +268,14 @@ void setup() {
     log_i("=== S3-02 Extender ACTIVO. Slaves: %d ===", NUM_SLAVES);
 }
 
-void loop() { vTaskDelay(portMAX_DELAY); }
\ No newline at end of file
+// ====================================================================
+// --- CONSOLA SERIAL: 'p' informe, 'P' snapshot (tools/rs485prof), 'r' reset ---
+// ====================================================================
+void loop() {
+    switch (Serial.read()) {
+        case 'p': rs485.printStats(); MidiTx::printStats(); break;
+        case 'P': rs485.writeProfile(Serial); break;
+        case 'r': rs485.resetStats(); log_i("[PROF] Estadísticas a cero"); break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+}
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "../config.h"
 #include <USBMIDI.h>
 #include "../RS485/RS485.h"
+#include "imakie_midi.h"
+#include "imakie_miditx.h"
+#include "imakie_lcd.h"
 #include "../hardware/Transporte.h"  // ← AÑADIDO
 
 extern USBMIDI MIDI;
@@ -12,10 +15,20 @@ extern bool btnStatePG2[32];
 extern uint8_t g_logicConnected;
 
 namespace {
-    byte midi_buffer[512];
-    int midi_idx = 0;
-    bool in_sysex = false;
-    byte last_status_byte = 0;
+    void onMidiMessage(void*, uint8_t status, uint8_t d1, uint8_t d2);
+    void onMidiSysEx(void*, const uint8_t* data, uint8_t n, uint8_t flags);
+
+    MidiParser<MIDI_SYSEX_CHUNK> midiIn(onMidiMessage, onMidiSysEx);
+
+    // SysEx en curso: el LCD (0x12) se vuelca por trozos; el resto,
+    // cortos, se juntan enteros para processMackieSysEx()
+    byte sysex_buf[MIDI_SYSEX_MAX];
+    int  sysex_len      = 0;
+    bool sysex_overflow = false;
+    bool sysex_lcd      = false;
+
+    // LCD Mackie 2 × 56: solo las celdas que cambian llegan a UI y RS485
+    McuLcd mcuLcd;
 
     static uint16_t fadersAtMinMask = 0;
     static unsigned long firstFaderMinTime = 0;
@@ -65,133 +78,142 @@ void tickCalibracion() {
     }
 }
 
+// ─── Salida USB-MIDI (lib/imakie_midi/imakie_miditx.h) ──────
+// Una sola cola para todos los productores; el task MIDI la vacía con
+// MidiTx::flush() una vez por vuelta y es el único que escribe en USB.
+
+namespace {
+    MidiTxQueue<midiEventPacket_t, MIDI_TX_QUEUE_LEN, MidiTxSpinlock> midiTx;
+    TaskHandle_t midiTxTask = nullptr;          // quien hace flush()
+
+    void writeUsb(const midiEventPacket_t& p) {
+        midiEventPacket_t pkt = p;
+        MIDI.writePacket(&pkt);
+    }
+}
+
+namespace MidiTx {
+
+void flush() {
+    midiTxTask = xTaskGetCurrentTaskHandle();
+    midiTx.flush(writeUsb);
+}
+
+void printStats() {
+    const auto& st = midiTx.stats();
+    log_i("[MIDI TX] push:%u coalesced:%u sent:%u flushes:%u (%.1f/flush) direct:%u drop:%u",
+          st.pushed, st.coalesced, st.sent, st.flushes,
+          st.flushes ? (float)(st.sent - st.direct) / st.flushes : 0.0f, st.direct, st.dropped);
+}
+
+} // namespace MidiTx
+
+// Convierte a paquetes USB-MIDI (cable 0) y los encola. Seguro desde
+// cualquier task. Un SysEx nunca se trunca: si no cabe, el task MIDI lo
+// escribe directo tras vaciar la cola; otro task espera a que la vacíe.
 void sendMIDIBytes(const byte* data, size_t len) {
     log_v("[MIDI OUT] Enviando %d bytes", len);
 
     if (data[0] == 0xF0) {
-        size_t i = 0;
-        while (i < len) {
-            midiEventPacket_t packet;
-            size_t remaining = len - i;
-            if (remaining >= 3 && (i + 3) < len) {
-                packet.header = 0x04;
-                packet.byte1  = data[i];
-                packet.byte2  = data[i+1];
-                packet.byte3  = data[i+2];
-                i += 3;
-            } else if (remaining == 1) {
-                packet.header = 0x05;
-                packet.byte1  = data[i];
-                packet.byte2  = 0x00;
-                packet.byte3  = 0x00;
-                i += 1;
-            } else if (remaining == 2) {
-                packet.header = 0x06;
-                packet.byte1  = data[i];
-                packet.byte2  = data[i+1];
-                packet.byte3  = 0x00;
-                i += 2;
-            } else {
-                packet.header = 0x07;
-                packet.byte1  = data[i];
-                packet.byte2  = data[i+1];
-                packet.byte3  = data[i+2];
-                i += 3;
+        const bool consumer = xTaskGetCurrentTaskHandle() == midiTxTask;
+        for (uint32_t waited = 0; !midiTx.pushSysEx(data, len, consumer, writeUsb); waited++) {
+            if (waited >= MIDI_TX_SYSEX_WAIT_MS) {
+                midiTx.countDropped(midiSysExPackets(len));
+                log_e("[MIDI OUT] SysEx de %u B descartado: la cola no se vacía", (unsigned)len);
+                return;
             }
-            MIDI.writePacket(&packet);
+            vTaskDelay(1);
         }
         return;
     }
 
-    if (len == 3) {
-        byte status  = data[0] & 0xF0;
-        byte channel = (data[0] & 0x0F) + 1;
-        byte byte1   = data[1];
-        byte byte2   = data[2];
-        switch (status) {
-            case 0x90:
-                if (byte2 > 0) MIDI.noteOn(byte1, byte2, channel);
-                else           MIDI.noteOff(byte1, 0, channel);
-                break;
-            case 0x80:
-                MIDI.noteOff(byte1, byte2, channel);
-                break;
-            case 0xB0:
-                MIDI.controlChange(byte1, byte2, channel);
-                break;
-            case 0xE0: {
-                midiEventPacket_t packet;
-                packet.header = 0x0E | ((data[0] & 0x0F) << 4);
-                packet.byte1  = data[0];
-                packet.byte2  = data[1];
-                packet.byte3  = data[2];
-                MIDI.writePacket(&packet);
-                break;
-            }
-            default:
-                log_d("[MIDI OUT] Mensaje no soportado: 0x%02X", status);
-                break;
-        }
+    midiEventPacket_t packet;
+    if (!midiPackMessage(data, len, packet)) {
+        log_d("[MIDI OUT] Mensaje no soportado: 0x%02X", data[0] & 0xF0);
+        return;
     }
+    midiTx.push(packet);
 }
 
+// ─── Entrada USB-MIDI (lib/imakie_midi) ─────────────────────
+
 void processMidiByte(byte b) {
-    if (b >= 0xF8) return;
+    midiIn.push(b);
+}
 
-    if (b & 0x80) {
-        if (b == 0xF0) {
-            in_sysex = true;
-            midi_idx = 0;
-            return;
-        }
-        if (b == 0xF7) {
-            if (in_sysex) { in_sysex = false; processMackieSysEx(midi_buffer, midi_idx); }
-            return;
-        }
-        if (in_sysex) {
-            in_sysex = false;
-        }
-        last_status_byte = b;
-        midi_idx = 0;
-        return;
+void processMidiBytes(const byte* data, size_t len) {
+    midiIn.push(data, len);
+}
+
+void processMidiPacket(const uint8_t* pkt) {
+    midiIn.pushPacket(pkt);
+}
+
+namespace {
+
+void onMidiMessage(void*, uint8_t status, uint8_t d1, uint8_t d2) {
+    switch (status & 0xF0) {
+        case 0x90: case 0x80: processNote(status, d1, d2); break;
+        case 0xD0: processChannelPressure(status & 0x0F, d1); break;
+        case 0xB0: processControlChange(status & 0x0F, d1, d2); break;
+        case 0xE0: processPitchBend(status & 0x0F, (d2 << 7) | d1); break;
+        default: break;
     }
+}
 
-    if (in_sysex) {
-        if (midi_idx < (int)sizeof(midi_buffer)) midi_buffer[midi_idx++] = b;
-        return;
+// Celdas cambiadas del LCD → fila 0: nombre de pista hacia el S2.
+// La fila 1 (valor del parámetro) no tiene dónde mostrarse en el S3.
+void lcdApply(bool partial) {
+    uint16_t mask = mcuLcd.takeDirty(partial) & ((1u << MCU_LCD_STRIPS) - 1);   // fila 0
+    while (mask) {
+        const uint8_t t = __builtin_ctz(mask);
+        mask &= mask - 1;
+        char text[MCU_LCD_CELL_W + 1];
+        mcuLcd.cell(0, t, text);
+        if (trackNames[t] == text) continue;
+        trackNames[t] = text;
+        rs485.setTrackName(t + 1, text);
     }
+}
 
-    if (last_status_byte != 0) {
-        if (midi_idx >= 250) midi_idx = 0;
-        midi_buffer[midi_idx++] = b;
+void onMidiSysEx(void*, const uint8_t* data, uint8_t n, uint8_t flags) {
+    if (flags & MIDI_SYSEX_START) {
+        sysex_len      = 0;
+        sysex_overflow = false;
+        sysex_lcd      = false;
+    }
 
-        byte cmd_type = last_status_byte & 0xF0;
-        int msg_len_expected = 0;
-        switch (cmd_type) {
-            case 0xC0: case 0xD0: msg_len_expected = 1; break;
-            case 0xF0: msg_len_expected = 0; break;
-            default:   msg_len_expected = 2; break;
+    if (sysex_lcd) {
+        mcuLcd.feed(data, n);
+    } else {
+        int k = n;
+        if (sysex_len + k > (int)sizeof(sysex_buf)) { k = sizeof(sysex_buf) - sysex_len; sysex_overflow = true; }
+        memcpy(sysex_buf + sysex_len, data, k);
+        sysex_len += k;
+        // Cabecera completa en el primer trozo (CHUNK ≥ 8): 00 00 66 14 12 offset
+        if ((flags & MIDI_SYSEX_START) && sysex_len >= 6 &&
+            sysex_buf[3] == 0x14 && sysex_buf[4] == 0x12) {
+            sysex_lcd = true;
+            mcuLcd.begin(sysex_buf[5]);
+            mcuLcd.feed(sysex_buf + 6, sysex_len - 6);
         }
+    }
 
-        if (midi_idx == msg_len_expected) {
-            byte data1 = midi_buffer[0];
-            byte data2 = (msg_len_expected > 1) ? midi_buffer[1] : 0;
-            switch (cmd_type) {
-                case 0x90: case 0x80: processNote(last_status_byte, data1, data2); break;
-                case 0xD0: processChannelPressure(last_status_byte & 0x0F, data1); break;
-                case 0xB0: processControlChange(last_status_byte & 0x0F, data1, data2); break;
-                case 0xE0: {
-                    int bendValue = (data2 << 7) | data1;
-                    processPitchBend(last_status_byte & 0x0F, bendValue);
-                    break;
-                }
-                default: break;
-            }
-            midi_idx = 0;
-        }
+    const bool last = flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT);
+    if (sysex_lcd) {
+        lcdApply(!last);                            // celda a medias: espera al siguiente trozo
+        return;
+    }
+    if (!last) return;
+    if ((flags & MIDI_SYSEX_END) && !sysex_overflow) {
+        processMackieSysEx(sysex_buf, sysex_len);
+    } else {
+        log_w("[MIDI IN] SysEx descartado (%s, %d B)", sysex_overflow ? "demasiado largo" : "cortado", sysex_len);
     }
 }
 
+} // namespace
+
 
 void processControlChange(byte channel, byte controller, byte value) {
     log_d("CC CH=%d, CC=%d, Val=0x%02X", channel, controller, value);
@@ -215,39 +237,33 @@ void processControlChange(byte channel, byte controller, byte value) {
 
 }
 
-String formatTimecodeString() {
-    char formatted[14];
-    int pos = 0;
+TimecodeText formatTimecodeString() {
+    TimecodeText result;
     for (int i = 0; i < 10; i++) {
         byte b = timeCodeChars_clean[i];
         char c = b & 0x7F;
         if (c == 0 || c < 32) c = ':';
         if (c == ';') c = ':';
-        formatted[pos++] = c;
-        if (b & 0x80) formatted[pos++] = ':';
+        result += c;
+        if (b & 0x80) result += ':';
     }
-    formatted[pos] = '\0';
-    String result = String(formatted);
     result.trim();
-    return (result.length() == 0) ? "--:--:--:--" : result;
+    return result.empty() ? TimecodeText("--:--:--:--") : result;
 }
 
-String formatBeatString() {
-    char formatted[14];
-    int pos = 0;
+TimecodeText formatBeatString() {
+    TimecodeText result;
     for (int i = 0; i < 10; i++) {
         byte b = beatsChars_clean[i];
         char c = b & 0x7F;
         if (c == 0 || c < 32) c = '.';
         if (c == ';') c = '.';
-        formatted[pos++] = c;
-        if (b & 0x80) formatted[pos++] = '.';
+        result += c;
+        if (b & 0x80) result += '.';
     }
-    formatted[pos] = '\0';
-    String result = String(formatted);
     result.trim();
-    if (result.length() == 0) return "  1.  1.  1.  1";
-    while ((int)result.length() < 13) result += " ";
+    if (result.empty()) return TimecodeText("  1.  1.  1.  1");
+    result.padRight(13);
     return result;
 }
 
@@ -336,6 +352,8 @@ void processMackieSysEx(byte* payload, int len) {
             g_logicConnected     = 0;   // Todos los slaves recibirán connected=0
             fadersAtMinMask      = 0;
             firstFaderMinTime    = 0;
+            for (int i = 0; i < 8; i++) trackNames[i] = "";
+            mcuLcd.reset();             // al reconectar, los nombres se vuelven a enviar
 
             // Inicia secuencia de notificación a slaves
             rs485.beginDisconnectSequence();
@@ -349,39 +367,9 @@ void processMackieSysEx(byte* payload, int len) {
 
         case 0x12: {
             if (len < 6) break;
-            byte startOffset = payload[5];
-            int  text_len    = len - 6;
-            if (text_len <= 0) break;
-
-            auto trimRight = [](char* s) {
-                for (int j = 6; j >= 0; j--) {
-                    if (s[j] == ' ' || s[j] == '\0') s[j] = '\0';
-                    else break;
-                }
-            };
-
-            char nameBufs[8][8] = {};
-            bool nameChanged[8] = {};
-
-            for (int t = 0; t < 8; t++) {
-                strncpy(nameBufs[t], trackNames[t].c_str(), 7);
-                nameBufs[t][7] = '\0';
-            }
-
-            for (int i = 0; i < text_len; i++) {
-                byte offset = startOffset + i;
-                if (offset >= 56) break;
-                nameBufs[offset / 7][offset % 7] = (char)payload[6 + i];
-                nameChanged[offset / 7] = true;
-            }
-
-            for (int t = 0; t < 8; t++) {
-                if (!nameChanged[t]) continue;
-                trimRight(nameBufs[t]);
-                if (trackNames[t] == nameBufs[t]) continue;
-                trackNames[t] = String(nameBufs[t]);
-                rs485.setTrackName(t + 1, nameBufs[t]);
-            }
+            mcuLcd.begin(payload[5]);
+            mcuLcd.feed(payload + 6, len - 6);
+            lcdApply(false);
             break;
         }
 
@@ -392,7 +380,7 @@ void processMackieSysEx(byte* payload, int len) {
             char c2 = (b2 >= 32 && b2 <= 126) ? (char)b2 : '?';
             char assign_buf[3] = {c1, c2, '\0'};
             if (assignmentString != assign_buf) {
-                assignmentString = String(assign_buf);
+                assignmentString = assign_buf;
             }
             break;
         }
@@ -518,31 +506,26 @@ void processNote(byte status, byte note, byte velocity) {
         AutoMode mode = modeMap[note - 74];
         g_channelAutoMode[g_selectedChannel] = (uint8_t)mode;
         rs485.setAutoMode(g_selectedChannel + 1, mode);
-        for (int key = 0; key < 32; key++) {
-            if (MIDI_NOTES_PG1[key] != 0x00 && MIDI_NOTES_PG1[key] == note) {
-                btnStatePG1[key]  = is_on;
-                btnFlashPG1[key]  = is_flashing;
-            }
+        const uint8_t key = MCU_NOTES.keyOf(MCU_PG1, note);
+        if (key != MCU_NO_KEY) {
+            btnStatePG1[key] = is_on;
+            btnFlashPG1[key] = is_flashing;
         }
         return;
     }
 
     bool stateChanged = false;
-    for (int key = 0; key < 32; key++) {
-        if (MIDI_NOTES_PG1[key] != 0x00 && MIDI_NOTES_PG1[key] == note) {
-            if (btnStatePG1[key] != is_on || btnFlashPG1[key] != is_flashing) {
-                btnStatePG1[key]  = is_on;
-                btnFlashPG1[key]  = is_flashing;
-                stateChanged = true;
-            }
-        }
-        if (MIDI_NOTES_PG2[key] != 0x00 && MIDI_NOTES_PG2[key] == note) {
-            if (btnStatePG2[key] != is_on || btnFlashPG2[key] != is_flashing) {
-                btnStatePG2[key]  = is_on;
-                btnFlashPG2[key]  = is_flashing;
-                stateChanged = true;
-            }
-        }
+    const uint8_t key1 = MCU_NOTES.keyOf(MCU_PG1, note);
+    if (key1 != MCU_NO_KEY && (btnStatePG1[key1] != is_on || btnFlashPG1[key1] != is_flashing)) {
+        btnStatePG1[key1] = is_on;
+        btnFlashPG1[key1] = is_flashing;
+        stateChanged = true;
+    }
+    const uint8_t key2 = MCU_NOTES.keyOf(MCU_PG2, note);
+    if (key2 != MCU_NO_KEY && (btnStatePG2[key2] != is_on || btnFlashPG2[key2] != is_flashing)) {
+        btnStatePG2[key2] = is_on;
+        btnFlashPG2[key2] = is_flashing;
+        stateChanged = true;
     }
    
     Transporte::setLedByNote(note, is_on);  // ← AÑADIDO
@@ -566,7 +549,7 @@ void processPitchBend(byte channel, int bendValue) {
                 fadersAtMinMask      = 0;
                 firstFaderMinTime    = 0;
                 for (uint8_t i = 1; i <= NUM_SLAVES; i++)
-                    rs485.setFaderTarget(i, rs485.getChannel(i).faderPos);
+                    rs485.setFaderTarget(i, rs485.getSlave(i).faderPos);
                 g_switchToOffline = true;
                 return;
             }
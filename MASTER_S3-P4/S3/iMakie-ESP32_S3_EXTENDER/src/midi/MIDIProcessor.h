@@ -24,8 +24,8 @@ extern bool btnStatePG1[32];
 extern bool btnStatePG2[32];
 extern bool btnFlashPG1[32];
 extern bool btnFlashPG2[32];
-extern String trackNames[8];
-extern String assignmentString;
+extern TrackName trackNames[8];
+extern AssignText assignmentString;
 extern uint8_t vpotValues[8];
 extern bool needsTOTALRedraw;
 extern bool needsMainAreaRedraw;
@@ -37,6 +37,8 @@ extern bool needsTimecodeRedraw;
 bool isLogicConnected();
 void sendMIDIBytes(const byte* data, size_t len);
 void processMidiByte(byte b);
+void processMidiBytes(const byte* data, size_t len);
+void processMidiPacket(const uint8_t* pkt);     // paquete USB-MIDI de 4 bytes
 void processMackieSysEx(byte* payload, int len);
 void processNote(byte status, byte note, byte velocity);
 void handleMcuHandshake(byte* challenge_code);
@@ -45,7 +47,13 @@ void processControlChange(byte channel, byte controller, byte value);
 void processPitchBend(byte channel, int bendValue);
 void checkMidiTimeout();   // ← AÑADIR
 void tickCalibracion();    // ← AÑADIR
-String formatBeatString();
-String formatTimecodeString();
+TimecodeText formatBeatString();
+TimecodeText formatTimecodeString();
+
+// Salida USB-MIDI: sendMIDIBytes() encola desde cualquier task
+namespace MidiTx {
+    void flush();          // solo task MIDI, una vez por vuelta
+    void printStats();
+}
 
 extern uint8_t g_channelAutoMode[8];
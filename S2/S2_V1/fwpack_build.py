@@ -0,0 +1,80 @@
+Import("env")
+# ============================================================
+#  fwpack_build.py — iMakie PTxx Track S2
+#  Tras firmware.bin: firmware.imz (LZ) y, si hay base desplegada,
+#  firmware.imd (delta contra ella) con tools/fwpack.
+#  pio run -t fwdeploy → copia ambos a la data/ del P4 (actualización
+#  por el bus RS485) y fija firmware.bin como base del próximo delta.
+#  upload_ota.py / ota_upload.sh también fijan la base al subir por WiFi.
+# ============================================================
+import os, shutil, subprocess
+
+project_dir = env.subst("$PROJECT_DIR")
+root        = os.path.normpath(os.path.join(project_dir, "..", ".."))
+tool_src    = os.path.join(root, "tools", "fwpack", "fwpack.cpp")
+tool        = os.path.join(root, "tools", "fwpack", "fwpack")
+tool_inc    = os.path.join(root, "lib", "imakie_protocol", "src")
+base        = os.path.join(project_dir, ".pio", "deployed", "firmware.bin")
+p4_data     = os.path.join(root, "MASTER_S3-P4", "P4", "data")
+
+def _tool():
+    deps = [tool_src, os.path.join(tool_inc, "imakie_fwpack.h")]
+    if os.path.exists(tool) and os.path.getmtime(tool) >= max(map(os.path.getmtime, deps)):
+        return tool
+    print("[fwpack] Compilando tools/fwpack...")
+    r = subprocess.run(["c++", "-std=c++17", "-O2", "-I", tool_inc, tool_src, "-o", tool])
+    return tool if r.returncode == 0 else None
+
+def _outputs():
+    build = env.subst("$BUILD_DIR")
+    return (os.path.join(build, "firmware.bin"),
+            os.path.join(build, "firmware.imz"),
+            os.path.join(build, "firmware.imd"))
+
+# El S2 guarda la IMZ1 al final de su partición OTA y descomprime hacia el
+# principio (BusOta.cpp): las dos tienen que caber a la vez
+def _fits(pack, fw):
+    csv = os.path.join(project_dir, env.GetProjectOption("board_build.partitions"))
+    with open(csv) as f:
+        rows = [[x.strip() for x in l.split(",")] for l in f if not l.startswith("#")]
+    part  = next(int(r[4], 0) for r in rows if len(r) >= 5 and r[2] == "ota_0")
+    stage = (part - os.path.getsize(pack)) & ~0xFFF
+    return (os.path.getsize(fw) + 0xFFF) & ~0xFFF <= stage
+
+def fwpack(source, target, env):
+    fw, imz, imd = _outputs()
+    t = _tool()
+    if not t:
+        print("[fwpack] Sin compilador de host: solo firmware.bin")
+        return
+    for f in (imz, imd):
+        if os.path.exists(f): os.remove(f)
+    subprocess.run([t, "lz", fw, imz])
+    if os.path.exists(base):
+        subprocess.run([t, "delta", base, fw, imd])
+    else:
+        print("[fwpack] Sin base desplegada (.pio/deployed): sin delta")
+
+def fwdeploy(*args, **kwargs):
+    fw, imz, imd = _outputs()
+    os.makedirs(p4_data, exist_ok=True)
+    # P4 abre RS485_FW_PATH / RS485_FW_DELTA_PATH y mira el contenido, no la extensión
+    full = imz if os.path.exists(imz) and _fits(imz, fw) else fw
+    shutil.copyfile(full, os.path.join(p4_data, "s2_firmware.bin"))
+    print(f"[fwpack] Imagen completa: {os.path.basename(full)}")
+    delta = os.path.join(p4_data, "s2_firmware.imd")
+    if os.path.exists(imd) and _fits(imd, fw):
+        shutil.copyfile(imd, delta)
+    elif os.path.exists(delta):
+        os.remove(delta)                     # delta de otra base: peor que nada
+    mark_deployed(fw)
+    print(f"[fwpack] Copiado a {p4_data} → pio run -t uploadfs en el P4")
+
+def mark_deployed(fw):
+    os.makedirs(os.path.dirname(base), exist_ok=True)
+    shutil.copyfile(fw, base)
+    print(f"[fwpack] Base para el próximo delta: {base}")
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", fwpack)
+env.AddCustomTarget("fwdeploy", "$BUILD_DIR/${PROGNAME}.bin", fwdeploy,
+                    title="FW deploy", description="firmware.imz/.imd → data/ del P4")
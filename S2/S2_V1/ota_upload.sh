@@ -38,6 +38,9 @@ python3 "$ESPOTA" \
 
 if [ $? -eq 0 ]; then
     echo "[OTA] Subida completada OK"
+    # Base para el próximo delta (fwpack_build.py)
+    mkdir -p "$SCRIPT_DIR/.pio/deployed"
+    cp "$FIRMWARE" "$SCRIPT_DIR/.pio/deployed/firmware.bin"
 else
     echo "[OTA] Error en la subida"
     exit 1
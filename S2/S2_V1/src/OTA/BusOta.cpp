@@ -0,0 +1,265 @@
+// ============================================================
+//  BusOta.cpp  —  iMakie PTxx Track S2
+//  Partición OTA inactiva + bitmap de bloques pendientes.
+//  esp_ota_write_with_offset(): los reenvíos llegan fuera de orden.
+//
+//  IMZ1: los bloques (también fuera de orden) van a la cola de la
+//  partición [_stageAt, fin); COMMIT los lee en orden, FwUnpack
+//  escribe la imagen desde el offset 0 con esp_ota_write y, si es
+//  delta, lee la base de la partición que se está ejecutando.
+//  RAM: ventana del decoder (4 KB por defecto), nunca la imagen.
+// ============================================================
+#include "BusOta.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_app_desc.h>
+#include <imakie_fwpack.h>
+
+namespace BusOta {
+
+namespace {
+    const esp_partition_t* _part    = nullptr;
+    esp_ota_handle_t       _ota     = 0;
+    bool                   _otaOpen = false;
+
+    FwState   _state    = FW_IDLE;
+    uint16_t  _session  = 0;
+    uint8_t   _format   = FWPACK_RAW;
+    uint32_t  _stageAt  = 0;            // IMZ1: inicio de la copia en la cola de la partición
+    uint32_t  _size     = 0;
+    uint16_t  _blocks   = 0;
+    uint16_t  _missing  = 0;
+    uint8_t*  _pending  = nullptr;      // bit = bloque aún no escrito
+    uint8_t   _lastPct  = 0;
+    volatile bool _reboot = false;
+
+    uint32_t  _written     = 0;
+    uint32_t  _duplicates  = 0;
+    uint32_t  _writeErrors = 0;
+
+    void _close() {
+        if (_otaOpen) esp_ota_abort(_ota);
+        _otaOpen = false;
+        free(_pending);
+        _pending = nullptr;
+    }
+
+    void _begin(const uint8_t* p, size_t n, uint16_t session) {
+        uint32_t size   = rs485_get32(&p[0]);
+        uint16_t blocks = rs485_get16(&p[4]);
+        const uint8_t* fwId = &p[6];
+        const bool   packed = n == FW_BEGIN_PACK_LEN && p[14] != FWPACK_RAW;
+        const uint8_t* baseId = &p[15];
+
+        // BEGIN se repite: la misma sesión no reinicia la transferencia
+        if (session == _session && _state != FW_IDLE) return;
+        _close();
+        _session = session;
+
+        const uint8_t* running = esp_app_get_description()->app_elf_sha256;
+        if (memcmp(running, fwId, FW_ID_LEN) == 0) {
+            _state = FW_UP_TO_DATE;
+            Serial.printf("[BUSOTA] Sesión %04X: imagen ya instalada\n", session);
+            return;
+        }
+        // Delta contra otra base: el master sigue con la imagen completa
+        if (packed && p[14] == FWPACK_DELTA && memcmp(running, baseId, FW_ID_LEN) != 0) {
+            _state = FW_ERROR;
+            Serial.printf("[BUSOTA] Sesión %04X: delta para otra base\n", session);
+            return;
+        }
+
+        _part = esp_ota_get_next_update_partition(nullptr);
+        if (!_part || size == 0 || size > _part->size ||
+            blocks != (size + FW_BLOCK_LEN - 1) / FW_BLOCK_LEN) {
+            _state = FW_ERROR;
+            Serial.printf("[BUSOTA] Sesión %04X: imagen %u B no cabe / cabecera incoherente\n",
+                          session, size);
+            return;
+        }
+
+        // Borra 'size' bytes de la partición: segundos, el master espera con QUERY.
+        // IMZ1: solo la cola donde se guarda; la imagen se borra en COMMIT
+        uint32_t t0 = millis();
+        _format  = packed ? p[14] : FWPACK_RAW;
+        _stageAt = packed ? (_part->size - size) & ~(SPI_FLASH_SEC_SIZE - 1) : 0;
+        esp_err_t err = packed
+            ? esp_partition_erase_range(_part, _stageAt, _part->size - _stageAt)
+            : esp_ota_begin(_part, size, &_ota);
+        if (err != ESP_OK) {
+            _state = FW_ERROR;
+            Serial.printf("[BUSOTA] Borrado falló: %s\n", esp_err_to_name(err));
+            return;
+        }
+        _otaOpen = !packed;
+
+        size_t mapLen = (blocks + 7) / 8;
+        _pending = (uint8_t*)malloc(mapLen);
+        if (!_pending) { _close(); _state = FW_ERROR; return; }
+        memset(_pending, 0xFF, mapLen);
+
+        _size    = size;
+        _blocks  = blocks;
+        _missing = blocks;
+        _lastPct = 0;
+        _written = _duplicates = _writeErrors = 0;
+        _state   = FW_RECEIVING;
+        Serial.printf("[BUSOTA] Sesión %04X: %u B%s, %u bloques → %s (borrado %lu ms)\n",
+                      session, size, packed ? (_format == FWPACK_DELTA ? " delta" : " LZ") : "",
+                      blocks, _part->label, millis() - t0);
+    }
+
+    void _data(const uint8_t* p, size_t n) {
+        if (_state != FW_RECEIVING) return;
+        uint16_t block = rs485_get16(p);
+        const uint8_t* data = p + 2;
+        n -= 2;
+
+        uint32_t offset = (uint32_t)block * FW_BLOCK_LEN;
+        uint32_t expect = _size - offset < FW_BLOCK_LEN ? _size - offset : FW_BLOCK_LEN;
+        if (block >= _blocks || n != expect) return;
+        if (!(_pending[block >> 3] & (1 << (block & 7)))) { _duplicates++; return; }
+
+        esp_err_t err = _format == FWPACK_RAW
+            ? esp_ota_write_with_offset(_ota, data, n, offset)
+            : esp_partition_write(_part, _stageAt + offset, data, n);
+        if (err != ESP_OK) {
+            _writeErrors++;                     // sigue pendiente → saldrá en el NACK
+            return;
+        }
+        _pending[block >> 3] &= ~(1 << (block & 7));
+        _written++;
+        if (--_missing == 0) _state = FW_COMPLETE;
+
+        uint8_t pct = (uint32_t)(_blocks - _missing) * 100 / _blocks;
+        if (pct / 10 != _lastPct / 10) Serial.printf("[BUSOTA] %u%%\n", pct);
+        _lastPct = pct;
+    }
+
+    bool _unpackWrite(void*, const uint8_t* src, size_t n) {
+        return esp_ota_write(_ota, src, n) == ESP_OK;
+    }
+
+    bool _unpackBase(void*, uint32_t off, uint8_t* dst, size_t n) {
+        return esp_partition_read(esp_ota_get_running_partition(), off, dst, n) == ESP_OK;
+    }
+
+    // IMZ1 guardada en la cola → imagen desde el offset 0, en streaming
+    esp_err_t _unpack() {
+        uint8_t buf[256];
+        FwPackHeader h;
+        if (esp_partition_read(_part, _stageAt, buf, FWPACK_HEADER_LEN) != ESP_OK ||
+            !fwpack_parseHeader(buf, FWPACK_HEADER_LEN, h) || h.format != _format)
+            return ESP_ERR_INVALID_ARG;
+        // La imagen (borrado por sectores) no puede pisar lo guardado
+        uint32_t outEnd = (h.outSize + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1);
+        if (outEnd > _stageAt) return ESP_ERR_INVALID_SIZE;
+
+        uint8_t* window = (uint8_t*)malloc(1u << h.windowBits);
+        if (!window) return ESP_ERR_NO_MEM;
+        esp_err_t err = esp_ota_begin(_part, h.outSize, &_ota);
+        if (err != ESP_OK) { free(window); return err; }
+        _otaOpen = true;
+
+        uint32_t t0 = millis();
+        FwUnpack un;
+        un.begin(h, window, _unpackWrite, nullptr, _unpackBase, esp_ota_get_running_partition()->size);
+        FwUnpackStatus st = FwUnpackStatus::OK;
+        for (uint32_t off = FWPACK_HEADER_LEN; off < _size && st == FwUnpackStatus::OK; off += sizeof(buf)) {
+            size_t k = _size - off < sizeof(buf) ? _size - off : sizeof(buf);
+            if (esp_partition_read(_part, _stageAt + off, buf, k) != ESP_OK) { st = FwUnpackStatus::BASE_ERROR; break; }
+            st = un.push(buf, k);
+            if ((off & 0x3FFF) < sizeof(buf)) vTaskDelay(1);   // task responder: no matar de hambre al resto
+        }
+        if (st == FwUnpackStatus::OK) st = un.finish();
+        free(window);
+        Serial.printf("[BUSOTA] Descomprimido %u → %u B en %lu ms (%s)\n", _size, un.produced(),
+                      millis() - t0, st == FwUnpackStatus::DONE ? "CRC OK" : "ERROR");
+        return st == FwUnpackStatus::DONE ? ESP_OK : ESP_ERR_INVALID_CRC;
+    }
+
+    // esp_ota_end valida la imagen (checksum + SHA-256) antes de marcarla
+    void _commit() {
+        if (_state != FW_COMPLETE) return;
+        if (_format != FWPACK_RAW) {
+            esp_err_t err = _unpack();
+            if (err != ESP_OK) {
+                _close();
+                _state = FW_ERROR;
+                Serial.printf("[BUSOTA] COMMIT: %s\n", esp_err_to_name(err));
+                return;
+            }
+        }
+        esp_err_t err = esp_ota_end(_ota);
+        _otaOpen = false;
+        if (err == ESP_OK) err = esp_ota_set_boot_partition(_part);
+        _state = (err == ESP_OK) ? FW_VERIFIED : FW_ERROR;
+        free(_pending);
+        _pending = nullptr;
+        Serial.printf("[BUSOTA] COMMIT: %s\n", err == ESP_OK ? "imagen verificada" : esp_err_to_name(err));
+    }
+}
+
+bool available() {
+    return esp_ota_get_next_update_partition(nullptr) != nullptr;
+}
+
+bool onFrame(const uint8_t* buf, size_t len, uint8_t myId, uint8_t* out, size_t& outLen) {
+    const uint8_t  op      = buf[2];
+    const uint16_t session = rs485_get16(&buf[3]);
+    const uint8_t* body    = &buf[FW_HEADER_LEN];
+    const size_t   bodyLen = len - FW_HEADER_LEN - 2;
+
+    if (op == FW_OP_BEGIN) {
+        // Con REBOOT pendiente un BEGIN nuevo borraría la imagen ya verificada
+        if (!_reboot && (bodyLen == FW_BEGIN_LEN || bodyLen == FW_BEGIN_PACK_LEN))
+            _begin(body, bodyLen, session);
+        return false;
+    }
+
+    // QUERY: estado + ventana NACK desde 'from'. Otra sesión (S2 reiniciado,
+    // BEGIN perdido) se ve como FW_IDLE con la sesión propia
+    if (op == FW_OP_QUERY) {
+        if (bodyLen != 3 || body[0] != myId) return false;
+        const bool mine = (session == _session);
+        uint8_t  win[FW_NACK_BYTES];
+        uint16_t base = 0;
+        size_t   n    = (mine && _state == FW_RECEIVING)
+                      ? rs485_fwNackWindow(_pending, _blocks, rs485_get16(&body[1]), base, win) : 0;
+        outLen = rs485_encodeFwStatus(out, myId, mine ? _state : FW_IDLE, _session,
+                                      (mine && _state == FW_RECEIVING) ? _missing : 0, base, win, n);
+        return true;
+    }
+
+    if (session != _session) return false;
+
+    switch (op) {
+        case FW_OP_DATA:
+            if (bodyLen > 2) _data(body, bodyLen);
+            return false;
+        case FW_OP_COMMIT:
+            _commit();
+            return false;
+        case FW_OP_REBOOT:
+            if (_state == FW_VERIFIED) _reboot = true;
+            return false;
+        case FW_OP_ABORT:
+            if (_state == FW_RECEIVING || _state == FW_COMPLETE) {
+                _close();
+                _state = FW_IDLE;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+bool rebootPending() { return _reboot; }
+
+void printStats() {
+    if (_state == FW_IDLE) return;
+    Serial.printf("[BUSOTA] state:%u session:%04X missing:%u/%u written:%u dup:%u write_err:%u\n",
+                  _state, _session, _missing, _blocks, _written, _duplicates, _writeErrors);
+}
+
+} // namespace BusOta
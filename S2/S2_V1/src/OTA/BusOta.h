@@ -0,0 +1,29 @@
+#pragma once
+// ============================================================
+//  BusOta.h  —  iMakie PTxx Track S2
+//
+//  Actualización de firmware por RS485 (tramas 0xAF del master).
+//  Alternativa a OtaManager para toda la flota a la vez: el master
+//  difunde bloques, cada S2 los escribe en su partición OTA inactiva
+//  (en cualquier orden) y contesta QUERY con el bitmap de los que
+//  le faltan. COMMIT verifica la imagen; REBOOT arranca con ella.
+//  Imágenes IMZ1 (LZ / delta, imakie_fwpack.h): se guardan tal cual
+//  al final de la partición y COMMIT las descomprime en streaming.
+//
+//  Lo llama el task responder de RS485 — nunca desde loop().
+// ============================================================
+#include <Arduino.h>
+#include "../protocol.h"
+
+namespace BusOta {
+
+    bool available();                   // hay partición OTA inactiva → SLAVE_CAP_FW
+
+    // Trama 0xAF ya validada. true = responder 'out' (QUERY a myId)
+    bool onFrame(const uint8_t* buf, size_t len, uint8_t myId,
+                 uint8_t* out, size_t& outLen);
+
+    bool rebootPending();               // REBOOT tras COMMIT OK: loop() reinicia
+    void printStats();
+
+} // namespace BusOta
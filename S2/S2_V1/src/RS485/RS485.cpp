@@ -1,9 +1,16 @@
 // ============================================================
 //  RS485.cpp  –  Slave ESP32-S2
-//  onReceive (IRAM_ATTR) → buffer circular → parseo en loop()
+//  onReceive → buffer circular → task responder (prioridad alta):
+//  parsea y contesta con la respuesta pre-construida por loop().
+//  La latencia de respuesta ya no depende de display/neopixels.
+//  Trama de grupo (0xAE): responde en su ranura TDMA, no al instante.
+//  Firmware (0xAF): se delega en BusOta; solo QUERY tiene respuesta.
+//  onReceive solo en RX timeout: cada lectura empieza tras un silencio
+//  de RS485_RX_IDLE_SYM símbolos, que cierra cualquier trama a medias.
 // ============================================================
 #include "RS485.h"
 #include "../config.h"
+#include "../OTA/BusOta.h"
 
 
 RS485Slave rs485;
@@ -21,23 +28,176 @@ void RS485Slave::begin(uint8_t myId) {
 
     Serial1.setRxBufferSize(512);
     Serial1.begin(RS485_BAUD, SERIAL_8N1, RS485_RX_PIN, RS485_TX_PIN);
-    Serial1.onReceive([](){ rs485._onReceiveISR(); });
+    Serial1.setRxTimeout(RS485_RX_IDLE_SYM);
+    Serial1.onReceive([](){
+        rs485._onReceiveISR();
+        if (rs485._task) xTaskNotifyGive(rs485._task);
+    }, true);   // sin FIFO lleno: el driver solo pasa bytes al ring en RX timeout
 
-    Serial.printf("[RS485] Slave ID:%d RX:%d TX:%d EN:%d BAUD:%d\n",
-                     _myId, RS485_RX_PIN, RS485_TX_PIN, RS485_ENABLE_PIN, RS485_BAUD);
+#if RS485_HW_HALF_DUPLEX
+    // RTS = DE: el UART lo activa durante TX y lo suelta tras el último bit
+    _hwDE = Serial1.setPins(-1, -1, -1, RS485_ENABLE_PIN) &&
+            Serial1.setMode(UART_MODE_RS485_HALF_DUPLEX);
+    if (!_hwDE) {
+        Serial1.setMode(UART_MODE_UART);
+        pinMode(RS485_ENABLE_PIN, OUTPUT);
+        digitalWrite(RS485_ENABLE_PIN, LOW);
+    }
+#endif
+
+    Serial.printf("[RS485] Slave ID:%d RX:%d TX:%d EN:%d BAUD:%d DE:%s\n",
+                     _myId, RS485_RX_PIN, RS485_TX_PIN, RS485_ENABLE_PIN, RS485_BAUD,
+                     _hwDE ? "UART" : "GPIO");
     Serial.printf("[RS485] MasterPacket:%u bytes SlavePacket:%u bytes\n",
                      sizeof(MasterPacket), sizeof(SlavePacket));
+
+#if RS485_RESPONDER_TASK
+    if (!_task)   // begin() se repite al guardar config SAT
+        xTaskCreatePinnedToCore(_taskEntry, "RS485Resp", RS485_RESPONDER_STACK, this,
+                                RS485_RESPONDER_PRIO, &_task, 0);
+
+    // Ranuras TDMA: el envío diferido lo hace el task, y sin DE por UART
+    // el setup/hold del GPIO no cabe en la guarda del master
+    if (RS485_GROUP_SLOTS && _hwDE && !_slotTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback        = [](void*) { if (rs485._task) xTaskNotifyGive(rs485._task); };
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name            = "rs485slot";
+        esp_timer_create(&args, &_slotTimer);
+    }
+    _groupOk = RS485_GROUP_SLOTS && _hwDE && _slotTimer;
+#endif
+    _fwOk = RS485_BUS_OTA && BusOta::available();
+}
+
+void RS485Slave::_taskEntry(void* param) {
+    RS485Slave* self = static_cast<RS485Slave*>(param);
+    for (;;) {
+        // Despierta con cada RX timeout del UART; el timeout propio solo
+        // sirve para el fallback de velocidad sin tráfico
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RS485_BAUD_FALLBACK_MS / 2));
+        self->_service();
+    }
 }
 
 void RS485Slave::update() {
+#if !RS485_RESPONDER_TASK
+    _service();
+#endif
+}
+
+void RS485Slave::_service() {
     _processBuffer();
+    if (_slotPending) _serviceSlot();
+
+    // Velocidad negociada sin tráfico válido: master reiniciado o cambio
+    // fallido → volver a la base, donde el master re-anuncia la velocidad
+    if (_baudCode && millis() - _lastValidMs > RS485_BAUD_FALLBACK_MS) {
+        _setBaud(0);
+        _baudFallbacks++;
+    }
 }
 
-void RS485Slave::sendResponse(const SlavePacket& pkt) {
+void RS485Slave::_setBaud(uint8_t code) {
+    Serial1.flush();                          // respuesta en curso sale a la velocidad anterior
+    Serial1.updateBaudRate(rs485_baudRate(code, RS485_BAUD));
+    _baudCode    = code;
+    _lastValidMs = millis();
+    _slotPending = false;                     // la ranura era de la velocidad anterior
+    _rxState     = RxState::WAIT_HEADER;
+    _rxBytesGot  = 0;
+    _replayLen   = _replayPos = 0;
+}
+
+// ─── Respuesta pre-construida ────────────────────────────────
+// loop() publica el estado actual; el task lo envía sin esperar a loop.
+// Tras enviarlo, la copia armada se vacía de eventos (botones, encoder):
+// un segundo poll antes del siguiente setReply() no los duplica.
+
+bool RS485Slave::setReply(const SlavePacket& pkt) {
     SlavePacket tx  = pkt;
-    tx.header       = RS485_RESP_BYTE;
     tx.id           = _myId;
-    tx.crc          = rs485_crc8((const uint8_t*)&tx, sizeof(SlavePacket) - 1);
+    tx.encoderButton = (pkt.encoderButton & SLAVE_ENC_BUTTON) | SLAVE_CAP_DELTA | SLAVE_CAP_BCAST
+                     | SLAVE_CAP_BAUD | (_groupOk ? SLAVE_CAP_GROUP : 0) | (_fwOk ? SLAVE_CAP_FW : 0);
+
+    bool ok = false;
+    portENTER_CRITICAL(&_mux);
+    if (!_sentPending) {                      // si no, loop aún no consumió lo enviado
+        _reply      = tx;
+        _replyArmed = true;
+        rs485_encodeSlave(_replyBuf, tx);     // header + crc
+        ok = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ok;
+}
+
+bool RS485Slave::takeSent(SlavePacket& out) {
+    portENTER_CRITICAL(&_mux);
+    bool pending = _sentPending;
+    if (pending) out = _sent;
+    _sentPending = false;
+    portEXIT_CRITICAL(&_mux);
+    return pending;
+}
+
+void RS485Slave::clearReply() {
+    portENTER_CRITICAL(&_mux);
+    _replyArmed = false;
+    portEXIT_CRITICAL(&_mux);
+}
+
+MasterPacket RS485Slave::getData() {
+    portENTER_CRITICAL(&_mux);
+    MasterPacket pkt = _rxPacket;
+    _newData = false;
+    portEXIT_CRITICAL(&_mux);
+    return pkt;
+}
+
+BroadcastPacket RS485Slave::getBroadcast() {
+    portENTER_CRITICAL(&_mux);
+    BroadcastPacket pkt = _bcast;
+    _newBcast = false;
+    portEXIT_CRITICAL(&_mux);
+    return pkt;
+}
+
+void RS485Slave::_sendReply() {
+    uint8_t buf[sizeof(SlavePacket)];
+
+    portENTER_CRITICAL(&_mux);
+    bool armed = _replyArmed;
+    if (armed) {
+        memcpy(buf, _replyBuf, sizeof(buf));
+        if (!_sentPending) _sent = _reply;    // los reenvíos ya van sin eventos
+        _sentPending = true;
+
+        if (_reply.buttons & SLAVE_FLAG_CALIB_SENDING) {
+            _replyArmed = false;              // min/max: loop construye el siguiente paso
+        } else {
+            _reply.buttons       &= ~FLAG_BUTTONS_MASK;
+            _reply.encoderDelta   = 0;
+            _reply.encoderButton &= ~SLAVE_ENC_BUTTON;
+            rs485_encodeSlave(_replyBuf, _reply);
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (!armed) {
+        _noReply++;                           // el master verá timeout
+        return;
+    }
+    _transmit(buf, sizeof(SlavePacket));
+    _txCount++;
+}
+
+void RS485Slave::_transmit(const uint8_t* buf, size_t len) {
+    if (_hwDE) {
+        // Cabe en la FIFO (≤ 128 B): el UART conmuta DE y el task no espera
+        Serial1.write(buf, len);
+        return;
+    }
 
     // ════════════════════════════════════════════════════════════════════
     // TIMING CRÍTICO — RS485 requiere setup/hold de EN
@@ -51,19 +211,21 @@ void RS485Slave::sendResponse(const SlavePacket& pkt) {
 
     digitalWrite(RS485_ENABLE_PIN, HIGH);
     delayMicroseconds(50);          // ← Setup time para transceiver (30-50µs típico)
-    Serial1.write((const uint8_t*)&tx, sizeof(SlavePacket));
+    Serial1.write(buf, len);
     Serial1.flush();                // ← Espera TX completo (~180µs)
     delayMicroseconds(50);          // ← Hold time: mantener EN HIGH después de flush
     digitalWrite(RS485_ENABLE_PIN, LOW);
-
-    _rxCount++;  // reutilizamos como TX count — renombrar si hace falta
 }
 
+// Llamado en RX timeout: el primer byte leído llegó tras un silencio
 void IRAM_ATTR RS485Slave::_onReceiveISR() {
+    bool gap = true;
     while (Serial1.available()) {
         uint16_t next = (_cbHead + 1) % CB_SIZE;
         if (next != _cbTail) {
-            _cb[_cbHead] = Serial1.read();
+            _cb[_cbHead]    = Serial1.read();
+            _cbGap[_cbHead] = gap;
+            gap     = false;
             _cbHead = next;
         } else {
             Serial1.read();  // descartar: overflow
@@ -77,33 +239,93 @@ void RS485Slave::_processBuffer() {
     uint16_t head = _cbHead;
     interrupts();
 
-    while (_cbTail != head) {
-        uint8_t byte = _cb[_cbTail];
-        _cbTail = (_cbTail + 1) % CB_SIZE;
+    for (;;) {
+        uint8_t byte;
+        if (_replayPos < _replayLen) {
+            byte = _replay[_replayPos++];       // primero lo pendiente de un _resync()
+        } else if (_cbTail != head) {
+            // Silencio con una trama a medias: su header era falso (ruido,
+            // 0xAE / 0xAF con una longitud que se tragaría los polls
+            // siguientes). Se re-parsea lo recibido antes del silencio y
+            // este byte se vuelve a mirar después
+            if (_cbGap[_cbTail] && _rxState == RxState::RECEIVE_PACKET) {
+                _idleResets++;
+                _resync();
+                continue;
+            }
+            byte = _cb[_cbTail];
+            _cbTail = (_cbTail + 1) % CB_SIZE;
+        } else {
+            break;
+        }
 
         switch (_rxState) {
             case RxState::WAIT_HEADER:
-                if (byte == RS485_START_BYTE) {
+                if (_isHeader(byte)) {
                     _rxBuf[0]    = byte;
                     _rxBytesGot  = 1;
+                    _rxExpected  = rs485_frameLength(_rxBuf, 1);
                     _rxState     = RxState::RECEIVE_PACKET;
                 }
                 break;
 
             case RxState::RECEIVE_PACKET:
                 _rxBuf[_rxBytesGot++] = byte;
-                if (_rxBytesGot >= sizeof(MasterPacket)) {
-                    // Verificar CRC
-                    uint8_t crc = rs485_crc8(_rxBuf, sizeof(MasterPacket) - 1);
-                    if (crc != _rxBuf[sizeof(MasterPacket) - 1]) {
+
+                // Delta: verFields (byte 2) fija versión y longitud real.
+                // Grupo / firmware: la longitud va en el byte 1
+                if ((_rxBuf[0] == RS485_DELTA_BYTE && _rxBytesGot == 3) ||
+                    (rs485_isLongFrame(_rxBuf[0]) && _rxBytesGot == 2)) {
+                    _rxExpected = rs485_frameLength(_rxBuf, 3);
+                    if (_rxExpected == 0) {
+                        _badVersion++;
+                        _resync();
+                        break;
+                    }
+                }
+
+                if (_rxBytesGot >= _rxExpected) {
+                    if (rs485_checkFrame(_rxBuf, _rxExpected) != Rs485Status::OK) {
                         _crcErrors++;
-                        //Serial.printf("[RS485] CRC error calc=0x%02X recv=0x%02X\n",
-                        //                 crc, _rxBuf[sizeof(MasterPacket) - 1]);
+                        _resync();
+                        break;
+                    }
+                    _lastValidMs = millis();
+                    if (_rxBuf[0] == RS485_BAUD_BYTE) {
+                        if (_rxBuf[1] == RS485_BROADCAST_ID && _rxBuf[2] != _baudCode &&
+                            _rxBuf[2] < RS485_BAUD_CODES) {
+                            _setBaud(_rxBuf[2]);
+                            _cbTail = head;     // resto del buffer: velocidad anterior
+                            return;             // (_setBaud ya vació _replay)
+                        }
+                    } else if (_rxBuf[0] == RS485_BCAST_BYTE) {
+                        if (_rxBuf[1] == RS485_BROADCAST_ID) _applyBroadcast();
+                    } else if (_rxBuf[0] == RS485_GROUP_BYTE) {
+                        _applyGroup();
+                    } else if (_rxBuf[0] == RS485_FW_BYTE) {
+                        if (_applyFw()) {
+                            // Lo llegado durante el borrado / la descompresión son
+                            // QUERY viejas: contestarlas ahora chocaría con el master
+                            noInterrupts();
+                            _cbTail = _cbHead;
+                            interrupts();
+                            _rxState    = RxState::WAIT_HEADER;
+                            _rxBytesGot = 0;
+                            _replayLen  = _replayPos = 0;
+                            return;
+                        }
                     } else if (_rxBuf[1] != _myId) {
                         _wrongId++;
                     } else {
-                        memcpy(&_rxPacket, _rxBuf, sizeof(MasterPacket));
+                        // Primero la respuesta: el master está esperando
+                        _slotPending = false;
+                        _sendReply();
+                        // Delta solo sobrescribe los campos presentes: RS485Handler
+                        // sigue viendo un MasterPacket completo
+                        portENTER_CRITICAL(&_mux);
+                        rs485_applyMaster(_rxBuf, _rxPacket);
                         _newData = true;
+                        portEXIT_CRITICAL(&_mux);
                         _rxCount++;
                     }
                     _rxState    = RxState::WAIT_HEADER;
@@ -114,7 +336,115 @@ void RS485Slave::_processBuffer() {
     }
 }
 
+// Solo tramas Master → Slave (0xBB es la respuesta de otro slave)
+bool RS485Slave::_isHeader(uint8_t b) const {
+    return b == RS485_START_BYTE || b == RS485_DELTA_BYTE ||
+           b == RS485_BCAST_BYTE || b == RS485_BAUD_BYTE ||
+           (b == RS485_GROUP_BYTE && _groupOk) ||
+           (b == RS485_FW_BYTE && _fwOk);
+}
+
+// Trama rechazada (longitud, versión, CRC o cortada por un silencio): su
+// header pudo ser un 0xAA / 0xAB dentro del payload de otra (delta, grupo,
+// respuesta de otro slave) o ruido. Se descarta solo ese byte y el resto
+// vuelve al parser, así una trama real que empiece dentro de la ventana no
+// se pierde (y se contesta: el CRC es lo único que decide). Cabe en _replay:
+// la ventana nunca supera RS485_RX_MAX_LEN y pierde al menos un byte.
+void RS485Slave::_resync() {
+    const uint8_t keep = _rxBytesGot - 1;
+    const uint8_t rest = _replayLen - _replayPos;
+    memmove(&_replay[keep], &_replay[_replayPos], rest);
+    memcpy(_replay, &_rxBuf[1], keep);
+    _replayLen  = keep + rest;
+    _replayPos  = 0;
+    _rxState    = RxState::WAIT_HEADER;
+    _rxBytesGot = 0;
+    _resyncs++;
+}
+
+// Grupo: el registro propio se aplica como un delta; la respuesta sale
+// en la ranura = posición del registro. La referencia es el instante de
+// parseo: todos los slaves ven la misma trama con el mismo retardo ± jitter,
+// que cubre la guarda de slotUs.
+void RS485Slave::_applyGroup() {
+    uint8_t slot;
+    const uint8_t* rec = rs485_groupFind(_rxBuf, _myId, slot);
+    if (!rec) return;                         // este ciclo no me incluye
+    uint32_t now = micros();
+
+    if (slot == 0) {
+        _slotPending = false;
+        _sendReply();
+    } else {
+        const uint16_t slotUs = rs485_get16(&_rxBuf[3]);
+        const uint16_t txUs   = rs485_groupSlotUs(rs485_baudRate(_baudCode, RS485_BAUD), 0);
+        _slotDueUs   = now + (uint32_t)slot * slotUs;
+        _slotGuardUs = slotUs > txUs ? slotUs - txUs : 0;
+        _slotPending = true;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    rs485_applyRecord(rec, _rxPacket);
+    _newData = true;
+    portEXIT_CRITICAL(&_mux);
+    _rxCount++;
+    _groupCount++;
+}
+
+// Espera acotada: el esp_timer despierta al task RS485_SLOT_SPIN_US antes
+// y el resto es delayMicroseconds (nunca más de SPIN_US de CPU por ranura,
+// el S2 tiene un solo núcleo). Despierto ya pasada la guarda, la respuesta
+// pisaría la ranura siguiente: se descarta y el master la cuenta perdida.
+void RS485Slave::_serviceSlot() {
+    int32_t wait = (int32_t)(_slotDueUs - micros());
+    if (wait > RS485_SLOT_SPIN_US) {
+        esp_timer_stop(_slotTimer);           // puede no estar armado
+        esp_timer_start_once(_slotTimer, wait - RS485_SLOT_SPIN_US);
+        return;
+    }
+    _slotPending = false;
+    if (wait < -(int32_t)_slotGuardUs) {
+        _slotLate++;
+        return;
+    }
+    if (wait > 0) delayMicroseconds(wait);
+    _sendReply();
+}
+
+// Firmware: BEGIN (borrado) y COMMIT de una imagen IMZ1 (descompresión)
+// tardan segundos; lo recibido mientras tanto se descarta y el master lo
+// repite por NACK / QUERY. true = trama lenta
+bool RS485Slave::_applyFw() {
+    uint8_t  out[RS485_FW_STATUS_MAX_LEN];
+    size_t   n  = 0;
+    uint32_t t0 = millis();
+    if (BusOta::onFrame(_rxBuf, _rxExpected, _myId, out, n)) _transmit(out, n);
+    _lastValidMs = millis();                  // sin fallback de velocidad tras el borrado
+    _fwCount++;
+    return _lastValidMs - t0 > 20;
+}
+
+// Broadcast: 'connected' también se refleja en _rxPacket para que los
+// deltas siguientes (que ya no lo traen) no reviertan el estado.
+void RS485Slave::_applyBroadcast() {
+    BroadcastPacket pkt;
+    rs485_decodeBroadcast(_rxBuf, pkt);
+
+    if (_bcastSeen && pkt.seq != (uint8_t)(_bcast.seq + 1))
+        _bcastMissed += (uint8_t)(pkt.seq - _bcast.seq - 1);
+    _bcastSeen = true;
+
+    portENTER_CRITICAL(&_mux);
+    _bcast              = pkt;
+    _newBcast           = true;
+    _rxPacket.connected = (pkt.state & BCAST_CONNECTED) ? 1 : 0;
+    portEXIT_CRITICAL(&_mux);
+    _bcastCount++;
+}
+
 void RS485Slave::printStats() const {
-    Serial.printf("[RS485] RX:%u CRC_ERR:%u WRONG_ID:%u OVERFLOW:%u\n",
-                     _rxCount, _crcErrors, _wrongId, _overflow);
+    Serial.printf("[RS485] RX:%u TX:%u NOREPLY:%u CRC_ERR:%u WRONG_ID:%u OVERFLOW:%u BAD_VER:%u RESYNC:%u IDLE:%u GROUP:%u LATE:%u FW:%u BCAST:%u MISS:%u BAUD:%u FALLBACK:%u\n",
+                     _rxCount, _txCount, _noReply, _crcErrors, _wrongId, _overflow, _badVersion, _resyncs, _idleResets,
+                     _groupCount, _slotLate, _fwCount, _bcastCount, _bcastMissed, rs485_baudRate(_baudCode, RS485_BAUD), _baudFallbacks);
+    BusOta::printStats();
 }
\ No newline at end of file
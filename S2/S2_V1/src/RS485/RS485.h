@@ -1,50 +1,114 @@
 #pragma once
 #include <Arduino.h>
+#include "esp_timer.h"
 #include "../config.h"
 #include "../protocol.h"
 
 class RS485Slave {
 public:
     void begin(uint8_t myId);
-    void update();                          // llamar en loop()
+    void update();                          // llamar en loop() (sin task: parsea aquí)
 
+    // Copias bajo lock: el task responder escribe mientras loop() lee
     bool hasNewData() const { return _newData; }
-    const MasterPacket& getData() {         // consume el flag
-        _newData = false;
-        return _rxPacket;
-    }
+    MasterPacket getData();                 // consume el flag
 
-    void sendResponse(const SlavePacket& pkt);
+    // Broadcast (id 0): estado global, nunca se responde
+    bool hasBroadcast() const { return _newBcast; }
+    BroadcastPacket getBroadcast();         // consume el flag
+
+    // Respuesta pre-construida: loop() la publica, el task la envía al
+    // recibir el poll. false = loop aún no recogió la última enviada.
+    bool setReply(const SlavePacket& pkt);
+    bool takeSent(SlavePacket& out);        // lo que vio el master → consumir eventos
+    void clearReply();                      // sin respuesta (master verá timeout)
     void printStats()  const;
 
     // llamado desde onReceive — no usar directamente
     void _onReceiveISR();
+    TaskHandle_t _task = nullptr;           // responder (onReceive lo despierta)
 
 private:
+    static void _taskEntry(void* param);
+    void _service();
+    void _sendReply();
+    void _transmit(const uint8_t* buf, size_t len);
     void _processBuffer();
+    bool _isHeader(uint8_t b) const;
+    void _resync();
+    void _applyGroup();
+    bool _applyFw();
+    void _serviceSlot();
+    void _applyBroadcast();
+    void _setBaud(uint8_t code);
 
     uint8_t  _myId      = 1;
+    bool     _hwDE      = false;           // DE por UART (RS485 half-duplex) o por GPIO
+    bool     _groupOk   = false;           // responde a tramas de grupo en su ranura
+    bool     _fwOk      = false;           // acepta firmware por el bus (BusOta)
 
     // Buffer circular
     static constexpr uint16_t CB_SIZE = 256;
     volatile uint8_t  _cb[CB_SIZE];
+    volatile bool     _cbGap[CB_SIZE];     // byte leído tras un RX timeout (silencio antes)
     volatile uint16_t _cbHead = 0;
     volatile uint16_t _cbTail = 0;
 
     // Máquina de estados RX
     enum class RxState : uint8_t { WAIT_HEADER, RECEIVE_PACKET };
     RxState _rxState     = RxState::WAIT_HEADER;
-    uint8_t _rxBuf[sizeof(MasterPacket)];
+    uint8_t _rxBuf[RS485_RX_MAX_LEN];      // MasterPacket (16), delta (≤17), grupo o firmware
     uint8_t _rxBytesGot  = 0;
+    uint8_t _rxExpected  = 0;              // longitud del paquete en curso
+
+    // Bytes a re-parsear tras una trama rechazada (header falso dentro de otro payload)
+    uint8_t _replay[RS485_RX_MAX_LEN];
+    uint8_t _replayLen   = 0;
+    uint8_t _replayPos   = 0;
+
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    MasterPacket _rxPacket = {};           // estado acumulado (delta solo trae cambios)
+    volatile bool _newData = false;
+
+    BroadcastPacket _bcast    = {};
+    volatile bool   _newBcast = false;
+    bool            _bcastSeen = false;
+
+    // Respuesta armada por loop(); el task solo copia _replyBuf al UART
+    SlavePacket _reply       = {};
+    uint8_t     _replyBuf[sizeof(SlavePacket)];
+    bool        _replyArmed  = false;
+    SlavePacket _sent        = {};         // primera copia enviada desde el último takeSent()
+    bool        _sentPending = false;
+
+    // Ranura TDMA pendiente (trama de grupo): esp_timer despierta al
+    // task poco antes y los últimos RS485_SLOT_SPIN_US son espera activa
+    esp_timer_handle_t _slotTimer   = nullptr;
+    uint32_t           _slotDueUs   = 0;
+    uint16_t           _slotGuardUs = 0;   // retraso tolerado: slotUs − respuesta
+    bool               _slotPending = false;
 
-    MasterPacket _rxPacket;
-    bool         _newData = false;
+    // Velocidad negociada por el master (0 = RS485_BAUD)
+    uint8_t  _baudCode    = 0;
+    uint32_t _lastValidMs = 0;             // última trama con CRC correcto
 
     // Estadísticas
     uint32_t _rxCount    = 0;
+    uint32_t _txCount    = 0;
+    uint32_t _noReply    = 0;              // polls sin respuesta armada
     uint32_t _crcErrors  = 0;
     uint32_t _wrongId    = 0;
     uint32_t _overflow   = 0;
+    uint32_t _badVersion = 0;
+    uint32_t _resyncs    = 0;              // tramas rechazadas re-parseadas desde el byte 1
+    uint32_t _idleResets = 0;              // de ellas, cortadas por un silencio (header falso)
+    uint32_t _groupCount  = 0;             // tramas de grupo con registro propio
+    uint32_t _slotLate    = 0;             // ranuras descartadas: task despierto tras la guarda
+    uint32_t _fwCount     = 0;             // tramas de firmware (0xAF)
+    uint32_t _bcastCount  = 0;
+    uint32_t _bcastMissed = 0;             // huecos en bcast.seq
+    uint32_t _baudFallbacks = 0;           // vueltas a la base por silencio
 };
 
 extern RS485Slave rs485;
\ No newline at end of file
@@ -22,29 +22,18 @@ extern void handleButtonLedState(ButtonId id);
 
 namespace RS485Handler {
 
+// Envío de min/max tras calibrar: solo avanza cuando el master recibió el paso
+static uint8_t           _calibSendState = 0;   // 0=normal, 1=min enviado, 2=max enviado
+static Motor::CalibState _lastCs         = Motor::CalibState::IDLE;
+
 // =============================================================
-//  onMasterData
+//  _applyConnection — común a paquete directo y broadcast
 // =============================================================
-void onMasterData(const MasterPacket& pkt) {
-    // Log no bloqueante cada 1s — diagnóstico RS485 recepción
-    static unsigned long lastLog = 0;
-    if (millis() - lastLog > 1000) {
-        log_i("[RS485 RX] Master packet: id=%d target=%d connected=%d", pkt.id, pkt.faderTarget, pkt.connected);
-        lastLog = millis();
-    }
-
-    // ── Calibración — ANTES de desconexión (2026-05-16 19:20) ──
-    // CRÍTICO: Procesar FLAG_CALIB ANTES de Motor::off() para que motor pueda calibrar
-    // S3 envía calibración secuencial al boot, independiente de Logic
-    // Motor debe estar activo cuando requestCalibration() lo ordene
-    if (pkt.flags & FLAG_CALIB) {
-        Motor::requestCalibration();  // Motor puede calibrar aunque _connected vaya a cambiar
-    }
-
-    // ── Conexión ──────────────────────────────────────────────
-    ConnectionState newState = pkt.connected ?
+static void _applyConnection(bool connected) {
+    ConnectionState newState = connected ?
         ConnectionState::CONNECTED : ConnectionState::DISCONNECTED;
-    if (newState != logicConnectionState) {
+    if (newState == logicConnectionState) return;
+
     logicConnectionState = newState;
     needsTOTALRedraw = true;
 
@@ -52,8 +41,8 @@ void onMasterData(const MasterPacket& pkt) {
         Motor::setConnected(true);  // Notificar motor que S3 conectó (2026-05-16 10:52)
         neoWaitingHandshake = false;
         // Cambio de azul a colores tenues
-        // ¡CRÍTICO! NO llamar updateAllNeopixels() aquí — retarda RS485 response
-        // Neopixels se actualizan en main.cpp DESPUÉS de sendResponse()
+        // ¡CRÍTICO! NO llamar updateAllNeopixels() aquí — alarga loop()
+        // Neopixels se actualizan al final de loop() en main.cpp
     } else {
         // ── Desconexión limpia ────────────────────────────
         Motor::setConnected(false);  // Notificar motor que S3 desconectó (2026-05-16 10:52)
@@ -64,11 +53,40 @@ void onMasterData(const MasterPacket& pkt) {
         //setScreenBrightness(0);
         neoWaitingHandshake = true;
         // Cambio a azul
-        // ¡CRÍTICO! NO llamar updateAllNeopixels() aquí — retarda RS485 response
-        // Neopixels se actualizan en main.cpp DESPUÉS de sendResponse()
+        // ¡CRÍTICO! NO llamar updateAllNeopixels() aquí — alarga loop()
+        // Neopixels se actualizan al final de loop() en main.cpp
     }
 }
 
+// =============================================================
+//  onBroadcast — estado global (id 0), sin respuesta
+// =============================================================
+void onBroadcast(const BroadcastPacket& pkt) {
+    _applyConnection((pkt.state & BCAST_CONNECTED) != 0);
+}
+
+// =============================================================
+//  onMasterData
+// =============================================================
+void onMasterData(const MasterPacket& pkt) {
+    // Log no bloqueante cada 1s — diagnóstico RS485 recepción
+    static unsigned long lastLog = 0;
+    if (millis() - lastLog > 1000) {
+        log_i("[RS485 RX] Master packet: id=%d target=%d connected=%d", pkt.id, pkt.faderTarget, pkt.connected);
+        lastLog = millis();
+    }
+
+    // ── Calibración — ANTES de desconexión (2026-05-16 19:20) ──
+    // CRÍTICO: Procesar FLAG_CALIB ANTES de Motor::off() para que motor pueda calibrar
+    // S3 envía calibración secuencial al boot, independiente de Logic
+    // Motor debe estar activo cuando requestCalibration() lo ordene
+    if (pkt.flags & FLAG_CALIB) {
+        Motor::requestCalibration();  // Motor puede calibrar aunque _connected vaya a cambiar
+    }
+
+    // ── Conexión ──────────────────────────────────────────────
+    _applyConnection(pkt.connected != 0);
+
     if (logicConnectionState != ConnectionState::CONNECTED) return;
 
     // ── Nombre de pista ───────────────────────────────────────
@@ -131,12 +149,11 @@ void onMasterData(const MasterPacket& pkt) {
 }
 
 // =============================================================
-//  buildResponse
+//  buildResponse — snapshot para el task responder (RS485Slave::setReply)
+//  Se llama cada loop(): no limpia botones ni encoder, eso lo hace
+//  onReplySent() con lo que de verdad salió al bus.
 // =============================================================
 SlavePacket buildResponse(FaderADC& faderADC, SatMenu& satMenu) {
-    static uint8_t _calib_send_state = 0;  // 0=normal, 1=enviando min, 2=enviando max
-    static Motor::CalibState _last_cs = Motor::CalibState::IDLE;
-
     SlavePacket resp = {};
     resp.touchState    = FaderTouch::isTouched() ? 1 : 0;
     resp.buttons       = ButtonManager::getButtonFlags();
@@ -146,23 +163,21 @@ SlavePacket buildResponse(FaderADC& faderADC, SatMenu& satMenu) {
     Motor::CalibState cs = Motor::getCalibState();
 
     // Detección: si volvemos a calibración desde DONE, resetear estado de envío
-    if (cs != Motor::CalibState::DONE && _last_cs == Motor::CalibState::DONE) {
-        _calib_send_state = 0;  // Reset para próxima calibración
+    if (cs != Motor::CalibState::DONE && _lastCs == Motor::CalibState::DONE) {
+        _calibSendState = 0;  // Reset para próxima calibración
     }
-    _last_cs = cs;
+    _lastCs = cs;
 
-    // Máquina de estado: enviar min/max tras calibración
-    if (cs == Motor::CalibState::DONE && _calib_send_state < 2) {
-        if (_calib_send_state == 0) {
+    // Máquina de estado: enviar min/max tras calibración (avanza en onReplySent)
+    if (cs == Motor::CalibState::DONE && _calibSendState < 2) {
+        if (_calibSendState == 0) {
             // Paquete 1: enviar MIN
             resp.faderPos = Motor::getADCMin();
             resp.buttons |= SLAVE_FLAG_CALIB_DONE | SLAVE_FLAG_CALIB_SENDING | SLAVE_FLAG_CALIB_IS_MIN;
-            _calib_send_state = 1;
-        } else if (_calib_send_state == 1) {
+        } else {
             // Paquete 2: enviar MAX
             resp.faderPos = Motor::getADCMax();
             resp.buttons |= SLAVE_FLAG_CALIB_DONE | SLAVE_FLAG_CALIB_SENDING;  // sin IS_MIN = es MAX
-            _calib_send_state = 2;
         }
     } else {
         // Normal: enviar posición actual
@@ -176,6 +191,20 @@ SlavePacket buildResponse(FaderADC& faderADC, SatMenu& satMenu) {
     return resp;
 }
 
+// =============================================================
+//  onReplySent — el master ya tiene estos eventos
+//  Resta solo lo enviado: pulsaciones y pasos de encoder llegados
+//  entre buildResponse() y el poll salen en la siguiente respuesta
+//  (una pulsación repetida espera a que el master vea el 0).
+// =============================================================
+void onReplySent(const SlavePacket& sent) {
+    ButtonManager::consumeSent(sent.buttons, sent.encoderButton);
+    Encoder::consume(sent.encoderDelta);
+
+    if (sent.buttons & SLAVE_FLAG_CALIB_SENDING)
+        _calibSendState = (sent.buttons & SLAVE_FLAG_CALIB_IS_MIN) ? 1 : 2;
+}
+
 // =============================================================
 //  checkTimeout
 // =============================================================
@@ -9,7 +9,9 @@
 namespace RS485Handler {
 
     void onMasterData(const MasterPacket& pkt);
-    SlavePacket buildResponse(FaderADC& faderADC, SatMenu& satMenu);
+    void onBroadcast(const BroadcastPacket& pkt);
+    SlavePacket buildResponse(FaderADC& faderADC, SatMenu& satMenu);   // no consume nada
+    void onReplySent(const SlavePacket& sent);                          // consume lo enviado
     void checkTimeout(unsigned long lastRxTime);
 
 } // namespace RS485Handler
\ No newline at end of file
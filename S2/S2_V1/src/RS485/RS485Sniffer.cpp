@@ -0,0 +1,146 @@
+// ============================================================
+//  RS485Sniffer.cpp  —  iMakie PTxx Track S2
+//  onReceive (task de eventos del UART) → ring SPSC → loop() → USB.
+//  RX timeout de 1 símbolo: cada trama llega como una lectura
+//  propia salvo que la siguiente empiece antes (el decoder
+//  reparte los bytes hacia atrás a la velocidad del bus).
+//  Sigue los cambios de velocidad igual que un slave.
+// ============================================================
+#include "RS485Sniffer.h"
+#include "../config.h"
+#include "../protocol.h"
+#include <imakie_sniff.h>
+#include "esp_timer.h"
+#include <esp_log.h>
+#include <atomic>
+
+namespace RS485Sniffer {
+
+namespace {
+    uint8_t*              _ring = nullptr;
+    uint32_t              _mask = 0;
+    std::atomic<uint32_t> _head{0};     // productor: onReceive
+    std::atomic<uint32_t> _tail{0};     // consumidor: loop()
+
+    uint8_t   _baudCode    = 0;
+    uint32_t  _lastValidMs = 0;
+    uint32_t  _dropped     = 0;
+    uint32_t  _dropSent    = 0;
+    uint32_t  _helloMs     = 0;
+    uint16_t  _ringKB      = 0;
+
+    static_assert((RS485_SNIFF_RING & (RS485_SNIFF_RING - 1)) == 0, "RS485_SNIFF_RING: potencia de 2");
+
+    bool _push(const uint8_t* rec, size_t n) {
+        uint32_t h = _head.load(std::memory_order_relaxed);
+        if (_mask + 1 - (h - _tail.load(std::memory_order_acquire)) < n) return false;
+        for (size_t i = 0; i < n; i++) _ring[(h + i) & _mask] = rec[i];
+        _head.store(h + n, std::memory_order_release);
+        return true;
+    }
+
+    // Ring lleno: se cuenta y se avisa con DROP en cuanto vuelve a haber sitio
+    void _record(uint8_t type, uint32_t t, const uint8_t* p, uint8_t n) {
+        uint8_t rec[SNIFF_MAX_LEN];
+        if (_dropped != _dropSent) {
+            uint8_t cnt[4];
+            rs485_put32(cnt, _dropped - _dropSent);
+            if (!_push(rec, sniff_encode(rec, SNIFF_DROP, t, cnt, 4))) { _dropped++; return; }
+            _dropSent = _dropped;
+        }
+        if (!_push(rec, sniff_encode(rec, type, t, p, n))) _dropped++;
+    }
+
+    // Al arrancar y cada segundo con tráfico: una captura empezada a
+    // mitad también sabe la velocidad actual y el RX timeout
+    void _hello(uint32_t t) {
+        uint8_t p[8];
+        p[0] = SNIFF_VERSION;
+        rs485_put32(&p[1], rs485_baudRate(_baudCode, RS485_BAUD));
+        p[5] = RS485_SNIFF_RX_TIMEOUT;
+        rs485_put16(&p[6], _ringKB);
+        _record(SNIFF_HELLO, t, p, sizeof(p));
+        _helloMs = millis();
+    }
+
+    void _setBaud(uint8_t code, uint32_t t) {
+        uint32_t baud = rs485_baudRate(code, RS485_BAUD);
+        Serial1.updateBaudRate(baud);
+        _baudCode    = code;
+        _lastValidMs = millis();
+        uint8_t p[4];
+        rs485_put32(p, baud);
+        _record(SNIFF_BAUD, t, p, 4);
+    }
+
+    // Tramas completas al inicio de la lectura: actividad válida y
+    // RS485_BAUD_BYTE. El resto lo interpreta el decoder
+    void _follow(const uint8_t* b, size_t n, uint32_t t) {
+        size_t i = 0;
+        while (i < n) {
+            size_t len = rs485_frameLength(&b[i], n - i);
+            if (len == 0 || len > n - i || rs485_checkFrame(&b[i], len) != Rs485Status::OK) break;
+            _lastValidMs = millis();
+            if (b[i] == RS485_BAUD_BYTE && b[i + 1] == RS485_BROADCAST_ID &&
+                b[i + 2] != _baudCode && b[i + 2] < RS485_BAUD_CODES) {
+                _setBaud(b[i + 2], t);
+                return;
+            }
+            i += len;
+        }
+        // Velocidad negociada sin trama válida: master reiniciado → base
+        if (_baudCode && millis() - _lastValidMs > RS485_BAUD_FALLBACK_MS) _setBaud(0, t);
+    }
+
+    void _onReceive() {
+        const uint32_t t = (uint32_t)esp_timer_get_time();
+        uint8_t buf[SNIFF_MAX_PAYLOAD];
+        size_t  n;
+        if (millis() - _helloMs > 1000) _hello(t);
+        while ((n = Serial1.available()) > 0) {
+            n = Serial1.read(buf, n < sizeof(buf) ? n : sizeof(buf));
+            _record(SNIFF_DATA, t, buf, n);
+            _follow(buf, n, t);
+        }
+    }
+}
+
+void begin() {
+    // El flujo USB es binario: nada de log encima
+    Serial.setDebugOutput(false);
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    pinMode(RS485_ENABLE_PIN, OUTPUT);
+    digitalWrite(RS485_ENABLE_PIN, LOW);      // DE: solo escucha
+
+    size_t size = RS485_SNIFF_RING;
+    _ring = (uint8_t*)ps_malloc(size);
+    if (!_ring) _ring = (uint8_t*)malloc(size = 32 * 1024);
+    _mask   = size - 1;
+    _ringKB = size / 1024;
+
+    Serial1.setRxBufferSize(4096);
+    Serial1.begin(RS485_BAUD, SERIAL_8N1, RS485_RX_PIN, -1);
+    Serial1.setRxTimeout(RS485_SNIFF_RX_TIMEOUT);
+    _hello((uint32_t)esp_timer_get_time());
+    Serial1.onReceive(_onReceive);
+}
+
+void update() {
+    uint32_t t = _tail.load(std::memory_order_relaxed);
+    uint32_t h = _head.load(std::memory_order_acquire);
+    while (t != h) {
+        size_t n = h - t;
+        size_t room = _mask + 1 - (t & _mask);            // hasta el final del ring
+        if (n > room) n = room;
+        int free = Serial.availableForWrite();
+        if (free <= 0) break;                             // USB lleno: el ring aguanta
+        if (n > (size_t)free) n = free;
+        n = Serial.write(&_ring[t & _mask], n);
+        if (n == 0) break;
+        t += n;
+        _tail.store(t, std::memory_order_release);
+    }
+}
+
+} // namespace RS485Sniffer
@@ -0,0 +1,20 @@
+#pragma once
+// ============================================================
+//  RS485Sniffer.h  —  iMakie PTxx Track S2
+//
+//  Captura pasiva del bus (RS485_SNIFFER): DE fijo a LOW, nunca
+//  transmite. Cada lectura del UART va con su instante a un ring
+//  en PSRAM; loop() lo vacía por USB en el formato de
+//  imakie_sniff.h. Decoder y timeline: tools/rs485sniff.
+//
+//  Sustituye al firmware normal: ni display, ni motor, ni
+//  respuesta al master. Cualquier strip del bus sirve.
+// ============================================================
+#include <Arduino.h>
+
+namespace RS485Sniffer {
+
+    void begin();
+    void update();                      // loop(): ring → USB
+
+} // namespace RS485Sniffer
@@ -53,7 +53,19 @@ enum class ConnectionState {
 #define RS485_RX_PIN             9
 #define RS485_TX_PIN             8
 #define RS485_ENABLE_PIN        35   // GPIO35 — libre en S2FN4R2 (PSRAM QSPI interna, no usa GPIO matrix)
-#define RS485_BAUD          500000
+#define RS485_BAUD          500000   // velocidad base; el master puede subirla (RS485_BAUD_BYTE)
+#define RS485_BAUD_FALLBACK_MS  300    // sin trama válida a velocidad negociada → volver a RS485_BAUD
+#define RS485_RX_IDLE_SYM         2    // símbolos de silencio (RX timeout) que cierran una trama a medias
+#define RS485_HW_HALF_DUPLEX      1    // 1 = DE por RTS del UART (la respuesta no bloquea); 0 = GPIO + flush
+#define RS485_RESPONDER_TASK      1    // 1 = parseo y respuesta en task propio; 0 = en loop()
+#define RS485_RESPONDER_PRIO      (configMAX_PRIORITIES - 2)   // por encima de loop y display
+#define RS485_RESPONDER_STACK  3072
+#define RS485_GROUP_SLOTS         1    // 1 = anuncia SLAVE_CAP_GROUP (requiere task responder y DE por UART)
+#define RS485_SLOT_SPIN_US       60    // últimos µs antes de la ranura: espera activa (el esp_timer no es tan fino)
+#define RS485_BUS_OTA             1    // 1 = anuncia SLAVE_CAP_FW: firmware difundido por el master (BusOta)
+#define RS485_SNIFFER             0    // 1 = firmware de captura pasiva (RS485Sniffer) en vez del strip
+#define RS485_SNIFF_RING  (1024 * 1024) // ring en PSRAM: ~20 s de bus lleno a 500 k con el USB parado
+#define RS485_SNIFF_RX_TIMEOUT    1    // símbolos de silencio que cierran una lectura (separa trama y respuesta)
 
 #define RS485_START_BYTE      0xAA
 #define RS485_RESP_BYTE       0xBB
@@ -15,8 +15,8 @@ namespace ButtonManager {
 
 static LovyanGFX* _tft   = nullptr;
 static SatMenu*   _sat   = nullptr;
-static uint8_t    _flags = 0;
-static uint8_t    _encoderBtnCount = 0;
+static EdgeLatch  _buttons;            // FLAG_REC/SOLO/MUTE/SELECT
+static EdgeLatch  _encoderBtn;         // SLAVE_ENC_BUTTON
 
 static bool          _holding   = false;
 static unsigned long _holdStart = 0;
@@ -86,7 +86,7 @@ static void _onRecReleased(Button2& btn) {
     if (held < HOLD_MS) {
         if (now - lastRecTime >= 300) {
             lastRecTime = now;
-            _flags |= FLAG_REC;
+            _buttons.press(FLAG_REC);
         }
     }
 }
@@ -106,20 +106,20 @@ static void _onButtonEvent(ButtonId id) {
         case ButtonId::SOLO:
             if (now - lastSoloTime < DEBOUNCE_MS) break;
             lastSoloTime = now;
-            _flags |= FLAG_SOLO;
+            _buttons.press(FLAG_SOLO);
             break;
         case ButtonId::MUTE:
             if (now - lastMuteTime < DEBOUNCE_MS) break;
             lastMuteTime = now;
-            _flags |= FLAG_MUTE;
+            _buttons.press(FLAG_MUTE);
             break;
         case ButtonId::SELECT:
             if (now - lastSelectTime < DEBOUNCE_MS) break;
             lastSelectTime = now;
-            _flags |= FLAG_SELECT;
+            _buttons.press(FLAG_SELECT);
             break;
         case ButtonId::ENCODER_SELECT:
-            _encoderBtnCount++;
+            _encoderBtn.press(SLAVE_ENC_BUTTON);
             needsVPotRedraw = true;
             break;
         default: break;
@@ -130,7 +130,8 @@ static void _onButtonEvent(ButtonId id) {
 void begin(LovyanGFX* tft, SatMenu* sat) {
     _tft   = tft;
     _sat   = sat;
-    _flags = 0;
+    _buttons.clear();
+    _encoderBtn.clear();
     buttonRec.setPressedHandler (_onRecPressed);
     buttonRec.setReleasedHandler(_onRecReleased);
     registerButtonEventCallback (_onButtonEvent);
@@ -157,9 +158,12 @@ void update() {
 }
 
 void setSatMenu(SatMenu* sat) { _sat = sat; }
-uint8_t getButtonFlags()      { return _flags; }
-void    clearButtonFlags()    { _flags = 0; }
-uint8_t getEncoderButton()    { return _encoderBtnCount; }
-void    clearEncoderButton()  { _encoderBtnCount = 0; }
+uint8_t getButtonFlags()      { return _buttons.pending(); }
+uint8_t getEncoderButton()    { return _encoderBtn.pending(); }
+
+void consumeSent(uint8_t buttons, uint8_t encoderButton) {
+    _buttons.consume(buttons & FLAG_BUTTONS_MASK);
+    _encoderBtn.consume(encoderButton & SLAVE_ENC_BUTTON);
+}
 
 } // namespace ButtonManager
\ No newline at end of file
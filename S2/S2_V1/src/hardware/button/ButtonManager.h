@@ -6,6 +6,7 @@
 #include <LovyanGFX.hpp>
 #include "hardware/Hardware.h"
 #include "hardware/encoder/Encoder.h"
+#include <EdgeLatch.h>
 
 class SatMenu;
 
@@ -15,10 +16,9 @@ namespace ButtonManager {
     void update();
     void setSatMenu(SatMenu* sat);
 
-    uint8_t getButtonFlags();
-    void    clearButtonFlags();
-
-    uint8_t getEncoderButton();    // ← AÑADIR
-    void    clearEncoderButton();  // ← AÑADIR
+    // Pulsaciones pendientes (EdgeLatch): una por press, 1→0 en el bus
+    uint8_t getButtonFlags();      // FLAG_REC/SOLO/MUTE/SELECT para la respuesta
+    uint8_t getEncoderButton();    // SLAVE_ENC_BUTTON para la respuesta
+    void    consumeSent(uint8_t buttons, uint8_t encoderButton);   // lo que salió al bus
 
 } // namespace ButtonManager
\ No newline at end of file
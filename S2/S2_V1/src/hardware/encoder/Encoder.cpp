@@ -62,3 +62,10 @@ void Encoder::reset() {
     interrupts();
     _lastReported = 0;
 }
+
+void Encoder::consume(long n) {
+    noInterrupts();
+    _counter      -= n;
+    interrupts();
+    _lastReported -= n;
+}
@@ -8,6 +8,7 @@ public:
     static long getCount();
     static bool hasChanged();
     static void reset();            // solo resetea delta, NO currentVPotLevel
+    static void consume(long n);    // resta lo ya enviado; conserva pasos posteriores
     static int  currentVPotLevel;
 
 private:
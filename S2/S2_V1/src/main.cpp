@@ -14,6 +14,8 @@
 #include "hardware/Motor/Motor.h"
 #include "RS485/RS485.h"
 #include "RS485/RS485Handler.h"
+#include "RS485/RS485Sniffer.h"
+#include "OTA/BusOta.h"
 #include "protocol.h"
 #include "hardware/button/ButtonManager.h"
 #include "SAT/SatMenu.h"
@@ -49,7 +51,7 @@ static SatMenu* satMenu    = nullptr;
 static void _satMotorOff()  { Motor::stop(); _suspended = true;  }
 static void _satMotorOn()   { Motor::init(); _suspended = false; }
 static void _satBrightness(uint8_t b) { setScreenBrightness(b); }
-static void _satRS485Off()  { _suspended = true;  }
+static void _satRS485Off()  { _suspended = true; rs485.clearReply(); }
 static void _satRS485On()   { _suspended = false; needsTOTALRedraw = true; }
 static void _satReboot()    { ESP.restart(); }
 static void _satMotorDrive(int pwm) { /* Motor::driveRaw(pwm); */ }
@@ -128,6 +130,12 @@ void setup() {
     Serial.printf("\n[BOOT] FW_VERSION=%s FW_BUILD_ID=%d\n", FW_VERSION, FW_BUILD_ID);
     Serial.flush();
 
+#if RS485_SNIFFER
+    // Captura pasiva del bus: el resto del strip no arranca (motor ya en EN=LOW)
+    RS485Sniffer::begin();
+    return;
+#endif
+
     // Leer PWM range de NVS (2026-05-10 20:20)
     Motor::initPWM();
     Motor::goToMin();  // Llevar fader a 0 en boot (2026-05-16 10:50)
@@ -255,6 +263,10 @@ static bool g_calibStarted = false;
 //  loop
 // =============================================================
 void loop() {
+#if RS485_SNIFFER
+    RS485Sniffer::update();
+    return;
+#endif
     // OTA siempre tiene máxima prioridad, incluso si SAT está abierto
     // Actualizar ADC SIEMPRE (incluso en SAT) para Test Mode live feedback (2026-05-10 21:57)
     faderADC.update();
@@ -271,7 +283,17 @@ void loop() {
         lastLog = millis();
     }
 
+    // Firmware por el bus verificado y REBOOT del master: arrancar con la imagen nueva
+    if (BusOta::rebootPending()) {
+        Motor::off();
+        Serial.printf("[BUSOTA] Reiniciando con el firmware nuevo...\n");
+        Serial.flush();
+        delay(100);
+        ESP.restart();
+    }
+
     if (satMenu && satMenu->isOpen()) {
+        rs485.clearReply();   // loop no refresca el snapshot → no contestar con datos viejos
         satMenu->update();
         return;
     }
@@ -305,18 +327,23 @@ void loop() {
         rs485.update();
         static unsigned long lastRxTime = millis();
 
-        if (rs485.hasNewData()) {
+        if (rs485.hasBroadcast()) {
             lastRxTime = millis();
-            RS485Handler::onMasterData(rs485.getData());
+            RS485Handler::onBroadcast(rs485.getBroadcast());
+        }
 
-            SlavePacket resp = RS485Handler::buildResponse(faderADC, *satMenu);
-            rs485.sendResponse(resp);
+        // El task responder ya contestó: descontar lo que vio el master
+        SlavePacket sent;
+        if (rs485.takeSent(sent)) RS485Handler::onReplySent(sent);
 
-            ButtonManager::clearButtonFlags();
-            ButtonManager::clearEncoderButton();
-            Encoder::reset();
+        if (rs485.hasNewData()) {
+            lastRxTime = millis();
+            RS485Handler::onMasterData(rs485.getData());
         }
 
+        // Snapshot siempre al día: el próximo poll se contesta sin esperar a loop()
+        rs485.setReply(RS485Handler::buildResponse(faderADC, *satMenu));
+
         RS485Handler::checkTimeout(lastRxTime);
     }
 
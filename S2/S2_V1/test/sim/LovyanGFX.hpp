@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  LovyanGFX.hpp (host)  –  solo lo que config.h necesita para
+//  compilar (LGFX de display/LovyanGFX_config.h, sprites extern).
+//  Los tests del S2 nunca dibujan. El resto de fakes (Arduino,
+//  FreeRTOS, esp_timer, reloj virtual) son los del master:
+//  MASTER_S3-P4/P4/test/sim.
+// ============================================================
+
+#define SPI3_HOST        2
+#define SPI_DMA_CH_AUTO  3
+
+namespace lgfx {
+
+struct Bus_SPI {
+    struct config_t {
+        int  spi_host, spi_mode, freq_write, freq_read, dma_channel;
+        bool spi_3wire, use_lock;
+        int  pin_sclk, pin_mosi, pin_miso, pin_dc;
+    };
+    config_t config() const { return {}; }
+    void     config(const config_t&) {}
+};
+
+struct Light_PWM {
+    struct config_t {
+        int  pin_bl, freq, pwm_channel;
+        bool invert;
+    };
+    config_t config() const { return {}; }
+    void     config(const config_t&) {}
+};
+
+struct Panel_ST7789 {
+    struct config_t {
+        int  pin_cs, pin_rst, pin_busy;
+        int  memory_width, memory_height, panel_width, panel_height;
+        int  offset_x, offset_y, offset_rotation, dummy_read_pixel, dummy_read_bits;
+        bool readable, invert, rgb_order, dlen_16bit, bus_shared;
+    };
+    config_t config() const { return {}; }
+    void     config(const config_t&) {}
+    void     setBus(Bus_SPI*) {}
+    void     setLight(Light_PWM*) {}
+};
+
+class LGFX_Device {
+public:
+    void setPanel(Panel_ST7789*) {}
+};
+
+}  // namespace lgfx
+
+class LGFX_Sprite {};
@@ -0,0 +1,179 @@
+// ============================================================
+//  test_button_edges.cpp  –  pulsaciones S2 → flancos en el master
+//  pio test -e native -f test_button_edges
+//
+//  Loop del S2 (EdgeLatch de ButtonManager + onReplySent), respuesta
+//  armada como RS485Slave (setReply / _sendReply / takeSent) y el
+//  master derivando flancos como _pushEvents (cur ^ prev). Con
+//  pulsaciones, polls y vueltas de loop en cualquier orden, cada
+//  press() llega como un flanco de subida y otro de bajada.
+// ============================================================
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <imakie_protocol.h>
+#include <EdgeLatch.h>
+
+void setUp() {}
+void tearDown() {}
+
+// ─── S2: ButtonManager + RS485Slave ───────────────────────────
+
+struct Slave {
+    EdgeLatch   buttons, encoderBtn;
+    SlavePacket reply = {}, sent = {};
+    bool        armed = false, sentPending = false;
+
+    // loop(): takeSent → onReplySent, luego setReply(buildResponse)
+    void loop() {
+        if (sentPending) {
+            buttons.consume(sent.buttons & FLAG_BUTTONS_MASK);
+            encoderBtn.consume(sent.encoderButton & SLAVE_ENC_BUTTON);
+            sentPending = false;
+        }
+        reply               = {};
+        reply.buttons       = buttons.pending();
+        reply.encoderButton = encoderBtn.pending();
+        armed               = true;
+    }
+
+    // task responder: la primera copia enviada es la que consume loop;
+    // los reenvíos salen sin eventos
+    bool poll(SlavePacket& out) {
+        if (!armed) return false;
+        out = reply;
+        if (!sentPending) sent = reply;
+        sentPending = true;
+        reply.buttons       &= ~FLAG_BUTTONS_MASK;
+        reply.encoderButton &= ~SLAVE_ENC_BUTTON;
+        return true;
+    }
+};
+
+// ─── Master: flancos como _pushEvents ─────────────────────────
+
+struct Master {
+    uint8_t  prevButtons = 0, prevEnc = 0;
+    uint32_t rise[5] = {}, fall[5] = {};   // 0..3 botones, 4 encoder
+
+    void receive(const SlavePacket& p) {
+        uint8_t changed = (p.buttons ^ prevButtons) & FLAG_BUTTONS_MASK;
+        for (uint8_t b = 0; b < 4; b++)
+            if (changed & (1 << b)) ((p.buttons >> b) & 1 ? rise : fall)[b]++;
+        uint8_t enc = p.encoderButton & SLAVE_ENC_BUTTON;
+        if (enc != prevEnc) (enc ? rise : fall)[4]++;
+        prevButtons = p.buttons;
+        prevEnc     = enc;
+    }
+};
+
+static void poll(Slave& s, Master& m) {
+    SlavePacket p;
+    if (s.poll(p)) m.receive(p);
+}
+
+// Vacía lo pendiente: vueltas de loop y polls alternos
+static void drain(Slave& s, Master& m) {
+    for (int i = 0; i < 4 * 255 * 2 + 8; i++) {
+        s.loop();
+        poll(s, m);
+    }
+}
+
+// ─── Casos concretos ──────────────────────────────────────────
+
+// Antes un segundo REC entre el envío y takeSent() se borraba con el primero
+static void test_press_between_send_and_consume() {
+    Slave s; Master m;
+    s.buttons.press(FLAG_REC);
+    s.loop();
+    poll(s, m);                    // sale REC=1
+    s.buttons.press(FLAG_REC);     // antes de que loop consuma
+    poll(s, m);                    // reenvío sin eventos: REC=0
+    drain(s, m);
+    TEST_ASSERT_EQUAL_UINT32(2, m.rise[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, m.fall[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, s.buttons.count(0));
+}
+
+// Un poll por vuelta de loop: sin reenvío, el 0 lo pone EdgeLatch
+static void test_back_to_back_presses_one_poll_per_loop() {
+    Slave s; Master m;
+    for (int i = 0; i < 5; i++) s.buttons.press(FLAG_MUTE);
+    for (int i = 0; i < 10; i++) { s.loop(); poll(s, m); }
+    TEST_ASSERT_EQUAL_UINT32(5, m.rise[2]);
+    TEST_ASSERT_EQUAL_UINT32(5, m.fall[2]);
+}
+
+// Respuesta preparada pero sin poll: nada se consume
+static void test_no_poll_nothing_consumed() {
+    Slave s; Master m;
+    s.buttons.press(FLAG_SOLO);
+    s.encoderBtn.press(SLAVE_ENC_BUTTON);
+    for (int i = 0; i < 20; i++) s.loop();
+    TEST_ASSERT_EQUAL_UINT8(1, s.buttons.count(1));
+    TEST_ASSERT_EQUAL_UINT8(1, s.encoderBtn.count(0));
+    drain(s, m);
+    TEST_ASSERT_EQUAL_UINT32(1, m.rise[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, m.rise[4]);
+}
+
+static void test_clear_drops_pending() {
+    EdgeLatch l;
+    l.press(FLAG_SELECT);
+    l.consume(FLAG_SELECT);
+    l.press(FLAG_SELECT);
+    TEST_ASSERT_EQUAL_UINT8(0, l.pending());   // el master aún no vio el 0
+    l.clear();
+    TEST_ASSERT_EQUAL_UINT8(0, l.count(3));
+    l.press(FLAG_SELECT);
+    TEST_ASSERT_EQUAL_UINT8(FLAG_SELECT, l.pending());
+}
+
+// ─── Ráfagas aleatorias ───────────────────────────────────────
+// Pulsaciones rápidas de los cuatro botones y el encoder, polls
+// (a veces varios seguidos) y vueltas de loop en orden arbitrario
+
+static void test_random_toggles_every_edge_delivered() {
+    static constexpr int SEEDS = 50, STEPS = 20000;
+    for (int seed = 1; seed <= SEEDS; seed++) {
+        srand(seed);
+        Slave s; Master m;
+        uint32_t presses[5] = {};
+        for (int step = 0; step < STEPS; step++) {
+            int r = rand() % 10;
+            if (r < 3) {
+                uint8_t b = rand() % 5;
+                // saturación de EdgeLatch (255) fuera del test
+                if (b < 4 ? s.buttons.count(b) < 200 : s.encoderBtn.count(0) < 200) {
+                    if (b < 4) s.buttons.press(1 << b);
+                    else       s.encoderBtn.press(SLAVE_ENC_BUTTON);
+                    presses[b]++;
+                }
+            } else if (r < 6) {
+                s.loop();
+            } else {
+                poll(s, m);
+            }
+        }
+        drain(s, m);
+        for (uint8_t b = 0; b < 5; b++) {
+            if (m.rise[b] != presses[b] || m.fall[b] != presses[b]) {
+                char msg[96];
+                snprintf(msg, sizeof(msg), "seed %d bit %u: %u pulsaciones, %u/%u flancos",
+                         seed, b, (unsigned)presses[b], (unsigned)m.rise[b], (unsigned)m.fall[b]);
+                TEST_FAIL_MESSAGE(msg);
+            }
+        }
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_press_between_send_and_consume);
+    RUN_TEST(test_back_to_back_presses_one_poll_per_loop);
+    RUN_TEST(test_no_poll_nothing_consumed);
+    RUN_TEST(test_clear_drops_pending);
+    RUN_TEST(test_random_toggles_every_edge_delivered);
+    return UNITY_END();
+}
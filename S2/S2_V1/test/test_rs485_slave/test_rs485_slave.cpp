@@ -0,0 +1,235 @@
+// ============================================================
+//  test_rs485_slave.cpp  –  src/RS485 (RS485Slave) real en host
+//  pio test -e native -f test_rs485_slave
+//
+//  Reloj virtual y fakes del master (MASTER_S3-P4/P4/test/sim):
+//  el task responder corre como en el S2 y Serial1 es una
+//  sim::Line. El test hace de master: inyecta tramas con sus
+//  instantes de llegada y el UART llama onReceive en RX timeout;
+//  lo que el S2 escribe queda en line.frames (src == nullptr).
+//  Ranuras de grupo: instante de cada respuesta y CPU en espera
+//  activa del task (sim::Task::busyUs).
+// ============================================================
+#include <unity.h>
+#include <new>
+#include <imakie_protocol.h>
+
+// config.h trae el estado estático del motor; %u con size_t es
+// correcto en el S2 (32 bits)
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wformat"
+#include "../../src/RS485/RS485.cpp"
+
+// OTA por el bus: 0xAF es header válido, nunca hay respuesta
+namespace BusOta {
+bool available() { return true; }
+bool onFrame(const uint8_t*, size_t, uint8_t, uint8_t*, size_t&) { return false; }
+bool rebootPending() { return false; }
+void printStats() {}
+}  // namespace BusOta
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint8_t MY_ID = 3;
+
+// El otro extremo del cable (master o ruido)
+static sim::S2 s_peer(0);
+
+// S2 recién arrancado con una respuesta armada
+static void boot(uint32_t seed, uint8_t id = MY_ID) {
+    sim::reset(seed);
+    Serial1.line = sim::Line();
+    rs485.~RS485Slave();
+    new (&rs485) RS485Slave();
+    rs485.begin(id);
+    SlavePacket p = {};
+    p.faderPos = 1234;
+    rs485.setReply(p);
+}
+
+// Bytes del master (o ruido) en el cable desde 't'
+static void inject(uint64_t t, const uint8_t* buf, size_t len) {
+    std::vector<uint8_t> bytes(buf, buf + len);
+    sim::at(t, [bytes]() {
+        Serial1.line.slaveWrite(s_peer, bytes.data(), bytes.size(), sim::now(),
+                                Serial1.line.masterBaud, false, false);
+    });
+}
+
+static size_t poll(uint8_t* buf, uint8_t id) {
+    MasterPacket p = {};
+    p.id          = id;
+    p.faderTarget = 0x1000;
+    p.vuLevel     = 64;
+    memcpy(p.trackName, "VOCALS ", 7);
+    return rs485_encodeMaster(buf, p);
+}
+
+// Respuestas del S2 (tramas escritas por él) con id y CRC correctos
+static std::vector<sim::Frame> replies() {
+    std::vector<sim::Frame> out;
+    for (const sim::Frame& f : Serial1.line.frames)
+        if (!f.src && f.header == RS485_RESP_BYTE) out.push_back(f);
+    return out;
+}
+
+// Poll limpio: una respuesta, tras el fin de trama + RX timeout + despertar
+static void test_poll_answered_after_rx_timeout() {
+    boot(1);
+    uint8_t buf[sizeof(MasterPacket)];
+    const size_t   len = poll(buf, MY_ID);
+    const uint64_t t0  = sim::now() + 1000;
+    inject(t0, buf, len);
+    sim::run(5000);
+
+    auto r = replies();
+    TEST_ASSERT_EQUAL_UINT32(1, r.size());
+    const uint64_t end = t0 + sim::charUs(RS485_BAUD, len);
+    TEST_ASSERT_GREATER_OR_EQUAL(end + sim::charUs(RS485_BAUD, RS485_RX_IDLE_SYM), r[0].start);
+    TEST_ASSERT_LESS_THAN(end + 200, r[0].start);
+    MasterPacket got = rs485.getData();
+    TEST_ASSERT_EQUAL_UINT16(0x1000, got.faderTarget);
+}
+
+// Ruido con pinta de header de grupo (0xAE) que declara 200 bytes y
+// luego silencio: los polls siguientes no entran en su payload
+static void test_idle_gap_drops_false_long_header() {
+    boot(2);
+    const uint8_t noise[] = { RS485_GROUP_BYTE, 200, 0x55 };
+    static_assert(200 <= RS485_GROUP_MAX_LEN, "longitud aceptada por rs485_frameLength");
+    const uint64_t t0 = sim::now() + 1000;
+    inject(t0, noise, sizeof(noise));
+
+    uint8_t buf[sizeof(MasterPacket)];
+    const size_t len = poll(buf, MY_ID);
+    for (int k = 0; k < 3; k++) inject(t0 + 200 + k * 600, buf, len);
+    sim::run(5000);
+
+    TEST_ASSERT_EQUAL_UINT32(3, replies().size());
+}
+
+// Header falso sin silencio detrás: la trama real queda entera dentro
+// de la ventana rechazada, se re-parsea y se contesta igual
+static void test_replayed_frame_is_answered() {
+    boot(3);
+    uint8_t burst[40] = { RS485_GROUP_BYTE, sizeof(burst) };
+    poll(&burst[2], MY_ID);
+    const uint64_t t0 = sim::now() + 1000;
+    inject(t0, burst, sizeof(burst));
+    sim::run(5000);
+
+    auto r = replies();
+    TEST_ASSERT_EQUAL_UINT32(1, r.size());
+    TEST_ASSERT_GREATER_OR_EQUAL(t0 + sim::charUs(RS485_BAUD, sizeof(burst)), r[0].start);
+    TEST_ASSERT_EQUAL_UINT16(0x1000, rs485.getData().faderTarget);
+}
+
+// Poll a otro id detrás del ruido: nada que contestar
+static void test_other_id_not_answered() {
+    boot(4);
+    const uint8_t noise[] = { RS485_FW_BYTE, 120 };
+    const uint64_t t0 = sim::now() + 1000;
+    inject(t0, noise, sizeof(noise));
+    uint8_t buf[sizeof(MasterPacket)];
+    inject(t0 + 200, buf, poll(buf, MY_ID + 1));
+    inject(t0 + 800, buf, poll(buf, MY_ID));
+    sim::run(5000);
+
+    TEST_ASSERT_EQUAL_UINT32(1, replies().size());
+}
+
+// ─── Ranuras de grupo ─────────────────────────────────────────
+
+static constexpr uint8_t  SLOT_ID    = 8;
+static constexpr uint16_t SLOT_GUARD = 40;                 // RS485_GROUP_GUARD_US del master
+static const uint16_t     SLOT_US    = rs485_groupSlotUs(RS485_BAUD, SLOT_GUARD);
+
+// Trama de grupo en la que SLOT_ID ocupa la ranura 'slot' (ids 1..slot delante)
+static size_t groupFrame(uint8_t* buf, uint8_t slot) {
+    size_t len = rs485_groupBegin(buf, SLOT_US);
+    MasterPacket p = {};
+    p.faderTarget  = 0x0800;
+    for (uint8_t id = 1; id <= slot; id++) {
+        p.id = id;
+        len  = rs485_groupAdd(buf, len, p, 0);
+    }
+    p.id = SLOT_ID;
+    len  = rs485_groupAdd(buf, len, p, 0);
+    return rs485_groupEnd(buf, len);
+}
+
+static sim::Task* responder() {
+    for (auto& t : sim::state().tasks)
+        if (!strcmp(t->name, "RS485Resp")) return t.get();
+    return nullptr;
+}
+
+struct SlotRun {
+    int64_t  offsetUs;   // inicio de la respuesta − fin de la trama de grupo
+    uint64_t busyUs;     // espera activa del task
+    size_t   replies;
+};
+
+static SlotRun runSlot(uint8_t slot, uint32_t wakeUs = 5) {
+    boot(10 + slot, SLOT_ID);
+    sim::state().wakeUs = wakeUs;
+    uint8_t buf[RS485_GROUP_MAX_LEN];
+    const size_t   len = groupFrame(buf, slot);
+    const uint64_t t0  = sim::now() + 1000;
+    inject(t0, buf, len);
+    sim::run(slot * SLOT_US + 3000);
+
+    SlotRun r = {};
+    auto rep  = replies();
+    r.replies = rep.size();
+    r.busyUs  = responder()->busyUs;
+    if (!rep.empty())
+        r.offsetUs = (int64_t)rep[0].start - (int64_t)(t0 + sim::charUs(RS485_BAUD, len));
+    return r;
+}
+
+// Cada ranura cae a slot × slotUs de la 0 (mismo retardo de parseo) sin
+// comerse la guarda, y la espera activa no pasa de RS485_SLOT_SPIN_US
+static void test_group_slot_timing() {
+    const SlotRun r0 = runSlot(0);
+    TEST_ASSERT_EQUAL_UINT32(1, r0.replies);
+    for (uint8_t slot = 1; slot <= 6; slot++) {
+        const SlotRun r = runSlot(slot);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "ranura %u: %+lld us desde la 0 (ideal %u), espera activa %llu us",
+                 slot, (long long)(r.offsetUs - r0.offsetUs), slot * SLOT_US, (unsigned long long)r.busyUs);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL_UINT32(1, r.replies);
+        TEST_ASSERT_GREATER_OR_EQUAL(slot * SLOT_US, r.offsetUs - r0.offsetUs);
+        TEST_ASSERT_LESS_THAN(slot * SLOT_US + SLOT_GUARD / 2, r.offsetUs - r0.offsetUs);
+        TEST_ASSERT_LESS_OR_EQUAL(RS485_SLOT_SPIN_US, r.busyUs);
+    }
+}
+
+// Task despierto tarde (otro task de más prioridad, flash): la ranura ya
+// pasó la guarda → sin respuesta, que chocaría con la siguiente. El
+// poll siguiente se contesta con la respuesta que no salió
+static void test_late_slot_is_dropped() {
+    const SlotRun r = runSlot(3, 200);
+    TEST_ASSERT_EQUAL_UINT32(0, r.replies);
+    TEST_ASSERT_LESS_OR_EQUAL(RS485_SLOT_SPIN_US, r.busyUs);
+
+    uint8_t buf[sizeof(MasterPacket)];
+    inject(sim::now() + 500, buf, poll(buf, SLOT_ID));
+    sim::run(3000);
+    TEST_ASSERT_EQUAL_UINT32(1, replies().size());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_poll_answered_after_rx_timeout);
+    RUN_TEST(test_idle_gap_drops_false_long_header);
+    RUN_TEST(test_replayed_frame_is_answered);
+    RUN_TEST(test_other_id_not_answered);
+    RUN_TEST(test_group_slot_timing);
+    RUN_TEST(test_late_slot_is_dropped);
+    int rc = UNITY_END();
+    sim::stop();
+    return rc;
+}
@@ -1,5 +1,5 @@
 Import("env")
-import subprocess, sys, os
+import subprocess, sys, os, shutil
 
 def ota_upload(source, target, env):
     ip = "192.168.1.15"
@@ -25,4 +25,9 @@ def ota_upload(source, target, env):
     if result.returncode != 0:
         raise Exception("OTA upload failed")
 
+    # Base para el próximo delta (fwpack_build.py)
+    deployed = os.path.join(project_dir, ".pio", "deployed")
+    os.makedirs(deployed, exist_ok=True)
+    shutil.copyfile(firmware, os.path.join(deployed, "firmware.bin"))
+
 env.Replace(UPLOADCMD=ota_upload)
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+//  imakie_fixedstr.h  –  Cadena de capacidad fija (P4 y S3)
+//
+//  Sustituye a String en los caminos que Logic alimenta sin parar
+//  (nombres de pista del LCD, display de asignación, timecode):
+//  todo vive en el propio objeto, sin heap. Lo que no cabe se
+//  trunca en silencio. Copiar o devolver por valor es un memcpy.
+// ============================================================
+
+template <uint8_t N>
+class FixedString {
+public:
+    FixedString() { _buf[0] = '\0'; }
+    FixedString(const char* s) { assign(s); }
+
+    FixedString& operator=(const char* s) { assign(s); return *this; }
+
+    void assign(const char* s) { assign(s, s ? strlen(s) : 0); }
+    void assign(const char* s, size_t n) {
+        if (n > N) n = N;
+        if (n) memcpy(_buf, s, n);
+        _len = (uint8_t)n;
+        _buf[_len] = '\0';
+    }
+
+    FixedString& operator+=(char c) {
+        if (_len < N) { _buf[_len++] = c; _buf[_len] = '\0'; }
+        return *this;
+    }
+    FixedString& operator+=(const char* s) {
+        while (*s && _len < N) _buf[_len++] = *s++;
+        _buf[_len] = '\0';
+        return *this;
+    }
+
+    bool operator==(const char* s) const { return strcmp(_buf, s) == 0; }
+    bool operator!=(const char* s) const { return strcmp(_buf, s) != 0; }
+
+    // Quita espacios y controles de los dos extremos (como String::trim)
+    void trim() {
+        uint8_t a = 0;
+        while (a < _len && (uint8_t)_buf[a] <= ' ') a++;
+        while (_len > a && (uint8_t)_buf[_len - 1] <= ' ') _len--;
+        if (a) memmove(_buf, _buf + a, _len - a);
+        _len -= a;
+        _buf[_len] = '\0';
+    }
+
+    void padRight(uint8_t n, char c = ' ') {
+        if (n > N) n = N;
+        while (_len < n) _buf[_len++] = c;
+        _buf[_len] = '\0';
+    }
+
+    void clear() { _len = 0; _buf[0] = '\0'; }
+
+    const char* c_str()  const { return _buf; }
+    uint8_t     length() const { return _len; }
+    bool        empty()  const { return _len == 0; }
+    static constexpr uint8_t capacity() { return N; }
+
+private:
+    char    _buf[N + 1];
+    uint8_t _len = 0;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+//  imakie_lcd.h  –  Copia del LCD Mackie (SysEx 0x12), P4 y S3
+//
+//  2 filas × 56 caracteres, 8 celdas de 7 por fila:
+//    fila 0 (offset 0x00-0x37): nombres de pista
+//    fila 1 (offset 0x38-0x6F): valor del parámetro del VPot
+//  Un 0x12 escribe desde su offset y sigue en la fila siguiente.
+//  Solo se marcan los caracteres que cambian (un bit por carácter);
+//  takeDirty() los agrupa por celda, así que una fila reescrita
+//  igual por Logic (barridos de parámetro) no genera trabajo.
+// ============================================================
+
+#define MCU_LCD_COLS    56
+#define MCU_LCD_ROWS    2
+#define MCU_LCD_CELLS   (MCU_LCD_COLS * MCU_LCD_ROWS)
+#define MCU_LCD_CELL_W  7
+#define MCU_LCD_STRIPS  (MCU_LCD_COLS / MCU_LCD_CELL_W)
+
+class McuLcd {
+    static_assert(MCU_LCD_ROWS * MCU_LCD_STRIPS <= 16, "máscara de celdas en 16 bits");
+public:
+    McuLcd() { reset(); }
+
+    // Todo en blanco y limpio (GoOffline: Logic lo reescribirá entero)
+    void reset() {
+        memset(_text, ' ', sizeof(_text));
+        memset(_dirty, 0, sizeof(_dirty));
+        _pos = 0;
+    }
+
+    // Cabecera de un 0x12: offset del primer carácter
+    void begin(uint8_t offset) { _pos = offset; }
+
+    void feed(const uint8_t* text, size_t n) {
+        for (size_t i = 0; i < n && _pos < MCU_LCD_CELLS; i++, _pos++) {
+            const char c = (char)text[i];
+            if (_text[_pos] == c) continue;
+            _text[_pos] = c;
+            _dirty[_pos >> 3] |= 1 << (_pos & 7);
+        }
+    }
+
+    // Celdas con algún carácter cambiado: bit = fila * 8 + pista.
+    // Con partial = true se deja fuera la celda a medio escribir
+    // (el resto llega en el siguiente trozo del SysEx).
+    uint16_t takeDirty(bool partial = false) {
+        uint16_t mask = 0;
+        const uint8_t open = (partial && _pos < MCU_LCD_CELLS && _pos % MCU_LCD_CELL_W)
+                           ? _pos / MCU_LCD_CELL_W : 0xFF;
+        for (uint8_t c = 0; c < MCU_LCD_ROWS * MCU_LCD_STRIPS; c++) {
+            if (c == open || !_cellDirty(c)) continue;
+            _clearCell(c);
+            mask |= 1 << c;
+        }
+        return mask;
+    }
+
+    // Texto de una celda sin espacios al final: out[MCU_LCD_CELL_W + 1]
+    void cell(uint8_t row, uint8_t strip, char* out) const {
+        const char* p = &_text[row * MCU_LCD_COLS + strip * MCU_LCD_CELL_W];
+        uint8_t n = MCU_LCD_CELL_W;
+        while (n && (p[n - 1] == ' ' || p[n - 1] == '\0')) n--;
+        memcpy(out, p, n);
+        out[n] = '\0';
+    }
+
+    const char* row(uint8_t r) const { return &_text[r * MCU_LCD_COLS]; }   // sin '\0'
+
+private:
+    char    _text[MCU_LCD_CELLS];
+    uint8_t _dirty[MCU_LCD_CELLS / 8];
+    uint8_t _pos = 0;
+
+    bool _cellDirty(uint8_t c) const {
+        for (uint8_t i = c * MCU_LCD_CELL_W; i < (c + 1) * MCU_LCD_CELL_W; i++)
+            if (_dirty[i >> 3] & (1 << (i & 7))) return true;
+        return false;
+    }
+    void _clearCell(uint8_t c) {
+        for (uint8_t i = c * MCU_LCD_CELL_W; i < (c + 1) * MCU_LCD_CELL_W; i++)
+            _dirty[i >> 3] &= ~(1 << (i & 7));
+    }
+};
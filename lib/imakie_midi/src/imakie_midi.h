@@ -0,0 +1,277 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+//  imakie_midi.h  –  MIDI de entrada de los masters (P4 y S3)
+//
+//  Byte a byte, sin memoria dinámica ni buffer de mensaje: el
+//  tipo de cada status sale de MIDI_STATUS_TABLE (constexpr).
+//    - running status en mensajes de canal; system common lo anula
+//    - realtime (0xF8-0xFF) en cualquier punto, también dentro de
+//      un mensaje o de un SysEx, sin tocar el estado
+//    - SysEx a trozos de CHUNK bytes (sin F0/F7): el LCD Mackie se
+//      procesa mientras llega, sin límite de longitud
+//    - cualquier otro status dentro de un SysEx lo cierra con
+//      MIDI_SYSEX_ABORT y se procesa normalmente
+//
+//  pushPacket(): paquetes USB-MIDI de 4 bytes tal cual llegan de
+//  tud_midi_packet_read(). El CIN (nibble bajo de la cabecera) ya
+//  dice qué es y cuánto mide: canal y system common se despachan
+//  sin pasar por la máquina de estados; solo SysEx (CIN 0x4-0x7) y
+//  byte suelto (0xF) van byte a byte por push().
+// ============================================================
+
+enum MidiStatusKind : uint8_t {
+    MIDI_KIND_CHANNEL  = 0x00,   // 0x80-0xEF: running status
+    MIDI_KIND_COMMON   = 0x10,   // 0xF1-0xF6 (+ F4/F5 sin definir): anula running status
+    MIDI_KIND_SYSEX    = 0x20,   // 0xF0
+    MIDI_KIND_EOX      = 0x30,   // 0xF7
+    MIDI_KIND_REALTIME = 0x40,   // 0xF8-0xFF
+};
+
+#define MIDI_KIND_MASK   0xF0
+#define MIDI_LEN_MASK    0x03
+
+// Entrada (status & 0x7F): tipo | bytes de datos
+struct MidiStatusTable {
+    uint8_t t[128];
+    constexpr MidiStatusTable() : t() {
+        for (int s = 0x80; s <= 0xFF; s++) {
+            uint8_t v = 0;
+            if (s < 0xF0) {
+                const uint8_t hi = s & 0xF0;
+                v = MIDI_KIND_CHANNEL | ((hi == 0xC0 || hi == 0xD0) ? 1 : 2);
+            } else if (s == 0xF0) v = MIDI_KIND_SYSEX;
+            else if (s == 0xF7)   v = MIDI_KIND_EOX;
+            else if (s >= 0xF8)   v = MIDI_KIND_REALTIME;
+            else if (s == 0xF2)   v = MIDI_KIND_COMMON | 2;        // song position
+            else if (s == 0xF1 || s == 0xF3) v = MIDI_KIND_COMMON | 1;   // MTC, song select
+            else                  v = MIDI_KIND_COMMON;             // F4, F5, F6
+            t[s & 0x7F] = v;
+        }
+    }
+};
+inline constexpr MidiStatusTable MIDI_STATUS_TABLE{};
+
+static_assert(MIDI_STATUS_TABLE.t[0x90 & 0x7F] == (MIDI_KIND_CHANNEL | 2), "note on");
+static_assert(MIDI_STATUS_TABLE.t[0xD3 & 0x7F] == (MIDI_KIND_CHANNEL | 1), "channel pressure");
+static_assert(MIDI_STATUS_TABLE.t[0xF6 & 0x7F] == MIDI_KIND_COMMON,        "tune request");
+
+// Code Index Number (USB-MIDI 1.0, tabla 4-1)
+enum MidiCin : uint8_t {
+    MIDI_CIN_COMMON_2   = 0x2,   // system common de 2 bytes (F1, F3)
+    MIDI_CIN_COMMON_3   = 0x3,   // system common de 3 bytes (F2)
+    MIDI_CIN_SYSEX      = 0x4,   // SysEx: empieza o sigue, 3 bytes
+    MIDI_CIN_SYSEX_END1 = 0x5,   // SysEx acaba con 1 byte, o common de 1 byte (F6)
+    MIDI_CIN_SYSEX_END2 = 0x6,
+    MIDI_CIN_SYSEX_END3 = 0x7,
+    MIDI_CIN_NOTE_OFF   = 0x8,   // 0x8-0xE: mensaje de canal, CIN = status >> 4
+    MIDI_CIN_PITCHBEND  = 0xE,
+    MIDI_CIN_BYTE       = 0xF,   // byte suelto (realtime)
+};
+
+enum MidiSysExFlags : uint8_t {
+    MIDI_SYSEX_START = 1 << 0,   // primer trozo (tras F0)
+    MIDI_SYSEX_END   = 1 << 1,   // último trozo, F7 recibido
+    MIDI_SYSEX_ABORT = 1 << 2,   // último trozo, cortado por otro status
+};
+
+// ============================================================
+//  MidiParser — callbacks en el constructor o en begin(), luego
+//  push() (flujo de bytes) o pushPacket() (USB-MIDI), sin mezclar
+//  CHUNK: bytes de SysEx por llamada a SysExFn
+// ============================================================
+template <uint8_t CHUNK>
+class MidiParser {
+    static_assert(CHUNK >= 8, "cabecera Mackie (6 bytes) en el primer trozo");
+public:
+    typedef void (*MessageFn) (void* ctx, uint8_t status, uint8_t d1, uint8_t d2);
+    typedef void (*SysExFn)   (void* ctx, const uint8_t* data, uint8_t n, uint8_t flags);
+    typedef void (*RealtimeFn)(void* ctx, uint8_t status);
+
+    MidiParser() = default;
+    MidiParser(MessageFn msg, SysExFn sysex, RealtimeFn realtime = nullptr, void* ctx = nullptr)
+        : _msg(msg), _sysex(sysex), _realtime(realtime), _ctx(ctx) {}
+
+    void begin(MessageFn msg, SysExFn sysex, RealtimeFn realtime = nullptr, void* ctx = nullptr) {
+        _msg      = msg;
+        _sysex    = sysex;
+        _realtime = realtime;
+        _ctx      = ctx;
+        reset();
+    }
+
+    void reset() {
+        _status  = 0;
+        _got     = 0;
+        _inSysEx = false;
+        _sxLen   = 0;
+    }
+
+    void push(const uint8_t* p, size_t n) { while (n--) push(*p++); }
+
+    void push(uint8_t b) {
+        if (b < 0x80) {
+            if (_inSysEx) {
+                _sx[_sxLen++] = b;
+                if (_sxLen == CHUNK) _flushSysEx(0);
+                return;
+            }
+            if (!_status) { _stray++; return; }
+            _data[_got++] = b;
+            if (_got < _need) return;
+            _got = 0;
+            _msg(_ctx, _status, _data[0], _need > 1 ? _data[1] : 0);
+            if (!_running) _status = 0;
+            return;
+        }
+
+        const uint8_t e = MIDI_STATUS_TABLE.t[b & 0x7F];
+        switch (e & MIDI_KIND_MASK) {
+            case MIDI_KIND_REALTIME:
+                if (_realtime) _realtime(_ctx, b);
+                return;
+
+            case MIDI_KIND_EOX:
+                if (_inSysEx) _endSysEx(MIDI_SYSEX_END);
+                _status = 0;
+                return;
+
+            case MIDI_KIND_SYSEX:
+                if (_inSysEx) _endSysEx(MIDI_SYSEX_ABORT);
+                _inSysEx = true;
+                _sxFlags = MIDI_SYSEX_START;
+                _sxLen   = 0;
+                _status  = 0;
+                return;
+
+            default:    // canal o system common
+                if (_inSysEx) _endSysEx(MIDI_SYSEX_ABORT);
+                _need    = e & MIDI_LEN_MASK;
+                _running = (e & MIDI_KIND_MASK) == MIDI_KIND_CHANNEL;
+                _got     = 0;
+                if (_need) { _status = b; return; }
+                _status = 0;                        // F6: mensaje completo ya
+                _msg(_ctx, b, 0, 0);
+                return;
+        }
+    }
+
+    void pushPacket(const uint8_t* pkt) {
+        const uint8_t cin = pkt[0] & 0x0F;
+        if (cin >= MIDI_CIN_NOTE_OFF && cin <= MIDI_CIN_PITCHBEND) {
+            if (pkt[1] >> 4 != cin) { _stray++; return; }     // status y CIN no cuadran
+            _packetMessage(pkt);
+            return;
+        }
+        switch (cin) {
+            case MIDI_CIN_COMMON_2:
+            case MIDI_CIN_COMMON_3: {
+                // Solo F1/F3 (CIN 2) y F2 (CIN 3): ni SysEx, ni realtime, ni F6
+                const uint8_t e = pkt[1] >= 0xF0 ? MIDI_STATUS_TABLE.t[pkt[1] & 0x7F] : 0;
+                if ((e & MIDI_KIND_MASK) != MIDI_KIND_COMMON || (e & MIDI_LEN_MASK) != cin - 1) {
+                    _stray++;
+                    return;
+                }
+                _packetMessage(pkt);
+                return;
+            }
+            case MIDI_CIN_SYSEX:
+                push(pkt[1]); push(pkt[2]); push(pkt[3]);
+                return;
+            case MIDI_CIN_SYSEX_END1:
+            case MIDI_CIN_SYSEX_END2:
+            case MIDI_CIN_SYSEX_END3:
+                for (uint8_t k = 1; k <= cin - MIDI_CIN_SYSEX; k++) push(pkt[k]);
+                return;
+            case MIDI_CIN_BYTE:
+                push(pkt[1]);
+                return;
+            default:                                        // 0x0/0x1 reservados
+                return;
+        }
+    }
+
+    uint32_t strayBytes() const { return _stray; }   // datos sin status; paquetes con CIN/datos incoherentes
+
+private:
+    MessageFn  _msg      = nullptr;
+    SysExFn    _sysex    = nullptr;
+    RealtimeFn _realtime = nullptr;
+    void*      _ctx      = nullptr;
+
+    uint8_t  _status  = 0;          // 0 = sin status activo
+    uint8_t  _need    = 0;
+    uint8_t  _got     = 0;
+    bool     _running = false;
+    uint8_t  _data[2];
+
+    bool     _inSysEx = false;
+    uint8_t  _sxFlags = 0;
+    uint8_t  _sxLen   = 0;
+    uint8_t  _sx[CHUNK];
+    uint32_t _stray   = 0;
+
+    // Mensaje completo de un paquete (CIN ya validado): los datos deben
+    // ser < 0x80, como en push()
+    void _packetMessage(const uint8_t* pkt) {
+        const uint8_t need = MIDI_STATUS_TABLE.t[pkt[1] & 0x7F] & MIDI_LEN_MASK;
+        const uint8_t d1   = pkt[2];
+        const uint8_t d2   = need > 1 ? pkt[3] : 0;
+        if ((d1 | d2) & 0x80) { _stray++; return; }
+        if (_inSysEx) _endSysEx(MIDI_SYSEX_ABORT);
+        _status = 0;
+        _msg(_ctx, pkt[1], d1, d2);
+    }
+
+    void _flushSysEx(uint8_t flags) {
+        _sysex(_ctx, _sx, _sxLen, _sxFlags | flags);
+        _sxFlags = 0;
+        _sxLen   = 0;
+    }
+
+    void _endSysEx(uint8_t flags) {
+        _inSysEx = false;
+        _flushSysEx(flags);
+    }
+};
+
+// ============================================================
+//  McuNoteMap — botones de pantalla ↔ notas MCU
+//
+//  Se genera en compilación desde un único mapa declarativo
+//  tecla → nota por página (config.h, 0x00 = tecla sin nota):
+//    note[página][tecla] → nota     (UI → Logic)
+//    key [página][nota]  → tecla    (Logic → UI), MCU_NO_KEY si no hay
+//  Así cada nota entrante se resuelve en O(1) y las dos direcciones
+//  no pueden divergir.
+// ============================================================
+#define MCU_NO_KEY  0xFF
+
+template <uint8_t PAGES, uint8_t KEYS>
+struct McuNoteMap {
+    static_assert(KEYS < MCU_NO_KEY, "tecla en un byte");
+
+    uint8_t note[PAGES][KEYS] = {};
+    uint8_t key [PAGES][128]  = {};
+    bool    unique = true;          // false: nota repetida dentro de una página
+
+    constexpr uint8_t keyOf(uint8_t page, uint8_t n) const { return key[page][n & 0x7F]; }
+};
+
+template <uint8_t PAGES, uint8_t KEYS>
+constexpr McuNoteMap<PAGES, KEYS> mcuNoteMap(const uint8_t (&notes)[PAGES][KEYS]) {
+    McuNoteMap<PAGES, KEYS> m;
+    for (uint8_t p = 0; p < PAGES; p++) {
+        for (int n = 0; n < 128; n++) m.key[p][n] = MCU_NO_KEY;
+        for (uint8_t k = 0; k < KEYS; k++) {
+            const uint8_t n = notes[p][k];
+            m.note[p][k] = n;
+            if (n == 0x00 || n > 0x7F) continue;
+            if (m.key[p][n] != MCU_NO_KEY) m.unique = false;
+            else                           m.key[p][n] = k;
+        }
+    }
+    return m;
+}
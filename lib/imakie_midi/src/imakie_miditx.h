@@ -0,0 +1,193 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "imakie_midi.h"
+
+// ============================================================
+//  imakie_miditx.h  –  cola única de salida USB-MIDI (P4 y S3)
+//
+//  Cualquier task encola paquetes de 4 bytes; solo el consumidor
+//  (task MIDI) llama flush() una vez por frame USB (1 ms) y escribe
+//  fuera del lock: los productores nunca esperan a TinyUSB.
+//
+//  Pitch bend: un PB pendiente del mismo canal se sobrescribe en su
+//  sitio solo si sigue siendo lo último encolado para ese canal.
+//  Cualquier otro evento del canal (nota, CC...) o un paquete sin
+//  canal (SysEx, system) cierra la ventana: el PB siguiente va
+//  detrás y el flujo de cada canal sale en el orden de entrada.
+//
+//  SysEx: entero o nada, sin intercalar con otros productores y sin
+//  truncar (ver pushSysEx()).
+//
+//  Pkt: {header, byte1, byte2, byte3} (midiEventPacket_t de USBMIDI).
+//  Lock: lock()/unlock(); en el firmware MidiTxSpinlock (abajo).
+// ============================================================
+
+// Paquetes que ocupa un SysEx de 'len' bytes (F0 ... F7)
+inline size_t midiSysExPackets(size_t len) { return (len + 2) / 3; }
+
+// Siguiente paquete del SysEx desde data[pos]; devuelve la nueva posición.
+// CIN 0x4 mientras queden más de 3 bytes, 0x5-0x7 con el final.
+template <typename Pkt>
+size_t midiPackSysEx(const uint8_t* data, size_t len, size_t pos, Pkt& p) {
+    const size_t  rest = len - pos;
+    const uint8_t n    = rest > 3 ? 3 : (uint8_t)rest;
+    p.header = (uint8_t)(rest > 3 ? MIDI_CIN_SYSEX : MIDI_CIN_SYSEX + n);
+    p.byte1  = data[pos];
+    p.byte2  = n > 1 ? data[pos + 1] : 0;
+    p.byte3  = n > 2 ? data[pos + 2] : 0;
+    return pos + n;
+}
+
+// Mensaje de canal de 3 bytes → paquete (cable 0). Note On con
+// velocity 0 sale como Note Off. false: tipo no soportado.
+template <typename Pkt>
+bool midiPackMessage(const uint8_t* data, size_t len, Pkt& p) {
+    if (len != 3) return false;
+    const uint8_t status = data[0] & 0xF0;
+    p = Pkt{ 0, data[0], data[1], data[2] };
+    switch (status) {
+        case 0x90:
+            if (data[2] == 0) {
+                p.byte1  = 0x80 | (data[0] & 0x0F);
+                p.header = 0x08;
+            } else {
+                p.header = 0x09;
+            }
+            return true;
+        case 0x80:
+        case 0xB0:
+        case 0xE0:
+            p.header = status >> 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename Pkt, uint16_t N, class Lock>
+class MidiTxQueue {
+public:
+    struct Stats {
+        uint32_t pushed = 0, coalesced = 0, sent = 0, flushes = 0, dropped = 0, direct = 0;
+    };
+
+    MidiTxQueue() { _closeAll(); }
+
+    // Thread-safe, nunca bloquea. false: cola llena (se cuenta)
+    bool push(const Pkt& pkt) {
+        bool ok = true;
+        _lock.lock();
+        _st.pushed++;
+        const uint8_t cin = pkt.header & 0x0F;
+        const uint8_t ch  = pkt.byte1 & 0x0F;
+        if (cin < MIDI_CIN_NOTE_OFF || cin > MIDI_CIN_PITCHBEND) {
+            ok = _append(pkt);
+            _closeAll();
+        } else if (cin == MIDI_CIN_PITCHBEND && _pbSlot[ch] >= 0) {
+            _q[_pbSlot[ch]] = pkt;              // valor superado, último del canal
+            _st.coalesced++;
+        } else {
+            const int16_t at = _count;
+            ok = _append(pkt);
+            _pbSlot[ch] = (ok && cin == MIDI_CIN_PITCHBEND) ? at : -1;
+        }
+        _lock.unlock();
+        return ok;
+    }
+
+    // SysEx F0 ... F7 de cualquier longitud:
+    //  - cabe en la cola → entero y seguido, true
+    //  - no cabe y llama el consumidor → flush(write) y el SysEx sale
+    //    directo por 'write' detrás (nadie más escribe: orden intacto)
+    //  - no cabe y llama otro task → nada encolado, false (reintentar
+    //    tras el siguiente flush; el que llama decide cuánto esperar)
+    template <class Write>
+    bool pushSysEx(const uint8_t* data, size_t len, bool consumer, Write&& write) {
+        const size_t need = midiSysExPackets(len);
+        _lock.lock();
+        if (_count + need <= N) {
+            for (size_t pos = 0; pos < len;) pos = midiPackSysEx(data, len, pos, _q[_count++]);
+            _st.pushed += need;
+            _closeAll();
+            _lock.unlock();
+            return true;
+        }
+        _lock.unlock();
+        if (!consumer) return false;
+
+        flush(write);
+        Pkt p;
+        for (size_t pos = 0; pos < len;) {
+            pos = midiPackSysEx(data, len, pos, p);
+            write(p);
+        }
+        _lock.lock();
+        _st.pushed += need;
+        _st.sent   += need;
+        _st.direct += need;
+        _lock.unlock();
+        return true;
+    }
+
+    // Solo el consumidor: copia bajo lock, escribe fuera. Devuelve paquetes escritos
+    template <class Write>
+    uint16_t flush(Write&& write) {
+        Pkt      out[N];
+        uint16_t n;
+        _lock.lock();
+        n = _count;
+        memcpy(out, _q, n * sizeof(Pkt));
+        _count = 0;
+        _closeAll();
+        _lock.unlock();
+
+        if (n == 0) return 0;
+        for (uint16_t i = 0; i < n; i++) write(out[i]);
+        _lock.lock();
+        _st.sent += n;
+        _st.flushes++;
+        _lock.unlock();
+        return n;
+    }
+
+    // Sin lock: informativo (printStats)
+    const Stats& stats() const { return _st; }
+    void countDropped(uint32_t n) {
+        _lock.lock();
+        _st.dropped += n;
+        _lock.unlock();
+    }
+
+private:
+    Lock     _lock;
+    Pkt      _q[N];
+    uint16_t _count = 0;
+    int16_t  _pbSlot[16];          // PB coalescible por canal: índice en _q, -1 = ninguno
+    Stats    _st;
+
+    bool _append(const Pkt& pkt) {
+        if (_count >= N) {
+            _st.dropped++;
+            return false;
+        }
+        _q[_count++] = pkt;
+        return true;
+    }
+
+    void _closeAll() {
+        for (auto& s : _pbSlot) s = -1;
+    }
+};
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+
+// Sección crítica entre núcleos: los productores nunca duermen
+struct MidiTxSpinlock {
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    void lock()   { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+};
+#endif
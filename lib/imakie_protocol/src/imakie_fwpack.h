@@ -0,0 +1,266 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+//  imakie_fwpack.h  –  Imágenes de firmware comprimidas / delta
+//
+//  Contenedor "IMZ1" para el firmware S2: LZ (ventana deslizante,
+//  estilo heatshrink) o delta contra la imagen que el S2 ya
+//  ejecuta (copias desde la base + LZ para lo nuevo).
+//  Decoder en streaming: entrada en trozos de cualquier tamaño,
+//  salida secuencial a un callback (esp_ota_write). RAM: la
+//  ventana (1 << windowBits) + ~300 B. Sin dependencias: el
+//  encoder de host (tools/fwpack) usa este mismo decoder para
+//  verificar lo que genera.
+//
+//  Cabecera (FWPACK_HEADER_LEN = 32, little-endian):
+//    [0]  "IMZ1"
+//    [4]  format       FWPACK_LZ | FWPACK_DELTA
+//    [5]  windowBits   8..FWPACK_MAX_WINDOW_BITS
+//    [6]  reservado (0)
+//    [8]  outSize:4    tamaño de la imagen resultante
+//    [12] outCrc:4     CRC-32 (IEEE) de la imagen resultante
+//    [16] fwId:8       prefijo app_elf_sha256 de la imagen resultante
+//    [24] baseId:8     prefijo app_elf_sha256 de la base (solo delta)
+//
+//  Operaciones (tras la cabecera, hasta outSize bytes de salida):
+//    0lllllll                 literales: l+1 bytes (1..128) a continuación
+//    10llllll [ext] dist:2    copia de la ventana: len = l+3, dist 1..ventana
+//    11llllll [ext] off       copia de la base:    len = l+4
+//      ext  (l == 63): varint, len += ext
+//      off: varint zigzag relativo al fin de la copia de base anterior
+//           (0 = sigue justo detrás → parches de punteros en 3-4 bytes)
+// ============================================================
+
+#define FWPACK_MAGIC            "IMZ1"
+#define FWPACK_HEADER_LEN       32
+#define FWPACK_ID_LEN           8
+#define FWPACK_WINDOW_BITS      12          // 4 KB: lo que usa tools/fwpack por defecto
+#define FWPACK_MAX_WINDOW_BITS  14
+#define FWPACK_LIT_MAX          128
+#define FWPACK_WIN_MIN          3
+#define FWPACK_BASE_MIN         4
+#define FWPACK_LEN_EXT          63          // campo l lleno → sigue varint
+#define FWPACK_OP_MAX_LEN       12          // op + varint(5) + varint(5) / dist(2)
+
+enum FwPackFormat : uint8_t {
+    FWPACK_RAW   = 0,       // .bin tal cual (sin contenedor)
+    FWPACK_LZ    = 1,
+    FWPACK_DELTA = 2,
+};
+
+struct FwPackHeader {
+    uint8_t  format     = FWPACK_LZ;
+    uint8_t  windowBits = FWPACK_WINDOW_BITS;
+    uint32_t outSize    = 0;
+    uint32_t outCrc     = 0;
+    uint8_t  fwId[FWPACK_ID_LEN]   = {};
+    uint8_t  baseId[FWPACK_ID_LEN] = {};
+};
+
+inline void fwpack_put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+inline uint32_t fwpack_get32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// CRC-32 IEEE (reflejado, 0xEDB88320), tabla de nibbles: 64 B de flash
+inline uint32_t fwpack_crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    static const uint32_t T[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ T[crc & 15];
+        crc = (crc >> 4) ^ T[crc & 15];
+    }
+    return ~crc;
+}
+
+inline void fwpack_writeHeader(uint8_t* b, const FwPackHeader& h) {
+    memset(b, 0, FWPACK_HEADER_LEN);
+    memcpy(b, FWPACK_MAGIC, 4);
+    b[4] = h.format;
+    b[5] = h.windowBits;
+    fwpack_put32(&b[8],  h.outSize);
+    fwpack_put32(&b[12], h.outCrc);
+    memcpy(&b[16], h.fwId,   FWPACK_ID_LEN);
+    memcpy(&b[24], h.baseId, FWPACK_ID_LEN);
+}
+
+inline bool fwpack_parseHeader(const uint8_t* b, size_t n, FwPackHeader& h) {
+    if (n < FWPACK_HEADER_LEN || memcmp(b, FWPACK_MAGIC, 4) != 0) return false;
+    h.format     = b[4];
+    h.windowBits = b[5];
+    if (h.format != FWPACK_LZ && h.format != FWPACK_DELTA) return false;
+    if (h.windowBits < 8 || h.windowBits > FWPACK_MAX_WINDOW_BITS) return false;
+    h.outSize = fwpack_get32(&b[8]);
+    h.outCrc  = fwpack_get32(&b[12]);
+    memcpy(h.fwId,   &b[16], FWPACK_ID_LEN);
+    memcpy(h.baseId, &b[24], FWPACK_ID_LEN);
+    return h.outSize > 0;
+}
+
+enum class FwUnpackStatus : uint8_t {
+    OK,             // sigue aceptando entrada
+    DONE,           // finish(): outSize bytes y CRC correcto
+    BAD_DATA,       // op fuera de rango, salida de más o CRC distinto
+    BASE_ERROR,     // readBase() falló
+    WRITE_ERROR,    // write() falló
+};
+
+// ============================================================
+//  FwUnpack — decoder en streaming
+//  begin() → push() con los trozos en orden → finish()
+// ============================================================
+class FwUnpack {
+public:
+    typedef bool (*WriteFn)(void* ctx, const uint8_t* src, size_t n);
+    typedef bool (*ReadFn) (void* ctx, uint32_t off, uint8_t* dst, size_t n);
+
+    // window: (1 << h.windowBits) bytes, los reserva quien llama.
+    // readBase/baseSize solo para FWPACK_DELTA
+    void begin(const FwPackHeader& h, uint8_t* window, WriteFn write, void* ctx,
+               ReadFn readBase = nullptr, uint32_t baseSize = 0) {
+        _h        = h;
+        _win      = window;
+        _mask     = (1u << h.windowBits) - 1;
+        _write    = write;
+        _read     = readBase;
+        _ctx      = ctx;
+        _baseSize = baseSize;
+        _pos = _baseNext = _litLeft = 0;
+        _opLen = 0;
+        _outLen = 0;
+        _crc = 0;
+        _status = FwUnpackStatus::OK;
+    }
+
+    FwUnpackStatus push(const uint8_t* in, size_t n) {
+        while (n && _status == FwUnpackStatus::OK) {
+            if (_litLeft) {
+                size_t k = n < _litLeft ? n : _litLeft;
+                if (_pos + k > _h.outSize) return _fail(FwUnpackStatus::BAD_DATA);
+                for (size_t i = 0; i < k; i++) _emit(in[i]);
+                _litLeft -= k;
+                in += k;
+                n  -= k;
+                continue;
+            }
+            _op[_opLen++] = *in++;
+            n--;
+            _parseOp();
+        }
+        return _status;
+    }
+
+    FwUnpackStatus finish() {
+        if (_status != FwUnpackStatus::OK) return _status;
+        _flush();
+        if (_status != FwUnpackStatus::OK) return _status;
+        if (_pos != _h.outSize || _opLen || _litLeft || _crc != _h.outCrc)
+            return _fail(FwUnpackStatus::BAD_DATA);
+        return _status = FwUnpackStatus::DONE;
+    }
+
+    uint32_t produced() const { return _pos; }
+
+private:
+    FwPackHeader _h;
+    uint8_t*  _win      = nullptr;
+    uint32_t  _mask     = 0;
+    WriteFn   _write    = nullptr;
+    ReadFn    _read     = nullptr;
+    void*     _ctx      = nullptr;
+    uint32_t  _baseSize = 0;
+
+    uint32_t  _pos      = 0;         // bytes de salida generados
+    uint32_t  _baseNext = 0;         // fin de la última copia de base
+    uint32_t  _litLeft  = 0;
+    uint8_t   _op[FWPACK_OP_MAX_LEN];
+    uint8_t   _opLen    = 0;
+    uint8_t   _out[256];             // salida agrupada antes de write()
+    uint16_t  _outLen   = 0;
+    uint32_t  _crc      = 0;
+    FwUnpackStatus _status = FwUnpackStatus::OK;
+
+    FwUnpackStatus _fail(FwUnpackStatus s) { return _status = s; }
+
+    void _flush() {
+        if (!_outLen) return;
+        _crc = fwpack_crc32(_crc, _out, _outLen);
+        if (!_write(_ctx, _out, _outLen)) _fail(FwUnpackStatus::WRITE_ERROR);
+        _outLen = 0;
+    }
+
+    void _emit(uint8_t b) {
+        _win[_pos & _mask] = b;
+        _pos++;
+        _out[_outLen++] = b;
+        if (_outLen == sizeof(_out)) _flush();
+    }
+
+    // varint LEB128 en _op[i..]: false = incompleto (o > 5 bytes → BAD_DATA)
+    bool _varint(uint8_t& i, uint32_t& v) {
+        v = 0;
+        for (uint8_t s = 0; ; s += 7) {
+            if (i >= _opLen) {
+                if (_opLen >= FWPACK_OP_MAX_LEN) _fail(FwUnpackStatus::BAD_DATA);
+                return false;
+            }
+            uint8_t b = _op[i++];
+            if (s == 28 && b > 0x0F) { _fail(FwUnpackStatus::BAD_DATA); return false; }
+            v |= (uint32_t)(b & 0x7F) << s;
+            if (!(b & 0x80)) return true;
+        }
+    }
+
+    // Cabecera de op completa → se ejecuta; incompleta → espera más bytes
+    void _parseOp() {
+        const uint8_t op = _op[0];
+        if (!(op & 0x80)) {
+            _litLeft = (op & 0x7F) + 1;
+            _opLen   = 0;
+            return;
+        }
+        const bool base = (op & 0x40) != 0;
+        uint32_t len = (op & 0x3F) + (base ? FWPACK_BASE_MIN : FWPACK_WIN_MIN);
+        uint8_t  i   = 1;
+        if ((op & 0x3F) == FWPACK_LEN_EXT) {
+            uint32_t ext;
+            if (!_varint(i, ext)) return;
+            if (ext > _h.outSize) { _fail(FwUnpackStatus::BAD_DATA); return; }
+            len += ext;
+        }
+        if (_pos + len > _h.outSize) { _fail(FwUnpackStatus::BAD_DATA); return; }
+
+        if (!base) {
+            if (_opLen < i + 2) return;
+            uint32_t dist = _op[i] | (_op[i + 1] << 8);
+            _opLen = 0;
+            if (dist == 0 || dist > _pos || dist > _mask + 1) { _fail(FwUnpackStatus::BAD_DATA); return; }
+            for (uint32_t k = 0; k < len; k++) _emit(_win[(_pos - dist) & _mask]);
+            return;
+        }
+
+        uint32_t zz;
+        if (!_varint(i, zz)) return;
+        _opLen = 0;
+        int64_t off = (int64_t)_baseNext + (int32_t)((zz >> 1) ^ (0u - (zz & 1)));
+        if (!_read || off < 0 || off + len > _baseSize) { _fail(FwUnpackStatus::BAD_DATA); return; }
+        _baseNext = (uint32_t)off + len;
+        uint8_t chunk[64];
+        while (len) {
+            uint32_t k = len < sizeof(chunk) ? len : sizeof(chunk);
+            if (!_read(_ctx, (uint32_t)off, chunk, k)) { _fail(FwUnpackStatus::BASE_ERROR); return; }
+            for (uint32_t j = 0; j < k; j++) _emit(chunk[j]);
+            off += k;
+            len -= k;
+        }
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+#include <stdio.h>
+#include "imakie_protocol.h"
+
+// ============================================================
+//  imakie_profiler.h  –  Profiler RS485 de los masters (P4 y S3)
+//
+//  Histogramas logarítmicos de latencia por slave: las medias
+//  esconden justo la cola (p99) que hace que un fader "se pegue".
+//  Siempre activo: add() es un clz, un incremento y un max; sin
+//  floats ni locks. Cada histograma tiene un solo escritor (task
+//  del bus o task MIDI); report/snapshot desde otro task pueden
+//  ir una muestra por detrás, nada más.
+//
+//  Cubetas: 2^PROF_SUB_BITS por octava → error ≤ 12.5 %.
+//  0..7 µs exactos; ≥ 2^PROF_MAX_BITS µs (~4 s) a la última.
+//
+//  Snapshot binario (tools/rs485prof), little-endian:
+//    [0]  "IMPF"
+//    [4]  version   PROF_VERSION
+//    [5]  subBits   PROF_SUB_BITS
+//    [6]  bus       'A' / 'B' (P4), 'S' (S3)
+//    [7]  firstId   id global del slave 1 del bus
+//    [8]  slaves
+//    [9]  records   histogramas que siguen (solo los no vacíos)
+//    [10] reservado:2
+//    [12] uptimeMs:4
+//    Contadores, slaves × PROF_COUNTERS_LEN:
+//         polls:4 timeouts:4 crcErrors:4 idMismatch:4
+//    Histograma, records ×:
+//         [metric][id][count:4][max:4][sum:8][nz] + nz × ([bucket][n:4])
+//         id: slave local 1..slaves (0 = todo el bus)
+//    [crc8] rs485_crc8 de todo lo anterior
+// ============================================================
+
+#define PROF_MAGIC          "IMPF"
+#define PROF_VERSION        1
+#define PROF_SUB_BITS       3
+#define PROF_MAX_BITS       22
+#define PROF_BUCKETS        ((PROF_MAX_BITS - PROF_SUB_BITS + 1) << PROF_SUB_BITS)
+#define PROF_HEADER_LEN     16
+#define PROF_COUNTERS_LEN   16
+#define PROF_RECORD_LEN     19          // cabecera de histograma, sin cubetas
+#define PROF_BUCKET_LEN     5
+
+static_assert(PROF_BUCKETS <= 256, "índice de cubeta en un byte");
+
+enum ProfMetric : uint8_t {
+    PROF_RX_WAIT = 1,   // fin del poll → respuesta completa (por slave)
+    PROF_CYCLE   = 2,   // inicio de barrido → siguiente (id 0)
+    PROF_E2E     = 3,   // respuesta RS485 → USB-MIDI enviado (evento FADER)
+};
+
+inline uint8_t prof_bucket(uint32_t us) {
+    if (us < (1u << PROF_SUB_BITS))  return (uint8_t)us;
+    if (us >= (1u << PROF_MAX_BITS)) return PROF_BUCKETS - 1;
+    const uint8_t e = 31 - __builtin_clz(us);              // 2^e ≤ us < 2^(e+1)
+    return (uint8_t)(((e - PROF_SUB_BITS + 1) << PROF_SUB_BITS) |
+                     ((us >> (e - PROF_SUB_BITS)) & ((1u << PROF_SUB_BITS) - 1)));
+}
+
+inline uint32_t prof_bucketLow(uint8_t b) {
+    if (b < (1u << PROF_SUB_BITS)) return b;
+    const uint8_t e = (b >> PROF_SUB_BITS) + PROF_SUB_BITS - 1;
+    return ((1u << PROF_SUB_BITS) | (b & ((1u << PROF_SUB_BITS) - 1))) << (e - PROF_SUB_BITS);
+}
+
+inline uint32_t prof_bucketHigh(uint8_t b) {
+    return b + 1 < PROF_BUCKETS ? prof_bucketLow(b + 1) - 1 : UINT32_MAX;
+}
+
+// ============================================================
+//  LatencyHistogram — acumulado desde reset(), sin ventana
+// ============================================================
+class LatencyHistogram {
+public:
+    void reset() {
+        memset(_count, 0, sizeof(_count));
+        _n   = 0;
+        _max = 0;
+        _sum = 0;
+    }
+
+    void add(uint32_t us) {
+        _count[prof_bucket(us)]++;
+        _n++;
+        _sum += us;
+        if (us > _max) _max = us;
+    }
+
+    uint32_t count()  const { return _n; }
+    uint32_t maxUs()  const { return _max; }
+    uint32_t meanUs() const { return _n ? (uint32_t)(_sum / _n) : 0; }
+    uint32_t bucket(uint8_t b) const { return _count[b]; }
+
+    // Borde superior de la cubeta que alcanza permille/1000 de las
+    // muestras (p99 = 990), nunca por encima del máximo visto
+    uint32_t percentileUs(uint16_t permille) const {
+        const uint32_t n = _n;
+        if (!n) return 0;
+        uint32_t need = (uint32_t)(((uint64_t)n * permille + 999) / 1000);
+        if (!need) need = 1;
+        uint32_t acc = 0;
+        for (uint16_t b = 0; b < PROF_BUCKETS; b++) {
+            acc += _count[b];
+            if (acc >= need) {
+                uint32_t hi = prof_bucketHigh((uint8_t)b);
+                return hi < _max ? hi : _max;
+            }
+        }
+        return _max;
+    }
+
+    // "n=1234 p50=180 p95=240 p99=410 max=2300" (µs)
+    int format(char* out, size_t len) const {
+        return snprintf(out, len, "n=%u p50=%u p95=%u p99=%u max=%u",
+                        (unsigned)_n, (unsigned)percentileUs(500), (unsigned)percentileUs(950),
+                        (unsigned)percentileUs(990), (unsigned)_max);
+    }
+
+    // Registro del snapshot; sink.put(p, n) (RS485Profiler::snapshot)
+    template <class Sink>
+    void write(Sink& sink, uint8_t metric, uint8_t id) const {
+        uint8_t rec[PROF_RECORD_LEN];
+        uint8_t nz = 0;
+        for (uint16_t b = 0; b < PROF_BUCKETS; b++) if (_count[b]) nz++;
+        rec[0] = metric;
+        rec[1] = id;
+        rs485_put32(&rec[2],  _n);
+        rs485_put32(&rec[6],  _max);
+        rs485_put32(&rec[10], (uint32_t)_sum);
+        rs485_put32(&rec[14], (uint32_t)(_sum >> 32));
+        rec[18] = nz;
+        sink.put(rec, PROF_RECORD_LEN);
+        // nz contado antes: una muestra nueva a mitad no descuadra el registro
+        for (uint16_t b = 0; b < PROF_BUCKETS && nz; b++) {
+            const uint32_t c = _count[b];
+            if (!c) continue;
+            uint8_t e[PROF_BUCKET_LEN] = { (uint8_t)b };
+            rs485_put32(&e[1], c);
+            sink.put(e, PROF_BUCKET_LEN);
+            nz--;
+        }
+        while (nz--) {                          // cubeta vaciada por un reset() concurrente
+            uint8_t e[PROF_BUCKET_LEN] = {};
+            sink.put(e, PROF_BUCKET_LEN);
+        }
+    }
+
+private:
+    uint32_t _count[PROF_BUCKETS] = {};
+    uint32_t _n   = 0;
+    uint32_t _max = 0;
+    uint64_t _sum = 0;
+};
+
+// ============================================================
+//  RS485Profiler — un bus: SLAVES slaves (ids locales 1..SLAVES)
+//  rxWait/timeout/crc/idMismatch/poll/cycle: task del bus
+//  e2e: task MIDI
+// ============================================================
+template <uint8_t SLAVES>
+class RS485Profiler {
+    static_assert(SLAVES >= 1 && SLAVES <= 32, "máscaras de 32 bits en snapshot()");
+public:
+    struct SlaveCounters {
+        uint32_t polls      = 0;
+        uint32_t timeouts   = 0;
+        uint32_t crcErrors  = 0;
+        uint32_t idMismatch = 0;
+    };
+
+    void reset() {
+        for (uint8_t i = 0; i < SLAVES; i++) {
+            _cnt[i] = SlaveCounters{};
+            _rxWait[i].reset();
+            _e2e[i].reset();
+        }
+        _cycle.reset();
+    }
+
+    void poll      (uint8_t id)              { if (_ok(id)) _cnt[id - 1].polls++; }
+    void timeout   (uint8_t id)              { if (_ok(id)) _cnt[id - 1].timeouts++; }
+    void crcError  (uint8_t id)              { if (_ok(id)) _cnt[id - 1].crcErrors++; }
+    void idMismatch(uint8_t id)              { if (_ok(id)) _cnt[id - 1].idMismatch++; }
+    void rxWait    (uint8_t id, uint32_t us) { if (_ok(id)) _rxWait[id - 1].add(us); }
+    void e2e       (uint8_t id, uint32_t us) { if (_ok(id)) _e2e[id - 1].add(us); }
+    void cycle     (uint32_t us)             { _cycle.add(us); }
+
+    const SlaveCounters&    counters  (uint8_t id) const { return _cnt[id - 1]; }
+    const LatencyHistogram& rxWaitHist(uint8_t id) const { return _rxWait[id - 1]; }
+    const LatencyHistogram& e2eHist   (uint8_t id) const { return _e2e[id - 1]; }
+    const LatencyHistogram& cycleHist ()           const { return _cycle; }
+
+    // Out: cualquier cosa con write(const uint8_t*, size_t) (Print, fichero).
+    // Devuelve los bytes escritos.
+    template <class Out>
+    size_t snapshot(Out& out, char bus, uint8_t firstId, uint8_t slaves, uint32_t uptimeMs) const {
+        if (slaves > SLAVES) slaves = SLAVES;
+        struct Sink {
+            Out&    out;
+            uint8_t crc;
+            size_t  len;
+            void put(const uint8_t* p, size_t n) {
+                crc  = rs485_crc8(p, n, crc);
+                len += n;
+                out.write(p, n);
+            }
+        } sink{out, 0, 0};
+
+        // Qué va se decide una vez: una primera muestra a mitad no descuadra 'records'
+        const bool haveCycle = _cycle.count() != 0;
+        uint32_t   rxMask = 0, e2eMask = 0;
+        uint8_t    records = haveCycle ? 1 : 0;
+        for (uint8_t i = 0; i < slaves; i++) {
+            if (_rxWait[i].count()) { rxMask  |= 1u << i; records++; }
+            if (_e2e[i].count())    { e2eMask |= 1u << i; records++; }
+        }
+
+        uint8_t h[PROF_HEADER_LEN] = {};
+        memcpy(h, PROF_MAGIC, 4);
+        h[4] = PROF_VERSION;
+        h[5] = PROF_SUB_BITS;
+        h[6] = (uint8_t)bus;
+        h[7] = firstId;
+        h[8] = slaves;
+        h[9] = records;
+        rs485_put32(&h[12], uptimeMs);
+        sink.put(h, sizeof(h));
+
+        for (uint8_t i = 0; i < slaves; i++) {
+            uint8_t c[PROF_COUNTERS_LEN];
+            rs485_put32(&c[0],  _cnt[i].polls);
+            rs485_put32(&c[4],  _cnt[i].timeouts);
+            rs485_put32(&c[8],  _cnt[i].crcErrors);
+            rs485_put32(&c[12], _cnt[i].idMismatch);
+            sink.put(c, sizeof(c));
+        }
+
+        if (haveCycle) _cycle.write(sink, PROF_CYCLE, 0);
+        for (uint8_t i = 0; i < slaves; i++) {
+            if (rxMask  & (1u << i)) _rxWait[i].write(sink, PROF_RX_WAIT, i + 1);
+            if (e2eMask & (1u << i)) _e2e[i].write(sink, PROF_E2E, i + 1);
+        }
+
+        const uint8_t crc = sink.crc;
+        out.write(&crc, 1);
+        return sink.len + 1;
+    }
+
+private:
+    SlaveCounters    _cnt[SLAVES];
+    LatencyHistogram _rxWait[SLAVES];
+    LatencyHistogram _e2e[SLAVES];
+    LatencyHistogram _cycle;
+
+    static bool _ok(uint8_t id) { return id >= 1 && id <= SLAVES; }
+};
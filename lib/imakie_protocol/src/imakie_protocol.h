@@ -0,0 +1,737 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+//  imakie_protocol.h  –  Protocolo RS485 único P4 / S3 / S2
+//  Master (ESP32-P4 / ESP32-S3) ↔ Slave (ESP32-S2)
+//
+//  Sin dependencias de Arduino: compila igual en el firmware y
+//  en host (herramientas de banco, sniffer en PC).
+//  Cada proyecto lo consume vía src/protocol.h (lib_extra_dirs).
+// ============================================================
+
+#define RS485_START_BYTE  0xAA
+#define RS485_RESP_BYTE   0xBB
+
+// --- FLAGS (byte flags de MasterPacket) ---
+// bits 0-3: estado de botones
+#define FLAG_REC    (1 << 0)
+#define FLAG_SOLO   (1 << 1)
+#define FLAG_MUTE   (1 << 2)
+#define FLAG_SELECT (1 << 3)
+#define FLAG_BUTTONS_MASK  0x0F
+// bit 4: orden de calibración (one-shot)
+#define FLAG_CALIB  (1 << 4)
+// bits 5-7: modo de automatización (3 bits = 8 valores)
+#define AUTOMODE_SHIFT  5
+#define AUTOMODE_MASK   (0x07 << AUTOMODE_SHIFT)
+
+// --- Slave flags (bits 4-7 de SlavePacket.buttons) ---
+// bits 0-3: botones (FLAG_REC, SOLO, MUTE, SELECT)
+// "Sin calibrar" = ausencia de CALIB_DONE (no hay bit propio)
+#define SLAVE_FLAG_CALIB_DONE      (1 << 4)   // calibración completa
+#define SLAVE_FLAG_CALIB_ERROR     (1 << 5)   // calibración fallida
+#define SLAVE_FLAG_CALIB_SENDING   (1 << 6)   // enviando datos calibración (min/max en faderPos)
+#define SLAVE_FLAG_CALIB_IS_MIN    (1 << 7)   // si SENDING=1: faderPos=MIN (sin flag: faderPos=MAX)
+
+static_assert((FLAG_BUTTONS_MASK & FLAG_CALIB) == 0 &&
+              (FLAG_BUTTONS_MASK & AUTOMODE_MASK) == 0 &&
+              (FLAG_CALIB & AUTOMODE_MASK) == 0,
+              "MasterPacket.flags: bits solapados");
+static_assert((FLAG_BUTTONS_MASK & (SLAVE_FLAG_CALIB_DONE | SLAVE_FLAG_CALIB_ERROR |
+                                    SLAVE_FLAG_CALIB_SENDING | SLAVE_FLAG_CALIB_IS_MIN)) == 0,
+              "SlavePacket.buttons: bits solapados");
+
+// Valores de autoMode (extraer con: (flags & AUTOMODE_MASK) >> AUTOMODE_SHIFT)
+enum AutoMode : uint8_t {
+    AUTO_OFF    = 0,
+    AUTO_READ   = 1,
+    AUTO_WRITE  = 2,
+    AUTO_TRIM   = 3,
+    AUTO_TOUCH  = 4,
+    AUTO_LATCH  = 5,
+    // 6, 7 reservados
+};
+
+// Helper: insertar autoMode en flags
+// Uso: flags = setAutoMode(flags, AUTO_READ)
+inline uint8_t setAutoMode(uint8_t flags, AutoMode mode) {
+    return (flags & ~AUTOMODE_MASK) | ((mode << AUTOMODE_SHIFT) & AUTOMODE_MASK);
+}
+
+// Helper: extraer autoMode de flags
+inline AutoMode getAutoMode(uint8_t flags) {
+    return (AutoMode)((flags & AUTOMODE_MASK) >> AUTOMODE_SHIFT);
+}
+
+// --- CRC ---
+// RS485_CRC_IMPL (build_flags):
+//   0 = bit a bit     (sin tabla, 8 iteraciones por byte)
+//   1 = tabla 256     (por defecto; 256 B CRC8 + 512 B CRC16 en flash)
+//   2 = tabla nibble  (16 B CRC8 + 32 B CRC16; builds justos de memoria)
+// Las tres variantes dan el mismo resultado: polinomio e init no cambian.
+#ifndef RS485_CRC_IMPL
+#define RS485_CRC_IMPL 1
+#endif
+
+// CRC8:        poly 0x07,   init 0x00   (todas las tramas actuales)
+// CRC16-CCITT: poly 0x1021, init 0xFFFF (tramas largas: rs485_isLongFrame)
+#define RS485_CRC8_POLY    0x07
+#define RS485_CRC16_POLY   0x1021
+#define RS485_CRC16_INIT   0xFFFF
+
+// Tablas generadas en compilación a partir del mismo polinomio
+template <typename T, T Poly, unsigned Bits, unsigned N>
+struct Rs485CrcTable {
+    T t[N];
+    constexpr Rs485CrcTable() : t{} {
+        constexpr unsigned W = sizeof(T) * 8;
+        for (unsigned i = 0; i < N; i++) {
+            T c = (T)(i << (W - Bits));
+            for (unsigned b = 0; b < Bits; b++)
+                c = (c & (T)(1u << (W - 1))) ? (T)((c << 1) ^ Poly) : (T)(c << 1);
+            t[i] = c;
+        }
+    }
+};
+
+#if RS485_CRC_IMPL == 1
+inline constexpr Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  8, 256> RS485_CRC8_TABLE{};
+inline constexpr Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 8, 256> RS485_CRC16_TABLE{};
+#elif RS485_CRC_IMPL == 2
+inline constexpr Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  4, 16>  RS485_CRC8_TABLE{};
+inline constexpr Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 4, 16>  RS485_CRC16_TABLE{};
+#endif
+
+// Un byte de CRC: bit a bit (referencia), tabla 256 o tabla nibble
+constexpr uint8_t rs485_crc8Step(uint8_t crc, uint8_t d) {
+    crc ^= d;
+    for (uint8_t b = 0; b < 8; b++)
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ RS485_CRC8_POLY) : (uint8_t)(crc << 1);
+    return crc;
+}
+constexpr uint8_t rs485_crc8Step(const Rs485CrcTable<uint8_t, RS485_CRC8_POLY, 8, 256>& tab,
+                                 uint8_t crc, uint8_t d) {
+    return tab.t[crc ^ d];
+}
+constexpr uint8_t rs485_crc8Step(const Rs485CrcTable<uint8_t, RS485_CRC8_POLY, 4, 16>& tab,
+                                 uint8_t crc, uint8_t d) {
+    crc ^= d;
+    crc = (uint8_t)(crc << 4) ^ tab.t[crc >> 4];
+    return (uint8_t)(crc << 4) ^ tab.t[crc >> 4];
+}
+
+constexpr uint16_t rs485_crc16Step(uint16_t crc, uint8_t d) {
+    crc ^= (uint16_t)d << 8;
+    for (uint8_t b = 0; b < 8; b++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ RS485_CRC16_POLY) : (uint16_t)(crc << 1);
+    return crc;
+}
+constexpr uint16_t rs485_crc16Step(const Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 8, 256>& tab,
+                                   uint16_t crc, uint8_t d) {
+    return (uint16_t)(crc << 8) ^ tab.t[(crc >> 8) ^ d];
+}
+constexpr uint16_t rs485_crc16Step(const Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 4, 16>& tab,
+                                   uint16_t crc, uint8_t d) {
+    crc ^= (uint16_t)d << 8;
+    crc = (uint16_t)(crc << 4) ^ tab.t[crc >> 12];
+    return (uint16_t)(crc << 4) ^ tab.t[crc >> 12];
+}
+
+// crc: valor de una llamada anterior para seguir por trozos (sin xor final)
+constexpr uint8_t rs485_crc8(const uint8_t* data, size_t len, uint8_t crc = 0x00) {
+    for (size_t i = 0; i < len; i++) {
+#if RS485_CRC_IMPL == 1 || RS485_CRC_IMPL == 2
+        crc = rs485_crc8Step(RS485_CRC8_TABLE, crc, data[i]);
+#else
+        crc = rs485_crc8Step(crc, data[i]);
+#endif
+    }
+    return crc;
+}
+
+constexpr uint16_t rs485_crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = RS485_CRC16_INIT;
+    for (size_t i = 0; i < len; i++) {
+#if RS485_CRC_IMPL == 1 || RS485_CRC_IMPL == 2
+        crc = rs485_crc16Step(RS485_CRC16_TABLE, crc, data[i]);
+#else
+        crc = rs485_crc16Step(crc, data[i]);
+#endif
+    }
+    return crc;
+}
+
+// Equivalencia tabla ↔ bit a bit en compilación, para las dos tablas
+// (no solo la de RS485_CRC_IMPL). Exhaustiva: el paso por tabla solo
+// depende de crc ^ byte (CRC8) o de byte alto ^ byte (CRC16; el byte
+// bajo solo se desplaza), así que basta recorrer sus 256 valores.
+constexpr bool rs485_crcTablesMatchBitwise() {
+    const Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  8, 256> t8{};
+    const Rs485CrcTable<uint8_t,  RS485_CRC8_POLY,  4, 16>  n8{};
+    const Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 8, 256> t16{};
+    const Rs485CrcTable<uint16_t, RS485_CRC16_POLY, 4, 16>  n16{};
+    for (unsigned x = 0; x < 256; x++) {
+        const uint8_t  d     = (uint8_t)(x * 37 + 11);            // byte arbitrario
+        const uint8_t  c8    = (uint8_t)(x ^ d);                  // crc ^ d == x
+        const uint8_t  ref8  = rs485_crc8Step(c8, d);
+        if (rs485_crc8Step(t8, c8, d) != ref8) return false;
+        if (rs485_crc8Step(n8, c8, d) != ref8) return false;
+        const uint16_t c16   = (uint16_t)(((x ^ d) << 8) | (uint8_t)~x);
+        const uint16_t ref16 = rs485_crc16Step(c16, d);
+        if (rs485_crc16Step(t16, c16, d) != ref16) return false;
+        if (rs485_crc16Step(n16, c16, d) != ref16) return false;
+    }
+    return true;
+}
+static_assert(rs485_crcTablesMatchBitwise(), "tabla CRC distinta de la versión bit a bit");
+
+// Valores de comprobación estándar ("123456789"): CRC-8 y CRC-16/CCITT-FALSE
+inline constexpr uint8_t RS485_CRC_CHECK_INPUT[9] = { '1','2','3','4','5','6','7','8','9' };
+static_assert(rs485_crc8 (RS485_CRC_CHECK_INPUT, 9) == 0xF4,   "CRC8 check");
+static_assert(rs485_crc16(RS485_CRC_CHECK_INPUT, 9) == 0x29B1, "CRC16 check");
+
+// --- Master → Slave (16 bytes) ---
+struct __attribute__((packed)) MasterPacket {
+    uint8_t  header;        // 0xAA
+    uint8_t  id;            // 1-17
+    char     trackName[7];  // Mackie Scribble Strip (7 chars, sin null)
+    uint8_t  flags;         // FLAG_REC | FLAG_SOLO | FLAG_MUTE | FLAG_SELECT
+    uint16_t faderTarget;   // Logic PitchBend 14-bit (el S2 lo mapea a su rango ADC)
+    uint8_t  vuLevel;       // 0-127
+    uint8_t  vpotValue;     // raw CC byte (bit6=center, 5-4=modo, 3-0=pos)
+    uint8_t  connected;     // 1=CONNECTED, 0=DISCONNECTED
+    uint8_t  crc;
+};
+
+// --- Slave → Master (9 bytes) ---
+struct __attribute__((packed)) SlavePacket {
+    uint8_t  header;        // 0xBB
+    uint8_t  id;            // MY_SLAVE_ID
+    uint16_t faderPos;      // ADC del slave (ADS1115 raw, rango calibrado ej. 0-27000)
+    uint8_t  touchState;    // 0=libre 1=tocado
+    uint8_t  buttons;       // FLAG_REC | FLAG_SOLO | FLAG_MUTE | FLAG_SELECT | SLAVE_FLAG_*
+    int8_t   encoderDelta;  // rotación acumulada (-127..+127)
+    uint8_t  encoderButton; // bit0 push encoder, bits 1-7 capacidades (SLAVE_CAP_*)
+    uint8_t  crc;
+};
+
+// ============================================================
+//  Paquete delta v1 (Master → Slave, longitud variable)
+//  Solo a slaves que anuncian SLAVE_CAP_DELTA; el resto sigue
+//  recibiendo MasterPacket de 16 bytes (firmware S2 antiguo).
+//
+//  [AB][id][verFields][faderTarget:2][vuLevel]
+//      [trackName:7]? [flags]? [vpotValue]? [connected]? [crc]
+// ============================================================
+#define RS485_DELTA_BYTE  0xAB
+
+// verFields: bits 7-5 versión, bits 4-0 campos presentes
+#define DELTA_VERSION        1
+#define DELTA_VERSION_SHIFT  5
+#define DELTA_FIELD_MASK     0x1F
+#define DF_NAME       (1 << 0)   // trackName[7]
+#define DF_FLAGS      (1 << 1)   // flags
+#define DF_VPOT       (1 << 2)   // vpotValue
+#define DF_CONNECTED  (1 << 3)   // connected
+#define DF_ALL        (DF_NAME | DF_FLAGS | DF_VPOT | DF_CONNECTED)
+
+#define DELTA_FIXED_LEN  6                                  // header..vuLevel (siempre)
+#define DELTA_MAX_LEN    (DELTA_FIXED_LEN + 7 + 1 + 1 + 1 + 1)   // todos los campos + crc
+
+// Capacidades del slave: bits 1-7 de SlavePacket.encoderButton (bit 0 = push)
+#define SLAVE_ENC_BUTTON  (1 << 0)
+#define SLAVE_CAP_DELTA   (1 << 7)   // entiende RS485_DELTA_BYTE
+
+// Longitud total del paquete delta a partir de verFields
+constexpr uint8_t rs485_deltaLength(uint8_t verFields) {
+    uint8_t f = verFields & DELTA_FIELD_MASK;
+    return DELTA_FIXED_LEN
+         + ((f & DF_NAME)      ? 7 : 0)
+         + ((f & DF_FLAGS)     ? 1 : 0)
+         + ((f & DF_VPOT)      ? 1 : 0)
+         + ((f & DF_CONNECTED) ? 1 : 0)
+         + 1;   // crc
+}
+
+// ============================================================
+//  Broadcast (Master → todos, id 0, sin respuesta)
+//  Estado global del bus: conexión Logic + número de ciclo.
+//  Se envía al inicio de cada barrido y al cambiar 'connected'.
+// ============================================================
+#define RS485_BCAST_BYTE    0xAC
+#define RS485_BROADCAST_ID  0
+
+// state: bit 0 = Logic conectado, resto reservado
+#define BCAST_CONNECTED  (1 << 0)
+
+#define SLAVE_CAP_BCAST  (1 << 6)   // acepta RS485_BCAST_BYTE (connected fuera del delta)
+
+#define SLAVE_CAP_BAUD   (1 << 5)   // acepta RS485_BAUD_BYTE (velocidad negociada)
+
+static_assert((SLAVE_ENC_BUTTON & (SLAVE_CAP_DELTA | SLAVE_CAP_BCAST | SLAVE_CAP_BAUD)) == 0 &&
+              (SLAVE_CAP_DELTA & SLAVE_CAP_BCAST) == 0 &&
+              ((SLAVE_CAP_DELTA | SLAVE_CAP_BCAST) & SLAVE_CAP_BAUD) == 0,
+              "SlavePacket.encoderButton: bits solapados");
+
+struct __attribute__((packed)) BroadcastPacket {
+    uint8_t  header;        // 0xAC
+    uint8_t  id;            // RS485_BROADCAST_ID
+    uint8_t  seq;           // número de ciclo (wrap 255)
+    uint8_t  state;         // BCAST_CONNECTED
+    uint8_t  crc;
+};
+
+// ============================================================
+//  Cambio de velocidad (Master → todos, id 0, sin respuesta)
+//  Todos arrancan a la velocidad base (RS485_BAUD de config.h).
+//  Tras esta trama el slave pasa a 'code'; si a esa velocidad no
+//  recibe ninguna trama válida en RS485_BAUD_FALLBACK_MS vuelve
+//  solo a la base → un master reiniciado o un cambio fallido
+//  nunca deja un slave sordo.
+// ============================================================
+#define RS485_BAUD_BYTE  0xAD
+
+// code: 0 = base, 1..3 = RS485_BAUD_RATES[code]
+#define RS485_BAUD_CODES  4
+constexpr uint32_t RS485_BAUD_RATES[RS485_BAUD_CODES] = { 0, 1000000, 2000000, 4000000 };
+
+inline uint32_t rs485_baudRate(uint8_t code, uint32_t base) {
+    return (code == 0 || code >= RS485_BAUD_CODES) ? base : RS485_BAUD_RATES[code];
+}
+
+struct __attribute__((packed)) BaudPacket {
+    uint8_t  header;        // 0xAD
+    uint8_t  id;            // RS485_BROADCAST_ID
+    uint8_t  code;          // índice en RS485_BAUD_RATES
+    uint8_t  crc;
+};
+
+// ============================================================
+//  Group poll TDMA (Master → varios slaves, una sola trama)
+//  Un registro por slave = cuerpo del delta sin header ni crc,
+//  ids en orden creciente. El registro i-ésimo da la ranura i:
+//  ese slave responde en  fin de trama + i × slotUs.
+//  slotUs lo fija el master según el baud (rs485_groupSlotUs).
+//  Siempre CRC16, como toda trama larga (rs485_isLongFrame).
+//
+//  [AE][len][count][slotUs:2] {[id][verFields][fader:2][vu][...]}×count [crc16:2]
+// ============================================================
+#define RS485_GROUP_BYTE        0xAE
+#define GROUP_HEADER_LEN        5
+#define GROUP_RECORD_MAX_LEN    (DELTA_MAX_LEN - 2)      // sin header ni crc
+#define RS485_GROUP_MAX_SLAVES  16
+#define RS485_GROUP_MAX_LEN     (GROUP_HEADER_LEN + RS485_GROUP_MAX_SLAVES * GROUP_RECORD_MAX_LEN + 2)
+
+#define SLAVE_CAP_GROUP   (1 << 4)   // acepta RS485_GROUP_BYTE y responde en su ranura
+
+static_assert(RS485_GROUP_MAX_LEN <= 255, "len de la trama de grupo es un byte");
+static_assert((SLAVE_CAP_GROUP & (SLAVE_ENC_BUTTON | SLAVE_CAP_DELTA |
+                                  SLAVE_CAP_BCAST | SLAVE_CAP_BAUD)) == 0,
+              "SlavePacket.encoderButton: SLAVE_CAP_GROUP solapado");
+
+// Ancho de ranura: respuesta de 9 B + 1 carácter de conmutación DE
+// + guardUs (jitter de despertar entre slaves). 10 bits por carácter.
+inline uint16_t rs485_groupSlotUs(uint32_t baud, uint16_t guardUs) {
+    uint32_t us = ((uint32_t)(sizeof(SlavePacket) + 1) * 10u * 1000000u + baud - 1) / baud;
+    return (uint16_t)(us + guardUs);
+}
+
+// ============================================================
+//  Firmware por el bus (mantenimiento, fuera del polling normal)
+//  El master difunde la imagen en bloques; cada S2 la escribe en
+//  su partición OTA inactiva y el master pregunta uno a uno qué
+//  falta (bitmap NACK) para repetir solo esos bloques. CRC16.
+//
+//  Master → todos:  [AF][len][op][session:2][...][crc16:2]
+//    BEGIN   [size:4][blocks:2][fwId:8]   imagen nueva (borra partición)
+//            [format:1][baseId:8]         opcional: IMZ1 LZ/delta (imakie_fwpack.h);
+//                                         size/blocks del contenedor, fwId del resultado
+//    DATA    [block:2][data:≤FW_BLOCK_LEN]
+//    QUERY   [id][from:2]                 único op con respuesta
+//    COMMIT / REBOOT / ABORT              sin cuerpo
+//  Slave → master:  [BC][len][id][state][session:2][missing:2][base:2][bitmap][crc16:2]
+//    bitmap: bit i = bloque base+i pendiente (FW_NACK_BYTES como mucho)
+// ============================================================
+#define RS485_FW_BYTE        0xAF
+#define RS485_FW_RESP_BYTE   0xBC
+#define FW_HEADER_LEN        5
+#define FW_STATUS_HEADER_LEN 10
+#define FW_BLOCK_LEN         192
+#define FW_NACK_BYTES        64                    // 512 bloques por respuesta
+#define FW_ID_LEN            8                     // prefijo de app_elf_sha256
+#define FW_BEGIN_LEN         (6 + FW_ID_LEN)
+#define FW_BEGIN_PACK_LEN    (FW_BEGIN_LEN + 1 + FW_ID_LEN)
+#define RS485_FW_MAX_LEN        (FW_HEADER_LEN + 2 + FW_BLOCK_LEN + 2)
+#define RS485_FW_STATUS_MAX_LEN (FW_STATUS_HEADER_LEN + FW_NACK_BYTES + 2)
+
+#define SLAVE_CAP_FW      (1 << 3)   // acepta RS485_FW_BYTE (actualización por el bus)
+
+enum FwOp : uint8_t {
+    FW_OP_BEGIN  = 1,
+    FW_OP_DATA   = 2,
+    FW_OP_QUERY  = 3,
+    FW_OP_COMMIT = 4,
+    FW_OP_REBOOT = 5,
+    FW_OP_ABORT  = 6,
+};
+
+enum FwState : uint8_t {
+    FW_IDLE       = 0,
+    FW_RECEIVING  = 1,   // faltan bloques (missing > 0)
+    FW_COMPLETE   = 2,   // todos los bloques escritos, sin verificar
+    FW_VERIFIED   = 3,   // COMMIT OK: arranca la imagen nueva en REBOOT
+    FW_UP_TO_DATE = 4,   // BEGIN con la imagen que ya ejecuta
+    FW_ERROR      = 5,
+};
+
+static_assert(RS485_FW_MAX_LEN <= 255 && RS485_FW_STATUS_MAX_LEN <= 255,
+              "len de las tramas de firmware es un byte");
+static_assert((SLAVE_CAP_FW & (SLAVE_ENC_BUTTON | SLAVE_CAP_DELTA | SLAVE_CAP_BCAST |
+                               SLAVE_CAP_BAUD | SLAVE_CAP_GROUP)) == 0,
+              "SlavePacket.encoderButton: SLAVE_CAP_FW solapado");
+
+// ============================================================
+//  Layout en el cable — fijado en compilación.
+//  Cualquier cambio de campo rompe la compatibilidad con
+//  firmware ya desplegado: estos asserts lo impiden.
+// ============================================================
+static_assert(sizeof(MasterPacket)    == 16, "MasterPacket debe ser 16 bytes");
+static_assert(sizeof(SlavePacket)     == 9,  "SlavePacket debe ser 9 bytes");
+static_assert(sizeof(BroadcastPacket) == 5,  "BroadcastPacket debe ser 5 bytes");
+static_assert(sizeof(BaudPacket)      == 4,  "BaudPacket debe ser 4 bytes");
+
+static_assert(offsetof(MasterPacket, id)          == 1,  "MasterPacket.id");
+static_assert(offsetof(MasterPacket, trackName)   == 2,  "MasterPacket.trackName");
+static_assert(offsetof(MasterPacket, flags)       == 9,  "MasterPacket.flags");
+static_assert(offsetof(MasterPacket, faderTarget) == 10, "MasterPacket.faderTarget");
+static_assert(offsetof(MasterPacket, vuLevel)     == 12, "MasterPacket.vuLevel");
+static_assert(offsetof(MasterPacket, vpotValue)   == 13, "MasterPacket.vpotValue");
+static_assert(offsetof(MasterPacket, connected)   == 14, "MasterPacket.connected");
+static_assert(offsetof(MasterPacket, crc)         == 15, "MasterPacket.crc");
+
+static_assert(offsetof(SlavePacket, faderPos)      == 2, "SlavePacket.faderPos");
+static_assert(offsetof(SlavePacket, touchState)    == 4, "SlavePacket.touchState");
+static_assert(offsetof(SlavePacket, buttons)       == 5, "SlavePacket.buttons");
+static_assert(offsetof(SlavePacket, encoderDelta)  == 6, "SlavePacket.encoderDelta");
+static_assert(offsetof(SlavePacket, encoderButton) == 7, "SlavePacket.encoderButton");
+static_assert(offsetof(SlavePacket, crc)           == 8, "SlavePacket.crc");
+
+static_assert(offsetof(BroadcastPacket, seq)   == 2, "BroadcastPacket.seq");
+static_assert(offsetof(BroadcastPacket, state) == 3, "BroadcastPacket.state");
+static_assert(offsetof(BroadcastPacket, crc)   == 4, "BroadcastPacket.crc");
+
+static_assert(rs485_deltaLength(0) == DELTA_FIXED_LEN + 1 &&
+              rs485_deltaLength(DF_ALL) == DELTA_MAX_LEN,
+              "longitud delta inconsistente");
+
+// Buffer que cabe cualquier trama Master → Slave individual
+// (la de grupo necesita RS485_GROUP_MAX_LEN)
+#define RS485_MAX_FRAME_LEN  (DELTA_MAX_LEN > sizeof(MasterPacket) ? DELTA_MAX_LEN : sizeof(MasterPacket))
+
+// Buffer de parseo del slave: cualquier trama Master → Slave
+#define RS485_RX_MAX_LEN     (RS485_GROUP_MAX_LEN > RS485_FW_MAX_LEN ? RS485_GROUP_MAX_LEN : RS485_FW_MAX_LEN)
+
+// ============================================================
+//  Encode / decode
+//
+//  encode: escribe la trama completa (header + crc) en buf,
+//          devuelve su longitud. buf ≥ RS485_MAX_FRAME_LEN.
+//  check:  valida header, longitud, versión y CRC sin tocar
+//          estado → seguro ante cualquier secuencia de bytes.
+//  apply/decode: solo sobre tramas que ya pasaron check.
+//  Multibyte en little-endian (orden nativo ESP32).
+// ============================================================
+enum class Rs485Status : uint8_t {
+    OK,
+    INCOMPLETE,     // faltan bytes (seguir recibiendo)
+    BAD_HEADER,
+    BAD_VERSION,
+    BAD_LENGTH,
+    BAD_CRC,
+};
+
+inline void rs485_put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+inline uint16_t rs485_get16(const uint8_t* p)   { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline void rs485_put32(uint8_t* p, uint32_t v) { rs485_put16(p, (uint16_t)v); rs485_put16(p + 2, (uint16_t)(v >> 16)); }
+inline uint32_t rs485_get32(const uint8_t* p)   { return rs485_get16(p) | ((uint32_t)rs485_get16(p + 2) << 16); }
+
+// Tramas largas [header][len]...[crc16]: grupo y firmware
+inline bool rs485_isLongFrame(uint8_t header) {
+    return header == RS485_GROUP_BYTE || header == RS485_FW_BYTE || header == RS485_FW_RESP_BYTE;
+}
+
+// Longitud de la trama que empieza en buf con 'got' bytes recibidos.
+// 0 = header desconocido o versión no soportada (descartar y resincronizar).
+// Para delta hacen falta 3 bytes; con menos devuelve DELTA_FIXED_LEN (provisional).
+// Grupo/firmware: len va en el byte 1; con 1 byte devuelve el mínimo (provisional).
+inline size_t rs485_frameLength(const uint8_t* buf, size_t got) {
+    if (got == 0) return 0;
+    switch (buf[0]) {
+        case RS485_START_BYTE: return sizeof(MasterPacket);
+        case RS485_RESP_BYTE:  return sizeof(SlavePacket);
+        case RS485_BCAST_BYTE: return sizeof(BroadcastPacket);
+        case RS485_BAUD_BYTE:  return sizeof(BaudPacket);
+        case RS485_DELTA_BYTE:
+            if (got < 3) return DELTA_FIXED_LEN;
+            if ((buf[2] >> DELTA_VERSION_SHIFT) != DELTA_VERSION) return 0;
+            return rs485_deltaLength(buf[2]);
+        case RS485_GROUP_BYTE:
+            if (got < 2) return GROUP_HEADER_LEN + 2;
+            if (buf[1] < GROUP_HEADER_LEN + 2 || buf[1] > RS485_GROUP_MAX_LEN) return 0;
+            return buf[1];
+        case RS485_FW_BYTE:
+            if (got < 2) return FW_HEADER_LEN + 2;
+            if (buf[1] < FW_HEADER_LEN + 2 || buf[1] > RS485_FW_MAX_LEN) return 0;
+            return buf[1];
+        case RS485_FW_RESP_BYTE:
+            if (got < 2) return FW_STATUS_HEADER_LEN + 2;
+            if (buf[1] < FW_STATUS_HEADER_LEN + 2 || buf[1] > RS485_FW_STATUS_MAX_LEN) return 0;
+            return buf[1];
+        default: return 0;
+    }
+}
+
+inline Rs485Status rs485_checkFrame(const uint8_t* buf, size_t len) {
+    if (len == 0) return Rs485Status::INCOMPLETE;
+    switch (buf[0]) {
+        case RS485_START_BYTE: case RS485_RESP_BYTE:
+        case RS485_BCAST_BYTE: case RS485_DELTA_BYTE:
+        case RS485_BAUD_BYTE:  case RS485_GROUP_BYTE:
+        case RS485_FW_BYTE:    case RS485_FW_RESP_BYTE: break;
+        default: return Rs485Status::BAD_HEADER;
+    }
+    if (buf[0] == RS485_DELTA_BYTE && len >= 3 &&
+        (buf[2] >> DELTA_VERSION_SHIFT) != DELTA_VERSION)
+        return Rs485Status::BAD_VERSION;
+
+    size_t need = rs485_frameLength(buf, len);
+    if (need == 0) return Rs485Status::BAD_LENGTH;
+    if (len < need) return Rs485Status::INCOMPLETE;
+    if (len > need) return Rs485Status::BAD_LENGTH;
+    if (!rs485_isLongFrame(buf[0]))
+        return rs485_crc8(buf, need - 1) == buf[need - 1] ? Rs485Status::OK : Rs485Status::BAD_CRC;
+
+    if (rs485_crc16(buf, need - 2) != rs485_get16(&buf[need - 2])) return Rs485Status::BAD_CRC;
+    if (buf[0] != RS485_GROUP_BYTE) return Rs485Status::OK;
+    // Los registros deben cubrir exactamente el cuerpo: apply/find no revalidan
+    size_t i = GROUP_HEADER_LEN;
+    for (uint8_t r = 0; r < buf[2]; r++) {
+        if (i + 2 > need - 2) return Rs485Status::BAD_LENGTH;
+        if ((buf[i + 1] >> DELTA_VERSION_SHIFT) != DELTA_VERSION) return Rs485Status::BAD_VERSION;
+        i += rs485_deltaLength(buf[i + 1]) - 2;
+    }
+    return i == need - 2 ? Rs485Status::OK : Rs485Status::BAD_LENGTH;
+}
+
+// ── Master → Slave ──────────────────────────────────────────
+inline size_t rs485_encodeMaster(uint8_t* buf, const MasterPacket& p) {
+    memcpy(buf, &p, sizeof(MasterPacket));
+    buf[0] = RS485_START_BYTE;
+    buf[sizeof(MasterPacket) - 1] = rs485_crc8(buf, sizeof(MasterPacket) - 1);
+    return sizeof(MasterPacket);
+}
+
+// Registro delta [id][verFields][fader:2][vu][...]: cuerpo común de
+// la trama 0xAB y de cada slave en la de grupo. Devuelve su longitud.
+inline size_t rs485_encodeRecord(uint8_t* rec, const MasterPacket& p, uint8_t fields) {
+    fields &= DF_ALL;
+    if (p.flags & FLAG_CALIB) fields |= DF_FLAGS;   // one-shot nunca se omite
+
+    size_t i = 0;
+    rec[i++] = p.id;
+    rec[i++] = (DELTA_VERSION << DELTA_VERSION_SHIFT) | fields;
+    rs485_put16(&rec[i], p.faderTarget); i += 2;
+    rec[i++] = p.vuLevel;
+    if (fields & DF_NAME)      { memcpy(&rec[i], p.trackName, 7); i += 7; }
+    if (fields & DF_FLAGS)       rec[i++] = p.flags;
+    if (fields & DF_VPOT)        rec[i++] = p.vpotValue;
+    if (fields & DF_CONNECTED)   rec[i++] = p.connected;
+    return i;
+}
+
+// Delta: fader + VU siempre, resto solo si está en fields
+inline size_t rs485_encodeDelta(uint8_t* buf, const MasterPacket& p, uint8_t fields) {
+    buf[0] = RS485_DELTA_BYTE;
+    size_t i = 1 + rs485_encodeRecord(&buf[1], p, fields);
+    buf[i] = rs485_crc8(buf, i);
+    return i + 1;
+}
+
+// Grupo: begin → add por slave (ids crecientes) → end. buf ≥ RS485_GROUP_MAX_LEN.
+inline size_t rs485_groupBegin(uint8_t* buf, uint16_t slotUs) {
+    buf[0] = RS485_GROUP_BYTE;
+    buf[1] = 0;                    // len, lo fija groupEnd
+    buf[2] = 0;                    // count
+    rs485_put16(&buf[3], slotUs);
+    return GROUP_HEADER_LEN;
+}
+
+inline size_t rs485_groupAdd(uint8_t* buf, size_t len, const MasterPacket& p, uint8_t fields) {
+    buf[2]++;
+    return len + rs485_encodeRecord(&buf[len], p, fields);
+}
+
+// Cierra una trama larga: fija len y añade el crc16
+inline size_t rs485_endLong(uint8_t* buf, size_t len) {
+    buf[1] = (uint8_t)(len + 2);
+    rs485_put16(&buf[len], rs485_crc16(buf, len));
+    return len + 2;
+}
+
+inline size_t rs485_groupEnd(uint8_t* buf, size_t len) { return rs485_endLong(buf, len); }
+
+// Firmware: buf ≥ RS485_FW_MAX_LEN (status: RS485_FW_STATUS_MAX_LEN)
+inline size_t rs485_fwHeader(uint8_t* buf, uint8_t op, uint16_t session) {
+    buf[0] = RS485_FW_BYTE;
+    buf[1] = 0;
+    buf[2] = op;
+    rs485_put16(&buf[3], session);
+    return FW_HEADER_LEN;
+}
+
+// format 0 = .bin tal cual: BEGIN corto, el que entienden todos los S2
+inline size_t rs485_encodeFwBegin(uint8_t* buf, uint16_t session, uint32_t size,
+                                  uint16_t blocks, const uint8_t* fwId,
+                                  uint8_t format = 0, const uint8_t* baseId = nullptr) {
+    size_t i = rs485_fwHeader(buf, FW_OP_BEGIN, session);
+    rs485_put32(&buf[i], size);   i += 4;
+    rs485_put16(&buf[i], blocks); i += 2;
+    memcpy(&buf[i], fwId, FW_ID_LEN); i += FW_ID_LEN;
+    if (format) {
+        buf[i++] = format;
+        if (baseId) memcpy(&buf[i], baseId, FW_ID_LEN);
+        else        memset(&buf[i], 0, FW_ID_LEN);
+        i += FW_ID_LEN;
+    }
+    return rs485_endLong(buf, i);
+}
+
+inline size_t rs485_encodeFwData(uint8_t* buf, uint16_t session, uint16_t block,
+                                 const uint8_t* data, size_t n) {
+    size_t i = rs485_fwHeader(buf, FW_OP_DATA, session);
+    rs485_put16(&buf[i], block); i += 2;
+    memcpy(&buf[i], data, n);    i += n;
+    return rs485_endLong(buf, i);
+}
+
+inline size_t rs485_encodeFwQuery(uint8_t* buf, uint16_t session, uint8_t id, uint16_t from) {
+    size_t i = rs485_fwHeader(buf, FW_OP_QUERY, session);
+    buf[i++] = id;
+    rs485_put16(&buf[i], from); i += 2;
+    return rs485_endLong(buf, i);
+}
+
+inline size_t rs485_encodeFwCmd(uint8_t* buf, uint8_t op, uint16_t session) {
+    return rs485_endLong(buf, rs485_fwHeader(buf, op, session));
+}
+
+inline size_t rs485_encodeFwStatus(uint8_t* buf, uint8_t id, uint8_t state, uint16_t session,
+                                   uint16_t missing, uint16_t base,
+                                   const uint8_t* bitmap, size_t nbytes) {
+    buf[0] = RS485_FW_RESP_BYTE;
+    buf[2] = id;
+    buf[3] = state;
+    rs485_put16(&buf[4], session);
+    rs485_put16(&buf[6], missing);
+    rs485_put16(&buf[8], base);
+    memcpy(&buf[FW_STATUS_HEADER_LEN], bitmap, nbytes);
+    return rs485_endLong(buf, FW_STATUS_HEADER_LEN + nbytes);
+}
+
+// Ventana NACK: primer bloque pendiente ≥ from y bitmap de los siguientes
+// FW_NACK_BYTES × 8. 'missing' = bitmap completo (bit = bloque pendiente).
+// Devuelve los bytes útiles de out (0 = nada pendiente desde from).
+inline size_t rs485_fwNackWindow(const uint8_t* missing, uint16_t blocks, uint16_t from,
+                                 uint16_t& base, uint8_t* out) {
+    base = from;
+    while (base < blocks && !(missing[base >> 3] & (1 << (base & 7)))) base++;
+    if (base >= blocks) return 0;
+
+    memset(out, 0, FW_NACK_BYTES);
+    size_t nbytes = 0;
+    for (uint16_t i = 0; i < FW_NACK_BYTES * 8 && base + i < blocks; i++) {
+        uint16_t b = base + i;
+        if (missing[b >> 3] & (1 << (b & 7))) {
+            out[i >> 3] |= 1 << (i & 7);
+            nbytes = (i >> 3) + 1;
+        }
+    }
+    return nbytes;
+}
+
+inline size_t rs485_encodeBroadcast(uint8_t* buf, uint8_t seq, uint8_t state) {
+    buf[0] = RS485_BCAST_BYTE;
+    buf[1] = RS485_BROADCAST_ID;
+    buf[2] = seq;
+    buf[3] = state;
+    buf[4] = rs485_crc8(buf, 4);
+    return sizeof(BroadcastPacket);
+}
+
+inline size_t rs485_encodeBaud(uint8_t* buf, uint8_t code) {
+    buf[0] = RS485_BAUD_BYTE;
+    buf[1] = RS485_BROADCAST_ID;
+    buf[2] = code;
+    buf[3] = rs485_crc8(buf, 3);
+    return sizeof(BaudPacket);
+}
+
+// Registro delta ya validado → estado acumulado del slave.
+// Solo sobrescribe los campos presentes: 'acc' sigue siendo
+// un MasterPacket completo. FLAG_CALIB ausente = no repetir.
+inline void rs485_applyRecord(const uint8_t* rec, MasterPacket& acc) {
+    const uint8_t fields = rec[1] & DELTA_FIELD_MASK;
+    size_t i = 2;
+
+    acc.header      = RS485_START_BYTE;
+    acc.id          = rec[0];
+    acc.faderTarget = rs485_get16(&rec[i]); i += 2;
+    acc.vuLevel     = rec[i++];
+    if (fields & DF_NAME)      { memcpy(acc.trackName, &rec[i], 7); i += 7; }
+    if (fields & DF_FLAGS)       acc.flags = rec[i++];
+    else                         acc.flags &= ~FLAG_CALIB;
+    if (fields & DF_VPOT)        acc.vpotValue = rec[i++];
+    if (fields & DF_CONNECTED)   acc.connected = rec[i++];
+}
+
+// Trama 0xAA o 0xAB ya validada → estado acumulado del slave.
+inline void rs485_applyMaster(const uint8_t* buf, MasterPacket& acc) {
+    if (buf[0] == RS485_START_BYTE) {
+        memcpy(&acc, buf, sizeof(MasterPacket));
+        return;
+    }
+    rs485_applyRecord(&buf[1], acc);
+}
+
+// Trama de grupo ya validada → registro de 'id' y su ranura,
+// nullptr si este ciclo no incluye a ese slave.
+inline const uint8_t* rs485_groupFind(const uint8_t* buf, uint8_t id, uint8_t& slot) {
+    size_t i = GROUP_HEADER_LEN;
+    for (uint8_t r = 0; r < buf[2]; r++) {
+        if (buf[i] == id) { slot = r; return &buf[i]; }
+        i += rs485_deltaLength(buf[i + 1]) - 2;
+    }
+    return nullptr;
+}
+
+inline void rs485_decodeBroadcast(const uint8_t* buf, BroadcastPacket& out) {
+    memcpy(&out, buf, sizeof(BroadcastPacket));
+}
+
+// ── Slave → Master ──────────────────────────────────────────
+inline size_t rs485_encodeSlave(uint8_t* buf, const SlavePacket& p) {
+    memcpy(buf, &p, sizeof(SlavePacket));
+    buf[0] = RS485_RESP_BYTE;
+    buf[sizeof(SlavePacket) - 1] = rs485_crc8(buf, sizeof(SlavePacket) - 1);
+    return sizeof(SlavePacket);
+}
+
+inline Rs485Status rs485_decodeSlave(const uint8_t* buf, size_t len, SlavePacket& out) {
+    if (len > 0 && buf[0] != RS485_RESP_BYTE) return Rs485Status::BAD_HEADER;
+    Rs485Status st = rs485_checkFrame(buf, len);
+    if (st == Rs485Status::OK) memcpy(&out, buf, sizeof(SlavePacket));
+    return st;
+}
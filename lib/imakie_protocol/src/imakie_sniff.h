@@ -0,0 +1,97 @@
+#pragma once
+#include "imakie_protocol.h"
+
+// ============================================================
+//  imakie_sniff.h  –  Captura pasiva del bus RS485
+//
+//  Formato del flujo binario que un S2 en modo sniffer
+//  (RS485_SNIFFER) saca por USB y que tools/rs485sniff decodifica.
+//  El nodo no interpreta nada: cada lectura del UART es un
+//  registro DATA con el instante en que llegó. Tramas, ranuras y
+//  tiempos se reconstruyen en el PC.
+//
+//  Registro: [0xA5][type][len][t:4][payload:len][crc8]
+//    t     µs (esp_timer, 32 bits: el decoder deshace el desborde)
+//    crc8  rs485_crc8 de type..payload → resincroniza tras basura
+//          en el USB (log de arranque, bytes perdidos)
+//
+//    HELLO  [version][baud:4][rxTimeout][ringKB:2]   al arrancar
+//    DATA   bytes del bus; t = RX timeout / FIFO lleno del UART,
+//           rxTimeout símbolos después del último byte
+//    BAUD   [baud:4]       el sniffer sigue el RS485_BAUD_BYTE
+//    DROP   [count:4]      registros perdidos con el ring lleno
+// ============================================================
+
+#define SNIFF_SYNC         0xA5
+#define SNIFF_VERSION      1
+#define SNIFF_HEADER_LEN   7
+#define SNIFF_MAX_PAYLOAD  255
+#define SNIFF_MAX_LEN      (SNIFF_HEADER_LEN + SNIFF_MAX_PAYLOAD + 1)
+
+enum SniffType : uint8_t {
+    SNIFF_HELLO = 'H',
+    SNIFF_DATA  = 'D',
+    SNIFF_BAUD  = 'B',
+    SNIFF_DROP  = 'O',
+};
+
+inline size_t sniff_encode(uint8_t* out, uint8_t type, uint32_t t, const uint8_t* p, uint8_t n) {
+    out[0] = SNIFF_SYNC;
+    out[1] = type;
+    out[2] = n;
+    rs485_put32(&out[3], t);
+    memcpy(&out[SNIFF_HEADER_LEN], p, n);
+    out[SNIFF_HEADER_LEN + n] = rs485_crc8(&out[1], SNIFF_HEADER_LEN - 1 + n);
+    return SNIFF_HEADER_LEN + n + 1;
+}
+
+// ============================================================
+//  SniffReader — decoder incremental del flujo
+//  push() byte a byte; true = registro completo en type/t/len/payload.
+//  Al final del flujo, next() hasta false (resincronización pendiente)
+// ============================================================
+class SniffReader {
+public:
+    uint8_t  type = 0;
+    uint32_t t    = 0;
+    uint8_t  len  = 0;
+    const uint8_t* payload() const { return _payload; }
+
+    uint32_t skipped = 0;       // bytes descartados resincronizando
+
+    bool push(uint8_t b) {
+        _buf[_got++] = b;
+        return next();
+    }
+
+    bool next() {
+        for (;;) {
+            if (_got == 0) return false;
+            if (_buf[0] != SNIFF_SYNC) { _drop(1); skipped++; continue; }
+            if (_got < SNIFF_HEADER_LEN) return false;
+            const size_t need = SNIFF_HEADER_LEN + _buf[2] + 1;
+            if (_got < need) return false;
+            if (rs485_crc8(&_buf[1], need - 2) != _buf[need - 1]) {
+                _drop(1);               // falso 0xA5: se reintenta desde el byte siguiente
+                skipped++;
+                continue;
+            }
+            type = _buf[1];
+            len  = _buf[2];
+            t    = rs485_get32(&_buf[3]);
+            memcpy(_payload, &_buf[SNIFF_HEADER_LEN], len);
+            _drop(need);
+            return true;
+        }
+    }
+
+private:
+    uint8_t _buf[SNIFF_MAX_LEN];
+    uint8_t _payload[SNIFF_MAX_PAYLOAD];
+    size_t  _got = 0;
+
+    void _drop(size_t n) {
+        memmove(_buf, &_buf[n], _got - n);
+        _got -= n;
+    }
+};
@@ -0,0 +1,329 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include <imakie_protocol.h>
+#include <Seqlock.h>
+#include <SpscRing.h>
+#include <LatencyEstimator.h>
+#include <imakie_profiler.h>
+
+// ============================================================
+//  imakie_rs485.h  –  Master RS485 compartido (P4 y S3)
+//
+//  Un RS485Master = un bus: UART, pines y tramo del mapa global en
+//  RS485BusConfig. El P4 los junta en RS485Network (src/RS485), el
+//  S3 usa uno solo. Las definiciones van en imakie_rs485_impl.h, que
+//  incluye un único .cpp por placa.
+//
+//  Se incluye DESPUÉS del config.h de la placa: tamaños, tiempos y
+//  opciones son sus RS485_*. Opcionales (por defecto, comportamiento P4):
+//    RS485_FW_UPDATE              1 = firmware S2 por el bus (RS485Fw.cpp del P4)
+//    RS485_CALIB_RETRIES          calibraciones automáticas por slave (1 = solo al primer contacto)
+//    RS485_FADER_EMA_PCT          suavizado de faderPos en % por respuesta (0 = crudo)
+//    RS485_FADER_MAP_CALIBRATED   1 = setFaderTarget escala 14 bits al rango calibrado del slave
+// ============================================================
+
+#ifndef RS485_BUS_MAX_SLAVES
+#error "imakie_rs485.h: falta RS485_BUS_MAX_SLAVES (incluir después de config.h)"
+#endif
+#ifndef RS485_FW_UPDATE
+#define RS485_FW_UPDATE             0
+#endif
+#ifndef RS485_CALIB_RETRIES
+#define RS485_CALIB_RETRIES         3
+#endif
+#ifndef RS485_FADER_EMA_PCT
+#define RS485_FADER_EMA_PCT         0
+#endif
+#ifndef RS485_FADER_MAP_CALIBRATED
+#define RS485_FADER_MAP_CALIBRATED  0
+#endif
+
+// Master → Slave: escrito SOLO por el task MIDI (set*), leído por RS485
+struct ChannelCmd {
+    char      trackName[8]  = {};
+    uint8_t   flags         = 0;
+    uint16_t  faderTarget   = 8192;
+    uint8_t   vuLevel       = 0;
+    uint8_t   vpotValue     = 0;
+    AutoMode  autoMode      = AUTO_OFF;
+};
+
+// Slave → Master: escrito SOLO por el task RS485, leído por MIDI
+struct SlaveState {
+    uint16_t faderPos         = 0;
+    uint8_t  touchState       = 0;
+    uint8_t  buttons          = 0;
+    uint8_t  prevButtons      = 0;
+    int8_t   encoderDelta     = 0;
+    uint8_t  encoderButton    = 0;
+    uint8_t  prevEncoderButton = 0;
+    bool     calibrated       = false;
+
+    // Rango ADC del slave (SLAVE_FLAG_CALIB_SENDING tras calibrar)
+    uint16_t calibratedMin    = 0;
+    uint16_t calibratedMax    = 0;
+};
+
+// Evento slave → MIDI. El task RS485 compara respuesta a respuesta, así
+// ningún flanco de botón se pierde aunque el task MIDI vaya con retraso.
+enum class SlaveEvtType : uint8_t { FADER, TOUCH, BUTTON, ENCODER, PRESENCE };
+struct SlaveEvent {
+    SlaveEvtType type;
+    uint8_t      id;       // slave 1..N
+    uint8_t      arg;      // BUTTON: bit (0-3) · TOUCH/BUTTON: 1 = on
+    uint8_t      on;
+    int16_t      value;    // FADER: faderPos · ENCODER: delta · PRESENCE: SlavePresence
+    uint32_t     t;        // micros() de la respuesta RS485 (perfil fader → MIDI)
+};
+
+// Presencia en el bus. OFFLINE sale del barrido (re-sondeo con backoff);
+// al pasar a OFFLINE se sueltan touch y botones pulsados (eventos normales).
+enum class SlavePresence : uint8_t { OFFLINE, SUSPECT, ONLINE };
+
+// Base de datos por canal — sin mutex: un seqlock por sentido + flags atómicos
+struct ChannelData {
+    Seqlock<ChannelCmd> cmd;
+    Seqlock<SlaveState> slave;
+
+    // Compartidos entre tasks (atómicos)
+    std::atomic<uint8_t> dirty{DF_ALL};        // campos pendientes de enviar (DF_*)
+    std::atomic<bool>    calibrate{false};     // one-shot FLAG_CALIB
+    std::atomic<bool>    calibrating{false};
+    std::atomic<bool>    responded{false};     // respuesta nueva (hasNewSlaveData la consume)
+    std::atomic<SlavePresence> presence{SlavePresence::OFFLINE};   // hasta la primera respuesta
+
+    // Privados del task RS485
+    uint8_t   inflight      = 0;       // campos del último envío sin respuesta aún
+    uint8_t   sentConnected = 0xFF;    // último 'connected' enviado (0xFF = nunca)
+    uint8_t   refreshCount  = 0;
+    bool      deltaCapable  = false;   // slave anuncia SLAVE_CAP_DELTA
+    bool      bcastCapable  = false;   // slave anuncia SLAVE_CAP_BCAST
+    bool      baudCapable   = false;   // slave anuncia SLAVE_CAP_BAUD
+    bool      groupCapable  = false;   // slave anuncia SLAVE_CAP_GROUP
+    bool      fwCapable     = false;   // slave anuncia SLAVE_CAP_FW
+    uint8_t   calibRetries  = 0;
+    uint8_t   misses        = 0;       // timeouts seguidos
+    uint16_t  backoffMs     = RS485_BACKOFF_MIN_MS;
+    uint32_t  retryAt       = 0;       // millis() del próximo re-sondeo (OFFLINE)
+    uint16_t  faderFiltered = 0;       // RS485_FADER_EMA_PCT
+
+    // Timeout adaptativo (latencia fin de TX → respuesta completa)
+    LatencyEstimator<RS485_LAT_BUCKET_US, RS485_LAT_BUCKETS, RS485_LAT_WINDOW> lat;
+    uint16_t  learnedUs     = 0;       // 0 = aún sin datos → RS485_RESP_TIMEOUT_US
+    bool      shortMissed   = false;   // el último timeout fue el aprendido
+};
+
+// Un bus: UART, pines y tramo del mapa global (firstId..firstId+numSlaves-1)
+struct RS485BusConfig {
+    HardwareSerial* uart;
+    int8_t          txPin;
+    int8_t          rxPin;
+    int8_t          enPin;
+    uint8_t         firstId;     // id global del slave 1 de este bus
+    uint8_t         numSlaves;   // ≤ RS485_BUS_MAX_SLAVES
+    char            name;        // 'A', 'B', 'S' — logs y nombre del task
+    const char*     nvsKey;      // velocidad negociada en NVS ("rs485"/nvsKey)
+};
+
+// Ids de la API (set*, getSlave, ...) son locales al bus: 1..numSlaves.
+// Los eventos salen ya con id global.
+class RS485Master {
+public:
+    explicit RS485Master(const RS485BusConfig& cfg)
+        : _cfg(cfg), _uart(*cfg.uart), _numSlaves(cfg.numSlaves) {}
+
+    void begin();
+    void startTask();
+
+    // FreeRTOS task (Core 1)
+    static void taskEntry(void* param);
+    void        runTask();
+
+    // API Core 0 → RS485 (MIDI → slaves)
+    void setTrackName  (uint8_t id, const char* name);
+    void setFlags      (uint8_t id, uint8_t flags);
+    void setFaderTarget(uint8_t id, uint16_t value14bit);
+    void setVuLevel    (uint8_t id, uint8_t value);
+    void setVPotValue  (uint8_t id, uint8_t rawCC);
+    void setCalibrate  (uint8_t id);               // one-shot calibración
+    void setAutoMode   (uint8_t id, AutoMode mode); // modo de automatización
+
+    // API RS485 → Core 0 (slaves → MIDI) — copia coherente, nunca bloquea
+    bool       hasNewSlaveData(uint8_t id);
+    SlaveState getSlave       (uint8_t id);
+    SlavePresence getPresence (uint8_t id) const;
+    // Strips perdidos tras haber respondido (bit = id local): LED de estado
+    uint32_t   lostMask       () const { return _lostMask.load(std::memory_order_relaxed); }
+
+    // Eventos: el task RS485 encola y notifica al task consumidor
+    void setEventTask(TaskHandle_t task) { _evtTask = task; }
+    bool popEvent    (SlaveEvent& ev)    { return _events.pop(ev); }
+
+    // Secuencia de desconexión: cualquier task la pide, el task RS485 la ejecuta
+    void beginDisconnectSequence();     // Pide el envío de DISCONNECTED a todos
+    bool isDisconnectComplete() const;  // Retorna true cuando todos recibieron
+
+#if RS485_FW_UPDATE
+    // Firmware S2 por el bus: se difunde 'path' (LittleFS) al inicio del
+    // próximo barrido. Bloquea el task de este bus hasta terminar.
+    // fallback: imagen completa para los que rechacen 'path' (delta de otra base)
+    void requestFirmware(const char* path, const char* fallback = nullptr);
+#endif
+
+    void printStats() const;
+    void resetStats();              // petición: el task RS485 pone a cero en el próximo slot
+
+    // Profiler (imakie_profiler.h): e2e lo registra el task MIDI tras el flush USB
+    void   profileE2E  (uint8_t id, uint32_t us) { _prof.e2e(id, us); }
+    size_t writeProfile(Print& out) const;   // snapshot binario "IMPF"
+
+    bool    owns   (uint8_t globalId) const {
+        return globalId >= _cfg.firstId && globalId < _cfg.firstId + _numSlaves;
+    }
+    uint8_t firstId() const { return _cfg.firstId; }
+
+private:
+    const RS485BusConfig _cfg;
+    HardwareSerial&   _uart;
+    uint8_t           _numSlaves;
+    uint8_t           _currentId  = 1;
+    ChannelData       _ch[RS485_BUS_MAX_SLAVES + 1];
+
+    enum class BusState : uint8_t { SEND, WAIT_RESP, WAIT_GROUP, GAP };
+    BusState _busState   = BusState::SEND;
+    uint32_t _stateTimer = 0;
+    uint32_t _cycleStart = 0;
+
+    uint8_t  _rxBuf[sizeof(SlavePacket)];
+    uint8_t  _rxGot    = 0;
+    bool     _rxHeader = false;
+    uint32_t _rxAt     = 0;     // micros() de la última respuesta completa
+
+    // Histogramas siempre activos: espera de respuesta, barrido, fader → MIDI
+    RS485Profiler<RS485_BUS_MAX_SLAVES> _prof;
+    uint32_t _sweepAt  = 0;     // micros() del inicio del barrido (0 = no medir el siguiente)
+
+    uint32_t _txCount   = 0;
+    uint32_t _rxCount   = 0;
+    uint32_t _timeouts  = 0;
+    uint32_t _crcErrors = 0;
+    uint32_t _wakeups   = 0;   // despertares del task (event-driven: ~2-3 por slave)
+    uint32_t _txBytes   = 0;   // bytes master→slave en el bus
+
+    // Transceptor: DE por UART (RS485 half-duplex) o por GPIO
+    bool     _hwDE      = false;
+    uint32_t _txBusyUs  = 0;   // modo HW: tiempo de cable del último envío (write no espera)
+    uint32_t _bcastCount = 0;
+
+    // Broadcast (id 0): estado global, sin respuesta
+    uint8_t  _bcastSeq       = 0;
+    uint8_t  _bcastConnected = 0xFF;   // último 'connected' difundido
+    bool     _bcastPending   = true;   // enviar antes del próximo slave
+    bool     _bcastSent      = false;  // GAP actual sigue a un broadcast → no avanzar slave
+
+    // Velocidad negociada (código RS485_BAUD_RATES; 0 = RS485_BAUD)
+    uint8_t  _baudCode     = 0;        // velocidad de trabajo del bus
+    uint8_t  _uartCode     = 0;        // velocidad actual del UART
+    uint32_t _baudAnnounce = 0;        // millis() del último re-anuncio
+
+    // Scheduler adaptativo: _sweepId recorre 1..N, los slots extra van a slaves activos
+    uint8_t  _sweepId    = 1;
+    uint8_t  _activeNext = 1;                         // rotación entre activos
+    bool     _extraSlot  = false;                     // último poll fue un slot extra
+    uint32_t _activeUntil [RS485_BUS_MAX_SLAVES + 1] = {0};     // millis() hasta el que sigue activo
+    uint16_t _lastFaderRaw[RS485_BUS_MAX_SLAVES + 1] = {0};
+    uint32_t _reprobes    = 0;                        // polls a slaves OFFLINE (backoff)
+    bool     _sweepReprobe = false;                   // ya hubo re-sondeo en este barrido
+    std::atomic<uint32_t> _lostMask{0};               // perdidos tras responder
+
+    // Timeout de la espera en curso (aprendido o fijo, + _txBusyUs)
+    uint32_t _respTimeoutUs = RS485_RESP_TIMEOUT_US;
+    bool     _respShort     = false;                  // la espera usa el aprendido
+    uint32_t _shortTimeouts = 0;
+
+    // Group poll: una trama por barrido para los que anuncian SLAVE_CAP_GROUP
+    bool     _groupPending = false;                   // enviar grupo antes del próximo slave
+    uint32_t _groupServed  = 0;                       // bit id: ya sondeado en grupo este barrido
+    uint32_t _groupWaiting = 0;                       // bit id: ranura aún sin respuesta
+    uint8_t  _groupCount   = 0;
+    uint16_t _slotUs       = 0;
+    uint32_t _groupPolls   = 0;
+
+#if RS485_FW_UPDATE
+    // Firmware por el bus (RS485Fw.cpp)
+    struct FwStatus {
+        uint8_t  state;
+        uint16_t session;
+        uint16_t missing;
+        uint16_t base;
+        uint8_t  nbytes;
+        uint8_t  bitmap[FW_NACK_BYTES];
+    };
+    std::atomic<bool> _fwRequest{false};
+    const char*       _fwPath     = nullptr;
+    const char*       _fwFallback = nullptr;
+#endif
+    uint32_t _statsStart  = 0;
+    std::atomic<bool> _resetRequested{false};   // resetStats() → _applyReset() en el task RS485
+
+    // Secuencia de desconexión. _disconnectRequest/_disconnectAt los escribe
+    // el task que la pide (MIDI); el resto solo el task RS485 (_startDisconnect)
+    std::atomic<bool>     _disconnectRequest{false};
+    std::atomic<uint32_t> _disconnectAt{0};       // millis() de la petición (timeout ~5s)
+    std::atomic<bool>     _disconnecting{false};  // En proceso de apagar todos los slaves
+    uint8_t  _disconnectLastId = 0;                // Último slave a notificar
+
+    // Cola de eventos slave → MIDI (productor: task RS485, consumidor: _evtTask)
+    SpscRing<SlaveEvent, RS485_EVENT_QUEUE_LEN> _events;
+    TaskHandle_t _evtTask   = nullptr;
+    uint32_t     _evtDrops  = 0;
+
+    // Event-driven: bits de notificación del task RS485
+    static constexpr uint32_t EVT_RX    = (1 << 0);   // UART: FIFO lleno o RX timeout
+    static constexpr uint32_t EVT_TIMER = (1 << 1);   // esp_timer: fin timeout respuesta / GAP
+    TaskHandle_t       _task  = nullptr;
+    esp_timer_handle_t _timer = nullptr;
+
+    uint8_t _buildPacket(uint8_t id, MasterPacket& pkt);
+    void _sendPacket   (uint8_t id);
+    void _sendGroup    ();
+    bool _groupMember  (uint8_t id) const;
+    void _handleGroupResponse();
+    void _missResponse (uint8_t id);
+    void _sendBroadcast();
+    void _transmit     (const uint8_t* buf, size_t len);
+    uint32_t _wireUs   (size_t len) const;
+    void _negotiateBaud();
+    bool _tryBaud      (uint8_t code, uint32_t present);
+    bool _probe        (uint8_t id);
+    void _sendBaud     (uint8_t code);
+    void _setUartBaud  (uint8_t code);
+    void _announceBaud ();
+    bool _readResponse ();
+    bool _handleResponse(uint8_t id);   // false: CRC o id no válidos
+    void _nextSlave    ();
+    void _startDisconnect();
+    void _applyReset   ();
+    void _markActivity (uint8_t id, const SlavePacket* resp);
+    void _pushEvents   (uint8_t id, const SlaveState& prev, const SlaveState& cur, bool faderValid);
+    uint8_t _nextActive(uint8_t skipA, uint8_t skipB);
+    bool _pollDue      (uint8_t id);
+    void _markPresent  (uint8_t id);
+    void _markMissed   (uint8_t id);
+    void _setPresence  (uint8_t id, SlavePresence p);
+    uint32_t _timeoutFor(uint8_t id) const;
+    void _learnLatency (uint8_t id, uint32_t us);
+    uint16_t _filterFader(uint8_t id, uint16_t raw);
+#if RS485_FW_UPDATE
+    uint32_t _fwUpdate (const char* path, uint32_t only);   // → máscara de slaves fallidos
+    bool _fwQuery      (uint8_t id, uint16_t session, uint16_t from, FwStatus& st);
+    void _fwSend       (const uint8_t* buf, size_t len, uint32_t gapUs);
+    void _sleepUs      (uint32_t us);
+#endif
+    void _armTimer     (uint32_t us);
+    void _waitEvent    ();
+    static void _onTimer(void* arg);
+};
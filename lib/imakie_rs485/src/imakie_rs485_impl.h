@@ -0,0 +1,1066 @@
+#pragma once
+#include "imakie_rs485.h"
+#include <Preferences.h>
+
+// ============================================================
+//  imakie_rs485_impl.h  –  definiciones de RS485Master
+//
+//  Lo incluye un único .cpp por placa (src/RS485/RS485.cpp), después
+//  de config.h. La placa define además g_logicConnected (main.cpp).
+// ============================================================
+
+static_assert(RS485_BUS_MAX_SLAVES < 32, "máscaras de 32 bits por id");
+static_assert(RS485_BUS_MAX_SLAVES <= RS485_GROUP_MAX_SLAVES, "trama de grupo: registros por bus");
+
+extern uint8_t g_logicConnected;
+
+void RS485Master::begin() {
+    pinMode(_cfg.enPin, OUTPUT);
+    digitalWrite(_cfg.enPin, LOW);
+
+    _uart.setRxBufferSize(256);   // ← ANTES del begin (fix bug anterior)
+#if RS485_GROUP_POLL
+    _uart.setTxBufferSize(256);   // trama de grupo > FIFO: write() no espera al cable
+#endif
+    _uart.begin(RS485_BAUD, SERIAL_8N1, _cfg.rxPin, _cfg.txPin);
+
+#if RS485_HW_HALF_DUPLEX
+    // RTS = DE: el UART lo activa durante TX y lo suelta tras el último bit
+    _hwDE = _uart.setPins(-1, -1, -1, _cfg.enPin) &&
+            _uart.setMode(UART_MODE_RS485_HALF_DUPLEX);
+    if (!_hwDE) {
+        log_w("[RS485] Half-duplex HW no disponible — DE por GPIO");
+        _uart.setMode(UART_MODE_UART);
+        pinMode(_cfg.enPin, OUTPUT);
+        digitalWrite(_cfg.enPin, LOW);
+    }
+#endif
+
+#if RS485_EVENT_DRIVEN
+    // Despertar por evento: FIFO con un SlavePacket completo o RX timeout
+    _uart.setRxFIFOFull(sizeof(SlavePacket));
+    _uart.setRxTimeout(RS485_RX_TIMEOUT_SYMBOLS);
+    _uart.onReceive([this]() {
+        if (_task) xTaskNotify(_task, EVT_RX, eSetBits);
+    });
+
+    esp_timer_create_args_t targs = {};
+    targs.callback        = &RS485Master::_onTimer;
+    targs.arg             = this;
+    targs.dispatch_method = ESP_TIMER_TASK;
+    targs.name            = "rs485";
+    ESP_ERROR_CHECK(esp_timer_create(&targs, &_timer));
+#endif
+
+    for (uint8_t i = 1; i <= _numSlaves; i++) {
+        ChannelCmd& c = _ch[i].cmd.beginWrite();
+        snprintf(c.trackName, 8, "TRK-%02d", i);
+        c.faderTarget = 8192;
+        _ch[i].cmd.endWrite();
+        _ch[i].dirty = DF_ALL;
+    }
+
+    _cycleStart = millis();
+    _statsStart = millis();
+
+    log_i("[RS485] Bus %c init | slaves:%u (ids %u-%u) baud:%u DE:%s", _cfg.name, _numSlaves,
+          _cfg.firstId, _cfg.firstId + _numSlaves - 1, RS485_BAUD, _hwDE ? "UART" : "GPIO");
+    // ← task ya NO se crea aquí
+}
+
+void RS485Master::startTask() {
+    char name[8];
+    snprintf(name, sizeof(name), "RS485%c", _cfg.name);
+    xTaskCreatePinnedToCore(
+        RS485Master::taskEntry, name,
+        RS485_TASK_STACK, this, 5, &_task, 1
+    );
+    log_i("[RS485] Task bus %c iniciado.", _cfg.name);
+}
+
+void RS485Master::setCalibrate(uint8_t id) {
+    if (id < 1 || id > _numSlaves) return;
+    _ch[id].calibrate   = true;
+    _ch[id].calibrating = true;  // la auto-calibración de _handleResponse no la repite
+    _ch[id].dirty      |= DF_FLAGS;
+}
+
+void RS485Master::setAutoMode(uint8_t id, AutoMode mode) {
+    if (id < 1 || id > _numSlaves) return;
+    _ch[id].cmd.beginWrite().autoMode = mode;
+    _ch[id].cmd.endWrite();
+    _ch[id].dirty |= DF_FLAGS;
+}
+
+void RS485Master::taskEntry(void* param) {
+    static_cast<RS485Master*>(param)->runTask();
+}
+
+void RS485Master::runTask() {
+#if RS485_BAUD_NEGOTIATE
+    _negotiateBaud();
+#endif
+    _stateTimer = micros();
+    for (;;) {
+        switch (_busState) {
+
+            case BusState::SEND:
+#if RS485_BAUD_NEGOTIATE
+                if (_baudCode && millis() - _baudAnnounce >= RS485_BAUD_ANNOUNCE_MS) {
+                    _announceBaud();
+                    _bcastSent  = true;            // GAP corto, sin avanzar de slave
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_BCAST_GAP_US + _txBusyUs);
+                    break;
+                }
+#endif
+                if (g_logicConnected != _bcastConnected) _bcastPending = true;
+                if (_bcastPending) {
+                    _sendBroadcast();
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_BCAST_GAP_US + _txBusyUs);
+                    break;
+                }
+#if RS485_GROUP_POLL
+                if (_groupPending) {
+                    _sendGroup();
+                    _rxGot    = 0;
+                    _rxHeader = false;
+                    _busState = BusState::WAIT_GROUP;
+                    _stateTimer = micros();
+                    // Hasta el final de la última ranura
+                    _respTimeoutUs = _txBusyUs + RS485_GROUP_LEAD_US + (uint32_t)_groupCount * _slotUs;
+                    _armTimer(_respTimeoutUs);
+                    break;
+                }
+#endif
+                if (!_currentId) {
+                    // Nadie a quien sondear (todos OFFLINE esperando backoff):
+                    // el barrido se queda en su broadcast
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_GAP_US);
+                    break;
+                }
+                _sendPacket(_currentId);
+                _prof.poll(_currentId);
+                _rxGot    = 0;
+                _rxHeader = false;
+                _busState = BusState::WAIT_RESP;
+                _stateTimer = micros();
+                _respTimeoutUs = _timeoutFor(_currentId);
+                _respShort     = _respTimeoutUs < RS485_RESP_TIMEOUT_US;
+                _respTimeoutUs += _txBusyUs;
+                _armTimer(_respTimeoutUs);
+                break;
+
+            case BusState::WAIT_RESP:
+                if (_readResponse()) {
+                    // Solo una respuesta válida enseña latencia: ruido o un
+                    // eco de otro id llegan a cualquier hora
+                    if (_handleResponse(_currentId)) {
+                        const uint32_t waitUs = _rxAt - _stateTimer;   // incluye _txBusyUs
+                        _prof.rxWait(_currentId, waitUs > _txBusyUs ? waitUs - _txBusyUs : 0);
+                        _learnLatency(_currentId, waitUs);
+                    } else {
+                        _missResponse(_currentId);    // respuesta inválida = sin respuesta
+                    }
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_GAP_US);
+                } else if (micros() - _stateTimer >= _respTimeoutUs) {
+                    _timeouts++;
+                    _prof.timeout(_currentId);
+                    log_v("[RS485] TIMEOUT slave %d (rx bytes=%d)", _currentId, _uart.available());  // ← añade esto
+                    if (_respShort) {
+                        _shortTimeouts++;
+                        _ch[_currentId].shortMissed = true;   // próximo poll con el fijo
+                    }
+                    _missResponse(_currentId);
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_GAP_US);
+                }
+                break;
+
+            case BusState::WAIT_GROUP:
+                // Respuestas en orden de ranura; cada una se atribuye por su id
+                while (_groupWaiting && _readResponse()) {
+                    _handleGroupResponse();
+                    _rxGot    = 0;
+                    _rxHeader = false;
+                }
+                if (!_groupWaiting || micros() - _stateTimer >= _respTimeoutUs) {
+                    for (uint8_t id = 1; id <= _numSlaves; id++) {
+                        if (!(_groupWaiting & (1u << id))) continue;
+                        _timeouts++;
+                        _prof.timeout(id);
+                        _missResponse(id);
+                    }
+                    _groupWaiting = 0;
+                    _busState   = BusState::GAP;
+                    _stateTimer = micros();
+                    _armTimer(RS485_GAP_US);
+                }
+                break;
+
+            case BusState::GAP:
+                if (_bcastSent) {
+                    if (micros() - _stateTimer >= RS485_BCAST_GAP_US + _txBusyUs) {
+                        _bcastSent = false;
+                        _busState  = BusState::SEND;
+                        continue;
+                    }
+                } else if (micros() - _stateTimer >= RS485_GAP_US) {
+                    _nextSlave();
+                    _busState = BusState::SEND;
+                    continue;   // SEND no espera evento
+                }
+                break;
+        }
+        _waitEvent();
+    }
+}
+
+// ─── Event-driven ────────────────────────────────────────────
+// El task duerme hasta un evento UART (onReceive) o el esp_timer
+// de timeout/GAP. Los eventos obsoletos son inocuos: cada estado
+// revalida con micros() antes de avanzar.
+
+void RS485Master::_onTimer(void* arg) {
+    RS485Master* self = static_cast<RS485Master*>(arg);
+    if (self->_task) xTaskNotify(self->_task, EVT_TIMER, eSetBits);
+}
+
+void RS485Master::_armTimer(uint32_t us) {
+#if RS485_EVENT_DRIVEN
+    esp_timer_stop(_timer);             // ESP_ERR_INVALID_STATE si no estaba activo — ignorar
+    esp_timer_start_once(_timer, us);
+#endif
+}
+
+void RS485Master::_waitEvent() {
+#if RS485_EVENT_DRIVEN
+    xTaskNotifyWait(0, UINT32_MAX, nullptr, pdMS_TO_TICKS(RS485_EVT_WAIT_MAX_MS));
+#else
+    taskYIELD();
+#endif
+    _wakeups++;
+}
+
+// Estado a enviar a un slave: snapshot de cmd + campos pendientes.
+// Devuelve los campos del delta y los deja en vuelo hasta la respuesta.
+uint8_t RS485Master::_buildPacket(uint8_t id, MasterPacket& pkt) {
+    ChannelData& ch = _ch[id];
+    // dirty ANTES del snapshot: un set*() posterior vuelve a marcarlo y
+    // viaja en el siguiente paquete (nunca se pierde una actualización)
+    uint8_t    fields = ch.dirty.exchange(0);
+    ChannelCmd c;
+    ch.cmd.read(c);                              // copia coherente, sin bloquear al task MIDI
+
+    // ── autoMode en bits 5-7 ──
+    uint8_t flags = ::setAutoMode(c.flags, c.autoMode);
+    // ── FLAG_CALIB one-shot ──
+    if (ch.calibrate.exchange(false)) flags |= FLAG_CALIB;
+
+    uint8_t connected = g_logicConnected;
+    // Slaves con broadcast reciben 'connected' por id 0, no en el delta
+    if (connected != ch.sentConnected && !ch.bcastCapable)
+        fields |= DF_CONNECTED;
+
+    pkt = {};
+    pkt.id          = id;
+    memcpy(pkt.trackName, c.trackName, 7);
+    pkt.flags       = flags;
+    pkt.faderTarget = c.faderTarget;
+    pkt.vuLevel     = c.vuLevel;
+    pkt.vpotValue   = c.vpotValue;
+    pkt.connected   = connected;
+
+    if (RS485_DELTA_PACKETS && ch.deltaCapable &&
+        ++ch.refreshCount >= RS485_DELTA_REFRESH_CYCLES) {
+        ch.refreshCount = 0;
+        fields          = DF_ALL;
+    }
+
+    // Campos en vuelo: se reponen en dirty si no hay respuesta válida
+    ch.inflight      = fields;
+    ch.sentConnected = connected;
+    return fields;
+}
+
+void RS485Master::_sendPacket(uint8_t id) {
+    uint8_t      tx[RS485_MAX_FRAME_LEN];
+    MasterPacket pkt;
+    uint8_t      fields = _buildPacket(id, pkt);
+
+    size_t len = (RS485_DELTA_PACKETS && _ch[id].deltaCapable)
+               ? rs485_encodeDelta(tx, pkt, fields)     // FLAG_CALIB fuerza DF_FLAGS
+               : rs485_encodeMaster(tx, pkt);           // firmware S2 sin SLAVE_CAP_DELTA
+
+    _transmit(tx, len);
+    _txCount++;
+}
+
+// ─── Group poll TDMA ─────────────────────────────────────────
+// Un registro delta por slave con SLAVE_CAP_GROUP (ids crecientes);
+// el i-ésimo responde i ranuras después del primero. Cada ranura =
+// respuesta de 9 B + 1 carácter de conmutación + RS485_GROUP_GUARD_US.
+
+bool RS485Master::_groupMember(uint8_t id) const {
+    const ChannelData& ch = _ch[id];
+    return RS485_DELTA_PACKETS && ch.groupCapable && ch.deltaCapable &&
+           ch.presence != SlavePresence::OFFLINE;
+}
+
+void RS485Master::_sendGroup() {
+    uint8_t tx[RS485_GROUP_MAX_LEN];
+    _slotUs = rs485_groupSlotUs(rs485_baudRate(_uartCode, RS485_BAUD), RS485_GROUP_GUARD_US);
+    size_t len = rs485_groupBegin(tx, _slotUs);
+
+    _groupCount   = 0;
+    _groupWaiting = 0;
+    for (uint8_t id = 1; id <= _numSlaves; id++) {
+        if (!_groupMember(id)) continue;
+        MasterPacket pkt;
+        uint8_t fields = _buildPacket(id, pkt);
+        len = rs485_groupAdd(tx, len, pkt, fields);
+        _groupWaiting |= 1u << id;
+        _groupCount++;
+        _prof.poll(id);
+    }
+    len = rs485_groupEnd(tx, len);
+    _groupServed  = _groupWaiting;
+    _groupPending = false;
+
+    _transmit(tx, len);
+    _txCount += _groupCount;       // un poll por registro: Exito % sigue siendo comparable
+    _groupPolls++;
+}
+
+// Respuesta dentro de la ventana de grupo: el id decide a quién pertenece.
+// Un id fuera del grupo o repetido solo puede ser ruido → cuenta como CRC.
+void RS485Master::_handleGroupResponse() {
+    uint8_t id = _rxBuf[1];
+    if (id < 1 || id > _numSlaves || !(_groupWaiting & (1u << id))) {
+        _crcErrors++;
+        return;
+    }
+    _groupWaiting &= ~(1u << id);
+    if (!_handleResponse(id))       // _currentId es el cursor del barrido: no se toca
+        _missResponse(id);
+}
+
+// Sin respuesta válida a tiempo: campos en vuelo de vuelta a dirty
+void RS485Master::_missResponse(uint8_t id) {
+    _ch[id].responded = false;
+    _ch[id].dirty    |= _ch[id].inflight;
+    _activeUntil[id]  = millis();   // sin respuesta → sin slots extra
+    _markMissed(id);
+}
+
+// Broadcast id 0: conexión + número de ciclo. Ningún slave responde.
+void RS485Master::_sendBroadcast() {
+    uint8_t tx[sizeof(BroadcastPacket)];
+    size_t  len = rs485_encodeBroadcast(tx, _bcastSeq++, g_logicConnected ? BCAST_CONNECTED : 0);
+
+    _bcastConnected = g_logicConnected;
+    _bcastPending   = false;
+    _bcastSent      = true;
+
+    _transmit(tx, len);
+    _bcastCount++;
+
+    // Desconexión: si todos los slaves aceptan broadcast, esta trama basta
+    if (_disconnecting && !g_logicConnected) {
+        bool allBcast = true;
+        for (uint8_t i = 1; i <= _numSlaves; i++)
+            if (!_ch[i].bcastCapable) { allBcast = false; break; }
+        if (allBcast) {
+            _disconnecting = false;
+            log_i("[RS485] DISCONNECT por broadcast — todos los slaves notificados");
+        }
+    }
+}
+
+void RS485Master::_transmit(const uint8_t* buf, size_t len) {
+    while (_uart.available()) _uart.read();
+
+    if (_hwDE) {
+        // Solo llena la FIFO: timeout y GAP se cuentan desde el fin estimado de TX
+        _uart.write(buf, len);
+        _txBusyUs = _wireUs(len);
+    } else {
+        digitalWrite(_cfg.enPin, HIGH);
+        delayMicroseconds(RS485_TX_ENABLE_US);
+        _uart.write(buf, len);
+        _uart.flush();
+        delayMicroseconds(RS485_TX_DONE_US);
+        digitalWrite(_cfg.enPin, LOW);
+        _txBusyUs = 0;
+    }
+
+    _txBytes += len;
+}
+
+// 10 bits por byte (8N1) a la velocidad actual del UART
+uint32_t RS485Master::_wireUs(size_t len) const {
+    return (uint32_t)len * 10000000UL / rs485_baudRate(_uartCode, RS485_BAUD);
+}
+
+// ─── Negociación de velocidad ────────────────────────────────
+// Bloqueante, una vez al arrancar el task. Solo se sube si TODOS los
+// slaves que responden a la base anuncian SLAVE_CAP_BAUD; una velocidad
+// vale si RS485_BAUD_PROBE_POLLS polls por slave pasan sin un solo CRC
+// error ni timeout (_crcErrors / _timeouts). Un cambio fallido se deshace
+// con silencio: cada slave vuelve solo a RS485_BAUD.
+
+void RS485Master::_negotiateBaud() {
+    // Slaves que sigan a otra velocidad (master reiniciado) vuelven a la base
+    vTaskDelay(pdMS_TO_TICKS(RS485_BAUD_FALLBACK_MS + RS485_BAUD_SWITCH_MS));
+    _setUartBaud(0);
+
+    uint32_t present = 0;
+    bool     capable = true;
+    for (uint8_t id = 1; id <= _numSlaves; id++) {
+        for (uint8_t t = 0; t < 3; t++) {
+            if (_probe(id)) { present |= (1u << id); break; }
+        }
+        if ((present & (1u << id)) && !_ch[id].baudCapable) capable = false;
+    }
+    if (!present || !capable) {
+        log_i("[RS485] Baud fijo %u (%s)", RS485_BAUD,
+              present ? "slave sin SLAVE_CAP_BAUD" : "ningún slave responde");
+        return;
+    }
+
+    Preferences prefs;
+    prefs.begin("rs485", true);
+    uint8_t stored = prefs.getUChar(_cfg.nvsKey, 0);
+    prefs.end();
+
+    // Velocidad guardada primero: si sigue limpia no hace falta barrido
+    uint8_t best = 0;
+    if (stored > 0 && stored <= RS485_BAUD_MAX_CODE && _tryBaud(stored, present)) {
+        best = stored;
+    } else {
+        for (uint8_t code = 1; code <= RS485_BAUD_MAX_CODE; code++) {
+            if (!_tryBaud(code, present)) break;
+            best = code;
+        }
+        if (best && _uartCode != best && !_tryBaud(best, present)) best = 0;
+    }
+
+    _baudCode     = best;
+    _baudAnnounce = millis();
+    if (best != stored) {
+        prefs.begin("rs485", false);
+        prefs.putUChar(_cfg.nvsKey, best);
+        prefs.end();
+    }
+    log_i("[RS485] Baud negociado: %u", rs485_baudRate(_baudCode, RS485_BAUD));
+}
+
+bool RS485Master::_tryBaud(uint8_t code, uint32_t present) {
+    _sendBaud(code);                        // a la velocidad actual
+    _setUartBaud(code);
+    vTaskDelay(pdMS_TO_TICKS(RS485_BAUD_SWITCH_MS));
+
+    uint32_t crc0 = _crcErrors, to0 = _timeouts;
+    for (uint8_t n = 0; n < RS485_BAUD_PROBE_POLLS; n++)
+        for (uint8_t id = 1; id <= _numSlaves; id++)
+            if (present & (1u << id)) _probe(id);
+    uint32_t crcErr = _crcErrors - crc0;
+    uint32_t tmo    = _timeouts  - to0;
+
+    log_i("[RS485] Baud %u: CRC_ERR:%u TO:%u → %s", rs485_baudRate(code, RS485_BAUD),
+          crcErr, tmo, (crcErr || tmo) ? "descartada" : "OK");
+    if (!crcErr && !tmo) return true;
+
+    vTaskDelay(pdMS_TO_TICKS(RS485_BAUD_FALLBACK_MS + RS485_BAUD_SWITCH_MS));
+    _setUartBaud(0);
+    return false;
+}
+
+// Transacción síncrona (fuera de la máquina de estados): envío + espera
+bool RS485Master::_probe(uint8_t id) {
+    bool got = false, ok = false;
+    _sendPacket(id);
+    _rxGot    = 0;
+    _rxHeader = false;
+
+    uint32_t t0 = micros();
+    _armTimer(RS485_RESP_TIMEOUT_US + _txBusyUs);
+    while (micros() - t0 < RS485_RESP_TIMEOUT_US + _txBusyUs) {
+        if (_readResponse()) {
+            ok  = _handleResponse(id);      // valida CRC/id, cuenta _crcErrors
+            got = true;
+            break;
+        }
+        _waitEvent();
+    }
+    if (!got) _timeouts++;
+    if (!ok)  _ch[id].dirty |= _ch[id].inflight;
+    delayMicroseconds(RS485_GAP_US);
+    return ok;
+}
+
+void RS485Master::_sendBaud(uint8_t code) {
+    uint8_t tx[sizeof(BaudPacket)];
+    _transmit(tx, rs485_encodeBaud(tx, code));
+}
+
+void RS485Master::_setUartBaud(uint8_t code) {
+    _uart.flush();                          // modo HW: la trama en curso sale a la velocidad anterior
+    _uart.updateBaudRate(rs485_baudRate(code, RS485_BAUD));
+    _uartCode = code;
+}
+
+// Slave reiniciado arranca a RS485_BAUD: se le repite la orden a la base
+void RS485Master::_announceBaud() {
+    _setUartBaud(0);
+    _sendBaud(_baudCode);
+    _setUartBaud(_baudCode);
+    _baudAnnounce = millis();
+}
+
+bool RS485Master::_readResponse() {
+    while (_uart.available()) {
+        uint8_t b = (uint8_t)_uart.read();
+        log_v("RX byte: 0x%02X", b);  // ← solo esta línea
+
+        if (!_rxHeader) {
+            if (b == RS485_RESP_BYTE) {
+                _rxBuf[0] = b;
+                _rxGot    = 1;
+                _rxHeader = true;
+            }
+        } else {
+            if (_rxGot < sizeof(SlavePacket))
+                _rxBuf[_rxGot++] = b;
+            if (_rxGot >= sizeof(SlavePacket)) {
+                _rxAt = micros();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//***************************************************************************************************
+// Procesa la respuesta del esclavo: valida CRC, actualiza estado del canal, maneja calibración, etc.
+//***************************************************************************************************
+
+bool RS485Master::_handleResponse(uint8_t id) {
+    SlavePacket pkt;
+    const SlavePacket* resp = &pkt;
+
+    bool valid = true;
+    if (rs485_decodeSlave(_rxBuf, sizeof(SlavePacket), pkt) != Rs485Status::OK) {
+        _crcErrors++;
+        _prof.crcError(id);
+        log_e("[RS485] slave=%u CRC ERROR recv=0x%02X",
+              id, _rxBuf[sizeof(SlavePacket) - 1]);
+        valid = false;
+    } else if (resp->id != id) {
+        _crcErrors++;                       // trama buena de otro: para el bus, error igual
+        _prof.idMismatch(id);
+        log_e("[RS485] ID MISMATCH esperado=%u recibido=%u",
+              id, resp->id);
+        valid = false;
+    }
+    if (!valid) return false;               // el que llama: _missResponse() o reintento
+
+    _markPresent(id);
+    _markActivity(id, resp);
+
+    ChannelData& ch = _ch[id];
+    ch.inflight = 0;
+
+    // ── Capacidad delta: al cambiar, próximo envío completo ──
+    bool deltaCapable = (resp->encoderButton & SLAVE_CAP_DELTA) != 0;
+    if (deltaCapable != ch.deltaCapable) {
+        ch.deltaCapable = deltaCapable;
+        ch.dirty        = DF_ALL;
+        log_i("[RS485] Slave %d paquetes %s", id, deltaCapable ? "delta" : "completos");
+    }
+    ch.bcastCapable = (resp->encoderButton & SLAVE_CAP_BCAST) != 0;
+    ch.baudCapable  = (resp->encoderButton & SLAVE_CAP_BAUD)  != 0;
+    ch.groupCapable = (resp->encoderButton & SLAVE_CAP_GROUP) != 0;
+    ch.fwCapable    = (resp->encoderButton & SLAVE_CAP_FW)    != 0;
+
+    // Copia local → se publica entera al final (sección de escritura mínima)
+    const SlaveState prev = ch.slave.data();
+    SlaveState st = prev;
+    // CALIB_SENDING: faderPos lleva min/max de calibración, no es posición
+    const bool faderValid = !(resp->buttons & SLAVE_FLAG_CALIB_SENDING);
+    if (faderValid)                                   st.faderPos      = _filterFader(id, resp->faderPos);
+    else if (resp->buttons & SLAVE_FLAG_CALIB_IS_MIN) st.calibratedMin = resp->faderPos;
+    else                                              st.calibratedMax = resp->faderPos;
+    st.touchState        = resp->touchState;
+    st.prevButtons       = st.buttons;
+    st.buttons           = resp->buttons & 0x0F;
+    st.encoderDelta      = resp->encoderDelta;
+    st.prevEncoderButton = st.encoderButton;
+    st.encoderButton     = resp->encoderButton & SLAVE_ENC_BUTTON;
+
+    bool calibDone     = resp->buttons & SLAVE_FLAG_CALIB_DONE;
+    bool calibError    = resp->buttons & SLAVE_FLAG_CALIB_ERROR;
+
+    if (calibDone) {
+        ch.calibrating = false;
+        if (!st.calibrated) {
+            st.calibrated = true;
+            ch.dirty     |= DF_FLAGS;
+            log_i("[RS485] Slave %d calibrado OK: MIN=%u MAX=%u",
+                  id, st.calibratedMin, st.calibratedMax);
+        }
+    }
+
+    if (calibError) {
+        ch.calibrating = false;
+        ch.calibRetries++;
+        log_w("[RS485] Slave %d ERROR calibracion (intento %d)",
+              id, ch.calibRetries);
+    }
+
+    // Auto-calibración: al primer contacto y tras cada error, hasta RS485_CALIB_RETRIES
+    if (!st.calibrated && !ch.calibrating && ch.calibRetries < RS485_CALIB_RETRIES) {
+        ch.calibrate   = true;
+        ch.dirty      |= DF_FLAGS;
+        ch.calibrating = true;
+        log_i("[RS485] Slave %d sin calibrar — disparando (intento %d)",
+              id, ch.calibRetries + 1);
+    }
+
+    ch.slave.write(st);
+    ch.responded = true;   // después de publicar: el lector ve el snapshot nuevo
+    _pushEvents(id, prev, st, faderValid);
+
+    // Desconexión por polls: el último slave ya recibió connected = 0
+    if (_disconnecting && id == _disconnectLastId) {
+        _disconnecting = false;
+        log_i("[RS485] DISCONNECT SEQUENCE completada — todos los slaves notificados");
+    }
+
+    _rxCount++;
+    return true;
+}
+
+
+
+
+void RS485Master::_nextSlave() {
+    if (_resetRequested.load(std::memory_order_acquire)) _applyReset();
+    if (_disconnectRequest.load(std::memory_order_acquire)) _startDisconnect();
+
+    // Desconexión: 1..N seguidos sin esperar al ciclo (prioridad: apagar
+    // rápido), ni slots extra ni grupo. OFFLINE no escucha: se salta.
+    if (_disconnecting) {
+        do {
+            _currentId++;
+        } while (_currentId <= _numSlaves && _ch[_currentId].presence == SlavePresence::OFFLINE);
+        _sweepId   = _currentId;
+        _extraSlot = false;
+        if (_currentId <= _numSlaves) return;
+        // Último slave ausente: nadie cerrará la secuencia en _handleResponse
+        _disconnecting = false;
+        _sweepId       = _numSlaves;
+        log_i("[RS485] DISCONNECT SEQUENCE completada — slaves OFFLINE omitidos");
+    }
+    // OFFLINE fuera de su turno de backoff no cuesta un timeout: se salta.
+    // Un barrido entero sin nadie pendiente → _currentId = 0: SEND envía
+    // el broadcast del barrido y no sondea (si no, se quedaría aquí
+    // para siempre con el broadcast pendiente)
+    bool wrapped = false;
+    for (;;) {
+        if (_sweepId >= _numSlaves) {          // barrido completo
+            if (wrapped) { _currentId = 0; return; }
+            wrapped = true;
+            uint32_t elapsed = millis() - _cycleStart;
+#if RS485_ADAPTIVE_POLL
+            // Resto de POLL_CYCLE_MS: slaves activos en vez de dormir
+            if (elapsed < POLL_CYCLE_MS) {
+                uint8_t id = _nextActive(0, 0);
+                if (id) { _currentId = id; return; }
+            }
+#endif
+            _sweepId      = 0;
+            _extraSlot    = false;
+            _sweepReprobe = false;
+            _bcastPending = true;   // broadcast al inicio de cada barrido
+            if (elapsed < POLL_CYCLE_MS)
+                vTaskDelay(pdMS_TO_TICKS(POLL_CYCLE_MS - elapsed));
+            _cycleStart = millis();
+            const uint32_t now = micros();
+            if (_sweepAt) _prof.cycle(now - _sweepAt);
+            _sweepAt = now;
+#if RS485_FW_UPDATE
+            if (_fwRequest.exchange(false)) {
+                // Segundos: el barrido empieza de cero. Delta rechazado → imagen completa
+                uint32_t failed = _fwUpdate(_fwPath, ~0u);
+                if (failed && _fwFallback) _fwUpdate(_fwFallback, failed);
+                _cycleStart = millis();
+                _sweepAt    = 0;           // la actualización no cuenta como barrido
+            }
+#endif
+#if RS485_GROUP_POLL
+            // Dos o más slaves con grupo: una trama para todos; el barrido
+            // sigue luego solo con el resto (OFFLINE, firmware antiguo)
+            _groupServed = 0;
+            uint8_t members = 0;
+            for (uint8_t id = 1; id <= _numSlaves; id++)
+                if (_groupMember(id)) members++;
+            if (members >= 2 && !_disconnecting) { _groupPending = true; return; }
+#endif
+        }
+#if RS485_ADAPTIVE_POLL
+        else if (!_extraSlot) {
+            // Un slot extra como máximo entre dos polls del barrido (sin inanición)
+            uint8_t id = _nextActive(_currentId, _sweepId + 1);
+            if (id) { _extraSlot = true; _currentId = id; return; }
+        }
+        _extraSlot = false;
+#endif
+        _currentId = ++_sweepId;
+        if (!(_groupServed & (1u << _currentId)) && _pollDue(_currentId)) return;
+    }
+}
+
+// ─── Presencia ───────────────────────────────────────────────
+// Primer timeout → SUSPECT (sigue en el barrido); RS485_OFFLINE_MISSES
+// seguidos → OFFLINE: solo un poll cada backoffMs (×2 por fallo, hasta
+// RS485_BACKOFF_MAX_MS). Cualquier respuesta válida → ONLINE.
+// Como mucho un re-sondeo por barrido: un bus entero apagado cuesta un
+// timeout por ciclo, no N a la vez cuando coinciden los backoffs.
+
+bool RS485Master::_pollDue(uint8_t id) {
+    const ChannelData& ch = _ch[id];
+    if (ch.presence != SlavePresence::OFFLINE) return true;
+    if (_sweepReprobe || (int32_t)(millis() - ch.retryAt) < 0) return false;
+    _sweepReprobe = true;
+    return true;
+}
+
+void RS485Master::_markPresent(uint8_t id) {
+    ChannelData& ch = _ch[id];
+    ch.misses    = 0;
+    ch.backoffMs = RS485_BACKOFF_MIN_MS;
+    _setPresence(id, SlavePresence::ONLINE);
+}
+
+void RS485Master::_markMissed(uint8_t id) {
+    ChannelData& ch = _ch[id];
+    if (ch.presence == SlavePresence::OFFLINE) {
+        _reprobes++;
+        ch.backoffMs = (ch.backoffMs * 2 > RS485_BACKOFF_MAX_MS) ? RS485_BACKOFF_MAX_MS
+                                                                 : ch.backoffMs * 2;
+        ch.retryAt   = millis() + ch.backoffMs;
+        return;
+    }
+    if (++ch.misses < RS485_OFFLINE_MISSES) {
+        _setPresence(id, SlavePresence::SUSPECT);
+        return;
+    }
+    ch.backoffMs = RS485_BACKOFF_MIN_MS;
+    ch.retryAt   = millis() + ch.backoffMs;
+    _setPresence(id, SlavePresence::OFFLINE);
+}
+
+// ─── Timeout adaptativo ──────────────────────────────────────
+// Un hipo cuesta el timeout aprendido (~300-500 µs) en vez del fijo.
+// Muestras solo de respuestas completas: el percentil solo puede subir
+// con las que llegan dentro del fijo tras un timeout corto.
+
+uint32_t RS485Master::_timeoutFor(uint8_t id) const {
+#if RS485_ADAPTIVE_TIMEOUT
+    const ChannelData& ch = _ch[id];
+    if (ch.learnedUs && !ch.shortMissed) return ch.learnedUs;
+#endif
+    return RS485_RESP_TIMEOUT_US;
+}
+
+void RS485Master::_learnLatency(uint8_t id, uint32_t us) {
+    ChannelData& ch = _ch[id];
+    ch.lat.add(us > _txBusyUs ? us - _txBusyUs : 0);
+    ch.shortMissed = false;
+    if (ch.lat.samples() < RS485_LAT_MIN_SAMPLES) return;
+
+    uint32_t p = ch.lat.percentileUs(RS485_LAT_PERCENTILE);
+    uint32_t t = (p == ch.lat.OUT_OF_RANGE) ? RS485_RESP_TIMEOUT_US : p + RS485_LAT_MARGIN_US;
+    if (t < RS485_RESP_TIMEOUT_MIN_US) t = RS485_RESP_TIMEOUT_MIN_US;
+    if (t > RS485_RESP_TIMEOUT_US)     t = RS485_RESP_TIMEOUT_US;
+    ch.learnedUs = t;
+}
+
+// Suavizado opcional de faderPos (RS485_FADER_EMA_PCT % por respuesta);
+// _markActivity sigue viendo el valor crudo
+uint16_t RS485Master::_filterFader(uint8_t id, uint16_t raw) {
+    if (!RS485_FADER_EMA_PCT) return raw;
+    ChannelData& ch = _ch[id];
+    ch.faderFiltered += ((int32_t)raw - ch.faderFiltered) * RS485_FADER_EMA_PCT / 100;
+    return ch.faderFiltered;
+}
+
+void RS485Master::_setPresence(uint8_t id, SlavePresence p) {
+    ChannelData& ch = _ch[id];
+    SlavePresence old = ch.presence.exchange(p);
+    if (old == p) return;
+
+    static const char* const NAMES[] = { "OFFLINE", "SUSPECT", "ONLINE" };
+    if (p == SlavePresence::SUSPECT) log_w("[RS485] Slave %d SUSPECT", id);
+    else                             log_i("[RS485] Slave %d %s → %s", id,
+                                           NAMES[(uint8_t)old], NAMES[(uint8_t)p]);
+
+    if (p == SlavePresence::OFFLINE) {
+        // Strip perdido con touch/botones pulsados: se sueltan en Logic
+        const SlaveState prev = ch.slave.data();
+        SlaveState st = prev;
+        st.touchState   = 0;
+        st.buttons     &= ~FLAG_BUTTONS_MASK;
+        st.encoderDelta = 0;
+        ch.slave.write(st);
+        _pushEvents(id, prev, st, false);
+        ch.calibrating = false;
+    } else if (old == SlavePresence::OFFLINE) {
+        // Puede venir de un reinicio: estado completo en el próximo envío
+        ch.dirty         = DF_ALL;
+        ch.sentConnected = 0xFF;
+        ch.lat.reset();                 // latencias del firmware/arranque anterior
+        ch.learnedUs     = 0;
+    }
+
+    // Perdidos tras haber respondido: lo lee el task que pinta el LED de
+    // estado (S3); el evento PRESENCE de abajo lo despierta
+    uint32_t lost = _lostMask.load(std::memory_order_relaxed);
+    if (p == SlavePresence::OFFLINE && old != SlavePresence::OFFLINE) lost |=  (1u << id);
+    if (p == SlavePresence::ONLINE)                                     lost &= ~(1u << id);
+    _lostMask.store(lost, std::memory_order_relaxed);
+
+    if (_events.push(SlaveEvent{SlaveEvtType::PRESENCE, (uint8_t)(id + _cfg.firstId - 1), 0,
+                                (uint8_t)(p != SlavePresence::OFFLINE), (int16_t)p, (uint32_t)micros()})) {
+        if (_evtTask) xTaskNotifyGive(_evtTask);
+    } else {
+        _evtDrops++;
+    }
+}
+
+// Flancos respuesta a respuesta → cola SPSC. Una sola notificación por
+// respuesta; el task MIDI drena todo lo pendiente al despertar.
+void RS485Master::_pushEvents(uint8_t id, const SlaveState& prev, const SlaveState& cur,
+                              bool faderValid) {
+    const uint8_t gid = id + _cfg.firstId - 1;   // la capa MIDI ve ids globales
+    bool pushed = false;
+    auto push = [&](SlaveEvtType type, uint8_t arg, uint8_t on, int16_t value) {
+        if (_events.push(SlaveEvent{type, gid, arg, on, value, _rxAt})) pushed = true;
+        else                                                    _evtDrops++;
+    };
+
+    if (cur.touchState != prev.touchState)
+        push(SlaveEvtType::TOUCH, 0, cur.touchState ? 1 : 0, 0);
+
+    if (cur.touchState && faderValid &&
+        (cur.faderPos != prev.faderPos || !prev.touchState))
+        push(SlaveEvtType::FADER, 0, 1, (int16_t)cur.faderPos);
+
+    uint8_t changed = (cur.buttons ^ prev.buttons) & 0x0F;
+    for (uint8_t bit = 0; bit < 4; bit++)
+        if (changed & (1 << bit))
+            push(SlaveEvtType::BUTTON, bit, (cur.buttons >> bit) & 1, 0);
+
+    if (cur.encoderDelta != 0)
+        push(SlaveEvtType::ENCODER, 0, 0, cur.encoderDelta);
+
+    if (pushed && _evtTask) xTaskNotifyGive(_evtTask);
+}
+
+// Actividad: touch, encoder o fader moviéndose (usuario o motor)
+void RS485Master::_markActivity(uint8_t id, const SlavePacket* resp) {
+    if (resp->buttons & SLAVE_FLAG_CALIB_SENDING) return;   // faderPos = min/max
+    int32_t dPos = (int32_t)resp->faderPos - _lastFaderRaw[id];
+    _lastFaderRaw[id] = resp->faderPos;
+    if (resp->touchState || resp->encoderDelta != 0 ||
+        dPos > RS485_MOTION_THRESHOLD || dPos < -RS485_MOTION_THRESHOLD)
+        _activeUntil[id] = millis() + RS485_ACTIVE_HOLD_MS;
+}
+
+// Siguiente slave activo en rotación (0 = ninguno). skipA/skipB: no repetir
+// el recién sondeado ni adelantar al que toca en el barrido.
+uint8_t RS485Master::_nextActive(uint8_t skipA, uint8_t skipB) {
+    uint32_t now = millis();
+    for (uint8_t n = 0; n < _numSlaves; n++) {
+        uint8_t id  = _activeNext;
+        _activeNext = (_activeNext >= _numSlaves) ? 1 : _activeNext + 1;
+        if (id == skipA || id == skipB) continue;
+        if ((int32_t)(_activeUntil[id] - now) > 0) return id;
+    }
+    return 0;
+}
+
+// --- API Core 0 ---
+
+// Escritor único (task MIDI): seqlock para el dato, fetch_or para dirty.
+// El task RS485 nunca puede bloquear estas llamadas.
+
+void RS485Master::setTrackName(uint8_t id, const char* name) {
+    if (id < 1 || id > _numSlaves) return;
+    ChannelCmd& c = _ch[id].cmd.beginWrite();
+    strncpy(c.trackName, name, 7);
+    c.trackName[7] = '\0';
+    _ch[id].cmd.endWrite();
+    _ch[id].dirty |= DF_NAME;
+}
+
+void RS485Master::setFlags(uint8_t id, uint8_t flags) {
+    if (id < 1 || id > _numSlaves) return;
+    _ch[id].cmd.beginWrite().flags = flags & ~AUTOMODE_MASK;  // preservar autoMode separado
+    _ch[id].cmd.endWrite();
+    _ch[id].dirty |= DF_FLAGS;
+}
+
+void RS485Master::setFaderTarget(uint8_t id, uint16_t value14bit) {
+    if (id < 1 || id > _numSlaves) return;
+    uint16_t target = value14bit & 0x3FFF;
+#if RS485_FADER_MAP_CALIBRATED
+    // Logic 0..LOGIC_PITCHBEND_MAX → rango calibrado del slave (min/max del mismo snapshot)
+    const SlaveState st = _ch[id].slave.read();
+    if (st.calibratedMax > st.calibratedMin)
+        target = st.calibratedMin +
+                 (uint32_t)value14bit * (st.calibratedMax - st.calibratedMin) / LOGIC_PITCHBEND_MAX;
+    else
+        target = (uint32_t)value14bit * 27000 / LOGIC_PITCHBEND_MAX;   // sin calibrar: rango teórico
+#endif
+    _ch[id].cmd.beginWrite().faderTarget = target;   // fader viaja siempre
+    _ch[id].cmd.endWrite();
+}
+
+void RS485Master::setVuLevel(uint8_t id, uint8_t value) {
+    if (id < 1 || id > _numSlaves) return;
+    _ch[id].cmd.beginWrite().vuLevel = value;
+    _ch[id].cmd.endWrite();
+}
+
+void RS485Master::setVPotValue(uint8_t id, uint8_t rawCC) {
+    if (id < 1 || id > _numSlaves) return;
+    _ch[id].cmd.beginWrite().vpotValue = rawCC & 0x7F;   // 7 bits útiles
+    _ch[id].cmd.endWrite();
+    _ch[id].dirty |= DF_VPOT;
+}
+
+bool RS485Master::hasNewSlaveData(uint8_t id) {
+    if (id < 1 || id > _numSlaves) return false;
+    return _ch[id].responded.exchange(false);
+}
+
+SlaveState RS485Master::getSlave(uint8_t id) {
+    if (id < 1 || id > _numSlaves) return SlaveState{};
+    return _ch[id].slave.read();
+}
+
+SlavePresence RS485Master::getPresence(uint8_t id) const {
+    if (id < 1 || id > _numSlaves) return SlavePresence::OFFLINE;
+    return _ch[id].presence;
+}
+
+void RS485Master::printStats() const {
+    float rate = _txCount > 0 ? (float)_rxCount / _txCount * 100.0f : 0.0f;
+    log_i("[RS485] ── Bus %c (ids %u-%u) ──", _cfg.name, _cfg.firstId, _cfg.firstId + _numSlaves - 1);
+    log_i("[RS485] TX:%u RX:%u TO:%u CRC_ERR:%u Exito:%.1f%% WAKE:%u",
+          _txCount, _rxCount, _timeouts, _crcErrors, rate, _wakeups);
+    log_i("[RS485] TX bytes:%u (%.1f/paquete) BCAST:%u EVQ_DROP:%u BAUD:%u",
+          _txBytes, _txCount > 0 ? (float)_txBytes / _txCount : 0.0f, _bcastCount, _evtDrops,
+          rs485_baudRate(_baudCode, RS485_BAUD));
+    uint32_t ms = millis() - _statsStart;
+    static const char* const PRESENCE[] = { "OFFLINE", "SUSPECT", "ONLINE" };
+    log_i("[RS485] Re-sondeos OFFLINE:%u  Timeouts cortos:%u  Grupo:%u (ranura %u us)",
+          _reprobes, _shortTimeouts, _groupPolls, _slotUs);
+    char h[64];
+    _prof.cycleHist().format(h, sizeof(h));
+    log_i("[RS485] Barrido us: %s", h);
+    for (uint8_t i = 1; i <= _numSlaves; i++) {
+        const auto& c = _prof.counters(i);
+        log_i("[RS485] Slave %d: %-7s poll %.0f Hz  timeout %u us  TO:%u CRC:%u ID_MM:%u", i + _cfg.firstId - 1,
+              PRESENCE[(uint8_t)_ch[i].presence.load()],
+              ms ? c.polls * 1000.0f / ms : 0.0f, _timeoutFor(i), c.timeouts, c.crcErrors, c.idMismatch);
+        if (_prof.rxWaitHist(i).count()) {
+            _prof.rxWaitHist(i).format(h, sizeof(h));
+            log_i("[RS485]   espera us: %s", h);
+        }
+        if (_prof.e2eHist(i).count()) {
+            _prof.e2eHist(i).format(h, sizeof(h));
+            log_i("[RS485]   fader→MIDI us: %s", h);
+        }
+    }
+}
+
+// Llamado desde el loop: los contadores y _prof son del task RS485 (no
+// atómicos), así que aquí solo se pide; _nextSlave() lo aplica entre
+// transacciones.
+void RS485Master::resetStats() {
+    _resetRequested.store(true, std::memory_order_release);
+}
+
+void RS485Master::_applyReset() {
+    _resetRequested.store(false, std::memory_order_relaxed);
+    _txCount = _rxCount = _timeouts = _crcErrors = _wakeups = _txBytes = _bcastCount = _evtDrops = 0;
+    _reprobes = _shortTimeouts = _groupPolls = 0;
+    _prof.reset();
+    _statsStart = millis();
+}
+
+size_t RS485Master::writeProfile(Print& out) const {
+    return _prof.snapshot(out, _cfg.name, _cfg.firstId, _numSlaves, millis());
+}
+
+// ═════════════════════════════════════════════════════════════════════
+//  beginDisconnectSequence() — Pide el envío de DISCONNECTED a todos
+// ═════════════════════════════════════════════════════════════════════
+// Cuando Logic se desconecta (GoOffline), este método garantiza que
+// TODOS los slaves reciban connected=0 antes de cambiar a offline.
+// Se llama desde el task MIDI: solo deja la petición; el estado del
+// barrido (_currentId, _sweepId, _bcastPending...) es del task RS485,
+// que la recoge en _nextSlave() al acabar la transacción en curso.
+// ═════════════════════════════════════════════════════════════════════
+void RS485Master::beginDisconnectSequence() {
+    _disconnectAt.store(millis(), std::memory_order_relaxed);
+    _disconnectRequest.store(true, std::memory_order_release);
+    log_i("[RS485] DISCONNECT SEQUENCE pedida para slaves 1..%d", _numSlaves);
+}
+
+// Task RS485. Con slaves SLAVE_CAP_BCAST basta el broadcast; si alguno
+// no lo soporta, itera sobre slave 1..numSlaves esperando respuesta de
+// cada uno. _disconnecting se activa ANTES de retirar la petición: quien
+// consulte isDisconnectComplete() nunca ve ambos a false a mitad de camino.
+void RS485Master::_startDisconnect() {
+    _disconnecting.store(true, std::memory_order_release);
+    _disconnectRequest.store(false, std::memory_order_release);
+    _bcastPending     = true;
+    _disconnectLastId = _numSlaves;
+    _currentId    = 0;                // _nextSlave avanza al primer slave
+    _sweepId      = 0;
+    _extraSlot    = false;
+    _groupPending = false;
+    log_i("[RS485] DISCONNECT SEQUENCE iniciada para slaves 1..%d", _numSlaves);
+}
+
+// ═════════════════════════════════════════════════════════════════════
+//  isDisconnectComplete() — Comprueba si ya se notificó a todos
+// ═════════════════════════════════════════════════════════════════════
+// Retorna true si:
+// - No hay petición pendiente y el task RS485 cerró la secuencia
+// - O timeout de seguridad se alcanzó (5s máx)
+// Solo lee atómicos: se llama desde el loop, no desde el task RS485.
+// ═════════════════════════════════════════════════════════════════════
+bool RS485Master::isDisconnectComplete() const {
+    if (!_disconnectRequest.load(std::memory_order_acquire) &&
+        !_disconnecting.load(std::memory_order_acquire)) return true;
+
+    // Timeout de seguridad: si tarda >5s, fuerza completación
+    if (millis() - _disconnectAt.load(std::memory_order_relaxed) > 5000) {
+        log_w("[RS485] Timeout desconexión (5s) — forzando completación");
+        return true;
+    }
+    return false;
+}
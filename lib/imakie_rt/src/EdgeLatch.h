@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+//  EdgeLatch.h  –  pulsaciones pendientes hasta que el master las ve
+//
+//  El slave manda cada botón como un bit; el master deriva los
+//  flancos comparando con la respuesta anterior (1 = pulsado,
+//  0 = soltado). Cada pulsación necesita un 1 seguido de un 0.
+//
+//  press()   cuenta la pulsación (no se pierde aunque llegue otra
+//            antes de enviar la primera)
+//  pending() bits para la próxima respuesta: solo si quedan
+//            pulsaciones y la última respuesta consumida iba a 0
+//  consume() con la respuesta que de verdad salió al bus
+//
+//  Tras un 1 la siguiente respuesta lleva 0 → el master ve una
+//  pulsación por cada press(). Un solo task (loop del S2).
+// ============================================================
+
+class EdgeLatch {
+public:
+    void press(uint8_t mask) {
+        for (uint8_t b = 0; b < 8; b++)
+            if ((mask & (1 << b)) && _count[b] < 0xFF) _count[b]++;
+    }
+
+    uint8_t pending() const {
+        uint8_t m = 0;
+        for (uint8_t b = 0; b < 8; b++)
+            if (_count[b] && !(_high & (1 << b))) m |= (1 << b);
+        return m;
+    }
+
+    // sent: bits tal como salieron (solo los de este latch)
+    void consume(uint8_t sent) {
+        for (uint8_t b = 0; b < 8; b++)
+            if ((sent & (1 << b)) && _count[b]) _count[b]--;
+        _high = sent;
+    }
+
+    void clear() {
+        for (uint8_t b = 0; b < 8; b++) _count[b] = 0;
+        _high = 0;
+    }
+
+    uint8_t count(uint8_t bit) const { return _count[bit]; }
+
+private:
+    uint8_t _count[8] = {};
+    uint8_t _high     = 0;     // bits que el master vio a 1 en la última respuesta
+};
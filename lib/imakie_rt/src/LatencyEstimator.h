@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+//  LatencyEstimator.h  –  percentil de latencia de respuesta
+//
+//  Histograma lineal: BUCKETS cubetas de BUCKET_US, la última
+//  acumula todo lo que no cabe. Al llegar a WINDOW muestras los
+//  contadores se dividen por 2 → pesa lo reciente. Sin floats ni
+//  locks: solo lo usa el task RS485.
+// ============================================================
+
+template <uint16_t BUCKET_US, uint8_t BUCKETS, uint16_t WINDOW>
+class LatencyEstimator {
+    static_assert(BUCKETS >= 2, "al menos una cubeta + desbordamiento");
+public:
+    static constexpr uint32_t OUT_OF_RANGE = UINT32_MAX;
+
+    void reset() {
+        memset(_count, 0, sizeof(_count));
+        _total   = 0;
+        _samples = 0;
+    }
+
+    void add(uint32_t us) {
+        uint32_t b = us / BUCKET_US;
+        if (b >= BUCKETS) b = BUCKETS - 1;
+        _count[b]++;
+        if (++_total >= WINDOW) {
+            _total = 0;
+            for (auto& c : _count) { c >>= 1; _total += c; }
+        }
+        if (_samples < UINT16_MAX) _samples++;
+    }
+
+    uint16_t samples() const { return _samples; }
+
+    // Borde superior de la cubeta que alcanza permille/1000 de las
+    // muestras (p99 = 990). OUT_OF_RANGE si cae en la última o no hay datos.
+    uint32_t percentileUs(uint16_t permille) const {
+        if (!_total) return OUT_OF_RANGE;
+        uint32_t need = ((uint32_t)_total * permille + 999) / 1000;
+        uint32_t acc  = 0;
+        for (uint8_t b = 0; b < BUCKETS - 1; b++) {
+            acc += _count[b];
+            if (acc >= need) return (uint32_t)(b + 1) * BUCKET_US;
+        }
+        return OUT_OF_RANGE;
+    }
+
+private:
+    uint16_t _count[BUCKETS] = {};
+    uint16_t _total   = 0;           // suma de _count (tras el último halving)
+    uint16_t _samples = 0;           // muestras desde reset(), satura
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// ============================================================
+//  Seqlock.h  –  snapshot sin bloqueo, un escritor / N lectores
+//
+//  El escritor nunca espera: incrementa seq (impar = escribiendo),
+//  modifica y vuelve a incrementar. El lector copia y reintenta si
+//  seq era impar o cambió durante la copia → nunca ve un par
+//  faderPos/buttons a medias.
+//
+//  Regla: cada Seqlock tiene UN solo task escritor. Ese task puede
+//  leer data() directamente (nadie más la modifica).
+// ============================================================
+
+template <typename T>
+class Seqlock {
+public:
+    // ── Escritor ────────────────────────────────────────────
+    T& beginWrite() {
+        _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return _data;
+    }
+    void endWrite() {
+        std::atomic_thread_fence(std::memory_order_release);
+        _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    void write(const T& v) { beginWrite() = v; endWrite(); }
+
+    const T& data() const { return _data; }   // solo desde el task escritor
+
+    // ── Lector ──────────────────────────────────────────────
+    void read(T& out) const {
+        uint32_t s0, s1;
+        do {
+            s0 = _seq.load(std::memory_order_acquire);
+            out = _data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = _seq.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || s0 != s1);
+    }
+    T read() const { T v; read(v); return v; }
+
+    uint32_t version() const { return _seq.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> _seq{0};
+    T                     _data{};
+};
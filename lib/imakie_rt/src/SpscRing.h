@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+//  SpscRing.h  –  cola acotada sin bloqueo, 1 productor / 1 consumidor
+//
+//  push() solo desde el productor, pop() solo desde el consumidor.
+//  N potencia de 2. Cola llena → push() devuelve false (el
+//  productor cuenta la pérdida, nunca espera).
+// ============================================================
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N debe ser potencia de 2");
+public:
+    bool push(const T& v) {
+        uint32_t h = _head.load(std::memory_order_relaxed);
+        if (h - _tail.load(std::memory_order_acquire) >= N) return false;
+        _buf[h & (N - 1)] = v;
+        _head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        uint32_t t = _tail.load(std::memory_order_relaxed);
+        if (t == _head.load(std::memory_order_acquire)) return false;
+        out = _buf[t & (N - 1)];
+        _tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    T                     _buf[N];
+};
@@ -0,0 +1,345 @@
+// ============================================================
+//  fwpack.cpp  –  Imágenes IMZ1 (LZ / delta) para el firmware S2
+//
+//  Herramienta de host. Genera lo que BusOta aplica en el S2 y
+//  lo verifica con el MISMO decoder (lib/imakie_protocol/src/
+//  imakie_fwpack.h), en trozos de FW_BLOCK_LEN como por el bus.
+//
+//  Compilar:
+//    g++ -std=c++17 -O2 -I lib/imakie_protocol/src tools/fwpack/fwpack.cpp -o tools/fwpack/fwpack
+//
+//  Uso:
+//    fwpack lz     <nuevo.bin> <salida.imz>
+//    fwpack delta  <base.bin> <nuevo.bin> <salida.imd>
+//    fwpack verify <imagen.imz|imd> <esperado.bin> [base.bin]
+//    opción: -w <bits>  ventana (8..FWPACK_MAX_WINDOW_BITS)
+//
+//  'base.bin' = la imagen que ejecuta el S2 (la última desplegada,
+//  ver S2/S2_V1/fwpack_build.py). Cada lz/delta se verifica al
+//  terminar: salida ≠ entrada → código de error y sin fichero.
+// ============================================================
+#include "imakie_fwpack.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+const size_t   BUS_CHUNK   = 192;          // = FW_BLOCK_LEN (imakie_protocol.h)
+const int      WIN_DEPTH   = 96;           // candidatos por posición (ventana)
+const int      BASE_DEPTH  = 48;           // candidatos por posición (base)
+const int      BASE_KEY    = 6;            // bytes del hash de la base
+const uint32_t BASE_HASH_BITS = 20;
+const uint32_t WIN_HASH_BITS  = 16;
+
+bool readFile(const char* path, Bytes& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { fprintf(stderr, "fwpack: no se puede abrir %s\n", path); return false; }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(n > 0 ? n : 0);
+    bool ok = out.empty() || fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+bool writeFile(const char* path, const Bytes& data) {
+    FILE* f = fopen(path, "wb");
+    if (!f) { fprintf(stderr, "fwpack: no se puede crear %s\n", path); return false; }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+// fwId = prefijo de app_elf_sha256 (esp_app_desc_t tras cabecera + segmento).
+// Otra cosa (pruebas en host): CRC-32 + tamaño, con aviso
+void imageId(const Bytes& img, const char* name, uint8_t* id) {
+    const size_t descAt = 24 + 8;           // esp_image_header_t + esp_image_segment_header_t
+    const size_t shaAt  = descAt + 144;     // offsetof(esp_app_desc_t, app_elf_sha256)
+    if (img.size() > shaAt + FWPACK_ID_LEN && img[0] == 0xE9 &&
+        fwpack_get32(&img[descAt]) == 0xABCD5432) {
+        memcpy(id, &img[shaAt], FWPACK_ID_LEN);
+        return;
+    }
+    fprintf(stderr, "fwpack: %s no es una imagen de app ESP32 — id = CRC-32 + tamaño\n", name);
+    fwpack_put32(id, fwpack_crc32(0, img.data(), img.size()));
+    fwpack_put32(id + 4, (uint32_t)img.size());
+}
+
+size_t varintLen(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) { v >>= 7; n++; }
+    return n;
+}
+
+void putVarint(Bytes& out, uint32_t v) {
+    while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+    out.push_back((uint8_t)v);
+}
+
+uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+// ─── Encoder: greedy con un paso de lazy matching ────────────
+class Encoder {
+public:
+    Encoder(const Bytes& in, const Bytes* base, uint8_t windowBits)
+        : _in(in), _base(base), _winSize(1u << windowBits) {}
+
+    Bytes run() {
+        _winHead.assign(1u << WIN_HASH_BITS, -1);
+        _winPrev.assign(_in.size(), -1);
+        if (_base) _indexBase();
+
+        size_t i = 0;
+        while (i < _in.size()) {
+            Match m = _best(i);
+            if (m.gain > 0 && i + 1 < _in.size()) {
+                _insert(i);
+                Match next = _best(i + 1);
+                if (next.gain > m.gain + 1) {   // mejor esperar un byte
+                    _lit.push_back(_in[i++]);
+                    continue;
+                }
+                _emitMatch(m);
+                i += m.len;
+                _insert(i - 1);
+                continue;
+            }
+            if (m.gain > 0) {
+                _emitMatch(m);
+                i += m.len;
+                continue;
+            }
+            _insert(i);
+            _lit.push_back(_in[i++]);
+        }
+        _flushLit();
+        return _out;
+    }
+
+private:
+    struct Match { size_t len = 0; int gain = 0; bool base = false; uint32_t arg = 0; };
+
+    const Bytes&  _in;
+    const Bytes*  _base;
+    const uint32_t _winSize;
+    Bytes _out, _lit;
+    std::vector<int32_t> _winHead, _winPrev, _baseHead, _basePrev;
+    uint32_t _baseNext = 0;
+    size_t   _inserted = 0;
+
+    static uint32_t _hash(const uint8_t* p, int n, uint32_t bits) {
+        uint32_t h = 0;
+        for (int k = 0; k < n; k++) h = (h ^ p[k]) * 0x9E3779B1u;
+        return h >> (32 - bits);
+    }
+
+    void _indexBase() {
+        const Bytes& b = *_base;
+        _baseHead.assign(1u << BASE_HASH_BITS, -1);
+        _basePrev.assign(b.size(), -1);
+        for (size_t j = 0; j + BASE_KEY <= b.size(); j++) {
+            uint32_t h = _hash(&b[j], BASE_KEY, BASE_HASH_BITS);
+            _basePrev[j] = _baseHead[h];
+            _baseHead[h] = (int32_t)j;
+        }
+    }
+
+    // Encadena las posiciones hasta i inclusive (cada una una sola vez)
+    void _insert(size_t i) {
+        for (; _inserted <= i && _inserted + FWPACK_WIN_MIN <= _in.size(); _inserted++) {
+            uint32_t h = _hash(&_in[_inserted], FWPACK_WIN_MIN, WIN_HASH_BITS);
+            _winPrev[_inserted] = _winHead[h];
+            _winHead[h] = (int32_t)_inserted;
+        }
+    }
+
+    size_t _extend(const uint8_t* a, const uint8_t* b, size_t max) const {
+        size_t n = 0;
+        while (n < max && a[n] == b[n]) n++;
+        return n;
+    }
+
+    static size_t _lenCost(size_t len, size_t min) {
+        return len - min >= FWPACK_LEN_EXT ? varintLen((uint32_t)(len - min - FWPACK_LEN_EXT)) : 0;
+    }
+
+    Match _best(size_t i) {
+        Match best;
+        const size_t rest = _in.size() - i;
+
+        // Ventana: dist ≤ ventana y ≤ 65535 (2 bytes)
+        if (rest >= FWPACK_WIN_MIN) {
+            uint32_t h = _hash(&_in[i], FWPACK_WIN_MIN, WIN_HASH_BITS);
+            int depth = WIN_DEPTH;
+            for (int32_t j = _winHead[h]; j >= 0 && depth--; j = _winPrev[j]) {
+                size_t dist = i - (size_t)j;
+                if (dist > _winSize || dist > 0xFFFF) break;
+                size_t len = _extend(&_in[j], &_in[i], rest);
+                if (len < FWPACK_WIN_MIN) continue;
+                int gain = (int)len - (int)(3 + _lenCost(len, FWPACK_WIN_MIN));
+                if (gain > best.gain) best = { len, gain, false, (uint32_t)dist };
+            }
+        }
+
+        // Base: primero la continuación (offset relativo 0), luego el hash
+        if (_base && rest >= FWPACK_BASE_MIN) {
+            const Bytes& b = *_base;
+            auto tryBase = [&](size_t j) {
+                if (j >= b.size()) return;
+                size_t len = _extend(&b[j], &_in[i], std::min(rest, b.size() - j));
+                if (len < FWPACK_BASE_MIN) return;
+                int32_t rel = (int32_t)j - (int32_t)_baseNext;
+                int gain = (int)len - (int)(1 + _lenCost(len, FWPACK_BASE_MIN) + varintLen(zigzag(rel)));
+                if (gain > best.gain) best = { len, gain, true, (uint32_t)j };
+            };
+            tryBase(_baseNext);
+            if (rest >= (size_t)BASE_KEY) {
+                uint32_t h = _hash(&_in[i], BASE_KEY, BASE_HASH_BITS);
+                int depth = BASE_DEPTH;
+                for (int32_t j = _baseHead[h]; j >= 0 && depth--; j = _basePrev[j]) tryBase((size_t)j);
+            }
+        }
+        return best;
+    }
+
+    void _flushLit() {
+        for (size_t k = 0; k < _lit.size(); k += FWPACK_LIT_MAX) {
+            size_t n = std::min<size_t>(FWPACK_LIT_MAX, _lit.size() - k);
+            _out.push_back((uint8_t)(n - 1));
+            _out.insert(_out.end(), _lit.begin() + k, _lit.begin() + k + n);
+        }
+        _lit.clear();
+    }
+
+    void _emitMatch(const Match& m) {
+        _flushLit();
+        size_t min = m.base ? FWPACK_BASE_MIN : FWPACK_WIN_MIN;
+        size_t l   = m.len - min;
+        uint8_t op = m.base ? 0xC0 : 0x80;
+        if (l >= FWPACK_LEN_EXT) {
+            _out.push_back(op | FWPACK_LEN_EXT);
+            putVarint(_out, (uint32_t)(l - FWPACK_LEN_EXT));
+        } else {
+            _out.push_back(op | (uint8_t)l);
+        }
+        if (m.base) {
+            putVarint(_out, zigzag((int32_t)m.arg - (int32_t)_baseNext));
+            _baseNext = m.arg + (uint32_t)m.len;
+        } else {
+            _out.push_back((uint8_t)m.arg);
+            _out.push_back((uint8_t)(m.arg >> 8));
+        }
+    }
+};
+
+// ─── Decoder: el de imakie_fwpack.h, en trozos del bus ───────
+struct DecodeCtx { Bytes out; const Bytes* base; };
+
+bool decWrite(void* ctx, const uint8_t* src, size_t n) {
+    Bytes& out = static_cast<DecodeCtx*>(ctx)->out;
+    out.insert(out.end(), src, src + n);
+    return true;
+}
+
+bool decRead(void* ctx, uint32_t off, uint8_t* dst, size_t n) {
+    const Bytes* b = static_cast<DecodeCtx*>(ctx)->base;
+    if (!b || off + n > b->size()) return false;
+    memcpy(dst, &(*b)[off], n);
+    return true;
+}
+
+bool verify(const Bytes& pack, const Bytes& expect, const Bytes* base) {
+    FwPackHeader h;
+    if (!fwpack_parseHeader(pack.data(), pack.size(), h)) {
+        fprintf(stderr, "fwpack: cabecera IMZ1 no válida\n");
+        return false;
+    }
+    if (h.format == FWPACK_DELTA && !base) {
+        fprintf(stderr, "fwpack: imagen delta — falta base.bin\n");
+        return false;
+    }
+    Bytes window(1u << h.windowBits);
+    DecodeCtx ctx{ {}, base };
+    FwUnpack un;
+    un.begin(h, window.data(), decWrite, &ctx, decRead, base ? (uint32_t)base->size() : 0);
+
+    auto t0 = std::chrono::steady_clock::now();
+    FwUnpackStatus st = FwUnpackStatus::OK;
+    for (size_t k = FWPACK_HEADER_LEN; k < pack.size() && st == FwUnpackStatus::OK; k += BUS_CHUNK)
+        st = un.push(&pack[k], std::min(BUS_CHUNK, pack.size() - k));
+    if (st == FwUnpackStatus::OK) st = un.finish();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    bool ok = st == FwUnpackStatus::DONE && ctx.out == expect;
+    printf("verify: %s (%zu B, decoder %.1f ms en host, ventana %u B)\n",
+           ok ? "OK" : "FALLO", ctx.out.size(), ms, 1u << h.windowBits);
+    return ok;
+}
+
+int usage() {
+    fprintf(stderr,
+        "uso: fwpack [-w bits] lz <nuevo.bin> <salida.imz>\n"
+        "     fwpack [-w bits] delta <base.bin> <nuevo.bin> <salida.imd>\n"
+        "     fwpack verify <imagen> <esperado.bin> [base.bin]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint8_t windowBits = FWPACK_WINDOW_BITS;
+    int a = 1;
+    if (a + 1 < argc && strcmp(argv[a], "-w") == 0) {
+        windowBits = (uint8_t)atoi(argv[a + 1]);
+        if (windowBits < 8 || windowBits > FWPACK_MAX_WINDOW_BITS) return usage();
+        a += 2;
+    }
+    if (a >= argc) return usage();
+    std::string cmd = argv[a++];
+    int n = argc - a;
+
+    if (cmd == "verify" && (n == 2 || n == 3)) {
+        Bytes pack, expect, base;
+        if (!readFile(argv[a], pack) || !readFile(argv[a + 1], expect)) return 1;
+        if (n == 3 && !readFile(argv[a + 2], base)) return 1;
+        return verify(pack, expect, n == 3 ? &base : nullptr) ? 0 : 1;
+    }
+
+    bool delta = cmd == "delta";
+    if (!((cmd == "lz" && n == 2) || (delta && n == 3))) return usage();
+    Bytes base, img;
+    if (delta && !readFile(argv[a++], base)) return 1;
+    const char* imgPath = argv[a++];
+    const char* outPath = argv[a];
+    if (!readFile(imgPath, img) || img.empty()) return 1;
+
+    FwPackHeader h;
+    h.format     = delta ? FWPACK_DELTA : FWPACK_LZ;
+    h.windowBits = windowBits;
+    h.outSize    = (uint32_t)img.size();
+    h.outCrc     = fwpack_crc32(0, img.data(), img.size());
+    imageId(img, imgPath, h.fwId);
+    if (delta) imageId(base, "base", h.baseId);
+
+    auto t0 = std::chrono::steady_clock::now();
+    Bytes body = Encoder(img, delta ? &base : nullptr, windowBits).run();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    Bytes pack(FWPACK_HEADER_LEN);
+    fwpack_writeHeader(pack.data(), h);
+    pack.insert(pack.end(), body.begin(), body.end());
+    printf("%s: %zu → %zu B (%.1f%%, %.1fx) en %.0f ms\n", delta ? "delta" : "lz",
+           img.size(), pack.size(), 100.0 * pack.size() / img.size(),
+           (double)img.size() / pack.size(), ms);
+
+    if (!verify(pack, img, delta ? &base : nullptr)) return 1;
+    return writeFile(outPath, pack) ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// ============================================================
+//  rs485prof.cpp  –  Lector de snapshots del profiler RS485
+//
+//  Herramienta de host. Pide por la consola serie del master
+//  (P4 o S3) el snapshot binario de los histogramas ('P', formato
+//  lib/imakie_protocol/src/imakie_profiler.h) y saca por slave
+//  polls, timeouts, CRC y p50/p95/p99/máx de la espera de
+//  respuesta y de fader → MIDI, más el barrido del bus.
+//  Los logs que van por el mismo puerto se ignoran: el snapshot
+//  se localiza por "IMPF" y se valida con su CRC.
+//
+//  Compilar:
+//    g++ -std=c++17 -O2 -I lib/imakie_protocol/src tools/rs485prof/rs485prof.cpp -o tools/rs485prof/rs485prof
+//
+//  Uso:
+//    rs485prof [-r] [-w snap.bin] <puerto | snap.bin>
+//    -r  pone las estadísticas a cero tras leerlas (ventanas de medida)
+//    -w  guarda lo recibido para leerlo otra vez
+// ============================================================
+#include "imakie_profiler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+const int QUIET_MS = 400;       // fin de la respuesta: sin bytes este tiempo
+const int WAIT_MS  = 3000;
+
+bool readFile(const char* path, Bytes& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { fprintf(stderr, "rs485prof: no se puede abrir %s\n", path); return false; }
+    uint8_t buf[65536];
+    size_t  n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+long nowMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+// Consola del master: 'P' → snapshot(s); 'r' → reset. Velocidad: la del monitor
+bool request(const char* path, bool reset, Bytes& out) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) { fprintf(stderr, "rs485prof: no se puede abrir %s\n", path); return false; }
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tio.c_cc[VMIN]  = 0;
+        tio.c_cc[VTIME] = 1;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIFLUSH);
+    if (write(fd, "P", 1) != 1) { close(fd); return false; }
+
+    const long t0 = nowMs();
+    long last = t0;
+    uint8_t buf[4096];
+    while (nowMs() - t0 < WAIT_MS && (out.empty() || nowMs() - last < QUIET_MS)) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) break;
+        if (n > 0) {
+            out.insert(out.end(), buf, buf + n);
+            last = nowMs();
+        }
+    }
+    if (reset && write(fd, "r", 1) != 1) fprintf(stderr, "rs485prof: reset no enviado\n");
+    close(fd);
+    return true;
+}
+
+// ─── Snapshot ────────────────────────────────────────────────
+
+struct Hist {
+    uint32_t count = 0, max = 0;
+    uint64_t sum   = 0;
+    uint32_t n[PROF_BUCKETS] = {};
+
+    uint32_t percentile(uint16_t permille) const {
+        if (!count) return 0;
+        uint64_t need = ((uint64_t)count * permille + 999) / 1000;
+        if (!need) need = 1;
+        uint64_t acc = 0;
+        for (int b = 0; b < PROF_BUCKETS; b++) {
+            acc += n[b];
+            if (acc >= need) {
+                uint32_t hi = prof_bucketHigh((uint8_t)b);
+                return hi < max ? hi : max;
+            }
+        }
+        return max;
+    }
+};
+
+struct Slave {
+    uint32_t polls = 0, timeouts = 0, crcErrors = 0, idMismatch = 0;
+    Hist     rxWait, e2e;
+};
+
+struct Snapshot {
+    char     bus     = '?';
+    uint8_t  firstId = 1;
+    uint32_t uptimeMs = 0;
+    std::vector<Slave> slaves;
+    Hist     cycle;
+};
+
+// Snapshot completo en p[0..len) → true; 'used' = bytes que ocupa
+bool parse(const uint8_t* p, size_t len, Snapshot& s, size_t& used) {
+    size_t i = PROF_HEADER_LEN;
+    if (len < i || memcmp(p, PROF_MAGIC, 4) != 0) return false;
+    if (p[4] != PROF_VERSION || p[5] != PROF_SUB_BITS) return false;
+    s.bus      = (char)p[6];
+    s.firstId  = p[7];
+    s.slaves.assign(p[8], Slave{});
+    s.uptimeMs = rs485_get32(&p[12]);
+    const uint8_t records = p[9];
+
+    for (Slave& sl : s.slaves) {
+        if (len < i + PROF_COUNTERS_LEN) return false;
+        sl.polls      = rs485_get32(&p[i]);
+        sl.timeouts   = rs485_get32(&p[i + 4]);
+        sl.crcErrors  = rs485_get32(&p[i + 8]);
+        sl.idMismatch = rs485_get32(&p[i + 12]);
+        i += PROF_COUNTERS_LEN;
+    }
+    for (uint8_t r = 0; r < records; r++) {
+        if (len < i + PROF_RECORD_LEN) return false;
+        const uint8_t metric = p[i], id = p[i + 1], nz = p[i + 18];
+        Hist h;
+        h.count = rs485_get32(&p[i + 2]);
+        h.max   = rs485_get32(&p[i + 6]);
+        h.sum   = rs485_get32(&p[i + 10]) | ((uint64_t)rs485_get32(&p[i + 14]) << 32);
+        i += PROF_RECORD_LEN;
+        if (len < i + (size_t)nz * PROF_BUCKET_LEN) return false;
+        for (uint8_t k = 0; k < nz; k++, i += PROF_BUCKET_LEN)
+            if (p[i] < PROF_BUCKETS) h.n[p[i]] += rs485_get32(&p[i + 1]);
+
+        if (metric == PROF_CYCLE) s.cycle = h;
+        else if (id >= 1 && id <= s.slaves.size()) {
+            if (metric == PROF_RX_WAIT) s.slaves[id - 1].rxWait = h;
+            if (metric == PROF_E2E)     s.slaves[id - 1].e2e    = h;
+        }
+    }
+    if (len < i + 1 || rs485_crc8(p, i) != p[i]) return false;
+    used = i + 1;
+    return true;
+}
+
+void printHist(const Hist& h) {
+    if (!h.count) { printf("  %29s", "-"); return; }
+    printf("  %6u %6u %6u %8u", h.percentile(500), h.percentile(950), h.percentile(990), h.max);
+}
+
+void print(const Snapshot& s) {
+    printf("\nBus %c  ids %u-%u  uptime %.1f s\n", s.bus, s.firstId,
+           s.firstId + (unsigned)s.slaves.size() - 1, s.uptimeMs / 1000.0);
+    if (s.cycle.count)
+        printf("Barrido (µs): n=%u media=%llu p50=%u p95=%u p99=%u máx=%u\n", s.cycle.count,
+               (unsigned long long)(s.cycle.sum / s.cycle.count), s.cycle.percentile(500),
+               s.cycle.percentile(950), s.cycle.percentile(990), s.cycle.max);
+    printf("\n%42s  %-29s  %s\n", "", "espera de respuesta (µs)", "fader → MIDI (µs)");
+    printf("%5s %9s %7s %6s %5s %5s  %6s %6s %6s %8s  %6s %6s %6s %8s\n", "slave", "polls", "TO", "TO%",
+           "CRC", "ID_MM", "p50", "p95", "p99", "máx", "p50", "p95", "p99", "máx");
+    for (size_t k = 0; k < s.slaves.size(); k++) {
+        const Slave& sl = s.slaves[k];
+        printf("%5u %9u %7u %5.1f%% %5u %5u", s.firstId + (unsigned)k, sl.polls, sl.timeouts,
+               sl.polls ? 100.0 * sl.timeouts / sl.polls : 0.0, sl.crcErrors, sl.idMismatch);
+        printHist(sl.rxWait);
+        printHist(sl.e2e);
+        printf("\n");
+    }
+}
+
+int usage() {
+    fprintf(stderr, "uso: rs485prof [-r] [-w snap.bin] <puerto | snap.bin>\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool        reset  = false;
+    const char* rawOut = nullptr;
+    int a = 1;
+    for (; a < argc && argv[a][0] == '-'; a++) {
+        if      (strcmp(argv[a], "-r") == 0)                reset  = true;
+        else if (strcmp(argv[a], "-w") == 0 && a + 1 < argc) rawOut = argv[++a];
+        else return usage();
+    }
+    if (a + 1 != argc) return usage();
+
+    Bytes raw;
+    struct stat st;
+    const bool tty = stat(argv[a], &st) == 0 && S_ISCHR(st.st_mode);
+    if (!(tty ? request(argv[a], reset, raw) : readFile(argv[a], raw))) return 1;
+    if (rawOut) {
+        FILE* f = fopen(rawOut, "wb");
+        if (!f || fwrite(raw.data(), 1, raw.size(), f) != raw.size()) {
+            fprintf(stderr, "rs485prof: no se puede escribir %s\n", rawOut);
+            return 1;
+        }
+        fclose(f);
+    }
+
+    int found = 0;
+    for (size_t i = 0; i + PROF_HEADER_LEN <= raw.size(); i++) {
+        if (raw[i] != PROF_MAGIC[0]) continue;
+        Snapshot s;
+        size_t   used;
+        if (!parse(&raw[i], raw.size() - i, s, used)) continue;
+        print(s);
+        found++;
+        i += used - 1;
+    }
+    if (!found) {
+        fprintf(stderr, "rs485prof: ningún snapshot válido en %zu B\n", raw.size());
+        return 1;
+    }
+    return 0;
+}
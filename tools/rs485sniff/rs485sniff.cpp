@@ -0,0 +1,511 @@
+// ============================================================
+//  rs485sniff.cpp  –  Decoder de capturas del bus RS485
+//
+//  Herramienta de host. Lee el flujo de un S2 en modo sniffer
+//  (RS485_SNIFFER, formato lib/imakie_protocol/src/imakie_sniff.h),
+//  reconstruye las tramas con imakie_protocol.h y saca:
+//    - resumen: por slave (polls, respuestas, timeouts, CRC,
+//      turnaround), ciclo de polling y reparto del tiempo de bus
+//    - timeline Chrome-trace JSON (ui.perfetto.dev / chrome://tracing)
+//
+//  Compilar:
+//    g++ -std=c++17 -O2 -I lib/imakie_protocol/src tools/rs485sniff/rs485sniff.cpp -o tools/rs485sniff/rs485sniff
+//
+//  Uso:
+//    rs485sniff [-t seg] [-w raw.bin] <puerto | captura.bin> [trace.json]
+//    puerto: /dev/cu.usbmodem… / /dev/ttyACM… → captura -t seg (o Ctrl-C);
+//    -w guarda el flujo tal cual para decodificarlo otra vez
+//
+//  Tiempos: cada lectura del UART llega con el instante de su RX
+//  timeout; los bytes se reparten hacia atrás a 10 bits/byte. Error
+//  típico = jitter del task de eventos del UART. Solo la última
+//  trama de cada lectura tiene su instante real: si la siguiente
+//  empieza antes de que el sniffer lea, ambas llegan juntas y el
+//  hueco se pierde. Esos turnaround se cuentan aparte ("fusión") y
+//  no entran en las estadísticas.
+// ============================================================
+#include "imakie_sniff.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+const int TID_MASTER = 0;
+const int TID_CYCLE  = 90;
+const int TID_ERRORS = 91;
+const int MAX_ID     = 32;
+
+volatile sig_atomic_t g_stop = 0;
+
+// ─── Entrada ─────────────────────────────────────────────────
+
+bool readFile(const char* path, Bytes& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { fprintf(stderr, "rs485sniff: no se puede abrir %s\n", path); return false; }
+    uint8_t buf[65536];
+    size_t  n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+// Puerto serie (USB CDC del S2): la velocidad da igual, solo modo raw
+bool capture(const char* path, int seconds, Bytes& out) {
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) { fprintf(stderr, "rs485sniff: no se puede abrir %s\n", path); return false; }
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cc[VMIN]  = 0;
+        tio.c_cc[VTIME] = 2;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    signal(SIGINT, [](int) { g_stop = 1; });
+    fprintf(stderr, "rs485sniff: capturando %s%s\n", path, seconds ? "" : " (Ctrl-C para terminar)");
+    const time_t t0 = time(nullptr);
+    uint8_t buf[65536];
+    while (!g_stop && (!seconds || time(nullptr) - t0 < seconds)) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) break;
+        out.insert(out.end(), buf, buf + n);
+    }
+    close(fd);
+    fprintf(stderr, "rs485sniff: %zu B capturados\n", out.size());
+    return true;
+}
+
+// ─── Tramas ──────────────────────────────────────────────────
+
+enum class FrameStatus : uint8_t { OK, BAD_CRC, BAD_LENGTH, TRUNCATED };
+
+struct Frame {
+    double      t0, t1;         // µs: inicio del primer bit, fin del último
+    Bytes       b;
+    FrameStatus status;
+    uint32_t    baud;
+    uint64_t    rec0, rec1;     // registros DATA del primer y último byte
+    bool        exact;          // sola al final de su lectura: t0/t1 fiables
+
+    uint8_t hdr() const { return b[0]; }
+    bool master() const { return hdr() != RS485_RESP_BYTE && hdr() != RS485_FW_RESP_BYTE; }
+    // Destino (master) u origen (slave); 0 = difusión / sin id
+    uint8_t id() const {
+        if (b.size() < 3) return 0;
+        switch (hdr()) {
+            case RS485_START_BYTE: case RS485_DELTA_BYTE: case RS485_RESP_BYTE: return b[1];
+            case RS485_FW_RESP_BYTE: return b[2];
+            case RS485_FW_BYTE:
+                return (b.size() > FW_HEADER_LEN && b[2] == FW_OP_QUERY) ? b[FW_HEADER_LEN] : 0;
+            default: return 0;
+        }
+    }
+    bool expectsReply() const {
+        return status == FrameStatus::OK && id() != 0 &&
+               (hdr() == RS485_START_BYTE || hdr() == RS485_DELTA_BYTE || hdr() == RS485_FW_BYTE);
+    }
+};
+
+const char* statusName(FrameStatus s) {
+    switch (s) {
+        case FrameStatus::OK:         return "OK";
+        case FrameStatus::BAD_CRC:    return "CRC";
+        case FrameStatus::BAD_LENGTH: return "longitud";
+        default:                      return "truncada";
+    }
+}
+
+std::string frameName(const Frame& f) {
+    static const char* const fwOps[] = { "?", "BEGIN", "DATA", "QUERY", "COMMIT", "REBOOT", "ABORT" };
+    char s[48];
+    switch (f.hdr()) {
+        case RS485_START_BYTE:   snprintf(s, sizeof(s), "poll %u", f.id()); break;
+        case RS485_DELTA_BYTE:   snprintf(s, sizeof(s), "delta %u", f.id()); break;
+        case RS485_RESP_BYTE:    snprintf(s, sizeof(s), "resp %u", f.id()); break;
+        case RS485_BCAST_BYTE:   snprintf(s, sizeof(s), "bcast"); break;
+        case RS485_BAUD_BYTE:
+            snprintf(s, sizeof(s), "baud → %u", f.b.size() > 2 ? rs485_baudRate(f.b[2], f.baud) : 0);
+            break;
+        case RS485_GROUP_BYTE:   snprintf(s, sizeof(s), "grupo ×%u", f.b.size() > 2 ? f.b[2] : 0); break;
+        case RS485_FW_BYTE:
+            snprintf(s, sizeof(s), "fw %s", f.b.size() > 2 && f.b[2] <= FW_OP_ABORT ? fwOps[f.b[2]] : "?");
+            break;
+        case RS485_FW_RESP_BYTE: snprintf(s, sizeof(s), "fw status %u", f.id()); break;
+        default:                 snprintf(s, sizeof(s), "0x%02X", f.hdr()); break;
+    }
+    return s;
+}
+
+// ids de una trama de grupo en orden de ranura
+std::vector<uint8_t> groupIds(const Frame& f, uint16_t& slotUs) {
+    std::vector<uint8_t> ids;
+    if (f.b.size() < GROUP_HEADER_LEN + 2) return ids;
+    slotUs = rs485_get16(&f.b[3]);
+    size_t i = GROUP_HEADER_LEN, end = f.b.size() - 2;
+    for (uint8_t k = 0; k < f.b[2] && i + 2 <= end; k++) {
+        ids.push_back(f.b[i]);
+        i += rs485_deltaLength(f.b[i + 1]) - 2;
+    }
+    return ids;
+}
+
+// Bytes con tiempo → tramas (misma resincronización que los slaves)
+class FrameParser {
+public:
+    std::vector<Frame> frames;
+    uint64_t noise = 0;
+
+    void push(uint8_t b, double start, double end, uint32_t baud, uint64_t rec) {
+        const double byteUs = end - start;
+        // Hueco dentro de una trama: la trama se cortó (colisión, nodo reiniciado)
+        if (!_cur.b.empty() && start - _cur.t1 > std::max(20 * byteUs, 100.0)) {
+            _cur.status = FrameStatus::TRUNCATED;
+            _emit();
+        }
+        if (_cur.b.empty()) {
+            if (rs485_frameLength(&b, 1) == 0) { noise++; return; }
+            _cur.t0   = start;
+            _cur.baud = baud;
+            _cur.rec0 = rec;
+        }
+        _cur.b.push_back(b);
+        _cur.t1   = end;
+        _cur.rec1 = rec;
+        size_t need = rs485_frameLength(_cur.b.data(), _cur.b.size());
+        if (need == 0) {
+            _cur.status = FrameStatus::BAD_LENGTH;
+            _emit();
+        } else if (_cur.b.size() >= need) {
+            _cur.status = rs485_checkFrame(_cur.b.data(), need) == Rs485Status::OK
+                        ? FrameStatus::OK : FrameStatus::BAD_CRC;
+            _emit();
+        }
+    }
+
+private:
+    Frame _cur{};
+    void _emit() { frames.push_back(_cur); _cur.b.clear(); }
+};
+
+// ─── Registros → bytes con tiempo ────────────────────────────
+
+struct Capture {
+    uint32_t baud      = 500000;
+    uint8_t  rxTimeout = 1;
+    uint64_t records = 0, dataBytes = 0, dropped = 0, overlaps = 0, skipped = 0;
+    bool     hello = false;
+    std::vector<std::pair<double, uint32_t>> baudChanges;
+    std::vector<double> drops;
+};
+
+void decodeStream(const Bytes& raw, Capture& cap, FrameParser& fp) {
+    SniffReader rd;
+    uint64_t base = 0;
+    uint32_t last = 0;
+    bool     first = true;
+    double   prevEnd = 0;
+
+    auto handle = [&]() {
+        cap.records++;
+        if (first) { base = 0; first = false; }         // timeline desde el primer registro
+        else       base += (uint32_t)(rd.t - last);      // desborde de 32 bits
+        last = rd.t;
+        const double t = (double)base;
+        const uint8_t* p = rd.payload();
+        switch (rd.type) {
+            case SNIFF_HELLO:
+                if (rd.len >= 6) { cap.baud = rs485_get32(&p[1]); cap.rxTimeout = p[5]; cap.hello = true; }
+                break;
+            case SNIFF_BAUD:
+                if (rd.len >= 4) { cap.baud = rs485_get32(p); cap.baudChanges.push_back({t, cap.baud}); }
+                break;
+            case SNIFF_DROP:
+                if (rd.len >= 4) { cap.dropped += rs485_get32(p); cap.drops.push_back(t); }
+                break;
+            case SNIFF_DATA: {
+                const double byteUs = 10e6 / cap.baud;
+                double end   = t - cap.rxTimeout * byteUs;
+                double start = end - rd.len * byteUs;
+                // Latencia del task de eventos: nunca antes del fin de lo anterior
+                if (start < prevEnd) { end += prevEnd - start; start = prevEnd; cap.overlaps++; }
+                for (uint8_t i = 0; i < rd.len; i++)
+                    fp.push(p[i], start + i * byteUs, start + (i + 1) * byteUs, cap.baud, cap.records);
+                prevEnd = end;
+                cap.dataBytes += rd.len;
+                break;
+            }
+        }
+    };
+    for (uint8_t b : raw)
+        if (rd.push(b)) handle();
+    while (rd.next()) handle();
+    cap.skipped = rd.skipped;
+}
+
+// ─── Análisis ────────────────────────────────────────────────
+
+struct Dist {
+    std::vector<double> v;
+    void add(double x) { v.push_back(x); }
+    double pct(double p) {
+        if (v.empty()) return 0;
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+    }
+    double avg() const {
+        double s = 0;
+        for (double x : v) s += x;
+        return v.empty() ? 0 : s / v.size();
+    }
+};
+
+struct SlaveStats {
+    uint32_t polls = 0, replies = 0, timeouts = 0, crc = 0, orphans = 0, merged = 0;
+    Dist     turnaround;
+};
+
+struct Trace {
+    FILE* f = nullptr;
+    bool  first = true;
+
+    void event(const char* ph, const std::string& name, int tid, double ts, double dur,
+               const std::string& args = "") {
+        if (!f) return;
+        fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.1f",
+                first ? "" : ",", name.c_str(), ph, tid, ts);
+        if (ph[0] == 'X') fprintf(f, ",\"dur\":%.1f", dur);
+        if (ph[0] == 'i') fprintf(f, ",\"s\":\"t\"");
+        if (!args.empty()) fprintf(f, ",\"args\":{%s}", args.c_str());
+        fprintf(f, "}");
+        first = false;
+    }
+    void thread(int tid, const std::string& name) {
+        if (!f) return;
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", tid, name.c_str());
+        fprintf(f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+                tid, tid);
+        first = false;
+    }
+};
+
+void analyze(const Capture& cap, const FrameParser& fp, Trace& tr) {
+    std::vector<Frame> frames = fp.frames;
+    for (size_t i = 0; i < frames.size(); i++)
+        frames[i].exact = frames[i].rec0 == frames[i].rec1 &&
+                          (i + 1 == frames.size() || frames[i + 1].rec0 != frames[i].rec1);
+    SlaveStats  sl[MAX_ID];
+    bool        seen[MAX_ID] = {};
+    Dist        cycles;
+    double      masterUs = 0, slaveUs = 0, turnUs = 0, timeoutUs = 0;
+    uint32_t    crcMaster = 0, crcSlave = 0, other = 0;
+
+    // Pendiente: último poll / grupo sin cerrar
+    const Frame*         poll = nullptr;
+    bool                 pollAnswered = false;
+    const Frame*         group = nullptr;
+    std::vector<uint8_t> groupPending;
+    uint16_t             slotUs = 0;
+    double               cycleStart = -1;
+
+    auto closePending = [&](double now) {
+        if (poll && !pollAnswered) {
+            sl[poll->id()].timeouts++;
+            timeoutUs += now - poll->t1;
+            tr.event("X", "timeout", poll->id(), poll->t1, now - poll->t1);
+        }
+        for (uint8_t id : groupPending) {
+            sl[id].timeouts++;
+            tr.event("X", "timeout", id, group->t1, now - group->t1);
+        }
+        if (group && !groupPending.empty()) timeoutUs += now - group->t1;
+        poll = nullptr;
+        group = nullptr;
+        groupPending.clear();
+    };
+
+    for (const Frame& f : frames) {
+        const double dur = f.t1 - f.t0;
+        const uint8_t id = f.id() < MAX_ID ? f.id() : 0;
+        std::string args = "\"len\":" + std::to_string(f.b.size()) +
+                           ",\"estado\":\"" + statusName(f.status) + "\"";
+
+        if (f.status != FrameStatus::OK) {
+            (f.master() ? crcMaster : crcSlave)++;
+            if (id) sl[id].crc++;
+            tr.event("i", std::string(f.master() ? "master " : "slave ") + statusName(f.status) +
+                     " " + frameName(f), TID_ERRORS, f.t0, 0, args);
+            // Respuesta corrupta: ocupa el bus igual, el poll queda contestado (mal)
+            if (!f.master()) { slaveUs += dur; if (poll) pollAnswered = true; continue; }
+        }
+
+        if (f.master()) {
+            closePending(f.t0);
+            masterUs += dur;
+            tr.event("X", frameName(f), TID_MASTER, f.t0, dur, args);
+            if (f.hdr() == RS485_BCAST_BYTE && f.status == FrameStatus::OK) {
+                if (cycleStart >= 0) {
+                    cycles.add(f.t0 - cycleStart);
+                    tr.event("X", "ciclo", TID_CYCLE, cycleStart, f.t0 - cycleStart);
+                }
+                cycleStart = f.t0;
+            }
+            if (f.expectsReply() && id) {
+                poll = &f;
+                pollAnswered = false;
+                sl[id].polls++;
+                seen[id] = true;
+            } else if (f.hdr() == RS485_GROUP_BYTE && f.status == FrameStatus::OK) {
+                group = &f;
+                groupPending = groupIds(f, slotUs);
+                groupPending.erase(std::remove_if(groupPending.begin(), groupPending.end(),
+                                                  [](uint8_t g) { return g >= MAX_ID; }),
+                                   groupPending.end());
+                for (uint8_t g : groupPending) { sl[g].polls++; seen[g] = true; }
+            }
+            continue;
+        }
+
+        // Slave
+        slaveUs += dur;
+        if (f.status != FrameStatus::OK) continue;
+        seen[id] = true;
+        std::string what = "resp";
+        if (poll && !pollAnswered && poll->id() == id) {
+            double ta = f.t0 - poll->t1;
+            sl[id].replies++;
+            turnUs += ta;
+            pollAnswered = true;
+            if (!f.exact || !poll->exact) {
+                sl[id].merged++;          // lectura compartida: hueco desconocido
+                tr.event("X", "turnaround (fusión)", id, poll->t1, ta);
+            } else {
+                sl[id].turnaround.add(ta);
+                tr.event("X", "turnaround", id, poll->t1, ta);
+            }
+        } else if (group && std::find(groupPending.begin(), groupPending.end(), id) != groupPending.end()) {
+            std::vector<uint8_t> all = groupIds(*group, slotUs);
+            size_t slot = std::find(all.begin(), all.end(), id) - all.begin();
+            // Turnaround dentro de la ranura: desde fin de trama + slot × slotUs
+            double ta = f.t0 - group->t1 - slot * (double)slotUs;
+            sl[id].replies++;
+            if (!f.exact || !group->exact) sl[id].merged++;
+            else                       sl[id].turnaround.add(ta);
+            groupPending.erase(std::find(groupPending.begin(), groupPending.end(), id));
+            args += ",\"ranura\":" + std::to_string(slot) + ",\"turnaround_us\":" + std::to_string((int)ta);
+        } else {
+            sl[id].orphans++;
+            what = "resp huérfana";
+            other++;
+        }
+        tr.event("X", what, id, f.t0, dur, args);
+    }
+    if (!frames.empty()) closePending(frames.back().t1);
+
+    for (size_t i = 0; i < cap.drops.size(); i++)
+        tr.event("i", "DROP (ring del sniffer lleno)", TID_ERRORS, cap.drops[i], 0);
+    for (auto& bc : cap.baudChanges)
+        tr.event("i", "baud " + std::to_string(bc.second), TID_MASTER, bc.first, 0);
+    tr.thread(TID_MASTER, "master");
+    tr.thread(TID_CYCLE, "ciclo");
+    tr.thread(TID_ERRORS, "errores");
+    for (int id = 1; id < MAX_ID; id++)
+        if (seen[id]) tr.thread(id, "slave " + std::to_string(id));
+
+    // ─── Resumen ───
+    const double span = frames.empty() ? 0 : frames.back().t1 - frames.front().t0;
+    printf("Captura: %.3f s, %llu registros, %llu B de bus, %zu tramas, baud %u%s\n",
+           span / 1e6, (unsigned long long)cap.records, (unsigned long long)cap.dataBytes,
+           frames.size(), cap.baud, cap.hello ? "" : " (sin HELLO: por defecto)");
+    printf("Errores: master %u, slave %u; ruido %llu B; huérfanas %u; DROP %llu; resinc. USB %llu B; solapes %llu\n",
+           crcMaster, crcSlave, (unsigned long long)fp.noise, other, (unsigned long long)cap.dropped,
+           (unsigned long long)cap.skipped, (unsigned long long)cap.overlaps);
+    printf("\n id   polls   resp  timeout  err  huérf  fusión   turnaround µs (media / p50 / p99 / máx)\n");
+    for (int id = 1; id < MAX_ID; id++) {
+        if (!seen[id]) continue;
+        SlaveStats& s = sl[id];
+        printf("%3d %7u %6u %8u %4u %6u %7u   %6.1f / %6.1f / %6.1f / %6.1f\n",
+               id, s.polls, s.replies, s.timeouts, s.crc, s.orphans, s.merged,
+               s.turnaround.avg(), s.turnaround.pct(0.5), s.turnaround.pct(0.99), s.turnaround.pct(1.0));
+    }
+    uint32_t replies = 0, merged = 0;
+    for (int id = 1; id < MAX_ID; id++) { replies += sl[id].replies; merged += sl[id].merged; }
+    if (replies && merged * 10 > replies)
+        printf("Aviso: %u%% de respuestas en la misma lectura que su poll o la trama siguiente: "
+               "el task del sniffer va con retraso y los turnaround medidos están sesgados\n",
+               merged * 100 / replies);
+    if (!cycles.v.empty())
+        printf("\nCiclo (bcast → bcast): %zu ciclos, media %.2f ms, p50 %.2f, p99 %.2f, máx %.2f\n",
+               cycles.v.size(), cycles.avg() / 1e3, cycles.pct(0.5) / 1e3, cycles.pct(0.99) / 1e3,
+               cycles.pct(1.0) / 1e3);
+    if (span > 0) {
+        double idle = span - masterUs - slaveUs - turnUs - timeoutUs;
+        printf("Tiempo de bus: master TX %.1f%%, slaves TX %.1f%%, turnaround %.1f%%, "
+               "esperando timeouts %.1f%%, resto (gaps, CPU del master) %.1f%%\n",
+               100 * masterUs / span, 100 * slaveUs / span, 100 * turnUs / span,
+               100 * timeoutUs / span, 100 * idle / span);
+    }
+}
+
+int usage() {
+    fprintf(stderr, "uso: rs485sniff [-t seg] [-w raw.bin] <puerto | captura.bin> [trace.json]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int         seconds = 0;
+    const char* rawOut  = nullptr;
+    int a = 1;
+    for (; a + 1 < argc && argv[a][0] == '-'; a += 2) {
+        if      (strcmp(argv[a], "-t") == 0) seconds = atoi(argv[a + 1]);
+        else if (strcmp(argv[a], "-w") == 0) rawOut  = argv[a + 1];
+        else return usage();
+    }
+    if (a >= argc || argc - a > 2) return usage();
+    const char* in  = argv[a];
+    const char* out = argc - a == 2 ? argv[a + 1] : nullptr;
+
+    Bytes raw;
+    struct stat st;
+    bool tty = stat(in, &st) == 0 && S_ISCHR(st.st_mode);
+    if (!(tty ? capture(in, seconds, raw) : readFile(in, raw))) return 1;
+    if (rawOut) {
+        FILE* f = fopen(rawOut, "wb");
+        if (!f || fwrite(raw.data(), 1, raw.size(), f) != raw.size()) {
+            fprintf(stderr, "rs485sniff: no se puede escribir %s\n", rawOut);
+            return 1;
+        }
+        fclose(f);
+    }
+
+    Capture     cap;
+    FrameParser fp;
+    decodeStream(raw, cap, fp);
+
+    Trace tr;
+    if (out) {
+        tr.f = fopen(out, "w");
+        if (!tr.f) { fprintf(stderr, "rs485sniff: no se puede crear %s\n", out); return 1; }
+        fprintf(tr.f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    }
+    analyze(cap, fp, tr);
+    if (tr.f) {
+        fprintf(tr.f, "\n]}\n");
+        fclose(tr.f);
+        fprintf(stderr, "rs485sniff: timeline en %s (ui.perfetto.dev)\n", out);
+    }
+    return 0;
+}